@@ -0,0 +1,242 @@
+// ActivityAnalyser.cpp
+#include "ActivityAnalyser.h"
+
+using int64 = juce::int64;
+
+namespace
+{
+    double sumOfSquares(const float* data, int numSamples)
+    {
+        double sum = 0.0;
+        for (int i = 0; i < numSamples; ++i)
+            sum += data[i] * data[i];
+
+        return sum;
+    }
+}
+
+//==============================================================================
+// TakeActivity
+//==============================================================================
+
+TakeActivity::TakeActivity(double seconds, std::vector<juce::Range<double>> activeRuns)
+    : lengthSeconds(juce::jmax(0.0, seconds)),
+      runs(std::move(activeRuns))
+{
+}
+
+double TakeActivity::getActiveFraction() const noexcept
+{
+    if (lengthSeconds <= 0.0)
+        return 0.0;
+
+    double active = 0.0;
+    for (const auto& r : runs)
+        active += r.getLength();
+
+    return juce::jlimit(0.0, 1.0, active / lengthSeconds);
+}
+
+std::vector<juce::Range<int64>> TakeActivity::getRunsInSamples(double sampleRate, int64 numSamples) const
+{
+    std::vector<juce::Range<int64>> result;
+    result.reserve(runs.size());
+
+    for (const auto& r : runs)
+    {
+        const int64 s = juce::jlimit<int64>(0, numSamples, (int64)std::floor(r.getStart() * sampleRate));
+        const int64 e = juce::jlimit<int64>(s, numSamples, (int64)std::ceil(r.getEnd() * sampleRate));
+
+        if (e > s)
+            result.push_back({ s, e });
+    }
+
+    return result;
+}
+
+bool TakeActivity::isActive(double startSec, double endSec) const noexcept
+{
+    // First run ending after startSec
+    auto it = std::lower_bound(runs.begin(), runs.end(), startSec,
+        [](const juce::Range<double>& r, double t) { return r.getEnd() <= t; });
+
+    return it != runs.end() && it->getStart() < endSec;
+}
+
+bool TakeActivity::writeToFile(const juce::File& file) const
+{
+    juce::Array<juce::var> runList;
+    runList.ensureStorageAllocated((int)runs.size());
+
+    for (const auto& r : runs)
+        runList.add(juce::Array<juce::var>{ r.getStart(), r.getEnd() });
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("length_s", lengthSeconds);
+    root->setProperty("threshold_dbfs", thresholdDbfs);
+    root->setProperty("padding_s", paddingSeconds);
+    root->setProperty("active_fraction", getActiveFraction());
+    root->setProperty("active_s", runList);
+
+    return file.replaceWithText(juce::JSON::toString(juce::var(root), true));
+}
+
+std::shared_ptr<TakeActivity> TakeActivity::readFromFile(const juce::File& file)
+{
+    if (!file.existsAsFile())
+        return nullptr;
+
+    const auto root = juce::JSON::parse(file);
+    const double length = (double)root.getProperty("length_s", -1.0);
+    const auto* runList = root.getProperty("active_s", {}).getArray();
+
+    if (length < 0.0 || runList == nullptr)
+        return nullptr;
+
+    std::vector<juce::Range<double>> activeRuns;
+    activeRuns.reserve((size_t)runList->size());
+
+    for (const auto& r : *runList)
+    {
+        if (!r.isArray() || r.size() != 2 || (double)r[1] <= (double)r[0])
+            continue;
+
+        // Kept sorted and disjoint whatever the file says
+        if (!activeRuns.empty() && (double)r[0] <= activeRuns.back().getEnd())
+            activeRuns.back().setEnd(juce::jmax(activeRuns.back().getEnd(), (double)r[1]));
+        else
+            activeRuns.push_back({ (double)r[0], (double)r[1] });
+    }
+
+    return std::make_shared<TakeActivity>(length, std::move(activeRuns));
+}
+
+juce::File TakeActivity::getSidecarFile(const juce::File& takeFile)
+{
+    return takeFile.withFileExtension("activity.json");
+}
+
+std::shared_ptr<TakeActivity> TakeActivity::readSidecarFor(const juce::File& takeFile)
+{
+    const auto sidecar = getSidecarFile(takeFile);
+
+    if (!sidecar.existsAsFile()
+        || sidecar.getLastModificationTime() < takeFile.getLastModificationTime())
+        return nullptr;
+
+    return readFromFile(sidecar);
+}
+
+//==============================================================================
+// ActivityAnalyser
+//==============================================================================
+
+ActivityAnalyser::ActivityAnalyser(double rate)
+    : sampleRate(rate > 0.0 ? rate : 44100.0),
+      frameSize(juce::jmax(1, juce::roundToInt(sampleRate * TakeActivity::frameSeconds))),
+      thresholdSquare(std::pow(10.0, TakeActivity::thresholdDbfs / 10.0))
+{
+}
+
+void ActivityAnalyser::process(const float* samples, int numSamples)
+{
+    if (samples == nullptr || numSamples <= 0)
+        return;
+
+    int pos = 0;
+    while (pos < numSamples)
+    {
+        const int n = juce::jmin(frameSize - frameFill, numSamples - pos);
+
+        frameSum += sumOfSquares(samples + pos, n);
+        frameFill += n;
+        pos += n;
+
+        if (frameFill == frameSize)
+        {
+            addFrame(frameSum / frameSize > thresholdSquare);
+            frameSum = 0.0;
+            frameFill = 0;
+        }
+    }
+}
+
+void ActivityAnalyser::addFrame(bool active)
+{
+    if (active)
+    {
+        if (!frameRuns.empty() && frameRuns.back().getEnd() == numFrames)
+            frameRuns.back().setEnd(numFrames + 1);
+        else
+            frameRuns.push_back({ numFrames, numFrames + 1 });
+    }
+
+    ++numFrames;
+}
+
+std::shared_ptr<TakeActivity> ActivityAnalyser::getResult() const
+{
+    auto runs = frameRuns;
+
+    // A partial last frame counts like a whole one
+    if (frameFill > 0 && frameSum / frameFill > thresholdSquare)
+    {
+        if (!runs.empty() && runs.back().getEnd() == numFrames)
+            runs.back().setEnd(numFrames + 1);
+        else
+            runs.push_back({ numFrames, numFrames + 1 });
+    }
+
+    const double lengthSeconds = ((double)numFrames * frameSize + frameFill) / sampleRate;
+    const double frameLength = (double)frameSize / sampleRate;
+
+    // Padded, then merged where the padding closes a gap
+    std::vector<juce::Range<double>> padded;
+
+    for (const auto& r : runs)
+    {
+        const double s = juce::jmax(0.0, (double)r.getStart() * frameLength - TakeActivity::paddingSeconds);
+        const double e = juce::jmin(lengthSeconds, (double)r.getEnd() * frameLength + TakeActivity::paddingSeconds);
+
+        if (!padded.empty() && s <= padded.back().getEnd())
+            padded.back().setEnd(juce::jmax(padded.back().getEnd(), e));
+        else
+            padded.push_back({ s, e });
+    }
+
+    return std::make_shared<TakeActivity>(lengthSeconds, std::move(padded));
+}
+
+std::shared_ptr<TakeActivity> ActivityAnalyser::analyse(juce::AudioFormatReader& reader,
+    const std::function<bool()>& shouldExit)
+{
+    ActivityAnalyser analyser(reader.sampleRate);
+
+    const int   numChannels = juce::jmax(1, (int)reader.numChannels);
+    const int   chunkSize = 65536;
+    const int64 totalSamples = reader.lengthInSamples;
+
+    juce::AudioBuffer<float> chunk(numChannels, chunkSize);
+
+    for (int64 pos = 0; pos < totalSamples; pos += chunkSize)
+    {
+        if (shouldExit != nullptr && shouldExit())
+            return nullptr;
+
+        const int n = (int)juce::jmin<int64>(chunkSize, totalSamples - pos);
+
+        reader.read(&chunk, 0, n, pos, true, true);
+
+        if (numChannels > 1)
+        {
+            for (int ch = 1; ch < numChannels; ++ch)
+                chunk.addFrom(0, 0, chunk, ch, 0, n);
+
+            chunk.applyGain(0, 0, n, 1.0f / (float)numChannels);
+        }
+
+        analyser.process(chunk.getReadPointer(0), n);
+    }
+
+    return analyser.getResult();
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// TakeActivity: where in a take something is sung (or breathed, or played).
+//
+// A list of active runs in seconds from the start of the take; everything
+// else is below the activity threshold and can be skipped by analysis,
+// stored as nothing and drawn as a flat line. Runs are padded so note
+// onsets and tails stay inside them. Saved as take_N.activity.json next to
+// the take, which the Python pipeline reads as well.
+//==============================================================================
+
+class TakeActivity
+{
+public:
+    static constexpr float thresholdDbfs = -50.0f;   // RMS of a 10 ms frame
+    static constexpr double frameSeconds = 0.01;
+    static constexpr double paddingSeconds = 0.2;    // kept either side of a run
+
+    TakeActivity(double lengthSeconds, std::vector<juce::Range<double>> activeRuns);
+
+    double getLengthSeconds() const noexcept { return lengthSeconds; }
+    const std::vector<juce::Range<double>>& getRuns() const noexcept { return runs; }
+
+    // Share of the take inside an active run (0..1)
+    double getActiveFraction() const noexcept;
+
+    // Active runs as sample ranges at sampleRate, clipped to [0, numSamples).
+    std::vector<juce::Range<juce::int64>> getRunsInSamples(double sampleRate, juce::int64 numSamples) const;
+
+    // True if any part of [startSec, endSec) is active.
+    bool isActive(double startSec, double endSec) const noexcept;
+
+    size_t getMemoryUsage() const noexcept { return runs.capacity() * sizeof(juce::Range<double>); }
+
+    bool writeToFile(const juce::File& file) const;
+    static std::shared_ptr<TakeActivity> readFromFile(const juce::File& file);
+
+    // take_N.wav -> take_N.activity.json
+    static juce::File getSidecarFile(const juce::File& takeFile);
+
+    // The take's sidecar, if there is one at least as new as the take.
+    static std::shared_ptr<TakeActivity> readSidecarFor(const juce::File& takeFile);
+
+private:
+    const double lengthSeconds;
+    const std::vector<juce::Range<double>> runs;   // sorted, disjoint
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TakeActivity)
+};
+
+//==============================================================================
+// ActivityAnalyser: 10 ms RMS frames against TakeActivity::thresholdDbfs,
+// merged into padded runs.
+//==============================================================================
+
+class ActivityAnalyser
+{
+public:
+    explicit ActivityAnalyser(double sampleRate);
+
+    // Mono samples, any block size.
+    void process(const float* samples, int numSamples);
+
+    // Activity of everything processed so far.
+    std::shared_ptr<TakeActivity> getResult() const;
+
+    // Whole file, mixed to mono. Returns nullptr if shouldExit() turned true.
+    static std::shared_ptr<TakeActivity> analyse(juce::AudioFormatReader& reader,
+        const std::function<bool()>& shouldExit);
+
+private:
+    void addFrame(bool active);
+
+    const double sampleRate;
+    const int    frameSize;
+    const double thresholdSquare;
+
+    std::vector<juce::Range<juce::int64>> frameRuns;   // active frames, by frame index
+    juce::int64 numFrames = 0;
+    double frameSum = 0.0;
+    int    frameFill = 0;
+};
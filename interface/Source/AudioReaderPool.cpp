@@ -0,0 +1,144 @@
+// AudioReaderPool.cpp
+#include "AudioReaderPool.h"
+
+using int64 = juce::int64;
+
+//==============================================================================
+// SharedReader: a reader over a pooled mapping. The mapped WAV reader keeps no
+// state between reads, so any number of these can read it at once.
+//==============================================================================
+
+class AudioReaderPool::SharedReader : public juce::AudioFormatReader
+{
+public:
+    explicit SharedReader(std::shared_ptr<Entry> e)
+        : juce::AudioFormatReader(nullptr, e->mapped->getFormatName()),
+          entry(std::move(e))
+    {
+        const auto& source = *entry->mapped;
+        sampleRate = source.sampleRate;
+        bitsPerSample = source.bitsPerSample;
+        lengthInSamples = source.lengthInSamples;
+        numChannels = source.numChannels;
+        usesFloatingPointData = source.usesFloatingPointData;
+        metadataValues = source.metadataValues;
+    }
+
+    bool readSamples(int* const* destChannels, int numDestChannels, int startOffsetInDestBuffer,
+        int64 startSampleInFile, int numSamples) override
+    {
+        return entry->mapped->readSamples(destChannels, numDestChannels, startOffsetInDestBuffer,
+            startSampleInFile, numSamples);
+    }
+
+private:
+    const std::shared_ptr<Entry> entry;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedReader)
+};
+
+//==============================================================================
+
+AudioReaderPool::AudioReaderPool(juce::AudioFormatManager& fm)
+    : formatManager(fm)
+{
+}
+
+AudioReaderPool::~AudioReaderPool() = default;
+
+std::unique_ptr<juce::AudioFormatReader> AudioReaderPool::createReaderFor(const juce::File& file)
+{
+    if (auto entry = findOrMap(file))
+        return std::make_unique<SharedReader>(std::move(entry));
+
+    // Not a mappable WAV: opened the usual way, every time
+    return std::unique_ptr<juce::AudioFormatReader>(formatManager.createReaderFor(file));
+}
+
+std::shared_ptr<AudioReaderPool::Entry> AudioReaderPool::findOrMap(const juce::File& file)
+{
+    if (!file.hasFileExtension("wav;wave") || !file.existsAsFile())
+        return nullptr;
+
+    const auto key = file.getFullPathName();
+    const auto modified = file.getLastModificationTime();
+    const auto fileSize = file.getSize();
+
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (auto it = entries.find(key); it != entries.end())
+        {
+            if (it->second->modified == modified && it->second->fileSize == fileSize)
+            {
+                it->second->lastUsed = ++useCounter;
+                return it->second;
+            }
+
+            // Rewritten since it was mapped
+            entries.erase(it);
+        }
+    }
+
+    // Parsed and mapped outside the lock; two threads racing here both map,
+    // and the second one in replaces the first
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(wavFormat.createMemoryMappedReader(file));
+
+    if (mapped == nullptr || !mapped->mapEntireFile())
+        return nullptr;
+
+    auto entry = std::make_shared<Entry>();
+    entry->mapped = std::move(mapped);
+    entry->modified = modified;
+    entry->fileSize = fileSize;
+
+    const juce::ScopedLock sl(lock);
+    entry->lastUsed = ++useCounter;
+    entries[key] = entry;
+
+    // Least recently used out
+    while ((int)entries.size() > maxFiles)
+    {
+        auto oldest = entries.begin();
+
+        for (auto it = entries.begin(); it != entries.end(); ++it)
+            if (it->second->lastUsed < oldest->second->lastUsed)
+                oldest = it;
+
+        entries.erase(oldest);
+    }
+
+    return entry;
+}
+
+void AudioReaderPool::invalidate(const juce::File& fileOrDirectory)
+{
+    const juce::ScopedLock sl(lock);
+
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        const juce::File f(it->first);
+
+        if (f == fileOrDirectory || f.isAChildOf(fileOrDirectory))
+            it = entries.erase(it);
+        else
+            ++it;
+    }
+}
+
+void AudioReaderPool::clear()
+{
+    const juce::ScopedLock sl(lock);
+    entries.clear();
+}
+
+int64 AudioReaderPool::getMappedBytes() const
+{
+    const juce::ScopedLock sl(lock);
+
+    int64 bytes = 0;
+    for (const auto& e : entries)
+        bytes += e.second->fileSize;
+
+    return bytes;
+}
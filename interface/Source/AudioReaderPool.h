@@ -0,0 +1,64 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+#include <memory>
+
+//==============================================================================
+// AudioReaderPool: readers for the same files, opened once.
+//
+// A WAV file is parsed and memory-mapped the first time a reader is asked
+// for; every reader handed out afterwards is a view of that mapping, so a
+// repeat open costs neither a header parse nor a file handle, and reads are
+// copies straight out of the page cache. Anything that cannot be mapped
+// (other formats, compressed WAV) gets a plain reader from the format manager.
+//
+// A mapping is dropped when its file's size or modification time changes,
+// when invalidate() is called for it (or its directory), or when it has not
+// been used for the longest of more than maxFiles. Readers handed out keep
+// their mapping alive until they are deleted, so invalidate() before writing
+// a file that is mapped: some systems refuse to replace a mapped file.
+//
+// Any thread.
+//==============================================================================
+
+class AudioReaderPool
+{
+public:
+    static constexpr int maxFiles = 64;
+
+    explicit AudioReaderPool(juce::AudioFormatManager& formatManager);
+    ~AudioReaderPool();
+
+    // nullptr if the file can't be read, like AudioFormatManager::createReaderFor.
+    std::unique_ptr<juce::AudioFormatReader> createReaderFor(const juce::File& file);
+
+    // Drops the mapping of fileOrDirectory, or of every file inside it.
+    void invalidate(const juce::File& fileOrDirectory);
+    void clear();
+
+    // Bytes of the files currently mapped (address space, not RAM)
+    juce::int64 getMappedBytes() const;
+
+private:
+    struct Entry
+    {
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped;
+        juce::Time modified;
+        juce::int64 fileSize = 0;
+        juce::uint32 lastUsed = 0;
+    };
+
+    class SharedReader;
+
+    std::shared_ptr<Entry> findOrMap(const juce::File& file);
+
+    juce::AudioFormatManager& formatManager;
+    juce::WavAudioFormat wavFormat;
+
+    mutable juce::CriticalSection lock;
+    std::map<juce::String, std::shared_ptr<Entry>> entries;   // by full path
+    juce::uint32 useCounter = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioReaderPool)
+};
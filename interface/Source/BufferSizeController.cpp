@@ -0,0 +1,259 @@
+// BufferSizeController.cpp
+#include "BufferSizeController.h"
+
+using int64 = juce::int64;
+
+namespace
+{
+    int64 nowMs()
+    {
+        return juce::Time::currentTimeMillis();
+    }
+
+    juce::String describeSize(int bufferSize, double sampleRate)
+    {
+        return juce::String(bufferSize) + " samples ("
+            + juce::String(1000.0 * bufferSize / juce::jmax(1.0, sampleRate), 1) + " ms)";
+    }
+}
+
+//==============================================================================
+
+BufferSizeController::BufferSizeController(juce::AudioDeviceManager& dm)
+    : deviceManager(dm)
+{
+    startTimer(1000);
+}
+
+BufferSizeController::~BufferSizeController()
+{
+    stopTimer();
+}
+
+BufferSizeController::Mode BufferSizeController::modeFromString(const juce::String& s)
+{
+    if (s.equalsIgnoreCase("off"))
+        return Mode::off;
+
+    if (s.equalsIgnoreCase("apply"))
+        return Mode::apply;
+
+    return Mode::suggest;
+}
+
+void BufferSizeController::setMode(Mode newMode)
+{
+    mode = newMode;
+
+    if (mode == Mode::off)
+        stopTimer();
+    else if (!isTimerRunning())
+        startTimer(1000);
+}
+
+void BufferSizeController::setUsage(Usage newUsage, bool recordingInProgress)
+{
+    recording = recordingInProgress;
+
+    if (newUsage != usage)
+    {
+        // A different job wants a different size: no need to wait for things to settle
+        usage = newUsage;
+        lastChangeMs = 0;
+    }
+}
+
+void BufferSizeController::prepare(double sampleRate, int blockSize)
+{
+    loadMeasurer.reset(sampleRate, blockSize);
+}
+
+juce::String BufferSizeController::getStatusText() const
+{
+    auto* device = deviceManager.getCurrentAudioDevice();
+    if (device == nullptr)
+        return "No audio device";
+
+    const double rate = device->getCurrentSampleRate();
+
+    juce::String text = "Buffer " + describeSize(device->getCurrentBufferSizeSamples(), rate)
+        + ", load " + juce::String(juce::roundToInt(100.0 * loadMeasurer.getLoadAsProportion())) + "%"
+        + ", " + juce::String(loadMeasurer.getXRunCount()) + " dropouts";
+
+    if (suggested > 0 && suggested != device->getCurrentBufferSizeSamples())
+        text << "\nSuggested: " << describeSize(suggested, rate);
+
+    return text;
+}
+
+//==============================================================================
+
+void BufferSizeController::timerCallback()
+{
+    auto* device = deviceManager.getCurrentAudioDevice();
+    if (device == nullptr || !device->isPlaying())
+        return;
+
+    // Counters start again whenever the device is reopened
+    const int xruns = loadMeasurer.getXRunCount();
+    const int deviceXRuns = device->getXRunCount();   // -1 if the driver cannot tell
+
+    if (xruns < lastXRuns)
+        lastXRuns = 0;
+
+    if (deviceXRuns < lastDeviceXRuns)
+        lastDeviceXRuns = 0;
+
+    const bool droppedOut = xruns > lastXRuns || deviceXRuns > lastDeviceXRuns;
+    lastXRuns = xruns;
+    lastDeviceXRuns = juce::jmax(0, deviceXRuns);
+
+    recentLoads.add(loadMeasurer.getLoadAsProportion());
+    while (recentLoads.size() > 5)
+        recentLoads.remove(0);
+
+    double peakLoad = 0.0;
+    for (auto l : recentLoads)
+        peakLoad = juce::jmax(peakLoad, l);
+
+    const int current = device->getCurrentBufferSizeSamples();
+
+    if (droppedOut)
+        droppedOutAtMs[current] = nowMs();
+
+    juce::String reason;
+    const int target = choose(*device, peakLoad, droppedOut, reason);
+
+    if (target == current)
+    {
+        suggest(*device, current, {});
+        return;
+    }
+
+    // Dropouts are dealt with straight away; everything else waits a bit
+    if (!droppedOut && nowMs() - lastChangeMs < settleSeconds * 1000)
+        return;
+
+    suggest(*device, target, reason);
+
+    if (mode != Mode::apply || recording)
+        return;
+
+    juce::AudioDeviceManager::AudioDeviceSetup setup;
+    deviceManager.getAudioDeviceSetup(setup);
+    setup.bufferSize = target;
+
+    const auto error = deviceManager.setAudioDeviceSetup(setup, true);
+
+    if (error.isNotEmpty())
+    {
+        DBG("BufferSizeController: could not switch to " << target << ": " << error);
+        droppedOutAtMs[target] = nowMs();   // do not keep trying
+    }
+    else
+    {
+        DBG("BufferSizeController: " << describeSize(target, setup.sampleRate) << ", " << reason);
+    }
+
+    lastChangeMs = nowMs();
+    resetMeasurement();
+}
+
+int BufferSizeController::choose(juce::AudioIODevice& device, double peakLoad,
+    bool droppedOut, juce::String& reason)
+{
+    auto sizes = device.getAvailableBufferSizes();
+    sizes.sort();
+
+    const int current = device.getCurrentBufferSizeSamples();
+
+    if (sizes.isEmpty())
+        return current;
+
+    const double rate = juce::jmax(1.0, device.getCurrentSampleRate());
+    const int64 now = nowMs();
+
+    auto isAvoided = [&](int size)
+        {
+            const auto it = droppedOutAtMs.find(size);
+            return it != droppedOutAtMs.end() && now - it->second < avoidSeconds * 1000;
+        };
+
+    // Too little headroom: the next larger size that has not dropped out lately
+    if (droppedOut || peakLoad > highLoad)
+    {
+        for (auto size : sizes)
+        {
+            if (size > current && !isAvoided(size))
+            {
+                reason = droppedOut ? "dropouts at " + juce::String(current)
+                                    : "callback load " + juce::String(juce::roundToInt(peakLoad * 100.0)) + "%";
+                return size;
+            }
+        }
+
+        return current;
+    }
+
+    // Recording wants the latency down; review only wants headroom
+    int floor = sizes.getFirst();
+
+    if (usage == Usage::review)
+    {
+        floor = sizes.getLast();
+        for (auto size : sizes)
+        {
+            if (1000.0 * size / rate >= reviewBufferMs)
+            {
+                floor = size;
+                break;
+            }
+        }
+
+        if (current < floor)
+        {
+            reason = "comp review: more headroom";
+            return floor;
+        }
+    }
+
+    // Comfortably loaded for a while: one size down, if it has behaved
+    if (recentLoads.size() >= 5 && peakLoad < lowLoad)
+    {
+        for (int i = sizes.size(); --i >= 0;)
+        {
+            const int size = sizes[i];
+
+            if (size < current && size >= floor && !isAvoided(size))
+            {
+                reason = usage == Usage::recording ? "recording: lower latency" : "callback load "
+                    + juce::String(juce::roundToInt(peakLoad * 100.0)) + "%";
+                return size;
+            }
+        }
+    }
+
+    return current;
+}
+
+void BufferSizeController::suggest(juce::AudioIODevice& device, int bufferSize, const juce::String& reason)
+{
+    if (bufferSize == suggested)
+        return;
+
+    suggested = bufferSize;
+
+    if (bufferSize != device.getCurrentBufferSizeSamples())
+        DBG("BufferSizeController: suggest " << describeSize(bufferSize, device.getCurrentSampleRate())
+            << " (" << reason << ")");
+
+    if (onSuggestion != nullptr)
+        onSuggestion(bufferSize, reason);
+}
+
+void BufferSizeController::resetMeasurement()
+{
+    recentLoads.clearQuick();
+    lastXRuns = 0;
+    lastDeviceXRuns = 0;
+}
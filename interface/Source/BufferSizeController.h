@@ -0,0 +1,79 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <map>
+
+//==============================================================================
+// BufferSizeController: picks the device buffer size from the measured
+// callback load and dropout history instead of leaving it to a guess in the
+// IN/OUT dialog.
+//
+// While the user records, it aims for the smallest buffer that has run
+// without dropouts (monitoring latency); during comp review latency does not
+// matter, so it keeps at least reviewBufferMs for headroom. A size that
+// dropped out is avoided for a while. In suggest mode the result is only
+// reported through onSuggestion; in apply mode the device is reopened with
+// it, but never while a take is being recorded.
+//
+// The audio callback wraps its work in a ScopedTimer on getLoadMeasurer();
+// prepare() is called from prepareToPlay.
+//==============================================================================
+
+class BufferSizeController : private juce::Timer
+{
+public:
+    enum class Mode { off, suggest, apply };
+    enum class Usage { recording, review };
+
+    static constexpr double reviewBufferMs = 20.0;
+    static constexpr double highLoad = 0.7;    // step up above this
+    static constexpr double lowLoad = 0.35;    // step down below this
+    static constexpr int settleSeconds = 10;   // between changes
+    static constexpr int avoidSeconds = 300;   // a size that dropped out
+
+    explicit BufferSizeController(juce::AudioDeviceManager& deviceManager);
+    ~BufferSizeController() override;
+
+    // "off", "suggest" or "apply" (AICOMP_BUFFER_CONTROL); anything else is suggest.
+    static Mode modeFromString(const juce::String& s);
+
+    void setMode(Mode newMode);
+    Mode getMode() const noexcept { return mode; }
+
+    // Message thread: what the user is doing now.
+    void setUsage(Usage newUsage, bool recordingInProgress);
+
+    // Audio device: the callback is not running.
+    void prepare(double sampleRate, int blockSize);
+
+    // Audio thread: the callback's work is timed against this.
+    juce::AudioProcessLoadMeasurer& getLoadMeasurer() noexcept { return loadMeasurer; }
+
+    int getSuggestedBufferSize() const noexcept { return suggested; }
+    juce::String getStatusText() const;
+
+    // Called when the suggestion changes: new size and why.
+    std::function<void(int bufferSize, const juce::String& reason)> onSuggestion;
+
+private:
+    void timerCallback() override;
+    int choose(juce::AudioIODevice& device, double peakLoad, bool droppedOut, juce::String& reason);
+    void suggest(juce::AudioIODevice& device, int bufferSize, const juce::String& reason);
+    void resetMeasurement();
+
+    juce::AudioDeviceManager& deviceManager;
+    juce::AudioProcessLoadMeasurer loadMeasurer;
+
+    Mode  mode = Mode::suggest;
+    Usage usage = Usage::recording;
+    bool  recording = false;
+
+    int suggested = 0;
+    int lastXRuns = 0, lastDeviceXRuns = 0;
+    juce::Array<double> recentLoads;                    // one per second, newest last
+    juce::int64 lastChangeMs = 0;
+    std::map<int, juce::int64> droppedOutAtMs;          // buffer size -> last dropout
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BufferSizeController)
+};
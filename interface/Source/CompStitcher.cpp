@@ -0,0 +1,482 @@
+// CompStitcher.cpp
+#include "CompStitcher.h"
+#include "LoudnessAnalyser.h"
+#include <map>
+
+using int64 = juce::int64;
+
+namespace
+{
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    // Scratch buffer whose data pointer is SIMD aligned
+    struct AlignedBuffer
+    {
+        explicit AlignedBuffer(size_t numFloats)
+            : storage(numFloats + Vec::SIMDNumElements, 0.0f),
+              data(Vec::getNextSIMDAlignedPtr(storage.data()))
+        {
+        }
+
+        std::vector<float> storage;
+        float* data;
+    };
+
+    struct Segment
+    {
+        double startSec = 0.0;
+        double endSec = 0.0;
+        juce::String take;
+        double offsetSec = 0.0;
+        std::map<juce::String, double> takeOffsets;   // winner and candidates
+    };
+
+    // take[start, start + length) into dest, zero outside the take
+    void readSlice(const std::vector<float>& take, int64 start, int length, float* dest)
+    {
+        std::fill(dest, dest + length, 0.0f);
+
+        const int64 first = juce::jmax<int64>(start, 0);
+        const int64 last = juce::jmin<int64>(start + length, (int64)take.size());
+
+        if (last > first)
+            std::copy(take.begin() + (std::ptrdiff_t)first,
+                take.begin() + (std::ptrdiff_t)last,
+                dest + (first - start));
+    }
+
+    float median(std::vector<float> values)
+    {
+        std::sort(values.begin(), values.end());
+        const size_t mid = values.size() / 2;
+
+        return values.size() % 2 == 1 ? values[mid] : 0.5f * (values[mid - 1] + values[mid]);
+    }
+
+    void peakNormalise(float* data, int numSamples, float targetDb)
+    {
+        const auto range = juce::FloatVectorOperations::findMinAndMax(data, numSamples);
+        const float peak = juce::jmax(std::abs(range.getStart()), std::abs(range.getEnd()));
+
+        if (peak > 0.0f)
+            juce::FloatVectorOperations::multiply(data,
+                juce::Decibels::decibelsToGain(targetDb) / peak,
+                numSamples);
+    }
+}
+
+//==============================================================================
+
+int CompStitcher::findBestSpliceLag(const float* outgoing,
+    const float* incoming,
+    int windowLength,
+    int maxLag)
+{
+    if (windowLength <= 0 || maxLag <= 0)
+        return 0;
+
+    const int lanes = (int)Vec::SIMDNumElements;
+    const int numLags = 2 * maxLag + 1;
+    const int incomingLength = windowLength + 2 * maxLag;
+    const int paddedWindow = (windowLength + lanes - 1) / lanes * lanes;
+    const int stride = paddedWindow + (numLags + lanes - 1) / lanes * lanes;
+
+    AlignedBuffer window((size_t)paddedWindow);
+    std::copy(outgoing, outgoing + windowLength, window.data);
+
+    // One copy of `incoming` per sub-register phase, so every lag is an aligned load
+    AlignedBuffer shifted((size_t)(stride * lanes));
+
+    for (int phase = 0; phase < lanes; ++phase)
+    {
+        float* dest = shifted.data + phase * stride;
+        const int count = juce::jlimit(0, stride, incomingLength - phase);
+        std::copy(incoming + phase, incoming + phase + count, dest);
+    }
+
+    double windowEnergy = 0.0;
+    for (int i = 0; i < windowLength; ++i)
+        windowEnergy += (double)outgoing[i] * outgoing[i];
+
+    if (windowEnergy < 1.0e-8)
+        return 0;
+
+    double incomingEnergy = 0.0;
+    for (int i = 0; i < windowLength; ++i)
+        incomingEnergy += (double)incoming[i] * incoming[i];
+
+    double bestScore = 0.0;
+    int    bestLag = 0;
+
+    for (int m = 0; m < numLags; ++m)
+    {
+        const float* src = shifted.data + (m % lanes) * stride + (m / lanes) * lanes;
+
+        auto acc = Vec::expand(0.0f);
+        for (int i = 0; i < paddedWindow; i += lanes)
+            acc += Vec::fromRawArray(window.data + i) * Vec::fromRawArray(src + i);
+
+        const double score = (double)acc.sum() / std::sqrt(windowEnergy * incomingEnergy + 1.0e-12);
+        const int lag = m - maxLag;
+
+        // Ties go to the smaller shift
+        if (score > bestScore + 1.0e-6
+            || (score > bestScore - 1.0e-6 && std::abs(lag) < std::abs(bestLag)))
+        {
+            bestScore = score;
+            bestLag = lag;
+        }
+
+        // Slide the energy of incoming[m, m + windowLength) by one sample
+        if (m + 1 < numLags)
+            incomingEnergy = juce::jmax(0.0, incomingEnergy
+                - (double)incoming[m] * incoming[m]
+                + (double)incoming[m + windowLength] * incoming[m + windowLength]);
+    }
+
+    return bestScore > 0.0 ? bestLag : 0;
+}
+
+int CompStitcher::findSpliceCentre(const float* a, const float* b, int length)
+{
+    if (length <= 0)
+        return 0;
+
+    const float middle = 0.5f * (float)(length - 1);
+    const float distanceWeight = 1.0e-5f;   // only breaks near-ties
+
+    int   best = length / 2;
+    float bestCost = std::numeric_limits<float>::max();
+
+    for (int i = 0; i < length; ++i)
+    {
+        const float cost = std::abs(a[i] - b[i]) + distanceWeight * std::abs((float)i - middle);
+
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+//==============================================================================
+
+juce::Result CompStitcher::stitch(const juce::File& compmapFile,
+    const juce::File& phraseDirectory,
+    const juce::File& outFile,
+    const Settings& settings,
+    juce::AudioFormatManager& formatManager)
+{
+    const auto compmap = juce::JSON::parse(compmapFile);
+    const auto* segmentsJson = compmap.getProperty("segments", {}).getArray();
+
+    if (segmentsJson == nullptr || segmentsJson->isEmpty())
+        return juce::Result::fail("Compmap has no segments:\n" + compmapFile.getFullPathName());
+
+    std::vector<Segment> segments;
+
+    for (const auto& s : *segmentsJson)
+    {
+        const auto winner = s.getProperty("winner", {});
+
+        Segment seg;
+        seg.startSec = (double)s.getProperty("start_s", 0.0);
+        seg.endSec = (double)s.getProperty("end_s", 0.0);
+        seg.take = winner.getProperty("take", {}).toString();
+        seg.offsetSec = (double)winner.getProperty("offset_s", 0.0);
+        seg.takeOffsets[seg.take] = seg.offsetSec;
+
+        if (const auto* candidates = s.getProperty("candidates", {}).getArray())
+            for (const auto& c : *candidates)
+                seg.takeOffsets[c.getProperty("take", {}).toString()] = (double)c.getProperty("offset_s", 0.0);
+
+        segments.push_back(seg);
+    }
+
+    // Whole-take offsets of every take in the phrase (not only the winners)
+    std::map<juce::String, double> takeOffsets;
+
+    if (const auto* offsetsJson = compmap.getProperty("take_offsets_s", {}).getDynamicObject())
+        for (const auto& p : offsetsJson->getProperties())
+            takeOffsets[p.name.toString()] = (double)p.value;
+
+    std::sort(segments.begin(), segments.end(),
+        [](const Segment& a, const Segment& b) { return a.startSec < b.startSec; });
+
+    // Winner takes, mono; peak-normalised like the Python stitcher unless loudness matched
+    std::map<juce::String, std::vector<float>> takes;
+    double sampleRate = 0.0;
+
+    for (const auto& seg : segments)
+    {
+        if (takes.count(seg.take) > 0)
+            continue;
+
+        const auto file = phraseDirectory.getChildFile(seg.take + ".wav");
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+
+        if (reader == nullptr)
+            return juce::Result::fail("Expected WAV not found:\n" + file.getFullPathName());
+
+        if (sampleRate == 0.0)
+            sampleRate = reader->sampleRate;
+        else if (reader->sampleRate != sampleRate)
+            return juce::Result::fail("Sample rate mismatch for " + seg.take);
+
+        const int numSamples = (int)reader->lengthInSamples;
+        const int numChannels = juce::jmax(1, (int)reader->numChannels);
+
+        juce::AudioBuffer<float> buffer(numChannels, numSamples);
+        reader->read(&buffer, 0, numSamples, 0, true, true);
+
+        for (int ch = 1; ch < numChannels; ++ch)
+            buffer.addFrom(0, 0, buffer, ch, 0, numSamples);
+
+        auto& mono = takes[seg.take];
+        mono.assign(buffer.getReadPointer(0), buffer.getReadPointer(0) + numSamples);
+
+        if (numChannels > 1)
+            juce::FloatVectorOperations::multiply(mono.data(), 1.0f / (float)numChannels, numSamples);
+
+        if (!settings.matchLoudness)
+            peakNormalise(mono.data(), numSamples, settings.perTakePeakDb);
+    }
+
+    if (sampleRate <= 0.0)
+        return juce::Result::fail("No takes loaded from compmap.");
+
+    const int numSegs = (int)segments.size();
+
+    // Per-segment linear gain, applied wherever segment audio is read
+    std::vector<float> gains((size_t)numSegs, 1.0f);
+
+    if (settings.matchLoudness)
+    {
+        std::map<juce::String, std::shared_ptr<TakeLoudness>> loudness;
+
+        for (const auto& entry : takeOffsets)
+            loudness[entry.first] = TakeLoudness::readSidecarFor(phraseDirectory.getChildFile(entry.first + ".wav"));
+
+        // Winners are in memory already, so a missing sidecar is cheap to make
+        for (const auto& [take, mono] : takes)
+        {
+            auto& l = loudness[take];
+
+            if (l == nullptr)
+                l = TakeLoudness::readSidecarFor(phraseDirectory.getChildFile(take + ".wav"));
+
+            if (l == nullptr)
+            {
+                l = LoudnessAnalyser::analyse(mono.data(), (int)mono.size(), sampleRate);
+                l->writeToFile(TakeLoudness::getSidecarFile(phraseDirectory.getChildFile(take + ".wav")));
+            }
+        }
+
+        auto offsetFor = [&takeOffsets](const Segment& seg, const juce::String& take)
+            {
+                if (auto it = seg.takeOffsets.find(take); it != seg.takeOffsets.end())
+                    return it->second;
+
+                if (auto it = takeOffsets.find(take); it != takeOffsets.end())
+                    return it->second;
+
+                return 0.0;
+            };
+
+        for (int i = 0; i < numSegs; ++i)
+        {
+            const auto& seg = segments[(size_t)i];
+            const auto& own = *loudness[seg.take];
+
+            // Level every take has over these words, after its own take gain
+            std::vector<float> levels;
+
+            for (const auto& [take, l] : loudness)
+            {
+                if (l == nullptr)
+                    continue;
+
+                const double offset = offsetFor(seg, take);
+                const float level = l->getLoudness(seg.startSec + offset, seg.endSec + offset);
+
+                if (level > TakeLoudness::silenceLufs)
+                    levels.push_back(level + l->getGainDb());
+            }
+
+            float gainDb = own.getGainDb();
+            const float ownLevel = own.getLoudness(seg.startSec + seg.offsetSec, seg.endSec + seg.offsetSec);
+
+            if (ownLevel > TakeLoudness::silenceLufs && !levels.empty())
+                gainDb += juce::jlimit(-settings.maxSegmentGainDb, settings.maxSegmentGainDb,
+                    median(levels) - (ownLevel + gainDb));
+
+            gains[(size_t)i] = juce::Decibels::decibelsToGain(gainDb);
+        }
+    }
+
+    double phraseEndSec = 0.0;
+    for (const auto& seg : segments)
+        phraseEndSec = juce::jmax(phraseEndSec, seg.endSec);
+
+    const int targetSamples = juce::jmin(juce::roundToInt(phraseEndSec * sampleRate),
+        (int)takes[segments.front().take].size());
+
+    if (targetSamples <= 0)
+        return juce::Result::fail("Output wave is empty after stitching.");
+
+    // Per-segment read offsets: alignment offset, plus the splice refinement below
+    std::vector<int64> offsets((size_t)numSegs);
+    for (int i = 0; i < numSegs; ++i)
+        offsets[(size_t)i] = (int64)std::llround(segments[(size_t)i].offsetSec * sampleRate);
+
+    struct Fade
+    {
+        int start = 0;
+        int length = 0;
+    };
+
+    std::vector<Fade> fades((size_t)juce::jmax(0, numSegs - 1));
+
+    const int maxLag = juce::jmax(1, juce::roundToInt(sampleRate * settings.maxSpliceShiftMs * 0.001));
+    std::vector<float> outgoing, incoming;
+    int   numRefined = 0;
+    int64 refineTicks = 0;
+
+    for (int b = 0; b + 1 < numSegs; ++b)
+    {
+        const auto& prev = segments[(size_t)b];
+        const auto& next = segments[(size_t)b + 1];
+
+        const double d1 = prev.endSec - prev.startSec;
+        const double d2 = next.endSec - next.startSec;
+        const double baseDur = juce::jmin(d1, d2);
+
+        if (baseDur <= 0.0 || settings.fadeFraction <= 0.0)
+            continue;
+
+        const double fadeSec = juce::jmin(juce::jmax(settings.minFadeSec, baseDur * settings.fadeFraction),
+            settings.maxFadeSec, d1 + d2);
+
+        int centre = juce::roundToInt(prev.endSec * sampleRate);
+        const auto& prevTake = takes[prev.take];
+        const auto& nextTake = takes[next.take];
+
+        // Same take, same offset: the audio is already continuous
+        if (prev.take != next.take || offsets[(size_t)b] != offsets[(size_t)b + 1])
+        {
+            const int64 startTicks = juce::Time::getHighResolutionTicks();
+
+            const int window = juce::jlimit(2 * maxLag,
+                juce::jmax(2 * maxLag, juce::roundToInt(fadeSec * sampleRate)),
+                juce::roundToInt(settings.spliceWindowMs * 0.001 * sampleRate));
+
+            outgoing.resize((size_t)window);
+            incoming.resize((size_t)(window + 2 * maxLag));
+
+            const int64 windowStart = (int64)centre - window / 2;
+            readSlice(prevTake, windowStart + offsets[(size_t)b], window, outgoing.data());
+            readSlice(nextTake, windowStart - maxLag + offsets[(size_t)b + 1], window + 2 * maxLag, incoming.data());
+
+            offsets[(size_t)b + 1] += findBestSpliceLag(outgoing.data(), incoming.data(), window, maxLag);
+
+            // Centre the fade where the two (now phase-aligned) waveforms meet
+            const int span = 2 * maxLag + 1;
+            outgoing.resize((size_t)span);
+            incoming.resize((size_t)span);
+
+            readSlice(prevTake, (int64)centre - maxLag + offsets[(size_t)b], span, outgoing.data());
+            readSlice(nextTake, (int64)centre - maxLag + offsets[(size_t)b + 1], span, incoming.data());
+            juce::FloatVectorOperations::multiply(outgoing.data(), gains[(size_t)b], span);
+            juce::FloatVectorOperations::multiply(incoming.data(), gains[(size_t)b + 1], span);
+
+            centre += findSpliceCentre(outgoing.data(), incoming.data(), span) - maxLag;
+
+            refineTicks += juce::Time::getHighResolutionTicks() - startTicks;
+            ++numRefined;
+        }
+
+        const double halfSec = fadeSec * 0.5;
+        const int start = juce::jlimit(0, targetSamples,
+            centre - juce::roundToInt(halfSec * sampleRate));
+        const int end = juce::jlimit(start, targetSamples,
+            centre + juce::roundToInt(halfSec * sampleRate));
+
+        fades[(size_t)b] = { start, end - start };
+    }
+
+    // Hard comp on the reference timeline
+    std::vector<float> out((size_t)targetSamples, 0.0f);
+
+    for (int i = 0; i < numSegs; ++i)
+    {
+        const auto& seg = segments[(size_t)i];
+        const int start = juce::jlimit(0, targetSamples, juce::roundToInt(seg.startSec * sampleRate));
+        const int end = juce::jlimit(start, targetSamples, juce::roundToInt(seg.endSec * sampleRate));
+
+        if (end > start)
+        {
+            readSlice(takes[seg.take], start + offsets[(size_t)i], end - start, out.data() + start);
+            juce::FloatVectorOperations::multiply(out.data() + start, gains[(size_t)i], end - start);
+        }
+    }
+
+    // Linear crossfades around the (refined) boundaries
+    for (int b = 0; b + 1 < numSegs; ++b)
+    {
+        const auto fade = fades[(size_t)b];
+        if (fade.length <= 1)
+            continue;
+
+        outgoing.resize((size_t)fade.length);
+        incoming.resize((size_t)fade.length);
+
+        readSlice(takes[segments[(size_t)b].take], fade.start + offsets[(size_t)b], fade.length, outgoing.data());
+        readSlice(takes[segments[(size_t)b + 1].take], fade.start + offsets[(size_t)b + 1], fade.length, incoming.data());
+        juce::FloatVectorOperations::multiply(outgoing.data(), gains[(size_t)b], fade.length);
+        juce::FloatVectorOperations::multiply(incoming.data(), gains[(size_t)b + 1], fade.length);
+
+        const float step = 1.0f / (float)(fade.length - 1);
+
+        for (int i = 0; i < fade.length; ++i)
+        {
+            const float t = (float)i * step;
+            out[(size_t)(fade.start + i)] = outgoing[(size_t)i] * (1.0f - t) + incoming[(size_t)i] * t;
+        }
+    }
+
+    peakNormalise(out.data(), targetSamples, settings.outputPeakDb);
+    juce::FloatVectorOperations::clip(out.data(), out.data(), -1.0f, 1.0f, targetSamples);
+
+    DBG("CompStitcher: " << numSegs << " segments, " << numRefined << " splices refined in "
+        << juce::String(juce::Time::highResolutionTicksToSeconds(refineTicks) * 1.0e6, 1) << " us");
+
+    // Write via a temporary so a failed write never leaves a truncated comp
+    outFile.getParentDirectory().createDirectory();
+    juce::TemporaryFile temp(outFile);
+
+    {
+        std::unique_ptr<juce::FileOutputStream> outStream(temp.getFile().createOutputStream());
+        if (outStream == nullptr || !outStream->openedOk())
+            return juce::Result::fail("Could not write:\n" + outFile.getFullPathName());
+
+        juce::WavAudioFormat wavFormat;
+        std::unique_ptr<juce::AudioFormatWriter> writer(
+            wavFormat.createWriterFor(outStream.get(), sampleRate, 1, 16, {}, 0));
+
+        if (writer == nullptr)
+            return juce::Result::fail("Could not create a WAV writer for:\n" + outFile.getFullPathName());
+
+        outStream.release();   // owned by the writer now
+
+        const float* channels[] = { out.data() };
+        writer->writeFromFloatArrays(channels, 1, targetSamples);
+    }
+
+    if (!temp.overwriteTargetFileWithTemporary())
+        return juce::Result::fail("Could not replace:\n" + outFile.getFullPathName());
+
+    return juce::Result::ok();
+}
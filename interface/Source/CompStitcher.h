@@ -0,0 +1,54 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+//==============================================================================
+// CompStitcher: native counterpart of src/stitch_from_compmap.py.
+//
+// Reads a compmap JSON, places every winner segment on the reference
+// timeline (at its alignment offset_s) and crossfades at the boundaries.
+// Each splice is refined first: the incoming take is nudged by the lag
+// (within a few ms) that best correlates it with the outgoing take, and the
+// crossfade centre is snapped to where the two waveforms coincide, so short
+// fades neither comb-filter nor click. Correlation uses juce::dsp::SIMDRegister.
+//
+// With matchLoudness, each segment gets its take's loudness gain
+// (take_N.loudness.json) plus a bounded correction towards the median level
+// all takes have over that segment, so a quieter take does not dip the comp.
+//==============================================================================
+
+class CompStitcher
+{
+public:
+    struct Settings
+    {
+        double fadeFraction = 0.15;      // of the shorter adjacent segment
+        double minFadeSec = 0.030;
+        double maxFadeSec = 0.500;
+        double maxSpliceShiftMs = 3.0;   // search range of the phase refinement
+        double spliceWindowMs = 20.0;    // correlation window around the boundary
+        bool   matchLoudness = true;
+        float  maxSegmentGainDb = 6.0f;  // bound of the per-segment correction
+        float  perTakePeakDb = -3.0f;    // used instead when matchLoudness is off
+        float  outputPeakDb = -1.0f;
+    };
+
+    // Takes are read from phraseDirectory/<take_id>.wav at their own sample rate.
+    static juce::Result stitch(const juce::File& compmapFile,
+        const juce::File& phraseDirectory,
+        const juce::File& outFile,
+        const Settings& settings,
+        juce::AudioFormatManager& formatManager);
+
+    // Lag in [-maxLag, maxLag] maximising the normalised correlation of
+    // incoming[maxLag + lag + i] with outgoing[i], i < windowLength.
+    // incoming must hold windowLength + 2 * maxLag samples. 0 if nothing correlates.
+    static int findBestSpliceLag(const float* outgoing,
+        const float* incoming,
+        int windowLength,
+        int maxLag);
+
+    // Index in [0, length) where a and b are closest, preferring the middle.
+    static int findSpliceCentre(const float* a, const float* b, int length);
+};
@@ -0,0 +1,176 @@
+// InputMonitor.cpp
+#include "InputMonitor.h"
+
+using int64 = juce::int64;
+
+namespace
+{
+    void atomicMax(std::atomic<float>& a, float v) noexcept
+    {
+        float old = a.load(std::memory_order_relaxed);
+        while (v > old && !a.compare_exchange_weak(old, v, std::memory_order_relaxed)) {}
+    }
+
+    void atomicAdd(std::atomic<float>& a, float v) noexcept
+    {
+        float old = a.load(std::memory_order_relaxed);
+        while (!a.compare_exchange_weak(old, old + v, std::memory_order_relaxed)) {}
+    }
+}
+
+//==============================================================================
+// Message thread
+//==============================================================================
+
+void InputMonitor::setMonitoring(bool shouldMonitor) noexcept
+{
+    monitoring.store(shouldMonitor);
+}
+
+void InputMonitor::setMonitorGainDb(float gainDb) noexcept
+{
+    monitorGain.store(juce::Decibels::decibelsToGain(gainDb));
+}
+
+int InputMonitor::takeLevels(Level* dest, int maxChannels) noexcept
+{
+    const int n = juce::jmin(maxChannels, numInputsSeen.load());
+
+    for (int ch = 0; ch < n; ++ch)
+    {
+        auto& m = meters[ch];
+        const int count = m.numSamples.exchange(0);
+        const float sumSquares = m.sumSquares.exchange(0.0f);
+
+        dest[ch].peak = m.peak.exchange(0.0f);
+        dest[ch].rms = count > 0 ? std::sqrt(sumSquares / (float)count) : 0.0f;
+        dest[ch].clipped = m.clipped.exchange(false);
+    }
+
+    return n;
+}
+
+void InputMonitor::takeClipRuns(juce::Array<ClipRun>& dest)
+{
+    int start1, size1, start2, size2;
+    clipFifo.prepareToRead(clipFifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1; ++i)
+        dest.add(clipRuns[start1 + i]);
+
+    for (int i = 0; i < size2; ++i)
+        dest.add(clipRuns[start2 + i]);
+
+    clipFifo.finishedRead(size1 + size2);
+}
+
+//==============================================================================
+// Audio device
+//==============================================================================
+
+void InputMonitor::prepare(double sampleRate)
+{
+    // 50 ms ramps when monitoring is switched or its level changed
+    smoothedGain.reset(sampleRate, 0.05);
+    smoothedGain.setCurrentAndTargetValue(monitoring.load() ? monitorGain.load() : 0.0f);
+}
+
+//==============================================================================
+// Audio thread
+//==============================================================================
+
+void InputMonitor::measure(const juce::AudioBuffer<float>& buffer, int start, int num,
+    int numInputs, int64 timelineStart) noexcept
+{
+    numInputs = juce::jmin(numInputs, maxInputs, buffer.getNumChannels());
+    numInputsSeen.store(numInputs);
+
+    for (int ch = 0; ch < numInputs; ++ch)
+    {
+        const float* x = buffer.getReadPointer(ch, start);
+        const auto range = juce::FloatVectorOperations::findMinAndMax(x, num);
+        const float peak = juce::jmax(-range.getStart(), range.getEnd());
+
+        float sumSquares = 0.0f;
+        for (int i = 0; i < num; ++i)
+            sumSquares += x[i] * x[i];
+
+        auto& m = meters[ch];
+        atomicMax(m.peak, peak);
+        atomicAdd(m.sumSquares, sumSquares);
+        m.numSamples.fetch_add(num);
+
+        if (peak >= clipLevel)
+            m.clipped.store(true);
+    }
+
+    if (timelineStart < 0)
+    {
+        // Not recording: a run in progress ends with the recording
+        endClipRun();
+        return;
+    }
+
+    for (int i = 0; i < num; ++i)
+    {
+        float level = 0.0f;
+        for (int ch = 0; ch < numInputs; ++ch)
+            level = juce::jmax(level, std::abs(buffer.getSample(ch, start + i)));
+
+        if (level >= clipLevel)
+        {
+            if (!inClipRun)
+            {
+                inClipRun = true;
+                currentRun = { timelineStart + i, 0, 0.0f };
+            }
+
+            ++currentRun.numSamples;
+            currentRun.peak = juce::jmax(currentRun.peak, level);
+        }
+        else if (inClipRun)
+        {
+            endClipRun();
+        }
+    }
+}
+
+void InputMonitor::endClipRun() noexcept
+{
+    if (!inClipRun)
+        return;
+
+    inClipRun = false;
+
+    if (clipFifo.getFreeSpace() < 1)
+    {
+        droppedClipRuns.fetch_add(1);
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    clipFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    clipRuns[size1 > 0 ? start1 : start2] = currentRun;
+    clipFifo.finishedWrite(1);
+}
+
+void InputMonitor::addMonitor(const float* monoInput, juce::AudioBuffer<float>& output,
+    int start, int num) noexcept
+{
+    smoothedGain.setTargetValue(monitoring.load() ? monitorGain.load() : 0.0f);
+
+    // Off and faded out: nothing to add
+    if (!smoothedGain.isSmoothing() && smoothedGain.getTargetValue() == 0.0f)
+        return;
+
+    const int numOut = output.getNumChannels();
+
+    for (int i = 0; i < num; ++i)
+    {
+        const float s = monoInput[i] * smoothedGain.getNextValue();
+
+        for (int ch = 0; ch < numOut; ++ch)
+            output.addSample(ch, start + i, s);
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+//==============================================================================
+// InputMonitor: what the audio thread sees of the inputs.
+//
+// - Meters: peak, RMS and clipping per input channel, accumulated by the
+//   audio thread in atomics and taken (and reset) by the UI once per frame.
+// - Clip runs: while recording, every run of samples at or above clipLevel
+//   on any input is queued with its position on the vocal timeline, so take
+//   metadata can carry them instead of analysis rescanning the audio.
+// - Direct monitoring: the mono input mix added to the output in the same
+//   callback, with a smoothed gain so switching it is click-free.
+//
+// Nothing here locks or allocates on the audio thread.
+//==============================================================================
+
+class InputMonitor
+{
+public:
+    static constexpr int maxInputs = 8;
+    static constexpr float clipLevel = 0.999f;   // features.clip_count uses the same
+    static constexpr int clipQueueSize = 1024;
+
+    struct Level
+    {
+        float peak = 0.0f;
+        float rms = 0.0f;
+        bool  clipped = false;
+    };
+
+    struct ClipRun
+    {
+        juce::int64 startSample = 0;   // on the vocal timeline (totalRecordedSamples)
+        int         numSamples = 0;
+        float       peak = 0.0f;
+    };
+
+    InputMonitor() = default;
+
+    // --- Message thread ---
+    void setMonitoring(bool shouldMonitor) noexcept;
+    bool isMonitoring() const noexcept { return monitoring.load(); }
+    void setMonitorGainDb(float gainDb) noexcept;
+
+    // Levels since the last call, one per input; returns the number of inputs.
+    int takeLevels(Level* dest, int maxChannels) noexcept;
+
+    // Appends the clip runs finished since the last call.
+    void takeClipRuns(juce::Array<ClipRun>& dest);
+    int getNumDroppedClipRuns() const noexcept { return droppedClipRuns.load(); }
+
+    // --- Audio device (the callback is not running) ---
+    void prepare(double sampleRate);
+
+    // --- Audio thread ---
+    // Meters input channels [0, numInputs) of buffer. timelineStart is the
+    // vocal timeline position of the first sample while recording, else -1.
+    void measure(const juce::AudioBuffer<float>& buffer, int start, int num,
+        int numInputs, juce::int64 timelineStart) noexcept;
+
+    // Adds monoInput at the monitor gain to every channel of output.
+    void addMonitor(const float* monoInput, juce::AudioBuffer<float>& output,
+        int start, int num) noexcept;
+
+private:
+    struct Meter
+    {
+        std::atomic<float> peak{ 0.0f };
+        std::atomic<float> sumSquares{ 0.0f };
+        std::atomic<int>   numSamples{ 0 };
+        std::atomic<bool>  clipped{ false };
+    };
+
+    void endClipRun() noexcept;
+
+    Meter meters[maxInputs];
+    std::atomic<int> numInputsSeen{ 0 };
+
+    std::atomic<bool>  monitoring{ false };
+    std::atomic<float> monitorGain{ 1.0f };
+    juce::SmoothedValue<float> smoothedGain;   // audio thread
+
+    // Audio thread: the run being extended
+    bool    inClipRun = false;
+    ClipRun currentRun;
+
+    juce::AbstractFifo clipFifo{ clipQueueSize };
+    ClipRun clipRuns[clipQueueSize];
+    std::atomic<int> droppedClipRuns{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(InputMonitor)
+};
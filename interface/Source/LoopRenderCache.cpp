@@ -0,0 +1,271 @@
+// LoopRenderCache.cpp
+#include "LoopRenderCache.h"
+#include "SincResampler.h"
+
+using int64 = juce::int64;
+
+static_assert(std::atomic<double>::is_always_lock_free
+    && std::atomic<int64>::is_always_lock_free,
+    "LoopRenderCache shares its rate and position with the audio thread");
+
+//==============================================================================
+
+LoopRenderCache::LoopRenderCache(juce::AudioFormatReaderSource& streamingSource,
+    std::unique_ptr<juce::AudioFormatReader> renderReader)
+    : juce::Thread("Loop render"),
+      streaming(streamingSource),
+      resampler(&streamingSource, false, 2),
+      reader(std::move(renderReader)),
+      sourceRate(streamingSource.getAudioFormatReader()->sampleRate),
+      numChannels(juce::jlimit(1, 2, (int)streamingSource.getAudioFormatReader()->numChannels))
+{
+    startThread();
+}
+
+LoopRenderCache::~LoopRenderCache()
+{
+    stopThread(4000);
+
+    // The transport has let go of us: everything left is ours to delete
+    delete current;
+    current = nullptr;
+    delete pendingRegion.exchange(nullptr);
+    deleteRetiredRegions();
+}
+
+//==============================================================================
+// Message thread
+//==============================================================================
+
+void LoopRenderCache::setLoopRange(double startSeconds, double endSeconds)
+{
+    {
+        const juce::ScopedLock sl(requestLock);
+
+        if (startSeconds == requestedStartSec && endSeconds == requestedEndSec)
+            return;
+
+        requestedStartSec = startSeconds;
+        requestedEndSec = endSeconds;
+        ++requestGeneration;
+    }
+
+    regionReady.store(false);
+    notify();
+}
+
+int64 LoopRenderCache::getTotalLength() const
+{
+    const double rate = deviceRate.load();
+    const int64 sourceLength = streaming.getTotalLength();
+
+    return rate > 0.0 ? (int64)std::llround((double)sourceLength * rate / sourceRate)
+                      : sourceLength;
+}
+
+//==============================================================================
+// Audio device
+//==============================================================================
+
+void LoopRenderCache::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    // Twice the expected block, like the other buffers the callback uses
+    resampler.setResamplingRatio(sourceRate / sampleRate);
+    resampler.prepareToPlay(samplesPerBlockExpected * 2, sampleRate);
+    streamingNextPosition = -1;
+
+    if (sampleRate != deviceRate.load())
+    {
+        // Whatever is in RAM is at the old rate
+        deviceRate.store(sampleRate);
+        ++requestGeneration;
+        regionReady.store(false);
+        notify();
+    }
+}
+
+void LoopRenderCache::releaseResources()
+{
+    resampler.releaseResources();
+}
+
+//==============================================================================
+// Audio thread
+//==============================================================================
+
+void LoopRenderCache::getNextAudioBlock(const juce::AudioSourceChannelInfo& info)
+{
+    // Swap in a newer region; the old one goes back for the render thread to delete
+    if (retireFifo.getFreeSpace() > 0)
+    {
+        if (auto* newer = pendingRegion.exchange(nullptr))
+        {
+            if (current != nullptr)
+            {
+                int start1, size1, start2, size2;
+                retireFifo.prepareToWrite(1, start1, size1, start2, size2);
+                retired[size1 > 0 ? start1 : start2] = current;
+                retireFifo.finishedWrite(1);
+            }
+
+            current = newer;
+        }
+    }
+
+    int64 pos = nextReadPosition.load();
+    const int num = info.numSamples;
+    const double rate = deviceRate.load();
+
+    if (current != nullptr && current->sampleRate == rate
+        && pos >= current->start && pos + num <= current->end())
+    {
+        const int offset = (int)(pos - current->start);
+
+        for (int ch = 0; ch < info.buffer->getNumChannels(); ++ch)
+            info.buffer->copyFrom(ch, info.startSample, current->audio,
+                juce::jmin(ch, current->audio.getNumChannels() - 1), offset, num);
+    }
+    else
+    {
+        // Outside the region, or not rendered yet: stream and resample as before
+        if (pos != streamingNextPosition)
+        {
+            streaming.setNextReadPosition((int64)std::llround((double)pos * sourceRate / rate));
+            resampler.flushBuffers();
+        }
+
+        resampler.getNextAudioBlock(info);
+        streamingNextPosition = pos + num;
+    }
+
+    // Unless the transport moved us meanwhile
+    nextReadPosition.compare_exchange_strong(pos, pos + num);
+}
+
+//==============================================================================
+// Render thread
+//==============================================================================
+
+void LoopRenderCache::run()
+{
+    juce::uint32 renderedGeneration = 0;
+    bool rendered = false;
+
+    while (!threadShouldExit())
+    {
+        deleteRetiredRegions();
+
+        const juce::uint32 generation = requestGeneration.load();
+
+        if (rendered && generation == renderedGeneration)
+        {
+            wait(250);
+            continue;
+        }
+
+        double startSec, endSec;
+        {
+            const juce::ScopedLock sl(requestLock);
+            startSec = requestedStartSec;
+            endSec = requestedEndSec;
+        }
+
+        const double rate = deviceRate.load();
+
+        if (reader == nullptr || rate <= 0.0 || endSec <= startSec || endSec - startSec > maxRegionSeconds)
+        {
+            // Nothing to render (or too long to keep in RAM): stream
+            renderedGeneration = generation;
+            rendered = true;
+            continue;
+        }
+
+        const int64 start = juce::jmax<int64>(0, (int64)std::floor((startSec - handleSeconds) * rate));
+        const int64 end = juce::jmin(getTotalLength(), (int64)std::ceil((endSec + handleSeconds) * rate));
+
+        if (end <= start)
+        {
+            renderedGeneration = generation;
+            rendered = true;
+            continue;
+        }
+
+        if (lastRendered == nullptr || lastRendered->sampleRate != rate
+            || lastRendered->start != start || lastRendered->end() != end)
+        {
+            auto region = render(start, end, rate, generation);
+
+            if (region == nullptr)
+                continue;   // a newer request came in
+
+            // One the audio thread never picked up can go straight away
+            delete pendingRegion.exchange(region.get());
+            lastRendered = region.release();
+            regionBytes.store((size_t)lastRendered->audio.getNumChannels()
+                * (size_t)lastRendered->audio.getNumSamples() * sizeof(float));
+        }
+
+        renderedGeneration = generation;
+        rendered = true;
+        regionReady.store(requestGeneration.load() == generation);
+    }
+}
+
+std::unique_ptr<LoopRenderCache::Region> LoopRenderCache::render(int64 start, int64 end,
+    double rate, juce::uint32 generation)
+{
+    auto region = std::make_unique<Region>();
+    region->sampleRate = rate;
+    region->start = start;
+    region->audio.setSize(numChannels, (int)(end - start));
+
+    // The part the last region already has is copied, only the rest is rendered
+    int64 keepFrom = start, keepTo = start;
+
+    if (lastRendered != nullptr && lastRendered->sampleRate == rate)
+    {
+        keepFrom = juce::jmax(start, lastRendered->start);
+        keepTo = juce::jmin(end, lastRendered->end());
+
+        if (keepTo > keepFrom)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+                region->audio.copyFrom(ch, (int)(keepFrom - start), lastRendered->audio,
+                    juce::jmin(ch, lastRendered->audio.getNumChannels() - 1),
+                    (int)(keepFrom - lastRendered->start), (int)(keepTo - keepFrom));
+        }
+        else
+        {
+            keepFrom = keepTo = start;
+        }
+    }
+
+    // Given up as soon as a newer request comes in
+    auto superseded = [this, generation]
+        {
+            return threadShouldExit() || requestGeneration.load() != generation;
+        };
+
+    if (!SincResampler::render(*reader, rate, start, keepFrom, region->audio, 0, superseded)
+        || !SincResampler::render(*reader, rate, keepTo, end, region->audio, (int)(keepTo - start), superseded))
+        return nullptr;
+
+    DBG("LoopRenderCache: " << (end - start) << " samples at " << rate << " Hz, rendered "
+        << (end - start) - (keepTo - keepFrom));
+
+    return region;
+}
+
+void LoopRenderCache::deleteRetiredRegions()
+{
+    int start1, size1, start2, size2;
+    retireFifo.prepareToRead(retireFifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1; ++i)
+        delete retired[start1 + i];
+
+    for (int i = 0; i < size2; ++i)
+        delete retired[start2 + i];
+
+    retireFifo.finishedRead(size1 + size2);
+}
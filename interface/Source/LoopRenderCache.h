@@ -0,0 +1,92 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+
+//==============================================================================
+// LoopRenderCache: the instrumental, as the transport's source, with the
+// loop region (plus handles either side) decoded and resampled to the device
+// rate once, on a background thread, into RAM (SincResampler).
+//
+// Positions are in device-rate samples, so the transport is given this with
+// no rate to correct for and never resamples. Inside the rendered region a
+// block is a copy; anywhere else (or until the region is ready) it streams
+// from the reader through a ResamplingAudioSource, as the transport did.
+//
+// Moving the loop only renders the part not already in RAM; the overlap is
+// copied from the previous region. Regions are handed to the audio thread
+// through an atomic pointer and handed back through a FIFO, so the audio
+// thread never allocates or frees one.
+//==============================================================================
+
+class LoopRenderCache : public juce::PositionableAudioSource,
+    private juce::Thread
+{
+public:
+    static constexpr double handleSeconds = 1.0;       // rendered either side of the loop
+    static constexpr double maxRegionSeconds = 180.0;  // longer loops just stream
+    static constexpr int retireQueueSize = 16;
+
+    // streamingSource is the fallback (and must outlive this); renderReader
+    // is a second reader on the same file, used only by the render thread.
+    LoopRenderCache(juce::AudioFormatReaderSource& streamingSource,
+        std::unique_ptr<juce::AudioFormatReader> renderReader);
+    ~LoopRenderCache() override;
+
+    // --- Message thread ---
+    void setLoopRange(double startSeconds, double endSeconds);
+    bool isRegionReady() const noexcept { return regionReady.load(); }
+    size_t getMemoryUsage() const noexcept { return regionBytes.load(); }
+
+    // --- PositionableAudioSource ---
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+    void releaseResources() override;
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& info) override;
+
+    void setNextReadPosition(juce::int64 newPosition) override { nextReadPosition.store(newPosition); }
+    juce::int64 getNextReadPosition() const override { return nextReadPosition.load(); }
+    juce::int64 getTotalLength() const override;
+    bool isLooping() const override { return false; }
+
+private:
+    struct Region
+    {
+        double sampleRate = 0.0;                // device rate it was rendered for
+        juce::int64 start = 0;                  // device samples
+        juce::AudioBuffer<float> audio;
+
+        juce::int64 end() const noexcept { return start + audio.getNumSamples(); }
+    };
+
+    void run() override;
+    std::unique_ptr<Region> render(juce::int64 start, juce::int64 end, double rate, juce::uint32 generation);
+    void deleteRetiredRegions();
+
+    juce::AudioFormatReaderSource& streaming;
+    juce::ResamplingAudioSource resampler;
+    std::unique_ptr<juce::AudioFormatReader> reader;   // render thread
+    const double sourceRate;
+    const int numChannels;
+
+    // Requests, from the message thread / device
+    juce::CriticalSection requestLock;
+    double requestedStartSec = 0.0, requestedEndSec = 0.0;
+    std::atomic<double> deviceRate{ 0.0 };
+    std::atomic<juce::uint32> requestGeneration{ 0 };
+
+    // Render thread -> audio thread -> render thread
+    std::atomic<Region*> pendingRegion{ nullptr };
+    juce::AbstractFifo retireFifo{ retireQueueSize };
+    Region* retired[retireQueueSize] = {};
+    const Region* lastRendered = nullptr;               // render thread; never retired yet
+    std::atomic<bool> regionReady{ false };
+    std::atomic<size_t> regionBytes{ 0 };               // of lastRendered
+
+    // Audio thread
+    Region* current = nullptr;
+    std::atomic<juce::int64> nextReadPosition{ 0 };
+    juce::int64 streamingNextPosition = -1;             // where the fallback left off
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoopRenderCache)
+};
@@ -0,0 +1,327 @@
+// LoudnessAnalyser.cpp
+#include "LoudnessAnalyser.h"
+
+using int64 = juce::int64;
+
+namespace
+{
+    constexpr float absoluteGateLufs = -70.0f;
+    constexpr float relativeGateLu = 10.0f;
+
+    double lufsToPower(float lufs)     { return std::pow(10.0, ((double)lufs + 0.691) / 10.0); }
+    float  powerToLufs(double power)
+    {
+        return power > 0.0 ? juce::jmax(TakeLoudness::silenceLufs, (float)(-0.691 + 10.0 * std::log10(power)))
+                           : TakeLoudness::silenceLufs;
+    }
+
+    // BS.1770 gating over 400 ms blocks (4 x 100 ms, 75 % overlap) in [first, last)
+    float gatedLoudness(const std::vector<float>& blockLufs, int first, int last)
+    {
+        first = juce::jmax(0, first);
+        last = juce::jmin((int)blockLufs.size(), last);
+
+        if (last <= first)
+            return TakeLoudness::silenceLufs;
+
+        const int span = juce::jmin(4, last - first);   // short ranges gate what they have
+        std::vector<double> gatingBlocks;
+
+        for (int i = first; i + span <= last; ++i)
+        {
+            double power = 0.0;
+            for (int j = i; j < i + span; ++j)
+                power += lufsToPower(blockLufs[(size_t)j]);
+
+            gatingBlocks.push_back(power / span);
+        }
+
+        auto meanAbove = [&gatingBlocks](double threshold)
+            {
+                double sum = 0.0;
+                int count = 0;
+
+                for (double p : gatingBlocks)
+                {
+                    if (p > threshold)
+                    {
+                        sum += p;
+                        ++count;
+                    }
+                }
+
+                return count > 0 ? sum / count : 0.0;
+            };
+
+        const double ungated = meanAbove(lufsToPower(absoluteGateLufs));
+        if (ungated <= 0.0)
+            return TakeLoudness::silenceLufs;
+
+        return powerToLufs(meanAbove(lufsToPower(powerToLufs(ungated) - relativeGateLu)));
+    }
+
+    double sumOfSquares(const float* data, int numSamples)
+    {
+        using Vec = juce::dsp::SIMDRegister<float>;
+
+        const float* p = data;
+        const float* end = data + numSamples;
+        const float* aligned = juce::jmin<const float*>(Vec::getNextSIMDAlignedPtr(const_cast<float*>(data)), end);
+
+        double sum = 0.0;
+        for (; p < aligned; ++p)
+            sum += *p * *p;
+
+        auto acc = Vec::expand(0.0f);
+        for (; p + Vec::SIMDNumElements <= end; p += Vec::SIMDNumElements)
+        {
+            const auto v = Vec::fromRawArray(p);
+            acc += v * v;
+        }
+
+        sum += acc.sum();
+
+        for (; p < end; ++p)
+            sum += *p * *p;
+
+        return sum;
+    }
+
+    // K-weighting stage 1: high shelf (+4 dB above ~1.7 kHz), for any sample rate
+    juce::dsp::IIR::Coefficients<float>::Ptr makeShelf(double sampleRate)
+    {
+        const double f0 = 1681.974450955533;
+        const double gainDb = 3.999843853973347;
+        const double q = 0.7071752369554196;
+
+        const double k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+        const double vh = std::pow(10.0, gainDb / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+
+        return new juce::dsp::IIR::Coefficients<float>((float)(vh + vb * k / q + k * k),
+            (float)(2.0 * (k * k - vh)),
+            (float)(vh - vb * k / q + k * k),
+            (float)(1.0 + k / q + k * k),
+            (float)(2.0 * (k * k - 1.0)),
+            (float)(1.0 - k / q + k * k));
+    }
+
+    // K-weighting stage 2: RLB high-pass (~38 Hz)
+    juce::dsp::IIR::Coefficients<float>::Ptr makeHighPass(double sampleRate)
+    {
+        const double f0 = 38.13547087602444;
+        const double q = 0.5003270373238773;
+        const double k = std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+
+        return new juce::dsp::IIR::Coefficients<float>(1.0f, -2.0f, 1.0f,
+            (float)(1.0 + k / q + k * k),
+            (float)(2.0 * (k * k - 1.0)),
+            (float)(1.0 - k / q + k * k));
+    }
+}
+
+//==============================================================================
+// TakeLoudness
+//==============================================================================
+
+TakeLoudness::TakeLoudness(double seconds, std::vector<float> lufs)
+    : blockSeconds(seconds > 0.0 ? seconds : 0.1),
+      blockLufs(std::move(lufs)),
+      integratedLufs(gatedLoudness(blockLufs, 0, (int)blockLufs.size()))
+{
+}
+
+float TakeLoudness::getLoudness(double startSec, double endSec) const
+{
+    return gatedLoudness(blockLufs,
+        (int)std::floor(startSec / blockSeconds),
+        (int)std::ceil(endSec / blockSeconds));
+}
+
+float TakeLoudness::getGainDb() const
+{
+    if (integratedLufs <= absoluteGateLufs)
+        return 0.0f;
+
+    return juce::jlimit(-maxTakeGainDb, maxTakeGainDb, targetLufs - integratedLufs);
+}
+
+void TakeLoudness::setClips(std::vector<juce::Range<double>> clipRanges)
+{
+    clips = std::move(clipRanges);
+    clipsKnown = true;
+}
+
+bool TakeLoudness::writeToFile(const juce::File& file) const
+{
+    juce::Array<juce::var> blocks;
+    blocks.ensureStorageAllocated((int)blockLufs.size());
+
+    for (float l : blockLufs)
+        blocks.add(std::round(l * 100.0f) / 100.0f);
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("block_s", blockSeconds);
+    root->setProperty("integrated_lufs", integratedLufs);
+    root->setProperty("target_lufs", targetLufs);
+    root->setProperty("gain_db", getGainDb());
+    root->setProperty("block_lufs", blocks);
+
+    if (clipsKnown)
+    {
+        juce::Array<juce::var> clipList;
+
+        for (const auto& c : clips)
+            clipList.add(juce::Array<juce::var>{ c.getStart(), c.getEnd() });
+
+        root->setProperty("clips_s", clipList);
+    }
+
+    return file.replaceWithText(juce::JSON::toString(juce::var(root), true));
+}
+
+std::shared_ptr<TakeLoudness> TakeLoudness::readFromFile(const juce::File& file)
+{
+    if (!file.existsAsFile())
+        return nullptr;
+
+    const auto root = juce::JSON::parse(file);
+    const double seconds = (double)root.getProperty("block_s", 0.0);
+    const auto* blocks = root.getProperty("block_lufs", {}).getArray();
+
+    if (seconds <= 0.0 || blocks == nullptr)
+        return nullptr;
+
+    std::vector<float> lufs;
+    lufs.reserve((size_t)blocks->size());
+
+    for (const auto& b : *blocks)
+        lufs.push_back((float)b);
+
+    auto result = std::make_shared<TakeLoudness>(seconds, std::move(lufs));
+
+    if (const auto* clipList = root.getProperty("clips_s", {}).getArray())
+    {
+        std::vector<juce::Range<double>> clipRanges;
+
+        for (const auto& c : *clipList)
+            if (c.isArray() && c.size() == 2)
+                clipRanges.push_back({ (double)c[0], (double)c[1] });
+
+        result->setClips(std::move(clipRanges));
+    }
+
+    return result;
+}
+
+juce::File TakeLoudness::getSidecarFile(const juce::File& takeFile)
+{
+    return takeFile.withFileExtension("loudness.json");
+}
+
+std::shared_ptr<TakeLoudness> TakeLoudness::readSidecarFor(const juce::File& takeFile)
+{
+    const auto sidecar = getSidecarFile(takeFile);
+
+    if (!sidecar.existsAsFile()
+        || sidecar.getLastModificationTime() < takeFile.getLastModificationTime())
+        return nullptr;
+
+    return readFromFile(sidecar);
+}
+
+//==============================================================================
+// LoudnessAnalyser
+//==============================================================================
+
+LoudnessAnalyser::LoudnessAnalyser(double rate)
+    : sampleRate(rate > 0.0 ? rate : 44100.0),
+      blockSize(juce::jmax(1, juce::roundToInt(sampleRate * 0.1)))
+{
+    shelf.coefficients = makeShelf(sampleRate);
+    highPass.coefficients = makeHighPass(sampleRate);
+}
+
+void LoudnessAnalyser::process(const float* samples, int numSamples)
+{
+    if (samples == nullptr || numSamples <= 0)
+        return;
+
+    scratch.assign(samples, samples + numSamples);
+
+    float* channels[] = { scratch.data() };
+    juce::dsp::AudioBlock<float> block(channels, 1, (size_t)numSamples);
+    juce::dsp::ProcessContextReplacing<float> context(block);
+
+    shelf.process(context);
+    highPass.process(context);
+
+    // Mean square per 100 ms block
+    int pos = 0;
+    while (pos < numSamples)
+    {
+        const int n = juce::jmin(blockSize - blockFill, numSamples - pos);
+
+        blockSum += sumOfSquares(scratch.data() + pos, n);
+        blockFill += n;
+        pos += n;
+
+        if (blockFill == blockSize)
+        {
+            blockLufs.push_back(powerToLufs(blockSum / blockSize));
+            blockSum = 0.0;
+            blockFill = 0;
+        }
+    }
+}
+
+std::shared_ptr<TakeLoudness> LoudnessAnalyser::getResult() const
+{
+    auto blocks = blockLufs;
+
+    if (blockFill > 0)
+        blocks.push_back(powerToLufs(blockSum / blockFill));
+
+    return std::make_shared<TakeLoudness>((double)blockSize / sampleRate, std::move(blocks));
+}
+
+std::shared_ptr<TakeLoudness> LoudnessAnalyser::analyse(juce::AudioFormatReader& reader,
+    const std::function<bool()>& shouldExit)
+{
+    LoudnessAnalyser analyser(reader.sampleRate);
+
+    const int   numChannels = juce::jmax(1, (int)reader.numChannels);
+    const int   chunkSize = 65536;
+    const int64 totalSamples = reader.lengthInSamples;
+
+    juce::AudioBuffer<float> chunk(numChannels, chunkSize);
+
+    for (int64 pos = 0; pos < totalSamples; pos += chunkSize)
+    {
+        if (shouldExit != nullptr && shouldExit())
+            return nullptr;
+
+        const int n = (int)juce::jmin<int64>(chunkSize, totalSamples - pos);
+
+        reader.read(&chunk, 0, n, pos, true, true);
+
+        if (numChannels > 1)
+        {
+            for (int ch = 1; ch < numChannels; ++ch)
+                chunk.addFrom(0, 0, chunk, ch, 0, n);
+
+            chunk.applyGain(0, 0, n, 1.0f / (float)numChannels);
+        }
+
+        analyser.process(chunk.getReadPointer(0), n);
+    }
+
+    return analyser.getResult();
+}
+
+std::shared_ptr<TakeLoudness> LoudnessAnalyser::analyse(const float* samples, int numSamples, double sampleRate)
+{
+    LoudnessAnalyser analyser(sampleRate);
+    analyser.process(samples, numSamples);
+    return analyser.getResult();
+}
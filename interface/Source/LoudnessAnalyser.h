@@ -0,0 +1,99 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// TakeLoudness: K-weighted loudness of one take (ITU-R BS.1770 style).
+//
+// Stored as the loudness of consecutive 100 ms blocks, so the loudness of any
+// time range (a comp segment) can be derived later with the usual 400 ms
+// gating. Saved as take_N.loudness.json next to the take, which the Python
+// pipeline reads as well. Takes recorded here also carry the input clips
+// the audio callback saw, so analysis does not have to look for them.
+//==============================================================================
+
+class TakeLoudness
+{
+public:
+    static constexpr float targetLufs = -20.0f;    // level takes are matched to
+    static constexpr float maxTakeGainDb = 12.0f;
+    static constexpr float silenceLufs = -120.0f;
+
+    TakeLoudness(double blockSeconds, std::vector<float> blockLufs);
+
+    double getBlockSeconds() const noexcept { return blockSeconds; }
+    float  getIntegratedLufs() const noexcept { return integratedLufs; }
+
+    // Gated loudness of [startSec, endSec); silenceLufs if nothing passes the gate.
+    float getLoudness(double startSec, double endSec) const;
+
+    // Gain bringing the whole take to targetLufs (0 for silent takes).
+    float getGainDb() const;
+
+    // Clipped input, in seconds from the start of the take. hasClips() is
+    // false when the take was not recorded live (nothing is known either way).
+    void setClips(std::vector<juce::Range<double>> clipRanges);
+    bool hasClips() const noexcept { return clipsKnown; }
+    const std::vector<juce::Range<double>>& getClips() const noexcept { return clips; }
+
+    size_t getMemoryUsage() const noexcept
+    {
+        return blockLufs.capacity() * sizeof(float) + clips.capacity() * sizeof(juce::Range<double>);
+    }
+
+    bool writeToFile(const juce::File& file) const;
+    static std::shared_ptr<TakeLoudness> readFromFile(const juce::File& file);
+
+    // take_N.wav -> take_N.loudness.json
+    static juce::File getSidecarFile(const juce::File& takeFile);
+
+    // The take's sidecar, if there is one at least as new as the take.
+    static std::shared_ptr<TakeLoudness> readSidecarFor(const juce::File& takeFile);
+
+private:
+    const double blockSeconds;
+    const std::vector<float> blockLufs;
+    const float integratedLufs;
+
+    bool clipsKnown = false;
+    std::vector<juce::Range<double>> clips;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TakeLoudness)
+};
+
+//==============================================================================
+// LoudnessAnalyser: K-weighting filter + 100 ms mean-square blocks.
+//==============================================================================
+
+class LoudnessAnalyser
+{
+public:
+    explicit LoudnessAnalyser(double sampleRate);
+
+    // Mono samples, any block size.
+    void process(const float* samples, int numSamples);
+
+    // Loudness of everything processed so far (a partial last block included).
+    std::shared_ptr<TakeLoudness> getResult() const;
+
+    // Whole file, mixed to mono. Returns nullptr if shouldExit() turned true.
+    static std::shared_ptr<TakeLoudness> analyse(juce::AudioFormatReader& reader,
+        const std::function<bool()>& shouldExit);
+
+    // Same analysis for audio already in memory.
+    static std::shared_ptr<TakeLoudness> analyse(const float* samples, int numSamples, double sampleRate);
+
+private:
+    const double sampleRate;
+    const int    blockSize;   // 100 ms
+
+    juce::dsp::IIR::Filter<float> shelf, highPass;
+    std::vector<float> scratch;
+
+    std::vector<float> blockLufs;
+    double blockSum = 0.0;
+    int    blockFill = 0;
+};
@@ -25,7 +25,9 @@ public:
     {
         // This method is where you should put your application's initialisation code..
 
-        mainWindow.reset (new MainWindow (getApplicationName()));
+        mainWindow.reset (new MainWindow (getApplicationName(),
+                                          ReplaySettings::fromCommandLine (commandLine),
+                                          SessionGenerator::Settings::fromCommandLine (commandLine)));
     }
 
     void shutdown() override
@@ -58,14 +60,15 @@ public:
     class MainWindow    : public juce::DocumentWindow
     {
     public:
-        MainWindow (juce::String name)
+        MainWindow (juce::String name, const ReplaySettings& replay,
+                    const SessionGenerator::Settings& scaleTest)
             : DocumentWindow (name,
                               juce::Desktop::getInstance().getDefaultLookAndFeel()
                                                           .findColour (juce::ResizableWindow::backgroundColourId),
                               DocumentWindow::allButtons)
         {
             setUsingNativeTitleBar (true);
-            setContentOwned (new MainComponent(), true);
+            setContentOwned (new MainComponent (replay, scaleTest), true);
 
            #if JUCE_IOS || JUCE_ANDROID
             setFullScreen (true);
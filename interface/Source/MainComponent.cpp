@@ -111,7 +111,7 @@ void CompingProgressComponent::resized()
 
 
 
-MainComponent::MainComponent()
+MainComponent::MainComponent(const ReplaySettings& replay, const SessionGenerator::Settings& scaleTest)
 {
     setLookAndFeel(&neonLookAndFeel);
 
@@ -121,9 +121,59 @@ MainComponent::MainComponent()
     // --- Audio setup ---
     formatManager.registerBasicFormats(); // WAV, AIFF, etc.
 
+    // Recorded takes beyond the budget spill to disk (AICOMP_TAKE_MEMORY_MB, default 256)
+    const int takeMemoryMb = juce::SystemStats::getEnvironmentVariable("AICOMP_TAKE_MEMORY_MB", "256").getIntValue();
+    vocalStore.setMemoryBudget((size_t)juce::jmax(16, takeMemoryMb) * 1024 * 1024);
+    vocalStore.setSpillDirectory(juce::File::getSpecialLocation(juce::File::tempDirectory)
+        .getChildFile("AI-Comp-Interface"));
+
+    // Device buffer size from measured load (AICOMP_BUFFER_CONTROL: off, suggest or apply)
+    bufferSizeController.setMode(BufferSizeController::modeFromString(
+        juce::SystemStats::getEnvironmentVariable("AICOMP_BUFFER_CONTROL", "suggest")));
+
+    bufferSizeController.onSuggestion = [this](int bufferSize, const juce::String& reason)
+        {
+            auto* device = deviceManager.getCurrentAudioDevice();
+            const bool differs = device != nullptr && bufferSize != device->getCurrentBufferSizeSamples();
+
+            ioButton.setButtonText(differs ? "IN/OUT *" : "IN/OUT");
+            ioButton.setTooltip(differs ? bufferSizeController.getStatusText() + " (" + reason + ")"
+                                        : juce::String());
+        };
+
+    // A replay run gets the replay device and nothing else, so no sound card is opened
+    if (replay.isEnabled())
+    {
+        replayProjectFile = replay.projectFile;
+
+        deviceManager.addAudioDeviceType(std::make_unique<ReplayAudioIODeviceType>(replay,
+            [this](const juce::String& action) { runReplayAction(action); },
+            [quit = replay.quitWhenDone]
+            {
+                if (quit)
+                    juce::JUCEApplicationBase::quit();
+            }));
+    }
+
     // 1 input (for mic), 2 outputs
     setAudioChannels(1, 2);
 
+    // Memory panel (AICOMP_MEMORY_PANEL=1; on by default in debug builds)
+   #if JUCE_DEBUG
+    const juce::String memoryPanelDefault{ "1" };
+   #else
+    const juce::String memoryPanelDefault{ "0" };
+   #endif
+    addChildComponent(memoryPanel);
+    memoryPanel.setVisible(juce::SystemStats::getEnvironmentVariable("AICOMP_MEMORY_PANEL",
+        memoryPanelDefault).getIntValue() != 0);
+    memoryPanel.setTooltip("Click to reset the peaks");
+    memoryPanel.onClick = [this]
+        {
+            memoryRegistry.resetPeaks();
+            memoryPanel.setLines(memoryRegistry.getDescription());
+        };
+
     // Initialise data_pilot/singer_user/phraseXX for this session
     initialiseUserPhraseDirectory();
 
@@ -136,6 +186,9 @@ MainComponent::MainComponent()
     addAndMakeVisible(resetButton);
     addAndMakeVisible(bpmLabel);
     addAndMakeVisible(metronomeToggle);
+    addAndMakeVisible(monitorToggle);
+    addAndMakeVisible(inputMeter);
+    addAndMakeVisible(spectrogramToggle);
     addAndMakeVisible(recordButton);
     addAndMakeVisible(ioButton);
     addAndMakeVisible(takeVolumeLabel);
@@ -152,6 +205,7 @@ MainComponent::MainComponent()
     addAndMakeVisible(styleRightLabel);
     addAndMakeVisible(crossfadeLeftLabel);
     addAndMakeVisible(crossfadeRightLabel);
+    addAndMakeVisible(timelineScrollBar);
     // Scrollable takes view (Recording tab)
     addAndMakeVisible(takesViewport);
     addAndMakeVisible(compedSelectButton);
@@ -169,12 +223,19 @@ MainComponent::MainComponent()
     takesViewport.setScrollOnDragEnabled(true);
     takesViewport.setVisible(false);   // only visible in Recording view
 
+    // Shared timeline scroll bar (instrumental, take lanes and comp row)
+    timelineScrollBar.setAutoHide(false);
+    timelineScrollBar.addListener(this);
+    updateTimelineScrollBar();
+
 
     importButton.addListener(this);
     playButton.addListener(this);
     stopButton.addListener(this);
     resetButton.addListener(this);
     metronomeToggle.addListener(this);
+    monitorToggle.addListener(this);
+    spectrogramToggle.addListener(this);
     recordButton.addListener(this);
     ioButton.addListener(this);
     recordingTabButton.addListener(this);
@@ -192,6 +253,10 @@ MainComponent::MainComponent()
     recordButton.setEnabled(false);
 
     metronomeToggle.setClickingTogglesState(true);
+    spectrogramToggle.setClickingTogglesState(true);
+    monitorToggle.setClickingTogglesState(true);
+    monitorToggle.setTooltip("Hear the input directly, with no extra latency");
+    inputMeter.setTooltip("Input level (click to clear the clip light)");
 
     bpmLabel.setJustificationType(juce::Justification::centredLeft);
     bpmLabel.setInterceptsMouseClicks(false, false);
@@ -220,9 +285,9 @@ MainComponent::MainComponent()
 
     takeVolumeSlider.onValueChange = [this]
         {
-            takeTransport.setGain((float)takeVolumeSlider.getValue());
+            updateTakePlaybackGain();
         };
-    takeTransport.setGain((float)takeVolumeSlider.getValue());
+    updateTakePlaybackGain();
 
     // --- Comping UI (STYLE / CROSSFADE knobs) ---
 
@@ -282,9 +347,6 @@ MainComponent::MainComponent()
         juce::Colours::darkgrey.darker(0.2f));
     exportCompedButton.setColour(juce::TextButton::textColourOffId, juce::Colours::white);
 
-    // Timer for moving playhead / loop wrap (60 FPS)
-    startTimerHz(60);
-
     // Listen for thumbnail changes so we repaint when it finishes loading
     thumbnail.addChangeListener(this);
     compedThumbnail.addChangeListener(this);
@@ -292,10 +354,16 @@ MainComponent::MainComponent()
     updateTabButtonStyles();
     refreshCompedButtons();
 
+    if (scaleTest.isEnabled())
+        startScaleTest(scaleTest);
 }
 
 MainComponent::~MainComponent()
 {
+    // Stop waveform/analysis jobs before anything they touch goes away
+    backgroundPool.removeAllJobs(true, 4000);
+
+    timelineScrollBar.removeListener(this);
     thumbnail.removeChangeListener(this);
     compedThumbnail.removeChangeListener(this);
 
@@ -310,6 +378,28 @@ MainComponent::~MainComponent()
     shutdownAudio();
 }
 
+void MainComponent::runReplayAction(const juce::String& action)
+{
+    // As if the button were pressed, at the block the replay device is waiting on
+    if (action == "play")        buttonClicked(&playButton);
+    else if (action == "stop")   buttonClicked(&stopButton);
+    else if (action == "record") buttonClicked(&recordButton);
+    else if (action == "load")
+    {
+        ProjectState state;
+        juce::String error;
+
+        if (ProjectState::loadFromFile(state, replayProjectFile, error))
+            applyProjectState(state);
+        else
+            DBG("Replay: could not load " << replayProjectFile.getFullPathName() << ": " << error);
+    }
+    else
+    {
+        DBG("Replay: unknown action " << action);
+    }
+}
+
 
 void MainComponent::onCompingFinished(bool /*success*/)
 {
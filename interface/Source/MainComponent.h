@@ -3,6 +3,26 @@
 #include <JuceHeader.h>
 #include "ProjectState.h"
 #include "NeonUI.h"
+#include "WaveformCache.h"
+#include "SpectrogramCache.h"
+#include "PitchTracker.h"
+#include "LoudnessAnalyser.h"
+#include "ActivityAnalyser.h"
+#include "TakeOnsets.h"
+#include "RealtimeArena.h"
+#include "TakeStore.h"
+#include "PhraseIndex.h"
+#include "TakePlayer.h"
+#include "RefreshScheduler.h"
+#include "BufferSizeController.h"
+#include "InputMonitor.h"
+#include "LoopRenderCache.h"
+#include "SincResampler.h"
+#include "ReplayAudioDevice.h"
+#include "SessionGenerator.h"
+#include "MemoryRegistry.h"
+#include "AudioReaderPool.h"
+#include <atomic>
 
 
 // Main component:
@@ -30,11 +50,12 @@ private:
 
 class MainComponent : public juce::AudioAppComponent,
     public juce::Button::Listener,
-    public juce::Timer,
-    public juce::ChangeListener
+    public juce::ChangeListener,
+    public juce::ScrollBar::Listener
 {
 public:
-    MainComponent();
+    explicit MainComponent(const ReplaySettings& replay = {},
+        const SessionGenerator::Settings& scaleTest = {});
     ~MainComponent() override;
 
     //==============================================================================
@@ -49,8 +70,10 @@ public:
     // Button::Listener
     void buttonClicked(juce::Button* button) override;
 
-    // Timer (for moving playhead & handling loop wrap)
-    void timerCallback() override;
+    // One UI frame (moving playhead, loop wrap), run by refreshScheduler
+    void refreshFrame(juce::uint32 reasons);
+    void updateInputMeters();
+    void setIdleFramesAsync(bool shouldRun);   // refreshScheduler.setIdleFrames from any thread
 
     // ChangeListener (for thumbnail finished/updated)
     void changeListenerCallback(juce::ChangeBroadcaster* source) override;
@@ -60,6 +83,14 @@ public:
     void mouseDrag(const juce::MouseEvent& event) override;
     void mouseUp(const juce::MouseEvent& event) override;
     void mouseMove(const juce::MouseEvent& event) override;
+    void mouseDoubleClick(const juce::MouseEvent& event) override;
+
+    // Mouse wheel: zoom / scroll the shared timeline
+    void mouseWheelMove(const juce::MouseEvent& event,
+        const juce::MouseWheelDetails& wheel) override;
+
+    // ScrollBar::Listener (timeline scroll bar)
+    void scrollBarMoved(juce::ScrollBar* scrollBar, double newRangeStart) override;
 
 private:
     // === UI ===
@@ -81,6 +112,9 @@ private:
 
     juce::Label        bpmLabel;
     juce::ToggleButton metronomeToggle{ "Metronome" };
+    juce::ToggleButton monitorToggle{ "Monitor" };
+    InputMeter         inputMeter;
+    juce::ToggleButton spectrogramToggle{ "Spectrogram" };
     juce::Label        takeVolumeLabel;
     juce::Slider       takeVolumeSlider;
 
@@ -114,6 +148,7 @@ private:
 
     // === Audio / thumbnail ===
     juce::AudioFormatManager  formatManager;
+    AudioReaderPool           readerPool{ formatManager };   // every reader the component opens
     juce::AudioThumbnailCache thumbnailCache{ 10 };
     juce::AudioThumbnail      thumbnail{ 512, formatManager, thumbnailCache };
 
@@ -121,6 +156,27 @@ private:
     juce::AudioThumbnail compedThumbnail{ 512, formatManager, thumbnailCache }; // NEW
     bool hasCompedThumbnail = false;                                             // NEW
 
+    // Multi-resolution peaks used for drawing (built on backgroundPool).
+    // The thumbnails above are only drawn until these are ready.
+    std::shared_ptr<WaveformPeakCache> instrumentalPeaks;
+    std::shared_ptr<WaveformPeakCache> compedPeaks;
+    int instrumentalPeaksGeneration = 0;
+    int compedPeaksGeneration = 0;
+
+    // Optional spectrogram view (takes + comp), only computed while shown
+    bool showSpectrogram = false;
+    std::shared_ptr<SpectrogramCache> compedSpectrogram;
+    int compedSpectrogramGeneration = 0;
+
+    // Worker threads for waveform / analysis jobs
+    juce::ThreadPool backgroundPool{ 2 };
+    WaveformImageRenderer waveformRenderer{ backgroundPool };
+
+    // Shared horizontal zoom/scroll, in instrumental seconds. Empty = whole file.
+    juce::Range<double> timelineViewRange;
+    juce::ScrollBar     timelineScrollBar{ false };
+    juce::Rectangle<int> timelineScrollBarBounds;
+
     struct CompSegment       // NEW
     {                        // NEW
         double startSec = 0.0;  // NEW
@@ -130,13 +186,24 @@ private:
     juce::Array<CompSegment> compSegments;   // NEW
 
     std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
+    std::unique_ptr<LoopRenderCache> instrumentalCache;   // what the transport plays; wraps readerSource
     juce::AudioTransportSource transportSource;
     juce::File currentInstrumentalFile;
 
-    // Recording writer for full_N.wav
+    // Memory the audio thread touches, faulted in and locked up front.
+    // Declared before every buffer allocated from it.
+    RealtimeArena realtimeArena;
+
+    // Recording writer for full_N.wav. The callback only queues samples into
+    // its FIFO; the writer thread does the file I/O.
     juce::WavAudioFormat wavFormat;
-    std::unique_ptr<juce::AudioFormatWriter> recordingWriter;
-    juce::CriticalSection writerLock;
+    juce::TimeSliceThread recordingWriterThread{ "Recording writer" };
+    std::unique_ptr<juce::AudioFormatWriter::ThreadedWriter> recordingWriter;
+    static constexpr int recordingWriterFifoSamples = 1 << 18;   // ~5 s at 48 kHz
+
+    // Set by the callback while it records a block. stopRecording() waits for
+    // it to clear before padding the store or closing the writer.
+    std::atomic<bool> recordingInCallback{ false };
     double currentSampleRate = 44100.0;
     juce::AudioSampleBuffer recordingInputBuffer;
 
@@ -166,26 +233,62 @@ private:
     // === Vocal recording visual state ===
     struct TakeTrack
     {
-        int startSample = 0;   // index in vocalWaveBuffer
+        int startSample = 0;   // index in vocalStore
         int numSamples = 0;   // length in samples for this take (one loop)
         juce::String name;     // "Take 1", "Take 2", ...
+        juce::File sourceFile; // take_N.wav once it exists on disk
     };
 
-    juce::AudioSampleBuffer vocalWaveBuffer;      // mono buffer with all recorded samples
-    int totalRecordedSamples = 0;                 // how many samples we've appended so far
-    int loopLengthSamples = 0;                 // cachedLoopLengthSec * currentSampleRate
+    TakeStore vocalStore{ realtimeArena };        // all recorded samples, mono, 16-bit blocks
+    std::atomic<int> totalRecordedSamples{ 0 };   // how many samples we've appended so far (audio thread, while recording)
+    int loopLengthSamples = 0;                 // whole loop on the BPM grid, at timelineSampleRate
+    double timelineSampleRate = 0.0;           // the device rate vocalStore / takeTracks were built at
+    double projectSampleRate = 0.0;            // every take_N.wav is stored at this; 0 until the first take
     juce::Array<TakeTrack> takeTracks;            // completed loop segments
+    juce::Array<std::shared_ptr<WaveformPeakCache>> takePeakCaches; // one per takeTracks entry (shared with render jobs)
+    juce::Array<std::shared_ptr<SpectrogramCache>>  takeSpectrograms; // filled only while the spectrogram is shown
+    juce::Array<std::shared_ptr<PitchCurve>>        takePitchCurves;  // live while recording, else read/analysed from the take file
+    juce::Array<std::shared_ptr<TakeLoudness>>      takeLoudness;     // measured when the take is written, else from its sidecar
+    juce::Array<std::shared_ptr<TakeActivity>>      takeActivity;     // same; null for takes still being recorded
+    juce::Array<std::shared_ptr<TakeOnsets>>        takeOnsets;       // found when the take is written, else from its sidecar
     juce::CriticalSection vocalLock;
-    int  vocalBufferCapacitySamples = 0;
     juce::File currentFullRecordingFile;
+    int  recordingStartSample = 0;               // totalRecordedSamples when the current pass started
+
+    // Pitch of the recording input, tracked on its own thread
+    LivePitchAnalyser livePitch;
+    int takePitchGeneration = 0;
 
     // === Take playback (selected take alongside instrumental) ===
-    juce::AudioTransportSource takeTransport;
-    std::unique_ptr<juce::AudioFormatReaderSource> takeReaderSource;
+    TakePlayer takePlayer;               // only commanded from the message thread
     juce::AudioSampleBuffer takeMixBuffer;
     int selectedTakeIndex = -1; // for take sleecion
     int soloTakeIndex = -1; // for oslo
 
+    // What the audio callback needs of the UI state, written by the message
+    // thread in one go (publishPlaybackState) and read once per block.
+    struct PlaybackState
+    {
+        bool recording = false;
+        bool muteInstrumental = false;   // a take or the comp is soloed
+        bool playTake = false;
+        bool metronome = false;
+    };
+
+    std::atomic<PlaybackState> playbackState{ PlaybackState{} };
+    void publishPlaybackState();
+
+    // Audio thread: one part of a callback, no larger than prepareToPlay sized the buffers for
+    void renderBlock(const juce::AudioSourceChannelInfo& bufferToFill, const PlaybackState& state);
+
+    // Suggests or applies the device buffer size from the measured callback load
+    BufferSizeController bufferSizeController{ deviceManager };
+    juce::TooltipWindow tooltipWindow{ this };
+
+    // Input meters, clip detection and direct monitoring in the callback
+    InputMonitor inputMonitor;
+    juce::Array<InputMonitor::ClipRun> recordedClipRuns;   // this pass, vocal timeline
+
     // --- Scrollable takes view (Recording tab) ---
     juce::Viewport takesViewport;
     juce::Component takesContainer;
@@ -193,6 +296,15 @@ private:
 
     // Helpers for the takes view
     void syncTakeLanesWithTakeTracks();
+    void addTakeTracksUpTo(int numSamples);
+    void updateTakePeakCaches();
+    void updateTakeSpectrograms();
+    void updateTakePitchCurves();
+    void analyseTakeFilesAsync();
+    void clearTakeAnalysis();
+    void setTakeLoudness(int takeIndex, std::shared_ptr<TakeLoudness> loudness);
+    void updateTakePlaybackGain();
+    void updateTakeLaneViewRanges();
     void layoutTakeLanes();
     void refreshTakeLaneSelectionStates();
     void updateTakeLanePlayhead(double globalTimeSeconds);
@@ -222,6 +334,7 @@ private:
 
     juce::File currentPhraseDirectory;
     int        currentPhraseIndex = 1;
+    std::unique_ptr<PhraseIndex> phraseIndex;   // data_pilot/singer_user.index.json
 
     // --- Comped-tab lane controls ---
     NeonButton compedSelectButton{ "Select" };
@@ -235,13 +348,39 @@ private:
     double xToTime(float x) const;
     int    timeToX(double t) const;
     int    compedTimeToX(double t, const juce::Rectangle<int>& area) const;
+    bool   isTimeInView(double t) const;
+
+    // Timeline zoom / scroll
+    juce::Range<double> getTimelineViewRange() const;
+    juce::Range<double> getLoopViewRange() const;   // view clipped to the loop (take lanes / comp row)
+    juce::Range<double> getCompedViewRange() const; // same, relative to the comped file
+    void setTimelineViewRange(juce::Range<double> newRange);
+    void resetTimelineView();
+    void zoomTimeline(double factor, double anchorSec);
+    bool handleTimelineWheel(double anchorSec,
+        const juce::MouseWheelDetails& wheel,
+        juce::ModifierKeys mods,
+        bool plainWheelZooms);
+    void updateTimelineScrollBar();
+    void layoutTimelineScrollBar(juce::Rectangle<int>& area);
+
+    // Peak caches for file-based waveforms
+    void buildPeakCacheAsync(const juce::File& file,
+        std::function<void(std::shared_ptr<WaveformPeakCache>)> onReady);
+    void rebuildInstrumentalPeaks();
+    void rebuildCompedPeaks();
+    void rebuildCompedSpectrogram();
 
     void splitFullRecordingIntoTakes(const juce::File& fullFile, int numLoops);
     void setSelectedTake(int newIndex);
     void setSoloTake(int newIndex);
     void stopRecording();                       // NEW
     void importInstrumental();                  // extracted from old button handler
+    void setInstrumentalSource(std::unique_ptr<juce::AudioFormatReaderSource> newSource,
+        const juce::File& file);
+    void updateLoopRenderRange();
     void importTakesFromFiles();
+    void finishImportingTakes(int numImportedTakes);
     void initialiseUserPhraseDirectory();
     void runCompingFromGui();
     void resetProjectState();
@@ -267,6 +406,7 @@ private:
     // View-specific painting/layout helpers
     void paintRecordingView(juce::Graphics& g);
     void paintCompReviewView(juce::Graphics& g);
+    void paintInstrumentalTrack(juce::Graphics& g, const juce::String& emptyMessage);
 
     void layoutRecordingView(juce::Rectangle<int> area);
     void layoutCompReviewView(juce::Rectangle<int> area);
@@ -280,10 +420,32 @@ private:
     void saveProjectToFile();
     void loadProjectFromFile();
 
-    // Rebuild visual takes (vocalWaveBuffer + takeTracks) from take_*.wav files
-    void rebuildTakesFromPhraseDirectory();
+    // Replay runs (--replay): play, stop, record or load, from the replay device
+    void runReplayAction(const juce::String& action);
+    juce::File replayProjectFile;
 
+    // Memory by category (AICOMP_MEMORY_PANEL shows it; logged on save and Start over)
+    MemoryRegistry memoryRegistry;
+    MemoryPanel memoryPanel;
+    double lastMemoryReportMs = 0.0;
+    void reportMemoryUsage();
+    void logMemoryUsage(const juce::String& when);
 
+    // Scaling test (--scale-test): generate a large session, time load/lanes/paint/comp/save
+    void startScaleTest(const SessionGenerator::Settings& settings);
+    void runScaleTest(const SessionGenerator::Settings& settings,
+        const juce::Array<SessionGenerator::Phrase>& phrases, double generateMs);
+
+    // Rebuild visual takes (vocalStore + takeTracks) from take_*.wav files
+    void rebuildTakesFromPhraseDirectory();
+    void rebuildTakesForDeviceRate();
+
+    // Frames follow the display while playing or recording, and only run
+    // otherwise when something was invalidated. Last, so it goes first.
+    RefreshScheduler refreshScheduler{ *this,
+        [this](juce::uint32 reasons) { refreshFrame(reasons); },
+        [this] { return isRecording || inputMonitor.isMonitoring()
+                     || transportSource.isPlaying() || takePlayer.isPlaying(); } };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainComponent)
 };
@@ -10,129 +10,144 @@ void MainComponent::prepareToPlay(int samplesPerBlockExpected, double sampleRate
     currentSampleRate = sampleRate;
 
     transportSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    takeTransport.prepareToPlay(samplesPerBlockExpected, sampleRate);
-    takeTransport.setGain((float)takeVolumeSlider.getValue());
+    takePlayer.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    bufferSizeController.prepare(sampleRate, samplesPerBlockExpected);
+    inputMonitor.prepare(sampleRate);
 
-    if (samplesPerBlockExpected > 0)
-        takeMixBuffer.setSize(1, samplesPerBlockExpected, false, false, true);
+    // Takes in memory are at the old device rate: rebuild them at this one
+    if (timelineSampleRate > 0.0 && sampleRate != timelineSampleRate)
+    {
+        juce::Component::SafePointer<MainComponent> safeThis(this);
+
+        juce::MessageManager::callAsync([safeThis]
+            {
+                if (safeThis != nullptr)
+                    safeThis->rebuildTakesForDeviceRate();
+            });
+    }
+    updateTakePlaybackGain();
 
+    // From the arena, so the first callbacks do not page-fault. Twice the
+    // expected size: some devices deliver the odd larger block.
     if (samplesPerBlockExpected > 0)
     {
-        recordingInputBuffer.setSize(1, samplesPerBlockExpected,
-            false, false, true);
+        realtimeArena.attach(takeMixBuffer, 1, samplesPerBlockExpected * 2);
+        realtimeArena.attach(recordingInputBuffer, 1, samplesPerBlockExpected * 2);
     }
+
+    DBG("Real-time memory: " << realtimeArena.getDescription());
+
+    // Input meters keep moving while the UI is otherwise idle, only as long
+    // as there are inputs to meter
+    bool hasInputs = false;
+    if (auto* device = deviceManager.getCurrentAudioDevice())
+        hasInputs = device->getActiveInputChannels().countNumberOfSetBits() > 0;
+
+    setIdleFramesAsync(hasInputs);
+}
+
+void MainComponent::setIdleFramesAsync(bool shouldRun)
+{
+    // prepareToPlay / releaseResources may come from the device's thread
+    juce::Component::SafePointer<MainComponent> safeThis(this);
+
+    juce::MessageManager::callAsync([safeThis, shouldRun]
+        {
+            if (safeThis != nullptr)
+                safeThis->refreshScheduler.setIdleFrames(shouldRun);
+        });
 }
 
 void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+    // Callback load and overruns, for the buffer size controller
+    const juce::AudioProcessLoadMeasurer::ScopedTimer loadTimer(
+        bufferSizeController.getLoadMeasurer(), bufferToFill.numSamples);
+
+    // One consistent view of the UI state for the whole block
+    const PlaybackState state = playbackState.load(std::memory_order_acquire);
+
+    // Blocks larger than prepareToPlay sized the buffers for are rendered
+    // in parts, so nothing below reallocates on this thread
+    const int maxBlock = juce::jmin(recordingInputBuffer.getNumSamples(),
+        takeMixBuffer.getNumSamples());
+
+    if (maxBlock <= 0)
+    {
+        bufferToFill.clearActiveBufferRegion();
+        return;
+    }
+
+    for (int done = 0; done < bufferToFill.numSamples;)
+    {
+        const int n = juce::jmin(bufferToFill.numSamples - done, maxBlock);
+        renderBlock({ bufferToFill.buffer, bufferToFill.startSample + done, n }, state);
+        done += n;
+    }
+}
+
+void MainComponent::renderBlock(const juce::AudioSourceChannelInfo& bufferToFill,
+    const PlaybackState& state)
 {
     auto* buffer = bufferToFill.buffer;
     const int start = bufferToFill.startSample;
     const int num = bufferToFill.numSamples;
 
-    if (takeMixBuffer.getNumSamples() < num)
-        takeMixBuffer.setSize(1, num, false, false, true);
+    int numInputChans = 0;
+    if (auto* device = deviceManager.getCurrentAudioDevice())
+        numInputChans = juce::jmin(device->getActiveInputChannels().countNumberOfSetBits(),
+            buffer->getNumChannels());
 
-    // Recording: grab input before overwriting buffer
-    if (isRecording && recordingWriter != nullptr)
+    // 1) Input, before the buffer is overwritten: meters (and clip runs
+    //    while recording), and the mono mix for recording and monitoring
+    if (numInputChans > 0)
     {
-        if (auto* device = deviceManager.getCurrentAudioDevice())
-        {
-            const int numInputChans =
-                device->getActiveInputChannels().countNumberOfSetBits();
-
-            if (numInputChans > 0)
-            {
-                const int bufferCapacity = recordingInputBuffer.getNumSamples();
-                if (bufferCapacity > 0)
-                {
-                    const int samplesToProcess = juce::jmin(num, bufferCapacity);
+        inputMonitor.measure(*buffer, start, num, numInputChans,
+            state.recording ? (int64)totalRecordedSamples.load(std::memory_order_relaxed) : -1);
 
-                    recordingInputBuffer.clear();
-                    auto* monoData = recordingInputBuffer.getWritePointer(0);
+        recordingInputBuffer.clear(0, 0, num);
+        auto* monoData = recordingInputBuffer.getWritePointer(0);
 
-                    const int chansToCopy =
-                        juce::jmin(numInputChans, buffer->getNumChannels());
+        for (int ch = 0; ch < numInputChans; ++ch)
+        {
+            const float* src = buffer->getReadPointer(ch, start);
+            for (int i = 0; i < num; ++i)
+                monoData[i] += src[i];
+        }
 
-                    for (int ch = 0; ch < chansToCopy; ++ch)
-                    {
-                        const float* src = buffer->getReadPointer(ch, start);
-                        for (int i = 0; i < samplesToProcess; ++i)
-                            monoData[i] += src[i];
-                    }
+        if (numInputChans > 1)
+        {
+            const float scale = 1.0f / (float)numInputChans;
+            recordingInputBuffer.applyGain(0, 0, num, scale);
+        }
+    }
 
-                    if (chansToCopy > 1)
-                    {
-                        const float scale = 1.0f / (float)chansToCopy;
-                        recordingInputBuffer.applyGain(scale);
-                    }
+    // Recording. No locks: the writer queues into its FIFO, the store appends
+    // into reserved blocks and publishes the count, and take lanes are added
+    // on the message thread from that count.
+    if (state.recording && numInputChans > 0)
+    {
+        // Paired with stopRecording(): either it sees this flag and waits, or
+        // this sees recording already off and leaves the writer alone
+        recordingInCallback.store(true);
 
-                    {
-                        const juce::ScopedLock sl(writerLock);
-                        recordingWriter->writeFromAudioSampleBuffer(recordingInputBuffer,
-                            0, samplesToProcess);
-                    }
+        if (playbackState.load().recording && recordingWriter != nullptr)
+        {
+            const float* const mono[] = { recordingInputBuffer.getReadPointer(0) };
+            recordingWriter->write(mono, num);
 
-                    // Visual buffer
-                    {
-                        const juce::ScopedLock sl(vocalLock);
+            // Bounded by the reserved capacity; never allocates
+            const int samplesToCopy = vocalStore.append(mono[0], num);
 
-                        if (vocalBufferCapacitySamples > 0
-                            && vocalWaveBuffer.getNumChannels() > 0)
-                        {
-                            const int remainingCapacity =
-                                juce::jmax(0, vocalBufferCapacitySamples - totalRecordedSamples);
-
-                            const int samplesToCopy =
-                                juce::jmin(samplesToProcess, remainingCapacity);
-
-                            if (samplesToCopy > 0)
-                            {
-                                vocalWaveBuffer.copyFrom(0, totalRecordedSamples,
-                                    recordingInputBuffer, 0, 0,
-                                    samplesToCopy);
-
-                                totalRecordedSamples += samplesToCopy;
-
-                                if (loopLengthSamples > 0)
-                                {
-                                    const int completedLoops =
-                                        totalRecordedSamples / loopLengthSamples;
-                                    const int remainder =
-                                        totalRecordedSamples % loopLengthSamples;
-
-                                    // Number of lanes we want to show:
-                                    //
-                                    // - all *completed* loops
-                                    // - plus 1 extra lane for the *current* loop
-                                    //   while it is still being recorded
-                                    int loopsToRepresent = completedLoops;
-                                    if (remainder > 0)
-                                        ++loopsToRepresent;      // show in-progress loop
-
-                                    // Safety: if we have *some* samples but less than one loop,
-                                    // still show at least 1 lane (first loop in progress).
-                                    if (totalRecordedSamples > 0 && loopsToRepresent == 0)
-                                        loopsToRepresent = 1;
-
-                                    while (takeTracks.size() < loopsToRepresent)
-                                    {
-                                        const int idx = takeTracks.size();
-
-                                        TakeTrack t;
-                                        t.startSample = idx * loopLengthSamples;
-                                        t.numSamples = loopLengthSamples;   // full loop span
-                                        t.name = "Take " + juce::String(idx + 1);
-
-                                        takeTracks.add(t);
-                                    }
-                                }
-
-                            }
-                        }
-                    }
-                }
+            if (samplesToCopy > 0)
+            {
+                // Lock-free handoff to the pitch analyser thread
+                livePitch.pushSamples(mono[0], samplesToCopy);
+                totalRecordedSamples.fetch_add(samplesToCopy, std::memory_order_release);
             }
         }
+
+        recordingInCallback.store(false, std::memory_order_release);
     }
 
     // 2) Start from silence
@@ -143,45 +158,27 @@ void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& buffer
     {
         transportSource.getNextAudioBlock(bufferToFill);
 
-        const bool soloRecording =
-            (!isRecording && viewMode == ViewMode::Recording && soloTakeIndex >= 0);
-        const bool soloComped =
-            (!isRecording && viewMode == ViewMode::CompReview && compedSolo);
-
-        if (soloRecording || soloComped)
+        if (state.muteInstrumental)
             bufferToFill.clearActiveBufferRegion();
     }
 
-    // 3) Decide if take / comped should be heard
-    bool playTake = false;
-
-    if (!isRecording)
-    {
-        if (viewMode == ViewMode::Recording)
-        {
-            if (soloTakeIndex >= 0 || selectedTakeIndex >= 0)
-                playTake = true;
-        }
-        else if (viewMode == ViewMode::CompReview)
-        {
-            if (compedSelected || compedSolo)
-                playTake = true;
-        }
-    }
+    // 3) Take / comped. Always pulled, so queued commands are applied
+    //    even while it is not heard.
+    juce::AudioSourceChannelInfo takeInfo(&takeMixBuffer, 0, num);
+    takePlayer.getNextAudioBlock(takeInfo);
 
-    if (playTake && takeReaderSource != nullptr)
+    if (state.playTake)
     {
-        takeMixBuffer.clear();
-
-        juce::AudioSourceChannelInfo takeInfo(&takeMixBuffer, 0, num);
-        takeTransport.getNextAudioBlock(takeInfo);
-
         for (int ch = 0; ch < buffer->getNumChannels(); ++ch)
             buffer->addFrom(ch, start, takeMixBuffer, 0, 0, num);
     }
 
-    // 4) Metronome placeholder
-    if (metronomeOn)
+    // 4) Direct monitoring: the input of this very block, no extra buffering
+    if (numInputChans > 0)
+        inputMonitor.addMonitor(recordingInputBuffer.getReadPointer(0), *buffer, start, num);
+
+    // 5) Metronome placeholder
+    if (state.metronome)
     {
 		// FUTURE METRONOME, need quantization to beat grid
     }
@@ -190,13 +187,13 @@ void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& buffer
 void MainComponent::releaseResources()
 {
     transportSource.releaseResources();
-    takeTransport.releaseResources();
+    takePlayer.releaseResources();
 
-    const juce::ScopedLock sl(writerLock);
-    recordingWriter.reset();
+    // The recording writer belongs to the message thread; stopRecording()
+    // closes it once the callback is known to be out of it
 
-    takeTransport.setSource(nullptr);
-    takeReaderSource.reset();
+    // No device, nothing to meter: an idle UI does no work again
+    setIdleFramesAsync(false);
 }
 
 //==============================================================================
@@ -209,71 +206,53 @@ void MainComponent::stopRecording()
         return;
 
     isRecording = false;
+    publishPlaybackState();
     recordButton.setButtonText("Record");
 
+    // The callback re-reads the state after raising recordingInCallback, so
+    // once the flag is down it will not touch the store or the writer again
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    while (recordingInCallback.load())
+        juce::Thread::yield();
+
     transportSource.stop();
 
     int missingSamplesToPad = 0;
+    const int recordedSamples = totalRecordedSamples.load();
 
+    if (loopLengthSamples > 0 && recordedSamples > 0)
     {
-        const juce::ScopedLock sl(vocalLock);
+        const int remainder = recordedSamples % loopLengthSamples;
 
-        if (loopLengthSamples > 0 && totalRecordedSamples > 0)
+        if (remainder > 0)
         {
-            const int remainder = totalRecordedSamples % loopLengthSamples;
-
-            if (remainder > 0)
-            {
-                missingSamplesToPad = loopLengthSamples - remainder;
-                const int neededSamples = totalRecordedSamples + missingSamplesToPad;
-
-                if (neededSamples > vocalBufferCapacitySamples)
-                {
-                    const int extra =
-                        (currentSampleRate > 0.0
-                            ? (int)(currentSampleRate * 10.0)
-                            : 44100 * 10);
-
-                    vocalBufferCapacitySamples = neededSamples + extra;
-
-                    if (vocalWaveBuffer.getNumChannels() < 1)
-                        vocalWaveBuffer.setSize(1, vocalBufferCapacitySamples,
-                            false, false, false);
-                    else
-                        vocalWaveBuffer.setSize(1, vocalBufferCapacitySamples,
-                            true, false, false);
-                }
-
-                vocalWaveBuffer.clear(0, totalRecordedSamples, missingSamplesToPad);
-                totalRecordedSamples = neededSamples;
-            }
-
-            const int completedLoops = totalRecordedSamples / loopLengthSamples;
-
-            while (takeTracks.size() < completedLoops)
-            {
-                const int idx = takeTracks.size();
-                TakeTrack t;
-                t.startSample = idx * loopLengthSamples;
-                t.numSamples = loopLengthSamples;
-                t.name = "Take " + juce::String(idx + 1);
-                takeTracks.add(t);
-            }
+            missingSamplesToPad = loopLengthSamples - remainder;
+            const int neededSamples = recordedSamples + missingSamplesToPad;
+
+            // Only past the recording reservation. The callback is out of
+            // the store by now, and the block is mapped before vocalLock is
+            // taken; it comes from the arena because the next pass records
+            // into whatever of it the padding leaves.
+            vocalStore.reserveForRecording(neededSamples, vocalLock);
+
+            const juce::ScopedLock sl(vocalLock);
+            vocalStore.appendSilence(missingSamplesToPad);
+            totalRecordedSamples = neededSamples;
         }
     }
 
+    addTakeTracksUpTo(totalRecordedSamples);
+
+    // Analyse whatever is still queued so the take sidecars are complete
+    livePitch.flush();
+
     int numLoopsForExport = 0;
     if (loopLengthSamples > 0 && totalRecordedSamples > 0)
         numLoopsForExport = totalRecordedSamples / loopLengthSamples;
 
-    {
-        const juce::ScopedLock sl(writerLock);
-
-        if (recordingWriter != nullptr)
-            recordingWriter->flush();
-
-        recordingWriter.reset();
-    }
+    // Waits for the writer thread to drain the FIFO and closes full_N.wav
+    recordingWriter.reset();
 
     repaint();
 
@@ -282,7 +261,7 @@ void MainComponent::stopRecording()
         && currentFullRecordingFile.existsAsFile())
     {
         std::unique_ptr<juce::AudioFormatReader> reader(
-            formatManager.createReaderFor(currentFullRecordingFile));
+            readerPool.createReaderFor(currentFullRecordingFile));
 
         if (reader != nullptr)
         {
@@ -345,6 +324,11 @@ void MainComponent::stopRecording()
                     }
 
                     padWriter.reset();
+
+                    // Let go of the mapping before the file is replaced
+                    reader.reset();
+                    readerPool.invalidate(currentFullRecordingFile);
+
                     paddedFile.moveFileTo(currentFullRecordingFile);
                 }
 
@@ -360,6 +344,7 @@ void MainComponent::stopRecording()
             splitFullRecordingIntoTakes(currentFullRecordingFile, numLoopsForExport);
     }
     syncTakeLanesWithTakeTracks();
+    refreshScheduler.invalidate(RefreshScheduler::takes);
 }
 
 //==============================================================================
@@ -368,13 +353,12 @@ void MainComponent::stopRecording()
 
 void MainComponent::setSelectedTake(int newIndex)
 {
-    takeTransport.stop();
-    takeTransport.setLooping(false);
-    takeTransport.setSource(nullptr);
-    takeReaderSource.reset();
+    takePlayer.stop();
+    takePlayer.unload();
 
     selectedTakeIndex = -1;
     soloTakeIndex = -1;
+    publishPlaybackState();
 
     if (newIndex < 0 || newIndex >= takeTracks.size())
     {
@@ -394,7 +378,7 @@ void MainComponent::setSelectedTake(int newIndex)
     }
 
     std::unique_ptr<juce::AudioFormatReader> reader(
-        formatManager.createReaderFor(takeFile));
+        readerPool.createReaderFor(takeFile));
 
     if (reader == nullptr)
     {
@@ -402,28 +386,27 @@ void MainComponent::setSelectedTake(int newIndex)
         return;
     }
 
-    auto* rawReader = reader.release();
-    takeReaderSource = std::make_unique<juce::AudioFormatReaderSource>(rawReader, true);
-
-    takeTransport.setSource(takeReaderSource.get(),
-        0,
-        nullptr,
-        currentSampleRate);
-
-    takeTransport.setLooping(true);
+    // Prepared here; the audio thread only swaps it in
+    if (!takePlayer.load(std::move(reader)))
+    {
+        repaint();
+        return;
+    }
 
     selectedTakeIndex = newIndex;
+    updateTakePlaybackGain();
+    publishPlaybackState();
 
     if (transportSource.isPlaying() && hasValidLoop())
     {
         transportSource.setPosition(loopStartSec);
-        takeTransport.setPosition(0.0);
-        takeTransport.start();
+        takePlayer.setPosition(0.0);
+        takePlayer.start();
     }
     else if (readerSource == nullptr)
     {
-        takeTransport.setPosition(0.0);
-        takeTransport.start();
+        takePlayer.setPosition(0.0);
+        takePlayer.start();
     }
 
     refreshTakeLaneSelectionStates();
@@ -432,13 +415,12 @@ void MainComponent::setSelectedTake(int newIndex)
 
 void MainComponent::setSoloTake(int newIndex)
 {
-    takeTransport.stop();
-    takeTransport.setLooping(false);
-    takeTransport.setSource(nullptr);
-    takeReaderSource.reset();
+    takePlayer.stop();
+    takePlayer.unload();
 
     soloTakeIndex = -1;
     selectedTakeIndex = -1;
+    publishPlaybackState();
 
     if (newIndex < 0 || newIndex >= takeTracks.size())
     {
@@ -458,7 +440,7 @@ void MainComponent::setSoloTake(int newIndex)
     }
 
     std::unique_ptr<juce::AudioFormatReader> reader(
-        formatManager.createReaderFor(takeFile));
+        readerPool.createReaderFor(takeFile));
 
     if (reader == nullptr)
     {
@@ -466,34 +448,94 @@ void MainComponent::setSoloTake(int newIndex)
         return;
     }
 
-    auto* rawReader = reader.release();
-    takeReaderSource = std::make_unique<juce::AudioFormatReaderSource>(rawReader, true);
-
-    takeTransport.setSource(takeReaderSource.get(),
-        0,
-        nullptr,
-        currentSampleRate);
-
-    takeTransport.setLooping(true);
+    // Prepared here; the audio thread only swaps it in
+    if (!takePlayer.load(std::move(reader)))
+    {
+        repaint();
+        return;
+    }
 
     soloTakeIndex = newIndex;
+    updateTakePlaybackGain();
+    publishPlaybackState();
 
     if (transportSource.isPlaying() && hasValidLoop())
     {
         transportSource.setPosition(loopStartSec);
-        takeTransport.setPosition(0.0);
-        takeTransport.start();
+        takePlayer.setPosition(0.0);
+        takePlayer.start();
     }
     else if (readerSource == nullptr)
     {
-        takeTransport.setPosition(0.0);
-        takeTransport.start();
+        takePlayer.setPosition(0.0);
+        takePlayer.start();
     }
 
     refreshTakeLaneSelectionStates();
     repaint();
 }
 
+void MainComponent::setTakeLoudness(int takeIndex, std::shared_ptr<TakeLoudness> loudness)
+{
+    if (takeIndex < 0)
+        return;
+
+    if (takeLoudness.size() <= takeIndex)
+        takeLoudness.resize(takeIndex + 1);
+
+    takeLoudness.set(takeIndex, std::move(loudness));
+
+    if (takeIndex == selectedTakeIndex || takeIndex == soloTakeIndex)
+        updateTakePlaybackGain();
+}
+
+void MainComponent::updateTakePlaybackGain()
+{
+    // Single takes play loudness-matched; the comp is already matched by CompStitcher
+    const int take = soloTakeIndex >= 0 ? soloTakeIndex : selectedTakeIndex;
+    float gainDb = 0.0f;
+
+    if (auto loudness = takeLoudness[take])
+        gainDb = loudness->getGainDb();
+
+    takePlayer.setGain((float)takeVolumeSlider.getValue() * juce::Decibels::decibelsToGain(gainDb));
+}
+
+void MainComponent::publishPlaybackState()
+{
+    static_assert(std::atomic<PlaybackState>::is_always_lock_free,
+        "the audio callback must never wait for the playback state");
+
+    // Message thread only; the audio callback picks this up on its next block
+    PlaybackState s;
+    s.recording = isRecording;
+    s.metronome = metronomeOn;
+
+    if (!isRecording)
+    {
+        if (viewMode == ViewMode::Recording)
+        {
+            s.playTake = (soloTakeIndex >= 0 || selectedTakeIndex >= 0);
+            s.muteInstrumental = (soloTakeIndex >= 0);
+        }
+        else if (viewMode == ViewMode::CompReview)
+        {
+            s.playTake = (compedSelected || compedSolo);
+            s.muteInstrumental = compedSolo;
+        }
+    }
+
+    playbackState.store(s, std::memory_order_release);
+
+    // Small buffers while recording, headroom while reviewing the comp
+    bufferSizeController.setUsage(viewMode == ViewMode::CompReview
+        ? BufferSizeController::Usage::review
+        : BufferSizeController::Usage::recording, isRecording);
+
+    // Playing or recording may just have started: frames follow the display again
+    refreshScheduler.invalidate(isRecording ? RefreshScheduler::recording : RefreshScheduler::playback);
+}
+
 //==============================================================================
 // Import instrumental
 //==============================================================================
@@ -518,7 +560,7 @@ void MainComponent::importInstrumental()
             currentInstrumentalFile = file;
 
             std::unique_ptr<juce::AudioFormatReader> reader(
-                formatManager.createReaderFor(file));
+                readerPool.createReaderFor(file));
 
             if (reader.get() == nullptr)
                 return;
@@ -527,26 +569,22 @@ void MainComponent::importInstrumental()
                 std::make_unique<juce::AudioFormatReaderSource>(reader.release(), true);
 
             transportSource.stop();
-            transportSource.setSource(nullptr);
 
             const double sr = newSource->getAudioFormatReader()->sampleRate;
             const double totalLengthSec =
                 (double)newSource->getAudioFormatReader()->lengthInSamples / sr;
 
-            transportSource.setSource(newSource.get(),
-                0,
-                nullptr,
-                sr);
-            transportSource.setLooping(false);
-
-            readerSource = std::move(newSource);
+            setInstrumentalSource(std::move(newSource), file);
 
             thumbnail.clear();
             thumbnail.setSource(new juce::FileInputSource(file));
+            rebuildInstrumentalPeaks();
+            resetTimelineView();
 
             loopStartSec = 0.0;
             loopEndSec = totalLengthSec;
             minLoopLengthSec = juce::jmin(5.0, totalLengthSec);
+            updateLoopRenderRange();
 
             promptForBpm();
 
@@ -560,6 +598,30 @@ void MainComponent::importInstrumental()
         });
 }
 
+void MainComponent::setInstrumentalSource(std::unique_ptr<juce::AudioFormatReaderSource> newSource,
+    const juce::File& file)
+{
+    transportSource.setSource(nullptr);
+    instrumentalCache.reset();
+    readerSource = std::move(newSource);
+
+    if (readerSource == nullptr)
+        return;
+
+    // The cache works at the device rate, so the transport has nothing to resample
+    instrumentalCache = std::make_unique<LoopRenderCache>(*readerSource,
+        readerPool.createReaderFor(file));
+
+    transportSource.setSource(instrumentalCache.get());
+    transportSource.setLooping(false);
+}
+
+void MainComponent::updateLoopRenderRange()
+{
+    if (instrumentalCache != nullptr)
+        instrumentalCache->setLoopRange(loopStartSec, loopEndSec);
+}
+
 //==============================================================================
 // Import takes from files
 //==============================================================================
@@ -592,122 +654,105 @@ void MainComponent::importTakesFromFiles()
                 return;
             }
 
-            std::unique_ptr<juce::AudioFormatReader> firstReader(
-                formatManager.createReaderFor(files[0]));
+            // All the same length in time; any rates
+            double takeSeconds = 0.0;
 
-            if (firstReader == nullptr)
+            for (int i = 0; i < files.size(); ++i)
             {
-                fileChooser.reset();
-                return;
-            }
-
-            const double fileSampleRate = firstReader->sampleRate;
-            const int64  fileNumSamples = firstReader->lengthInSamples;
+                std::unique_ptr<juce::AudioFormatReader> r(
+                    readerPool.createReaderFor(files[i]));
 
-            if (fileSampleRate <= 0.0 || fileNumSamples <= 0)
-            {
-                fileChooser.reset();
-                return;
-            }
+                if (r == nullptr || r->sampleRate <= 0.0 || r->lengthInSamples <= 0)
+                {
+                    fileChooser.reset();
+                    return;
+                }
 
-            for (int i = 1; i < files.size(); ++i)
-            {
-                std::unique_ptr<juce::AudioFormatReader> r(
-                    formatManager.createReaderFor(files[i]));
+                const double seconds = (double)r->lengthInSamples / r->sampleRate;
 
-                if (r == nullptr
-                    || r->sampleRate != fileSampleRate
-                    || r->lengthInSamples != fileNumSamples)
+                if (i == 0)
+                    takeSeconds = seconds;
+                else if (std::abs(seconds - takeSeconds) > ProjectState::gridToleranceSec)
                 {
                     fileChooser.reset();
                     return;
                 }
             }
 
-            const int numImportedTakes = files.size();
-            const int loopLenSamplesInt = (int)fileNumSamples;
-
-            {
-                const juce::ScopedLock sl(vocalLock);
+            // Every take is stored at the project rate, a whole loop long on the grid
+            if (projectSampleRate <= 0.0)
+                projectSampleRate = currentSampleRate;
 
-                totalRecordedSamples = 0;
-                takeTracks.clear();
+            const double rate = projectSampleRate;
+            const int64 takeSamples =
+                ProjectState::gridLoopLengthSamples(takeSeconds, bpmSet ? bpm : 0, rate);
 
-                loopLengthSamples = loopLenSamplesInt;
-                cachedLoopLengthSec = (double)fileNumSamples / fileSampleRate;
+            juce::File baseDir = currentPhraseDirectory;
+            baseDir.createDirectory();
+            readerPool.invalidate(baseDir);
 
-                vocalBufferCapacitySamples = numImportedTakes * loopLengthSamples;
-                vocalWaveBuffer.setSize(1,
-                    vocalBufferCapacitySamples,
-                    false,
-                    false,
-                    false);
+            importButton.setEnabled(false);
+            fileChooser.reset();
 
-                juce::AudioSampleBuffer temp(1, loopLengthSamples);
-                int writePos = 0;
+            // Converted (or just copied) into the phrase off the message thread
+            juce::Component::SafePointer<MainComponent> safeThis(this);
 
-                for (int i = 0; i < numImportedTakes; ++i)
+            backgroundPool.addJob([this, safeThis, files, baseDir, rate, takeSamples]
                 {
-                    std::unique_ptr<juce::AudioFormatReader> r(
-                        formatManager.createReaderFor(files[i]));
-
-                    if (r == nullptr)
-                        continue;
+                    auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob();
+                    const auto shouldExit = [job] { return job != nullptr && job->shouldExit(); };
 
-                    temp.clear();
+                    int numImported = 0;
 
-                    r->read(&temp,
-                        0,
-                        loopLengthSamples,
-                        0,
-                        true,
-                        false);
+                    for (int i = 0; i < files.size() && !shouldExit(); ++i)
+                    {
+                        const auto dest = baseDir.getChildFile("take_" + juce::String(i + 1) + ".wav");
 
-                    vocalWaveBuffer.copyFrom(0,
-                        writePos,
-                        temp,
-                        0,
-                        0,
-                        loopLengthSamples);
+                        const bool converted = SincResampler::convertFile(readerPool, files[i], dest,
+                            rate, takeSamples, shouldExit);
 
-                    TakeTrack t;
-                    t.startSample = writePos;
-                    t.numSamples = loopLengthSamples;
-                    t.name = "Take " + juce::String(i + 1);
+                        // Read once; no reason to keep it mapped
+                        readerPool.invalidate(files[i]);
 
-                    takeTracks.add(t);
+                        if (!converted)
+                            break;
 
-                    writePos += loopLengthSamples;
-                }
+                        ++numImported;
+                    }
 
-                totalRecordedSamples = writePos;
-            }
+                    juce::MessageManager::callAsync([safeThis, numImported]
+                        {
+                            if (safeThis != nullptr)
+                                safeThis->finishImportingTakes(numImported);
+                        });
+                });
+        });
+}
 
-            takeTransport.stop();
-            takeTransport.setSource(nullptr);
-            takeReaderSource.reset();
-            selectedTakeIndex = -1;
-            soloTakeIndex = -1;
+void MainComponent::finishImportingTakes(int numImportedTakes)
+{
+    importButton.setEnabled(true);
 
-            juce::File baseDir = currentPhraseDirectory;
-            baseDir.createDirectory();
+    if (numImportedTakes <= 0 || isRecording)
+        return;
 
-            nextTakeIndex = numImportedTakes + 1;
+    takePlayer.stop();
+    takePlayer.unload();
+    selectedTakeIndex = -1;
+    soloTakeIndex = -1;
+    publishPlaybackState();
 
-            for (int i = 0; i < files.size(); ++i)
-            {
-                const int fileIndex = i + 1;
-                juce::File dest =
-                    baseDir.getChildFile("take_" + juce::String(fileIndex) + ".wav");
+    nextTakeIndex = juce::jmax(nextTakeIndex, numImportedTakes + 1);
 
-                files[i].copyFileTo(dest);
-            }
+    if (phraseIndex != nullptr)
+        phraseIndex->refreshPhrase(currentPhraseDirectory, formatManager, true);
 
-            syncTakeLanesWithTakeTracks();
+    rebuildTakesFromPhraseDirectory();
+    syncTakeLanesWithTakeTracks();
+    analyseTakeFilesAsync();
+    refreshScheduler.invalidate(RefreshScheduler::takes);
 
-            repaint();
-            fileChooser.reset();
-        });
+    repaint();
 }
 
 //==============================================================================
@@ -746,37 +791,19 @@ void MainComponent::initialiseUserPhraseDirectory()
     const int maxPhrases = 999;
     currentPhraseDirectory = juce::File();
 
-    for (int idx = 1; idx <= maxPhrases; ++idx)
-    {
-        const juce::String phraseName = "phrase"
-            + juce::String(idx).paddedLeft('0', 2);
-        juce::File phraseDir = singerDir.getChildFile(phraseName);
-
-        bool useThis = false;
-
-        if (!phraseDir.exists())
-        {
-            phraseDir.createDirectory();
-            useThis = true;
-        }
-        else
-        {
-            bool hasFiles = false;
-            juce::DirectoryIterator it(phraseDir, false, "*", juce::File::findFiles);
+    // The index knows which phrases have files; only stale entries touch the disk
+    phraseIndex = std::make_unique<PhraseIndex>(singerDir);
+    phraseIndex->open(formatManager);
 
-            if (it.next())
-                hasFiles = true;
+    if (const int idx = phraseIndex->findFirstEmptyPhrase(maxPhrases); idx > 0)
+    {
+        juce::File phraseDir = singerDir.getChildFile(PhraseIndex::getPhraseName(idx));
+        phraseDir.createDirectory();
 
-            if (!hasFiles)
-                useThis = true;
-        }
+        currentPhraseDirectory = phraseDir;
+        currentPhraseIndex = idx;
 
-        if (useThis)
-        {
-            currentPhraseDirectory = phraseDir;
-            currentPhraseIndex = idx;
-            break;
-        }
+        phraseIndex->refreshPhrase(phraseDir, formatManager);
     }
 
     if (!currentPhraseDirectory.exists())
@@ -812,51 +839,99 @@ namespace
     };
 }
 
+void MainComponent::rebuildTakesForDeviceRate()
+{
+    if (isRecording || timelineSampleRate <= 0.0 || currentSampleRate == timelineSampleRate)
+        return;
+
+    takePlayer.stop();
+    takePlayer.unload();
+    selectedTakeIndex = -1;
+    soloTakeIndex = -1;
+    publishPlaybackState();
+
+    rebuildTakesFromPhraseDirectory();
+    syncTakeLanesWithTakeTracks();
+    analyseTakeFilesAsync();
+    refreshScheduler.invalidate(RefreshScheduler::takes);
+}
+
 void MainComponent::rebuildTakesFromPhraseDirectory()
 {
-    const juce::ScopedLock sl(vocalLock);
+    // vocalLock is held only while the store and the take lists change, not
+    // while takes are read and converted, nor while blocks are spilled
+    {
+        const juce::ScopedLock sl(vocalLock);
 
-    vocalWaveBuffer.setSize(0, 0);
-    takeTracks.clear();
-    totalRecordedSamples = 0;
-    loopLengthSamples = 0;
-    vocalBufferCapacitySamples = 0;
+        vocalStore.reset();
+        takeTracks.clear();
+        clearTakeAnalysis();
+        totalRecordedSamples = 0;
+        loopLengthSamples = 0;
+        timelineSampleRate = 0.0;
+    }
 
     if (!currentPhraseDirectory.isDirectory())
         return;
 
     juce::Array<juce::File> takeFiles;
-    currentPhraseDirectory.findChildFiles(takeFiles,
-        juce::File::findFiles,
-        false,
-        "take_*.wav");
+
+    const auto* indexed = (phraseIndex != nullptr)
+        ? phraseIndex->refreshPhrase(currentPhraseDirectory, formatManager)
+        : nullptr;
+
+    if (indexed != nullptr)
+    {
+        for (const auto& t : indexed->takes)
+            takeFiles.add(currentPhraseDirectory.getChildFile(t.fileName));
+    }
+    else
+    {
+        // Outside the indexed singer directory
+        currentPhraseDirectory.findChildFiles(takeFiles,
+            juce::File::findFiles,
+            false,
+            "take_*.wav");
+
+        takeFiles.sort(TakeFileComparator(), true);
+    }
 
     if (takeFiles.isEmpty())
         return;
 
-    takeFiles.sort(TakeFileComparator(), true);
-
     std::unique_ptr<juce::AudioFormatReader> firstReader(
-        formatManager.createReaderFor(takeFiles[0]));
+        readerPool.createReaderFor(takeFiles[0]));
 
     if (firstReader == nullptr)
         return;
 
     const double sr = firstReader->sampleRate;
-    const int    samplesPerTake = (int)firstReader->lengthInSamples;
 
-    if (samplesPerTake <= 0)
+    if (sr <= 0.0 || firstReader->lengthInSamples <= 0)
         return;
 
-    loopLengthSamples = samplesPerTake;
-    cachedLoopLengthSec = (sr > 0.0) ? (double)samplesPerTake / sr : 0.0;
+    // Older projects: the takes on disk define the project rate
+    if (projectSampleRate <= 0.0)
+        projectSampleRate = sr;
+
+    // In memory the takes are at the device rate, converted here once if the
+    // files are not; the loop length comes from the grid either way
+    const double timelineRate = currentSampleRate > 0.0 ? currentSampleRate : sr;
+    const int    samplesPerTake = (timelineRate == sr)
+        ? (int)firstReader->lengthInSamples
+        : ProjectState::gridLoopLengthSamples((double)firstReader->lengthInSamples / sr,
+            bpmSet ? bpm : 0, timelineRate);
 
-    const int numTakes = takeFiles.size();
-    vocalBufferCapacitySamples = numTakes * samplesPerTake;
+    if (samplesPerTake <= 0)
+        return;
+
+    {
+        const juce::ScopedLock sl(vocalLock);
+        loopLengthSamples = samplesPerTake;
+        timelineSampleRate = timelineRate;
+    }
 
-    vocalWaveBuffer.setSize(1,
-        vocalBufferCapacitySamples,
-        false, false, false);
+    cachedLoopLengthSec = (double)samplesPerTake / timelineRate;
 
     juce::AudioSampleBuffer temp(1, samplesPerTake);
 
@@ -866,25 +941,25 @@ void MainComponent::rebuildTakesFromPhraseDirectory()
     for (const auto& f : takeFiles)
     {
         std::unique_ptr<juce::AudioFormatReader> r(
-            formatManager.createReaderFor(f));
+            readerPool.createReaderFor(f));
 
         if (r == nullptr)
             continue;
 
+        // Where the take is sung: measured once, then read from its sidecar
+        auto activity = TakeActivity::readSidecarFor(f);
+
+        if (activity == nullptr)
+        {
+            activity = ActivityAnalyser::analyse(*r, nullptr);
+            activity->writeToFile(TakeActivity::getSidecarFile(f));
+        }
+
+        // The whole take, as it plays: quiet room tone and tails are kept.
+        // The activity map is for analysis and peaks; only blocks that really
+        // are all zeros are released afterwards.
         temp.clear();
-        r->read(&temp,
-            0,
-            samplesPerTake,
-            0,
-            true,
-            false);
-
-        vocalWaveBuffer.copyFrom(0,
-            writePos,
-            temp,
-            0,
-            0,
-            samplesPerTake);
+        SincResampler::render(*r, timelineRate, 0, samplesPerTake, temp, 0, nullptr);
 
         TakeTrack t;
         t.startSample = writePos;
@@ -895,11 +970,26 @@ void MainComponent::rebuildTakesFromPhraseDirectory()
             takeIdx = takeTracks.size() + 1;
 
         t.name = "Take " + juce::String(takeIdx);
+        t.sourceFile = f;
+
+        // Display and analysis only, so ordinary heap blocks
+        vocalStore.reserve(writePos + samplesPerTake, vocalLock);
+
+        {
+            const juce::ScopedLock sl(vocalLock);
 
-        takeTracks.add(t);
+            vocalStore.append(temp.getReadPointer(0), samplesPerTake);
 
-        writePos += samplesPerTake;
-        totalRecordedSamples = writePos;
+            takeTracks.add(t);
+            takeActivity.add(std::move(activity));
+
+            writePos += samplesPerTake;
+            totalRecordedSamples = writePos;
+        }
+
+        // One take at a time, so a long session never has to fit in memory at once
+        vocalStore.releaseSilentBlocks(vocalLock);
+        vocalStore.spillColdBlocks(vocalLock);
 
         if (takeIdx > maxIndexFound)
             maxIndexFound = takeIdx;
@@ -909,6 +999,9 @@ void MainComponent::rebuildTakesFromPhraseDirectory()
         nextTakeIndex = maxIndexFound + 1;
     else
         nextTakeIndex = takeTracks.size() + 1;
+
+    // The frame spills what no longer fits the memory budget
+    refreshScheduler.invalidate(RefreshScheduler::takes);
 }
 
 //==============================================================================
@@ -920,7 +1013,10 @@ void MainComponent::splitFullRecordingIntoTakes(const juce::File& fullFile, int
     if (numLoops <= 0 || !fullFile.existsAsFile())
         return;
 
-    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(fullFile));
+    // Takes about to be written must not stay mapped
+    readerPool.invalidate(fullFile.getParentDirectory());
+
+    std::unique_ptr<juce::AudioFormatReader> reader(readerPool.createReaderFor(fullFile));
     if (reader == nullptr)
         return;
 
@@ -938,6 +1034,21 @@ void MainComponent::splitFullRecordingIntoTakes(const juce::File& fullFile, int
 
     juce::File baseDir = fullFile.getParentDirectory();
 
+    // The file starts at the first take of this recording pass
+    const int firstTakeInPass = recordingStartSample / loopLengthSamples;
+
+    // Takes are stored at the project rate, whatever the device ran at
+    const double fileRate = reader->sampleRate;
+    const double takeRate = projectSampleRate > 0.0 ? projectSampleRate : fileRate;
+    const int64 takeLengthAtTakeRate = (takeRate == fileRate) ? loopLenSamples
+        : (int64)ProjectState::gridLoopLengthSamples(cachedLoopLengthSec, bpmSet ? bpm : 0, takeRate);
+
+    // Clip runs of this pass, on the vocal timeline like recordingStartSample
+    inputMonitor.takeClipRuns(recordedClipRuns);
+
+    // Measured and hashed here, so the phrase index does not read them back
+    std::vector<PhraseIndex::Take> writtenTakes;
+
     for (int takeIdx = 0; takeIdx < numLoops; ++takeIdx)
     {
         const int64 takeStart = (int64)takeIdx * loopLenSamples;
@@ -946,16 +1057,17 @@ void MainComponent::splitFullRecordingIntoTakes(const juce::File& fullFile, int
         if (takeSamples <= 0)
             break;
 
+        const int takeNumber = nextTakeIndex++;
         juce::File takeFile =
-            baseDir.getChildFile("take_" + juce::String(nextTakeIndex++) + ".wav");
+            baseDir.getChildFile("take_" + juce::String(takeNumber) + ".wav");
 
-        std::unique_ptr<juce::FileOutputStream> outStream(takeFile.createOutputStream());
-        if (outStream == nullptr || !outStream->openedOk())
-            continue;
+        // The take is built in memory (a few MB) and written in one go, so its
+        // MD5 is taken from the bytes at hand instead of reading the file again
+        juce::MemoryBlock takeData;
 
         std::unique_ptr<juce::AudioFormatWriter> writer(
-            wavFormat.createWriterFor(outStream.release(),
-                reader->sampleRate,
+            wavFormat.createWriterFor(new juce::MemoryOutputStream(takeData, false),
+                takeRate,
                 1,
                 16,
                 {},
@@ -964,27 +1076,111 @@ void MainComponent::splitFullRecordingIntoTakes(const juce::File& fullFile, int
         if (writer == nullptr)
             continue;
 
-        int64 remaining = takeSamples;
-        int64 srcPos = takeStart;
+        // Positions at the take rate (the same as the file's unless converting)
+        int64 remaining = (takeSamples == loopLenSamples) ? takeLengthAtTakeRate
+            : (int64)std::llround((double)takeSamples * takeRate / fileRate);
+        int64 srcPos = (int64)takeIdx * takeLengthAtTakeRate;
+        const int64 takeLengthWritten = remaining;
+
+        // Loudness, activity and onsets are measured on the same blocks as they are written
+        LoudnessAnalyser loudness(takeRate);
+        ActivityAnalyser activity(takeRate);
+        OnsetAnalyser onsets(takeRate);
 
         while (remaining > 0)
         {
             const int64 thisBlock = juce::jmin<int64>(blockSize, remaining);
             tempBuffer.clear();
 
-            reader->read(&tempBuffer,
-                0,
-                (int)thisBlock,
-                srcPos,
-                true,
-                false);
+            SincResampler::render(*reader, takeRate, srcPos, srcPos + thisBlock,
+                tempBuffer, 0, nullptr);
 
             writer->writeFromAudioSampleBuffer(tempBuffer, 0, (int)thisBlock);
+            loudness.process(tempBuffer.getReadPointer(0), (int)thisBlock);
+            activity.process(tempBuffer.getReadPointer(0), (int)thisBlock);
+            onsets.process(tempBuffer.getReadPointer(0), (int)thisBlock);
 
             remaining -= thisBlock;
             srcPos += thisBlock;
         }
+
+        writer.reset();
+
+        if (!takeFile.replaceWithData(takeData.getData(), takeData.getSize()))
+            continue;
+
+        {
+            PhraseIndex::Take written;
+            written.fileName = takeFile.getFileName();
+            written.index = takeNumber;
+            written.numSamples = takeLengthWritten;
+            written.sampleRate = takeRate;
+            written.fileSize = (int64)takeData.getSize();
+            written.modifiedMs = takeFile.getLastModificationTime().toMilliseconds();
+            written.md5 = juce::MD5(takeData).toHexString();
+            writtenTakes.push_back(std::move(written));
+        }
+
+        // Reuse the live pitch curve so the take is not analysed again on load
+        const int globalTake = firstTakeInPass + takeIdx;
+
+        if (auto curve = livePitch.getCurveForTake(globalTake))
+            curve->writeToFile(takeFile.withFileExtension("f0"));
+
+        auto takeLoudnessResult = loudness.getResult();
+
+        {
+            // The callback's clip runs that fall in this take, in take seconds
+            const int64 takeOffset = (int64)recordingStartSample + takeStart;
+            std::vector<juce::Range<double>> clips;
+
+            for (const auto& run : recordedClipRuns)
+            {
+                const int64 s = juce::jmax<int64>(run.startSample - takeOffset, 0);
+                const int64 e = juce::jmin<int64>(run.startSample + run.numSamples - takeOffset, takeSamples);
+
+                if (e > s)
+                    clips.push_back({ (double)s / reader->sampleRate, (double)e / reader->sampleRate });
+            }
+
+            takeLoudnessResult->setClips(std::move(clips));
+        }
+
+        takeLoudnessResult->writeToFile(TakeLoudness::getSidecarFile(takeFile));
+        setTakeLoudness(globalTake, std::move(takeLoudnessResult));
+
+        auto takeActivityResult = activity.getResult();
+        takeActivityResult->writeToFile(TakeActivity::getSidecarFile(takeFile));
+
+        auto takeOnsetsResult = onsets.getResult();
+        takeOnsetsResult->writeToFile(TakeOnsets::getSidecarFile(takeFile));
+
+        {
+            const juce::ScopedLock sl(vocalLock);
+
+            if (globalTake < takeTracks.size())
+                takeTracks.getReference(globalTake).sourceFile = takeFile;
+
+            // The take's samples in vocalStore are the live ones and stay as
+            // they are; the map is for analysis and for the next load
+            if (takeActivity.size() <= globalTake)
+                takeActivity.resize(globalTake + 1);
+
+            takeActivity.set(globalTake, std::move(takeActivityResult));
+
+            if (takeOnsets.size() <= globalTake)
+                takeOnsets.resize(globalTake + 1);
+
+            takeOnsets.set(globalTake, std::move(takeOnsetsResult));
+        }
     }
 
+    recordedClipRuns.clearQuick();
+
+    reader.reset();
+    readerPool.invalidate(fullFile);
     fullFile.deleteFile();
+
+    if (phraseIndex != nullptr)
+        phraseIndex->refreshPhrase(baseDir, formatManager, true, writtenTakes);
 }
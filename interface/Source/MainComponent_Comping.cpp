@@ -1,5 +1,6 @@
 // MainComponent_Comping.cpp
 #include "MainComponent.h"
+#include "CompStitcher.h"
 #include <thread>
 
 //==============================================================================
@@ -77,6 +78,7 @@ void MainComponent::runCompingFromGui()
     lastCompFadeFraction = fadeFraction;
     compedSelected = true;
     compedSolo = false;
+    publishPlaybackState();
     refreshCompedButtons();
 
     // Figure out project root and python path
@@ -130,21 +132,32 @@ void MainComponent::runCompingFromGui()
     args.add("--out_compmap_path");
     args.add(compmapTargetFile.getFullPathName());
 
+    // Python scores and writes the compmap; the audio is stitched natively below
+    args.add("--skip_stitch");
+
+    CompStitcher::Settings stitchSettings;
+    stitchSettings.fadeFraction = fadeFraction;
+
+    // A previous comp at the same settings is about to be overwritten
+    readerPool.invalidate(compedTargetFile);
+
     // Make copies for the background thread (no references!)
     auto projectRootCopy = projectRoot;
     auto argsCopy = args;
     auto compedFileCopy = compedTargetFile;
     auto compmapFileCopy = compmapTargetFile;
+    auto phraseDirCopy = currentPhraseDirectory;
 
     // ---- DO THE HEAVY WORK ON A BACKGROUND THREAD ----
     std::thread([this,
         projectRootCopy,
         argsCopy,
         compedFileCopy,
-        compmapFileCopy]() mutable
+        compmapFileCopy,
+        phraseDirCopy,
+        stitchSettings]() mutable
         {
             bool success = false;
-            bool compmapMissing = false;
             juce::String errorMessage;
             juce::String processOutput;
 
@@ -165,17 +178,35 @@ void MainComponent::runCompingFromGui()
 
                 DBG("run_comping output:\n" + processOutput);
 
-                // Check that the comped file exists
-                if (!compedFileCopy.existsAsFile())
+                if (!compmapFileCopy.existsAsFile())
                 {
-                    errorMessage = "Python finished but the expected comped file "
-                        "was not found:\n"
-                        + compedFileCopy.getFullPathName();
+                    errorMessage = "Python finished but the expected compmap was not found:\n"
+                        + compmapFileCopy.getFullPathName();
                 }
                 else
                 {
-                    success = true;
-                    compmapMissing = !compmapFileCopy.existsAsFile();
+                    // Stitch with phase-refined splices
+                    const auto stitchResult = CompStitcher::stitch(compmapFileCopy,
+                        phraseDirCopy,
+                        compedFileCopy,
+                        stitchSettings,
+                        formatManager);
+
+                    if (stitchResult.failed())
+                    {
+                        errorMessage = "Stitching the comped file failed:\n"
+                            + stitchResult.getErrorMessage();
+                    }
+                    else if (!compedFileCopy.existsAsFile())
+                    {
+                        errorMessage = "Stitching finished but the expected comped file "
+                            "was not found:\n"
+                            + compedFileCopy.getFullPathName();
+                    }
+                    else
+                    {
+                        success = true;
+                    }
                 }
             }
 
@@ -185,7 +216,6 @@ void MainComponent::runCompingFromGui()
             // Jump back to JUCE message thread for all UI work
             juce::MessageManager::callAsync([this,
                 success,
-                compmapMissing,
                 errorMessage,
                 compedFileCopy,
                 compmapFileCopy]() mutable
@@ -222,17 +252,6 @@ void MainComponent::runCompingFromGui()
                     // Tell the progress component to jump to 100% and close
                     onCompingFinished(true);
 
-                    // Optional warning if the compmap is missing
-                    if (compmapMissing)
-                    {
-                        juce::AlertWindow::showMessageBoxAsync(
-                            juce::AlertWindow::WarningIcon,
-                            "Comping warning",
-                            "Comped audio was created, but the compmap JSON is missing:\n"
-                            + compmapFileCopy.getFullPathName()
-                            + "\n\nThe Comped tab will not show segment boundaries.");
-                    }
-
                     // Final "comping complete" dialog that switches to the Comped tab
                     juce::AlertWindow::showMessageBoxAsync(
                         juce::AlertWindow::InfoIcon,
@@ -248,6 +267,7 @@ void MainComponent::runCompingFromGui()
                                     DBG("CompReview: loadLastCompForReview() failed");
 
                                 viewMode = ViewMode::CompReview;
+                                publishPlaybackState();
                                 updateTabButtonStyles();
                                 resized();
                                 repaint();
@@ -272,7 +292,7 @@ bool MainComponent::loadCompedFile(const juce::File& file)
     }
 
     std::unique_ptr<juce::AudioFormatReader> reader(
-        formatManager.createReaderFor(file));
+        readerPool.createReaderFor(file));
 
     if (reader == nullptr)
     {
@@ -283,25 +303,17 @@ bool MainComponent::loadCompedFile(const juce::File& file)
         return false;
     }
 
-    auto newSource =
-        std::make_unique<juce::AudioFormatReaderSource>(reader.release(), true);
+    // Replaces the previous source, which the audio thread hands back
+    takePlayer.stop();
 
-    takeTransport.stop();
-    takeTransport.setSource(nullptr);
-    takeReaderSource.reset();
+    if (!takePlayer.load(std::move(reader)))
+        return false;
 
     selectedTakeIndex = -1;
     soloTakeIndex = -1;
+    publishPlaybackState();
 
-    takeTransport.setSource(
-        newSource.get(),
-        0,
-        nullptr,
-        currentSampleRate);
-
-    takeTransport.setLooping(true);
-
-    takeReaderSource = std::move(newSource);
+    updateTakePlaybackGain();
 
     return true;
 }
@@ -315,6 +327,10 @@ bool MainComponent::loadLastCompForReview()
     compSegments.clear();
     hasCompedThumbnail = false;
     compedThumbnail.clear();
+    compedPeaks.reset();
+    ++compedPeaksGeneration;
+    compedSpectrogram.reset();
+    ++compedSpectrogramGeneration;
 
     if (!hasLastCompResult)
     {
@@ -331,6 +347,10 @@ bool MainComponent::loadLastCompForReview()
 
     compedThumbnail.setSource(new juce::FileInputSource(lastCompedFile));
     hasCompedThumbnail = (compedThumbnail.getTotalLength() > 0.0);
+    rebuildCompedPeaks();
+
+    if (showSpectrogram)
+        rebuildCompedSpectrogram();
 
     if (!hasCompedThumbnail)
     {
@@ -0,0 +1,214 @@
+// MainComponent_Diagnostics.cpp
+#include "MainComponent.h"
+#include "CompStitcher.h"
+
+using int64 = juce::int64;
+
+namespace
+{
+    // AudioThumbnail has no size of its own: one 2-byte min/max pair per
+    // channel per 512 samples (the resolution both thumbnails are made with)
+    int64 estimateThumbnailBytes(const juce::AudioThumbnail& t)
+    {
+        return (int64)t.getNumChannels() * (t.getNumSamplesFinished() / 512 + 1) * 2;
+    }
+}
+
+//==============================================================================
+// Memory accounting
+//==============================================================================
+
+void MainComponent::reportMemoryUsage()
+{
+    using Category = MemoryRegistry::Category;
+
+    const auto takeStats = vocalStore.getStats();
+    const auto arenaStats = realtimeArena.getStats();
+
+    memoryRegistry.set(Category::takeBlocks, (int64)takeStats.residentBytes);
+    memoryRegistry.set(Category::takeDecoded, (int64)takeStats.decodedBytes);
+    memoryRegistry.set(Category::takeSpilled, (int64)takeStats.spilledBytes);
+
+    // The recording's take blocks come from the arena too
+    memoryRegistry.set(Category::audioBuffers,
+        juce::jmax<int64>(0, (int64)arenaStats.mappedBytes - (int64)takeStats.realtimeBytes));
+
+    memoryRegistry.set(Category::instrumentalCache,
+        instrumentalCache != nullptr ? (int64)instrumentalCache->getMemoryUsage() : 0);
+
+    int64 peaks = 0;
+    for (const auto& cache : { instrumentalPeaks, compedPeaks })
+        if (cache != nullptr)
+            peaks += (int64)cache->getMemoryUsage();
+    for (const auto& cache : takePeakCaches)
+        if (cache != nullptr)
+            peaks += (int64)cache->getMemoryUsage();
+    memoryRegistry.set(Category::waveformPeaks, peaks);
+
+    int64 spectrograms = compedSpectrogram != nullptr ? (int64)compedSpectrogram->getMemoryUsage() : 0;
+    for (const auto& cache : takeSpectrograms)
+        if (cache != nullptr)
+            spectrograms += (int64)cache->getMemoryUsage();
+    memoryRegistry.set(Category::spectrograms, spectrograms);
+
+    memoryRegistry.set(Category::thumbnails,
+        estimateThumbnailBytes(thumbnail) + estimateThumbnailBytes(compedThumbnail));
+
+    int64 analysis = 0;
+    for (const auto& curve : takePitchCurves)
+        if (curve != nullptr)
+            analysis += (int64)curve->getNumFrames() * (int64)sizeof(float);
+    for (const auto& loudness : takeLoudness)
+        if (loudness != nullptr)
+            analysis += (int64)loudness->getMemoryUsage();
+    for (const auto& activity : takeActivity)
+        if (activity != nullptr)
+            analysis += (int64)activity->getMemoryUsage();
+    for (const auto& onsets : takeOnsets)
+        if (onsets != nullptr)
+            analysis += (int64)onsets->getMemoryUsage();
+    memoryRegistry.set(Category::takeAnalysis, analysis);
+
+    memoryRegistry.set(Category::mappedFiles, readerPool.getMappedBytes());
+
+    if (memoryPanel.isVisible())
+        memoryPanel.setLines(memoryRegistry.getDescription());
+}
+
+void MainComponent::logMemoryUsage(const juce::String& when)
+{
+    reportMemoryUsage();
+
+    juce::Logger::writeToLog("Memory (" + when + "):\n"
+        + memoryRegistry.getDescription().joinIntoString("\n"));
+}
+
+//==============================================================================
+// Scaling test (--scale-test): a synthetic session, then the app timed on it
+//==============================================================================
+
+void MainComponent::startScaleTest(const SessionGenerator::Settings& settings)
+{
+    DBG("Scale test: generating under " << settings.rootDirectory.getFullPathName());
+
+    // Hundreds of takes to write: off the message thread
+    juce::Component::SafePointer<MainComponent> safeThis(this);
+
+    backgroundPool.addJob([safeThis, settings]
+        {
+            auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob();
+            const auto shouldExit = [job] { return job != nullptr && job->shouldExit(); };
+
+            const double startMs = juce::Time::getMillisecondCounterHiRes();
+            juce::Array<SessionGenerator::Phrase> phrases;
+            const auto result = SessionGenerator::generate(settings, phrases, shouldExit);
+            const double generateMs = juce::Time::getMillisecondCounterHiRes() - startMs;
+
+            juce::MessageManager::callAsync([safeThis, settings, phrases, result, generateMs]
+                {
+                    if (safeThis == nullptr)
+                        return;
+
+                    if (result.failed())
+                        juce::Logger::writeToLog("Scale test: " + result.getErrorMessage());
+                    else
+                        safeThis->runScaleTest(settings, phrases, generateMs);
+                });
+        });
+}
+
+void MainComponent::runScaleTest(const SessionGenerator::Settings& settings,
+    const juce::Array<SessionGenerator::Phrase>& phrases, double generateMs)
+{
+    auto timeMs = [](auto&& step)
+        {
+            const double t0 = juce::Time::getMillisecondCounterHiRes();
+            step();
+            return juce::Time::getMillisecondCounterHiRes() - t0;
+        };
+
+    juce::Array<juce::var> rows;
+
+    for (const auto& phrase : phrases)
+    {
+        auto* row = new juce::DynamicObject();
+        row->setProperty("phrase", phrase.index);
+        row->setProperty("takes", phrase.numTakes);
+
+        // Comping: the native stitch only, the Python scoring is not part of the app
+        juce::Result stitched = juce::Result::ok();
+        row->setProperty("comp_stitch_ms", timeMs([&]
+            {
+                stitched = CompStitcher::stitch(phrase.compmapFile, phrase.directory,
+                    phrase.compedFile, CompStitcher::Settings(), formatManager);
+            }));
+
+        if (stitched.failed())
+            row->setProperty("error", stitched.getErrorMessage());
+
+        // Load: the whole of applyProjectState, as from the Load button
+        row->setProperty("load_ms", timeMs([&]
+            {
+                ProjectState state;
+                juce::String error;
+
+                if (ProjectState::loadFromFile(state, phrase.projectFile, error))
+                    applyProjectState(state);
+                else
+                    row->setProperty("error", error);
+            }));
+
+        // The parts of the load that grow with the take count, again on their own
+        row->setProperty("rebuild_takes_ms", timeMs([&] { rebuildTakesFromPhraseDirectory(); }));
+        row->setProperty("sync_lanes_ms", timeMs([&] { syncTakeLanesWithTakeTracks(); }));
+        row->setProperty("comp_review_ms", timeMs([&] { loadLastCompForReview(); }));
+
+        // A full frame in either view, children included
+        for (auto mode : { ViewMode::Recording, ViewMode::CompReview })
+        {
+            viewMode = mode;
+            resized();
+
+            row->setProperty(mode == ViewMode::Recording ? "paint_recording_ms" : "paint_comp_review_ms",
+                timeMs([&] { createComponentSnapshot(getLocalBounds()); }));
+        }
+
+        viewMode = ViewMode::Recording;
+        publishPlaybackState();
+        updateTabButtonStyles();
+        resized();
+
+        row->setProperty("save_ms", timeMs([&]
+            {
+                juce::String error;
+                ProjectState::saveToFile(createProjectState(),
+                    phrase.projectFile.withFileExtension("saved.json"), error);
+            }));
+
+        reportMemoryUsage();
+        row->setProperty("memory", memoryRegistry.toVar());
+        rows.add(juce::var(row));
+
+        DBG("Scale test: " << juce::JSON::toString(rows.getLast(), true));
+    }
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("instrumental_s", settings.instrumentalSeconds);
+    report->setProperty("loop_s", settings.loopSeconds);
+    report->setProperty("sample_rate", settings.sampleRate);
+    report->setProperty("segments_per_comp", settings.segmentsPerComp);
+    report->setProperty("generate_ms", generateMs);
+    report->setProperty("phrases", rows);
+
+    // Waveform, analysis and spectrogram jobs the loads started are not included
+    const auto json = juce::JSON::toString(juce::var(report), false);
+    const auto reportFile = settings.rootDirectory.getChildFile("scale-report.json");
+    reportFile.replaceWithText(json);
+
+    juce::Logger::writeToLog("Scale test report: " + reportFile.getFullPathName() + "\n" + json);
+
+    repaint();
+
+    if (settings.quitWhenDone)
+        juce::JUCEApplicationBase::quit();
+}
@@ -24,6 +24,8 @@ void MainComponent::buttonClicked(juce::Button* button)
     }
     else if (button == &playButton)
     {
+        refreshScheduler.invalidate(RefreshScheduler::playback);
+
         const bool haveInstrumental = (readerSource.get() != nullptr);
 
         if (haveInstrumental)
@@ -45,7 +47,7 @@ void MainComponent::buttonClicked(juce::Button* button)
                 const bool soloMode = (soloTakeIndex >= 0);
                 const int  indexToUse = soloMode ? soloTakeIndex : selectedTakeIndex;
 
-                if (takeReaderSource == nullptr)
+                if (!takePlayer.hasSource())
                 {
                     if (soloMode)
                         setSoloTake(indexToUse);
@@ -53,30 +55,32 @@ void MainComponent::buttonClicked(juce::Button* button)
                         setSelectedTake(indexToUse);
                 }
 
-                if (takeReaderSource != nullptr)
+                if (takePlayer.hasSource())
                 {
-                    takeTransport.setPosition(0.0);
-                    takeTransport.start();
+                    takePlayer.setPosition(0.0);
+                    takePlayer.start();
                 }
             }
         }
         else if (viewMode == ViewMode::CompReview)
         {
-            if (takeReaderSource != nullptr && (compedSelected || compedSolo))
+            if (takePlayer.hasSource() && (compedSelected || compedSolo))
             {
-                takeTransport.setPosition(0.0);
-                takeTransport.start();
+                takePlayer.setPosition(0.0);
+                takePlayer.start();
             }
         }
     }
     else if (button == &stopButton)
     {
+        refreshScheduler.invalidate(RefreshScheduler::playback);
+
         if (isRecording)
             stopRecording();
         else
             transportSource.stop();
 
-        takeTransport.stop();
+        takePlayer.stop();
     }
     else if (button == &saveProjectButton)
     {
@@ -150,61 +154,83 @@ void MainComponent::buttonClicked(juce::Button* button)
             if (writerSampleRate <= 0.0)
                 writerSampleRate = 44100.0;
 
-            {
-                const juce::ScopedLock sl(writerLock);
-                recordingWriter.reset(
-                    wavFormat.createWriterFor(outStream.release(),
-                        writerSampleRate,
-                        1,
-                        16,
-                        {},
-                        0));
-            }
+            std::unique_ptr<juce::AudioFormatWriter> fileWriter(
+                wavFormat.createWriterFor(outStream.release(),
+                    writerSampleRate,
+                    1,
+                    16,
+                    {},
+                    0));
 
-            if (recordingWriter == nullptr)
+            if (fileWriter == nullptr)
             {
                 --fullRecordingIndex;
                 return;
             }
 
-            loopLengthSamples = (cachedLoopLengthSec > 0.0 && currentSampleRate > 0.0)
-                ? juce::roundToInt(cachedLoopLengthSec * currentSampleRate)
-                : 0;
+            // The callback queues into the FIFO; this thread writes the file
+            if (!recordingWriterThread.isThreadRunning())
+                recordingWriterThread.startThread();
+
+            recordingWriter = std::make_unique<juce::AudioFormatWriter::ThreadedWriter>(
+                fileWriter.release(), recordingWriterThread, recordingWriterFifoSamples);
+
+            // The first take fixes the project rate; the loop is a whole number
+            // of samples taken from the grid, not rounded seconds
+            if (projectSampleRate <= 0.0)
+                projectSampleRate = writerSampleRate;
 
+            loopLengthSamples = ProjectState::gridLoopLengthSamples(cachedLoopLengthSec,
+                bpmSet ? bpm : 0, writerSampleRate);
+            timelineSampleRate = writerSampleRate;
+
+            if (fullRecordingIndex == 1)
             {
-                const juce::ScopedLock sl(vocalLock);
+                const double maxRecordingSeconds = 5.0 * 60.0;
+                int capacitySamples = (int)(currentSampleRate * maxRecordingSeconds);
+                if (capacitySamples <= 0)
+                    capacitySamples = 44100 * 60;
+
+                const int maxExpectedTakes =
+                    (loopLengthSamples > 0 && cachedLoopLengthSec > 0.0)
+                    ? juce::jmax(32, (int)(maxRecordingSeconds / cachedLoopLengthSec) + 4)
+                    : 256;
 
-                if (fullRecordingIndex == 1)
                 {
+                    const juce::ScopedLock sl(vocalLock);
+
                     totalRecordedSamples = 0;
                     takeTracks.clear();
-
-                    const double maxRecordingSeconds = 5.0 * 60.0;
-                    vocalBufferCapacitySamples = (int)(currentSampleRate * maxRecordingSeconds);
-                    if (vocalBufferCapacitySamples <= 0)
-                        vocalBufferCapacitySamples = 44100 * 60;
-
-                    vocalWaveBuffer.setSize(1,
-                        vocalBufferCapacitySamples,
-                        false,
-                        false,
-                        false);
-
-                    const int maxExpectedTakes =
-                        (loopLengthSamples > 0 && cachedLoopLengthSec > 0.0)
-                        ? juce::jmax(32, (int)(maxRecordingSeconds / cachedLoopLengthSec) + 4)
-                        : 256;
+                    clearTakeAnalysis();
+                    vocalStore.reset();
 
                     takeTracks.ensureStorageAllocated(maxExpectedTakes);
                 }
+
+                // Faults in and locks the whole recording up front, with
+                // vocalLock only held while the blocks are added
+                vocalStore.reserveForRecording(capacitySamples, vocalLock);
+                DBG("Real-time memory: " << realtimeArena.getDescription());
             }
 
-            takeTransport.stop();
+            // Pitch is tracked off the audio thread; frames are filed per loop take
+            recordingStartSample = totalRecordedSamples;
+            livePitch.prepare(currentSampleRate, loopLengthSamples);
+            livePitch.beginRecording(recordingStartSample);
+
+            // Runs left over from an earlier pass belong to no take of this one
+            inputMonitor.takeClipRuns(recordedClipRuns);
+            recordedClipRuns.clearQuick();
+
+            syncTakeLanesWithTakeTracks();
+
+            takePlayer.stop();
 
             transportSource.setPosition(loopStartSec);
             transportSource.start();
 
             isRecording = true;
+            publishPlaybackState();
             recordButton.setButtonText("Stop Rec");
         }
         else
@@ -239,7 +265,7 @@ void MainComponent::buttonClicked(juce::Button* button)
     else if (button == &compedSelectButton)
     {
         const bool haveInstrumental = (readerSource.get() != nullptr);
-        const bool canPlayComped = (!isRecording && takeReaderSource != nullptr);
+        const bool canPlayComped = (!isRecording && takePlayer.hasSource());
 
         if (compedSelected)
             compedSelected = false;
@@ -249,6 +275,8 @@ void MainComponent::buttonClicked(juce::Button* button)
             compedSolo = false;
         }
 
+        publishPlaybackState();
+
         if (canPlayComped)
         {
             if (compedSelected)
@@ -264,13 +292,13 @@ void MainComponent::buttonClicked(juce::Button* button)
                     transportSource.stop();
                 }
 
-                takeTransport.setPosition(0.0);
-                takeTransport.start();
+                takePlayer.setPosition(0.0);
+                takePlayer.start();
             }
             else
             {
                 // deselected -> stop comped playback
-                takeTransport.stop();
+                takePlayer.stop();
             }
         }
 
@@ -280,7 +308,7 @@ void MainComponent::buttonClicked(juce::Button* button)
     else if (button == &compedSoloButton)
     {
         const bool haveInstrumental = (readerSource.get() != nullptr);
-        const bool canPlayComped = (!isRecording && takeReaderSource != nullptr);
+        const bool canPlayComped = (!isRecording && takePlayer.hasSource());
         juce::ignoreUnused(haveInstrumental);
 
         if (compedSolo)
@@ -291,19 +319,21 @@ void MainComponent::buttonClicked(juce::Button* button)
             compedSelected = false;
         }
 
+        publishPlaybackState();
+
         if (canPlayComped)
         {
             if (compedSolo)
             {
                 // Solo -> stop instrumental, only comped
                 transportSource.stop();
-                takeTransport.setPosition(0.0);
-                takeTransport.start();
+                takePlayer.setPosition(0.0);
+                takePlayer.start();
             }
             else
             {
                 // Unsolo -> stop comped; user can hit PLAY if they want both
-                takeTransport.stop();
+                takePlayer.stop();
             }
         }
 
@@ -314,8 +344,9 @@ void MainComponent::buttonClicked(juce::Button* button)
     else if (button == &recordingTabButton)
     {
         transportSource.stop();               
-        takeTransport.stop();
+        takePlayer.stop();
         viewMode = ViewMode::Recording;
+        publishPlaybackState();
         updateTabButtonStyles();
         resized();
         repaint();
@@ -338,9 +369,10 @@ void MainComponent::buttonClicked(juce::Button* button)
         }
 
         transportSource.stop();             
-        takeTransport.stop();
+        takePlayer.stop();
 
         viewMode = ViewMode::CompReview;
+        publishPlaybackState();
         updateTabButtonStyles();
         refreshCompedButtons();
         resized();
@@ -408,14 +440,65 @@ void MainComponent::buttonClicked(juce::Button* button)
     else if (button == &metronomeToggle)
     {
         metronomeOn = metronomeToggle.getToggleState();
+        publishPlaybackState();
+    }
+    else if (button == &monitorToggle)
+    {
+        inputMonitor.setMonitoring(monitorToggle.getToggleState());
+        refreshScheduler.invalidate(RefreshScheduler::playback);
+    }
+    else if (button == &spectrogramToggle)
+    {
+        showSpectrogram = spectrogramToggle.getToggleState();
+
+        // Spectrograms are computed lazily, the first time they are shown
+        if (showSpectrogram && compedSpectrogram == nullptr && hasCompedThumbnail)
+            rebuildCompedSpectrogram();
+
+        syncTakeLanesWithTakeTracks();
+
+        for (auto* lane : takeLaneComponents)
+            lane->setShowSpectrogram(showSpectrogram);
+
+        repaint();
     }
 }
 
 //==============================================================================
 
-void MainComponent::timerCallback()
+void MainComponent::refreshFrame(juce::uint32 reasons)
 {
+    // Nothing to animate: only keep the meters moving and drained
+    if (reasons == RefreshScheduler::idle)
+    {
+        updateInputMeters();
+        return;
+    }
+
+    // While recording, a lane appears as soon as the callback starts its loop
+    if (isRecording)
+        addTakeTracksUpTo(totalRecordedSamples.load(std::memory_order_acquire));
+
     syncTakeLanesWithTakeTracks();
+
+    // Silent take blocks are dropped; past the memory budget, cold ones move
+    // to the spill file. Both take vocalLock only to hand blocks over.
+    vocalStore.releaseSilentBlocks(vocalLock);
+    vocalStore.spillColdBlocks(vocalLock);
+
+    // Sources the audio thread swapped out are deleted here, not there
+    takePlayer.releaseRetiredSources();
+
+    // Memory by category, a couple of times a second at most
+    if (const double now = juce::Time::getMillisecondCounterHiRes();
+        now - lastMemoryReportMs >= MemoryRegistry::sampleIntervalMs)
+    {
+        lastMemoryReportMs = now;
+        reportMemoryUsage();
+    }
+
+    updateInputMeters();
+
     if (transportSource.isPlaying() && hasValidLoop())
     {
         const double pos = transportSource.getCurrentPosition();
@@ -430,19 +513,19 @@ void MainComponent::timerCallback()
             {
                 shouldRestartTake =
                     (selectedTakeIndex >= 0 || soloTakeIndex >= 0)
-                    && takeReaderSource != nullptr;
+                    && takePlayer.hasSource();
             }
             else if (viewMode == ViewMode::CompReview)
             {
                 shouldRestartTake =
                     (compedSelected || compedSolo)
-                    && takeReaderSource != nullptr;
+                    && takePlayer.hasSource();
             }
 
             if (shouldRestartTake)
             {
-                takeTransport.setPosition(0.0);
-                takeTransport.start();
+                takePlayer.setPosition(0.0);
+                takePlayer.start();
             }
         }
 
@@ -450,26 +533,37 @@ void MainComponent::timerCallback()
 
     if (viewMode == ViewMode::Recording)
     {
-        // Keep number of lanes in sync with the take list
-        syncTakeLanesWithTakeTracks();
-
         // Compute a global time in seconds for the playhead
         double globalTime = transportSource.getCurrentPosition();
 
         if (hasValidLoop())
         {
             // When only the take is playing (no instrumental), align it to the loop
-            if (!transportSource.isPlaying() && takeTransport.isPlaying())
-                globalTime = loopStartSec + takeTransport.getCurrentPosition();
+            if (!transportSource.isPlaying() && takePlayer.isPlaying())
+                globalTime = loopStartSec + takePlayer.getCurrentPosition();
         }
 
         updateTakeLanePlayhead(globalTime);
     }
 
-    if (transportSource.isPlaying() || takeTransport.isPlaying())
+    // Any number of thumbnail updates since the last frame end up here once
+    if ((reasons & RefreshScheduler::thumbnail) != 0)
+        updateTimelineScrollBar();
 
+    repaint();
+}
 
-        repaint();
+void MainComponent::updateInputMeters()
+{
+    // Input levels since the last frame, and clip runs for the takes' metadata
+    InputMonitor::Level levels[InputMeter::maxChannels];
+    const int numInputs = inputMonitor.takeLevels(levels, InputMeter::maxChannels);
+
+    inputMeter.setNumChannels(numInputs);
+    for (int ch = 0; ch < numInputs; ++ch)
+        inputMeter.setLevel(ch, levels[ch].peak, levels[ch].rms, levels[ch].clipped);
+
+    inputMonitor.takeClipRuns(recordedClipRuns);
 }
 
 //==============================================================================
@@ -478,14 +572,14 @@ void MainComponent::changeListenerCallback(juce::ChangeBroadcaster* source)
 {
     if (source == &thumbnail)
     {
-        repaint();
+        refreshScheduler.invalidate(RefreshScheduler::thumbnail);
     }
     else if (source == &compedThumbnail)
     {
         if (compedThumbnail.getTotalLength() > 0.0)
             hasCompedThumbnail = true;
 
-        repaint();
+        refreshScheduler.invalidate(RefreshScheduler::thumbnail);
     }
 }
 
@@ -518,12 +612,89 @@ void MainComponent::mouseDown(const juce::MouseEvent& event)
     const int mouseX = event.getPosition().getX();
     const int handleRadius = 12;
 
-    if (std::abs(mouseX - xStart) <= handleRadius)
+    // Handles scrolled out of view sit clamped at the edge; don't grab those
+    if (isTimeInView(loopStartSec) && std::abs(mouseX - xStart) <= handleRadius)
         dragMode = DragMode::leftHandle;
-    else if (std::abs(mouseX - xEnd) <= handleRadius)
+    else if (isTimeInView(loopEndSec) && std::abs(mouseX - xEnd) <= handleRadius)
         dragMode = DragMode::rightHandle;
 }
 
+void MainComponent::mouseDoubleClick(const juce::MouseEvent& event)
+{
+    // Double-click on the instrumental zooms back out to the whole file
+    if (instrumentalWaveformBounds.contains(event.getPosition()))
+        resetTimelineView();
+}
+
+void MainComponent::mouseWheelMove(const juce::MouseEvent& event,
+    const juce::MouseWheelDetails& wheel)
+{
+    const auto pos = event.getPosition();
+
+    if (instrumentalWaveformBounds.contains(pos))
+    {
+        if (handleTimelineWheel(xToTime(event.position.x), wheel, event.mods, true))
+            return;
+    }
+    else if (viewMode == ViewMode::CompReview && takesAreaBounds.contains(pos))
+    {
+        juce::Rectangle<int> row, labelRect, waveRect, controlsRect;
+        getCompRowLayout(row, labelRect, waveRect, controlsRect);
+
+        if (waveRect.getWidth() > 0 && waveRect.contains(pos))
+        {
+            const auto view = getLoopViewRange();
+            const double proportion =
+                juce::jlimit(0.0, 1.0, (double)(pos.x - waveRect.getX()) / (double)waveRect.getWidth());
+
+            if (handleTimelineWheel(view.getStart() + proportion * view.getLength(),
+                wheel, event.mods, true))
+                return;
+        }
+    }
+
+    juce::Component::mouseWheelMove(event, wheel);
+}
+
+bool MainComponent::handleTimelineWheel(double anchorSec,
+    const juce::MouseWheelDetails& wheel,
+    juce::ModifierKeys mods,
+    bool plainWheelZooms)
+{
+    const auto view = getTimelineViewRange();
+    if (view.getLength() <= 0.0)
+        return false;
+
+    // Ctrl/Cmd+wheel zooms anywhere; a plain vertical wheel only zooms where
+    // there is nothing else to scroll (take lanes keep their vertical scrolling)
+    const bool wantsZoom = mods.isCommandDown() || mods.isCtrlDown()
+        || (plainWheelZooms && !mods.isShiftDown() && wheel.deltaX == 0.0f);
+
+    if (wantsZoom && wheel.deltaY != 0.0f)
+    {
+        zoomTimeline(std::exp(-2.0 * (double)wheel.deltaY), anchorSec);
+        return true;
+    }
+
+    // Horizontal (or shift+vertical) wheel scrolls by half a view per notch
+    const float scrollDelta = (wheel.deltaX != 0.0f) ? wheel.deltaX
+        : (mods.isShiftDown() ? wheel.deltaY : 0.0f);
+
+    if (scrollDelta != 0.0f)
+    {
+        setTimelineViewRange(view - (double)scrollDelta * view.getLength() * 0.5);
+        return true;
+    }
+
+    return false;
+}
+
+void MainComponent::scrollBarMoved(juce::ScrollBar* scrollBar, double newRangeStart)
+{
+    if (scrollBar == &timelineScrollBar)
+        setTimelineViewRange(getTimelineViewRange().movedToStartAt(newRangeStart));
+}
+
 void MainComponent::mouseDrag(const juce::MouseEvent& event)
 {
     if (dragMode == DragMode::bpmAdjust)
@@ -578,6 +749,8 @@ void MainComponent::mouseDrag(const juce::MouseEvent& event)
         loopEndSec = newEnd;
     }
 
+    // Only the part of the new range not already in RAM is rendered
+    updateLoopRenderRange();
     repaint();
 }
 
@@ -607,8 +780,8 @@ void MainComponent::mouseMove(const juce::MouseEvent& event)
     const int mouseX = (int)event.position.x;
     const int handleRadius = 12;
 
-    if (std::abs(mouseX - xStart) <= handleRadius
-        || std::abs(mouseX - xEnd) <= handleRadius)
+    if ((isTimeInView(loopStartSec) && std::abs(mouseX - xStart) <= handleRadius)
+        || (isTimeInView(loopEndSec) && std::abs(mouseX - xEnd) <= handleRadius))
     {
         setMouseCursor(juce::MouseCursor::LeftRightResizeCursor);
     }
@@ -14,6 +14,7 @@ ProjectState MainComponent::createProjectState() const
     s.loopEndSec = loopEndSec;
     s.loopLocked = loopLocked;
     s.cachedLoopLengthSec = cachedLoopLengthSec;
+    s.projectSampleRate = projectSampleRate;
 
     s.bpm = bpm;
     s.bpmSet = bpmSet;
@@ -56,9 +57,13 @@ ProjectState MainComponent::createProjectState() const
 
 void MainComponent::resetProjectState()
 {
+    // The callback must be out of the writer and the store before they go
+    if (isRecording)
+        stopRecording();
+
     transportSource.stop();
-    transportSource.setSource(nullptr);
-    readerSource.reset();
+    setInstrumentalSource(nullptr, {});
+    readerPool.clear();
 
     thumbnail.clear();
 
@@ -76,39 +81,45 @@ void MainComponent::resetProjectState()
     playButton.setEnabled(false);
     stopButton.setEnabled(false);
 
-    {
-        const juce::ScopedLock sl(writerLock);
-        recordingWriter.reset();
-    }
+    recordingWriter.reset();
 
     isRecording = false;
     loopLocked = false;
     fullRecordingIndex = 0;
     nextTakeIndex = 1;
     cachedLoopLengthSec = 0.0;
+    projectSampleRate = 0.0;
     recordButton.setButtonText("Record");
     recordButton.setEnabled(false);
 
     selectedTakeIndex = -1;
     soloTakeIndex = -1;
-    takeTransport.stop();
-    takeTransport.setSource(nullptr);
-    takeReaderSource.reset();
+    takePlayer.stop();
+    takePlayer.unload();
 
     {
         const juce::ScopedLock sl(vocalLock);
-        vocalWaveBuffer.setSize(0, 0);
+        vocalStore.reset();
         totalRecordedSamples = 0;
         loopLengthSamples = 0;
+        timelineSampleRate = 0.0;
         takeTracks.clear();
-        vocalBufferCapacitySamples = 0;
+        clearTakeAnalysis();
     }
 
+    syncTakeLanesWithTakeTracks();
+
     currentInstrumentalFile = juce::File();
+    rebuildInstrumentalPeaks();
+    resetTimelineView();
 
     hasLastCompResult = false;
     hasCompedThumbnail = false;
     compedThumbnail.clear();
+    compedPeaks.reset();
+    ++compedPeaksGeneration;
+    compedSpectrogram.reset();
+    ++compedSpectrogramGeneration;
     compSegments.clear();
     lastCompAlphaPct = 0;
     lastCompCrossfadePct = 0;
@@ -117,6 +128,10 @@ void MainComponent::resetProjectState()
     compedSolo = false;
     compedTabButton.setEnabled(false);
     updateTabButtonStyles();
+    publishPlaybackState();
+
+    // What is still held now was not released by Start over
+    logMemoryUsage("start over");
 
     repaint();
 }
@@ -129,36 +144,35 @@ void MainComponent::applyProjectState(const ProjectState& s)
         stopRecording();
 
     transportSource.stop();
-    takeTransport.stop();
+    takePlayer.stop();
 
-    {
-        const juce::ScopedLock sl(writerLock);
-        recordingWriter.reset();
-    }
-
-    transportSource.setSource(nullptr);
+    recordingWriter.reset();
 
-    readerSource.reset();
+    setInstrumentalSource(nullptr, {});
     thumbnail.clear();
 
 
     {
         const juce::ScopedLock sl(vocalLock);
-        vocalWaveBuffer.setSize(0, 0);
+        vocalStore.reset();
         takeTracks.clear();
+        clearTakeAnalysis();
         totalRecordedSamples = 0;
         loopLengthSamples = 0;
-        vocalBufferCapacitySamples = 0;
     }
 
     selectedTakeIndex = -1;
     soloTakeIndex = -1;
 
-    takeTransport.setSource(nullptr);
-    takeReaderSource.reset();
+    takePlayer.unload();
+    publishPlaybackState();
 
     hasCompedThumbnail = false;
     compedThumbnail.clear();
+    compedPeaks.reset();
+    ++compedPeaksGeneration;
+    compedSpectrogram.reset();
+    ++compedSpectrogramGeneration;
     compSegments.clear();
 
     hasLastCompResult = false;
@@ -183,6 +197,7 @@ void MainComponent::applyProjectState(const ProjectState& s)
     loopEndSec = s.loopEndSec;
     loopLocked = s.loopLocked;
     cachedLoopLengthSec = s.cachedLoopLengthSec;
+    projectSampleRate = s.projectSampleRate;
 
     fullRecordingIndex = s.fullRecordingIndex;
     nextTakeIndex = s.nextTakeIndex;
@@ -191,7 +206,7 @@ void MainComponent::applyProjectState(const ProjectState& s)
     if (currentInstrumentalFile.existsAsFile())
     {
         std::unique_ptr<juce::AudioFormatReader> reader(
-            formatManager.createReaderFor(currentInstrumentalFile));
+            readerPool.createReaderFor(currentInstrumentalFile));
 
         if (reader != nullptr)
         {
@@ -202,13 +217,7 @@ void MainComponent::applyProjectState(const ProjectState& s)
             const double totalLengthSec =
                 (double)newSource->getAudioFormatReader()->lengthInSamples / sr;
 
-            transportSource.setSource(newSource.get(),
-                0,
-                nullptr,
-                sr);
-            transportSource.setLooping(false);
-
-            readerSource = std::move(newSource);
+            setInstrumentalSource(std::move(newSource), currentInstrumentalFile);
 
             thumbnail.setSource(new juce::FileInputSource(currentInstrumentalFile));
             minLoopLengthSec = juce::jmin(5.0, totalLengthSec);
@@ -220,10 +229,16 @@ void MainComponent::applyProjectState(const ProjectState& s)
             loopEndSec = juce::jlimit(loopStartSec + minLoopLengthSec,
                 totalLengthSec,
                 loopEndSec);
+            updateLoopRenderRange();
         }
     }
 
+    rebuildInstrumentalPeaks();
+    resetTimelineView();
+
     rebuildTakesFromPhraseDirectory();
+    syncTakeLanesWithTakeTracks();
+    analyseTakeFilesAsync();
 
     if (s.selectedTakeIndex >= 0 && s.selectedTakeIndex < takeTracks.size())
         selectedTakeIndex = s.selectedTakeIndex;
@@ -234,7 +249,7 @@ void MainComponent::applyProjectState(const ProjectState& s)
     double vol = s.takeVolume;
     vol = juce::jlimit(0.0, 1.5, vol);
     takeVolumeSlider.setValue(vol, juce::dontSendNotification);
-    takeTransport.setGain((float)vol);
+    updateTakePlaybackGain();
 
     hasLastCompResult = s.hasLastCompResult;
     lastCompedFile = juce::File(s.lastCompedFilePath);
@@ -287,6 +302,7 @@ void MainComponent::applyProjectState(const ProjectState& s)
         ? ViewMode::CompReview
         : ViewMode::Recording;
 
+    publishPlaybackState();
     updateTabButtonStyles();
 
     const bool haveInstrumental = (readerSource.get() != nullptr);
@@ -343,6 +359,8 @@ void MainComponent::saveProjectToFile()
                 return;
             }
 
+            logMemoryUsage("saved " + target.getFileName());
+
             juce::AlertWindow::showMessageBoxAsync(
                 juce::AlertWindow::InfoIcon,
                 "Project saved",
@@ -65,6 +65,11 @@ void MainComponent::paint(juce::Graphics& g)
 }
 
 void MainComponent::paintRecordingView(juce::Graphics& g)
+{
+    paintInstrumentalTrack(g, "Click 'IMPORT' to load a WAV file");
+}
+
+void MainComponent::paintInstrumentalTrack(juce::Graphics& g, const juce::String& emptyMessage)
 {
     g.setColour(juce::Colours::darkgrey.darker(0.5f));
     g.fillRect(instrumentalLabelBounds);
@@ -79,217 +84,102 @@ void MainComponent::paintRecordingView(juce::Graphics& g)
 
     const double totalLength = thumbnail.getTotalLength();
 
-    if (totalLength > 0.0)
-    {
-        auto innerBounds = instrumentalWaveformBounds.reduced(2);
-
-        g.setColour(juce::Colours::darkgrey.brighter(0.3f));
-        thumbnail.drawChannel(g,
-            innerBounds,
-            0.0,
-            totalLength,
-            0,
-            1.0f);
-
-        if (hasValidLoop())
-        {
-            const double startProp = juce::jlimit(0.0, 1.0, loopStartSec / totalLength);
-            const double endProp = juce::jlimit(0.0, 1.0, loopEndSec / totalLength);
-
-            const int totalW = innerBounds.getWidth();
-
-            const int loopX = innerBounds.getX()
-                + juce::roundToInt(startProp * (double)totalW);
-            const int loopW = juce::jmax(1,
-                juce::roundToInt((endProp - startProp) * (double)totalW));
-
-            juce::Rectangle<int> loopRect(loopX,
-                innerBounds.getY(),
-                loopW,
-                innerBounds.getHeight());
-
-            g.setColour(juce::Colours::lightgreen);
-            thumbnail.drawChannel(g,
-                loopRect,
-                loopStartSec,
-                loopEndSec,
-                0,
-                1.0f);
-        }
-
-        const double current = transportSource.getCurrentPosition();
-        if (current >= 0.0 && totalLength > 0.0)
-        {
-            const double proportion =
-                juce::jlimit(0.0, 1.0, current / totalLength);
-
-            const int x = instrumentalWaveformBounds.getX()
-                + juce::roundToInt(proportion
-                    * (double)instrumentalWaveformBounds.getWidth());
-
-            g.setColour(juce::Colours::yellow);
-            g.drawLine((float)x,
-                (float)instrumentalWaveformBounds.getY(),
-                (float)x,
-                (float)instrumentalWaveformBounds.getBottom(),
-                2.0f);
-        }
-
-        if (hasValidLoop())
-        {
-            const int   xStart = timeToX(loopStartSec);
-            const int   xEnd = timeToX(loopEndSec);
-
-            const float topY = (float)instrumentalWaveformBounds.getY();
-            const float bottomY = (float)instrumentalWaveformBounds.getBottom();
-
-            g.setColour(juce::Colours::red);
-
-            g.drawLine((float)xStart, topY, (float)xStart, bottomY, 2.0f);
-            g.drawLine((float)xEnd, topY, (float)xEnd, bottomY, 2.0f);
-
-            const float arrowHeight = 10.0f;
-            const float arrowHalfW = 6.0f;
-
-            juce::Path startArrow;
-            startArrow.addTriangle((float)xStart, topY,
-                (float)xStart - arrowHalfW, topY - arrowHeight,
-                (float)xStart + arrowHalfW, topY - arrowHeight);
-            g.fillPath(startArrow);
-
-            juce::Path endArrow;
-            endArrow.addTriangle((float)xEnd, topY,
-                (float)xEnd - arrowHalfW, topY - arrowHeight,
-                (float)xEnd + arrowHalfW, topY - arrowHeight);
-            g.fillPath(endArrow);
-        }
-    }
-    else
+    if (totalLength <= 0.0)
     {
         g.setColour(juce::Colours::white);
         g.setFont(14.0f);
-        g.drawFittedText("Click 'IMPORT' to load a WAV file",
+        g.drawFittedText(emptyMessage,
             instrumentalWaveformBounds.reduced(10),
             juce::Justification::centred,
             2);
+        return;
     }
 
-    
-}
+    const auto view = getTimelineViewRange();
+    const auto innerBounds = instrumentalWaveformBounds.reduced(0, 2);
 
-//==============================================================================
+    // Draws the visible part of a time range; peaks once built, thumbnail until then
+    auto drawSection = [&](juce::Range<double> range, juce::Colour colour)
+        {
+            const auto visible = range.getIntersectionWith(view);
+            if (visible.isEmpty())
+                return;
 
-void MainComponent::paintCompReviewView(juce::Graphics& g)
-{
-    const double instrumentalLength = thumbnail.getTotalLength();
+            const int x0 = timeToX(visible.getStart());
+            const int x1 = timeToX(visible.getEnd());
 
-    g.setColour(juce::Colours::darkgrey.darker(0.5f));
-    g.fillRect(instrumentalLabelBounds);
-    g.fillRect(instrumentalWaveformBounds);
+            juce::Rectangle<int> area(x0,
+                innerBounds.getY(),
+                juce::jmax(1, x1 - x0),
+                innerBounds.getHeight());
 
-    g.setColour(juce::Colours::white);
-    g.setFont(16.0f);
-    g.drawText("Instrumental",
-        instrumentalLabelBounds.reduced(4),
-        juce::Justification::centredLeft,
-        true);
+            g.setColour(colour);
 
-    if (instrumentalLength > 0.0)
-    {
-        auto innerBounds = instrumentalWaveformBounds.reduced(2);
+            if (instrumentalPeaks != nullptr)
+            {
+                const double sr = instrumentalPeaks->getSampleRate();
+                instrumentalPeaks->drawRange(g, area,
+                    visible.getStart() * sr,
+                    visible.getLength() * sr);
+            }
+            else
+            {
+                thumbnail.drawChannel(g, area, visible.getStart(), visible.getEnd(), 0, 1.0f);
+            }
+        };
 
-        g.setColour(juce::Colours::darkgrey.brighter(0.3f));
-        thumbnail.drawChannel(g,
-            innerBounds,
-            0.0,
-            instrumentalLength,
-            0,
-            1.0f);
+    drawSection(view, juce::Colours::darkgrey.brighter(0.3f));
 
-        if (hasValidLoop())
-        {
-            const double startProp =
-                juce::jlimit(0.0, 1.0, loopStartSec / instrumentalLength);
-            const double endProp =
-                juce::jlimit(0.0, 1.0, loopEndSec / instrumentalLength);
+    if (hasValidLoop())
+        drawSection({ loopStartSec, loopEndSec }, juce::Colours::lightgreen);
 
-            const int totalW = innerBounds.getWidth();
+    const double current = transportSource.getCurrentPosition();
+    if (current >= 0.0 && isTimeInView(current))
+    {
+        const int x = timeToX(current);
 
-            const int loopX = innerBounds.getX()
-                + juce::roundToInt(startProp * (double)totalW);
-            const int loopW = juce::jmax(1,
-                juce::roundToInt((endProp - startProp) * (double)totalW));
+        g.setColour(juce::Colours::yellow);
+        g.drawLine((float)x,
+            (float)instrumentalWaveformBounds.getY(),
+            (float)x,
+            (float)instrumentalWaveformBounds.getBottom(),
+            2.0f);
+    }
 
-            juce::Rectangle<int> loopRect(loopX,
-                innerBounds.getY(),
-                loopW,
-                innerBounds.getHeight());
+    if (hasValidLoop())
+    {
+        const float topY = (float)instrumentalWaveformBounds.getY();
+        const float bottomY = (float)instrumentalWaveformBounds.getBottom();
 
-            g.setColour(juce::Colours::lightgreen);
-            thumbnail.drawChannel(g,
-                loopRect,
-                loopStartSec,
-                loopEndSec,
-                0,
-                1.0f);
-        }
+        const float arrowHeight = 10.0f;
+        const float arrowHalfW = 6.0f;
 
-        const double current = transportSource.getCurrentPosition();
-        if (current >= 0.0 && instrumentalLength > 0.0)
-        {
-            const double proportion =
-                juce::jlimit(0.0, 1.0, current / instrumentalLength);
-
-            const int x = instrumentalWaveformBounds.getX()
-                + juce::roundToInt(proportion
-                    * (double)instrumentalWaveformBounds.getWidth());
-
-            g.setColour(juce::Colours::yellow);
-            g.drawLine((float)x,
-                (float)instrumentalWaveformBounds.getY(),
-                (float)x,
-                (float)instrumentalWaveformBounds.getBottom(),
-                2.0f);
-        }
+        g.setColour(juce::Colours::red);
 
-        if (hasValidLoop())
+        // Handles scrolled out of view are not drawn (or grabbable)
+        for (const double handleSec : { loopStartSec, loopEndSec })
         {
-            const int   xStart = timeToX(loopStartSec);
-            const int   xEnd = timeToX(loopEndSec);
-
-            const float topY = (float)instrumentalWaveformBounds.getY();
-            const float bottomY = (float)instrumentalWaveformBounds.getBottom();
-
-            g.setColour(juce::Colours::red);
+            if (!isTimeInView(handleSec))
+                continue;
 
-            g.drawLine((float)xStart, topY, (float)xStart, bottomY, 2.0f);
-            g.drawLine((float)xEnd, topY, (float)xEnd, bottomY, 2.0f);
+            const float x = (float)timeToX(handleSec);
 
-            const float arrowHeight = 10.0f;
-            const float arrowHalfW = 6.0f;
+            g.drawLine(x, topY, x, bottomY, 2.0f);
 
-            juce::Path startArrow;
-            startArrow.addTriangle((float)xStart, topY,
-                (float)xStart - arrowHalfW, topY - arrowHeight,
-                (float)xStart + arrowHalfW, topY - arrowHeight);
-            g.fillPath(startArrow);
-
-            juce::Path endArrow;
-            endArrow.addTriangle((float)xEnd, topY,
-                (float)xEnd - arrowHalfW, topY - arrowHeight,
-                (float)xEnd + arrowHalfW, topY - arrowHeight);
-            g.fillPath(endArrow);
+            juce::Path arrow;
+            arrow.addTriangle(x, topY,
+                x - arrowHalfW, topY - arrowHeight,
+                x + arrowHalfW, topY - arrowHeight);
+            g.fillPath(arrow);
         }
     }
-    else
-    {
-        g.setColour(juce::Colours::white);
-        g.setFont(14.0f);
-        g.drawFittedText("Click 'IMPORT' to load an instrumental",
-            instrumentalWaveformBounds.reduced(10),
-            juce::Justification::centred,
-            2);
-    }
+}
+
+//==============================================================================
+
+void MainComponent::paintCompReviewView(juce::Graphics& g)
+{
+    paintInstrumentalTrack(g, "Click 'IMPORT' to load an instrumental");
 
     const double compLength = compedThumbnail.getTotalLength();
     const bool   canDrawComped =
@@ -384,23 +274,41 @@ void MainComponent::paintCompReviewView(juce::Graphics& g)
     g.setColour(juce::Colours::darkred);
     g.fillRect(topBarRect);
 
+    // Comped file starts at the loop start, so it follows the zoomed loop view
+    const auto compView = getCompedViewRange();
+
     g.setColour(panelCol.brighter(0.8f));   // waveform colour
-    compedThumbnail.drawChannel(g,
-        compWaveArea,
-        0.0,
-        compLength,
-        0,
-        1.0f);
+    if (showSpectrogram && compedSpectrogram != nullptr)
+    {
+        const double sr = compedSpectrogram->getSampleRate();
+        compedSpectrogram->drawRange(g,
+            compWaveArea,
+            compView.getStart() * sr,
+            compView.getLength() * sr);
+    }
+    else if (compedPeaks != nullptr)
+    {
+        const double sr = compedPeaks->getSampleRate();
+        compedPeaks->drawRange(g,
+            compWaveArea,
+            compView.getStart() * sr,
+            compView.getLength() * sr);
+    }
+    else
+    {
+        compedThumbnail.drawChannel(g,
+            compWaveArea,
+            compView.getStart(),
+            compView.getEnd(),
+            0,
+            1.0f);
+    }
 
     // ALWAYS draw playhead over comped waveform while playing
-    const double compPos = takeTransport.getCurrentPosition();
-    if (compPos >= 0.0 && compLength > 0.0)
+    const double compPos = takePlayer.getCurrentPosition();
+    if (compPos >= compView.getStart() && compPos <= compView.getEnd())
     {
-        const double prop =
-            juce::jlimit(0.0, 1.0, compPos / compLength);
-
-        const int x = compWaveArea.getX()
-            + juce::roundToInt(prop * (double)compWaveArea.getWidth());
+        const int x = compedTimeToX(compPos, compWaveArea);
 
         g.setColour(juce::Colours::yellow);
         g.drawLine((float)x,
@@ -420,15 +328,21 @@ void MainComponent::paintCompReviewView(juce::Graphics& g)
         if (!(seg.endSec > seg.startSec))
             continue;
 
+        if (seg.endSec <= compView.getStart() || seg.startSec >= compView.getEnd())
+            continue;
+
         const int xStart = compedTimeToX(seg.startSec, compWaveArea);
         const int xEnd = compedTimeToX(seg.endSec, compWaveArea);
 
-        g.setColour(juce::Colours::lightgreen);
-        g.drawLine((float)xStart,
-            (float)topBarRect.getY(),
-            (float)xStart,
-            (float)compWaveArea.getBottom(),
-            2.0f);
+        if (seg.startSec >= compView.getStart())
+        {
+            g.setColour(juce::Colours::lightgreen);
+            g.drawLine((float)xStart,
+                (float)topBarRect.getY(),
+                (float)xStart,
+                (float)compWaveArea.getBottom(),
+                2.0f);
+        }
 
         const int midX = xStart + (xEnd - xStart) / 2;
         const int labelWidth = 30;
@@ -519,6 +433,10 @@ void MainComponent::resized()
 
     topRow.removeFromLeft(10);
     metronomeToggle.setBounds(topRow.removeFromLeft(110));
+    topRow.removeFromLeft(10);
+    monitorToggle.setBounds(topRow.removeFromLeft(90));
+    topRow.removeFromLeft(6);
+    inputMeter.setBounds(topRow.removeFromLeft(120).reduced(0, 6));
 
     if (viewMode == ViewMode::Recording)
         layoutRecordingView(area);
@@ -527,6 +445,12 @@ void MainComponent::resized()
 
     // Takes viewport only visible in Recording view
     takesViewport.setVisible(viewMode == ViewMode::Recording);
+
+    // Debug overlay, bottom right, over everything
+    memoryPanel.setBounds(getLocalBounds().reduced(10)
+        .removeFromBottom(memoryPanel.getIdealHeight())
+        .removeFromRight(360));
+    memoryPanel.toFront(false);
 }
 
 void MainComponent::layoutRecordingView(juce::Rectangle<int> area)
@@ -542,6 +466,8 @@ void MainComponent::layoutRecordingView(juce::Rectangle<int> area)
     instrumentalLabelBounds = labelArea;
     instrumentalWaveformBounds = trackArea;
 
+    layoutTimelineScrollBar(area);
+
     takesAreaBounds = area;
 
     const int compPanelHeight = 210;
@@ -558,6 +484,8 @@ void MainComponent::layoutRecordingView(juce::Rectangle<int> area)
     //selectTakeLabel.setBounds(selectArea);
    // soloLabel.setBounds(soloArea);
 
+    spectrogramToggle.setBounds(headerArea.removeFromRight(120));
+
     auto headerLeft = headerArea.removeFromLeft(220);
     auto takeVolLabelArea = headerLeft.removeFromLeft(90);
     auto takeVolSliderArea = headerLeft;
@@ -666,6 +594,8 @@ void MainComponent::layoutCompReviewView(juce::Rectangle<int> area)
     instrumentalLabelBounds = trackArea.removeFromLeft(130);
     instrumentalWaveformBounds = trackArea;
 
+    layoutTimelineScrollBar(area);
+
     takesAreaBounds = area;
 
     const int headerHeight = 22;
@@ -679,6 +609,8 @@ void MainComponent::layoutCompReviewView(juce::Rectangle<int> area)
     //selectTakeLabel.setBounds(selectArea);
     //soloLabel.setBounds(soloArea);
 
+    spectrogramToggle.setBounds(headerArea.removeFromRight(120));
+
     auto headerLeft = headerArea.removeFromLeft(220);
     auto takeVolLabelArea = headerLeft.removeFromLeft(90);
     auto takeVolSliderArea = headerLeft;
@@ -719,8 +651,8 @@ void MainComponent::layoutCompReviewView(juce::Rectangle<int> area)
 
 double MainComponent::xToTime(float x) const
 {
-    const double totalLength = thumbnail.getTotalLength();
-    if (totalLength <= 0.0 || instrumentalWaveformBounds.getWidth() <= 0)
+    const auto view = getTimelineViewRange();
+    if (view.getLength() <= 0.0 || instrumentalWaveformBounds.getWidth() <= 0)
         return 0.0;
 
     const double norm =
@@ -728,29 +660,37 @@ double MainComponent::xToTime(float x) const
             (x - (double)instrumentalWaveformBounds.getX())
             / (double)instrumentalWaveformBounds.getWidth());
 
-    return norm * totalLength;
+    return view.getStart() + norm * view.getLength();
 }
 
 int MainComponent::timeToX(double t) const
 {
-    const double totalLength = thumbnail.getTotalLength();
-    if (totalLength <= 0.0 || instrumentalWaveformBounds.getWidth() <= 0)
+    const auto view = getTimelineViewRange();
+    if (view.getLength() <= 0.0 || instrumentalWaveformBounds.getWidth() <= 0)
         return instrumentalWaveformBounds.getX();
 
     const double prop =
-        juce::jlimit(0.0, 1.0, t / totalLength);
+        juce::jlimit(0.0, 1.0, (t - view.getStart()) / view.getLength());
 
     return instrumentalWaveformBounds.getX()
         + juce::roundToInt(prop * (double)instrumentalWaveformBounds.getWidth());
 }
 
+bool MainComponent::isTimeInView(double t) const
+{
+    const auto view = getTimelineViewRange();
+    return t >= view.getStart() && t <= view.getEnd();
+}
+
 int MainComponent::compedTimeToX(double t, const juce::Rectangle<int>& area) const
 {
-    const double totalLength = compedThumbnail.getTotalLength();
-    if (totalLength <= 0.0 || area.getWidth() <= 0)
+    const auto view = getCompedViewRange();
+    if (view.getLength() <= 0.0 || area.getWidth() <= 0)
         return area.getX();
 
-    const double prop = juce::jlimit(0.0, 1.0, t / totalLength);
+    const double prop =
+        juce::jlimit(0.0, 1.0, (t - view.getStart()) / view.getLength());
+
     return area.getX()
         + juce::roundToInt(prop * (double)area.getWidth());
 }
@@ -768,17 +708,290 @@ void MainComponent::getCompRowLayout(juce::Rectangle<int>& row,
     waveRect = tmp;                       // big waveform in the middle
 }
 
+//==============================================================================
+// Timeline zoom / scroll
+//==============================================================================
+
+juce::Range<double> MainComponent::getTimelineViewRange() const
+{
+    const double totalLength = thumbnail.getTotalLength();
+    if (totalLength <= 0.0)
+        return {};
+
+    const juce::Range<double> full(0.0, totalLength);
+
+    // Empty view range = zoomed all the way out
+    if (timelineViewRange.isEmpty())
+        return full;
+
+    return full.constrainRange(timelineViewRange);
+}
+
+juce::Range<double> MainComponent::getLoopViewRange() const
+{
+    double startSec = loopStartSec;
+    double endSec = loopEndSec;
+    if (endSec <= startSec && cachedLoopLengthSec > 0.0)
+        endSec = startSec + cachedLoopLengthSec;
+
+    const juce::Range<double> loop(startSec, endSec);
+    const auto visible = loop.getIntersectionWith(getTimelineViewRange());
+
+    // Loop scrolled fully out of view: lanes keep showing the whole loop
+    return visible.isEmpty() ? loop : visible;
+}
+
+juce::Range<double> MainComponent::getCompedViewRange() const
+{
+    const double compLength = compedThumbnail.getTotalLength();
+    const juce::Range<double> full(0.0, juce::jmax(0.0, compLength));
+
+    const auto loopView = getLoopViewRange();
+    if (loopView.isEmpty())
+        return full;
+
+    const auto visible = (loopView - loopStartSec).getIntersectionWith(full);
+    return visible.isEmpty() ? full : visible;
+}
+
+void MainComponent::setTimelineViewRange(juce::Range<double> newRange)
+{
+    const double totalLength = thumbnail.getTotalLength();
+
+    if (totalLength <= 0.0 || newRange.getLength() >= totalLength)
+        timelineViewRange = {};
+    else
+        timelineViewRange = juce::Range<double>(0.0, totalLength).constrainRange(newRange);
+
+    updateTimelineScrollBar();
+    updateTakeLaneViewRanges();
+    repaint();
+}
+
+void MainComponent::resetTimelineView()
+{
+    setTimelineViewRange({});
+}
+
+void MainComponent::zoomTimeline(double factor, double anchorSec)
+{
+    const auto view = getTimelineViewRange();
+    if (view.getLength() <= 0.0 || factor <= 0.0)
+        return;
+
+    // Never zoom in past 50 ms across the whole waveform width
+    const double totalLength = thumbnail.getTotalLength();
+    const double minLength = juce::jmin(totalLength, 0.05);
+    const double newLength = juce::jlimit(minLength, totalLength, view.getLength() * factor);
+
+    // Keep the time under the mouse at the same x position
+    const double anchorProp =
+        juce::jlimit(0.0, 1.0, (anchorSec - view.getStart()) / view.getLength());
+    const double newStart = anchorSec - anchorProp * newLength;
+
+    setTimelineViewRange({ newStart, newStart + newLength });
+}
+
+void MainComponent::layoutTimelineScrollBar(juce::Rectangle<int>& area)
+{
+    const int scrollBarHeight = 10;
+    auto strip = area.removeFromTop(scrollBarHeight + 2).withTrimmedTop(2);
+
+    timelineScrollBarBounds = strip
+        .withX(instrumentalWaveformBounds.getX())
+        .withWidth(instrumentalWaveformBounds.getWidth());
+
+    timelineScrollBar.setBounds(timelineScrollBarBounds);
+}
+
+void MainComponent::updateTimelineScrollBar()
+{
+    const double totalLength = thumbnail.getTotalLength();
+
+    if (totalLength <= 0.0)
+    {
+        timelineScrollBar.setRangeLimits(0.0, 1.0, juce::dontSendNotification);
+        timelineScrollBar.setCurrentRange(0.0, 1.0, juce::dontSendNotification);
+        return;
+    }
+
+    const auto view = getTimelineViewRange();
+    timelineScrollBar.setRangeLimits(0.0, totalLength, juce::dontSendNotification);
+    timelineScrollBar.setCurrentRange(view.getStart(), view.getLength(), juce::dontSendNotification);
+}
+
+void MainComponent::rebuildCompedSpectrogram()
+{
+    compedSpectrogram.reset();
+    const int generation = ++compedSpectrogramGeneration;
+
+    if (!lastCompedFile.existsAsFile())
+        return;
+
+    juce::Component::SafePointer<MainComponent> safeThis(this);
+    const auto file = lastCompedFile;
+
+    backgroundPool.addJob([this, safeThis, file, generation]
+        {
+            std::unique_ptr<juce::AudioFormatReader> reader(readerPool.createReaderFor(file));
+            if (reader == nullptr)
+                return;
+
+            auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob();
+
+            auto spectrogram = SpectrogramCache::createFromReader(*reader,
+                [job] { return job != nullptr && job->shouldExit(); });
+
+            if (spectrogram == nullptr)
+                return;
+
+            juce::MessageManager::callAsync([safeThis, spectrogram, generation]
+                {
+                    if (safeThis == nullptr || generation != safeThis->compedSpectrogramGeneration)
+                        return;
+
+                    safeThis->compedSpectrogram = spectrogram;
+                    safeThis->repaint();
+                });
+        });
+}
+
+void MainComponent::updateTakeLaneViewRanges()
+{
+    const auto view = getLoopViewRange();
+
+    for (auto* lane : takeLaneComponents)
+        lane->setVisibleRange(view.getStart(), view.getEnd());
+}
+
+//==============================================================================
+// Waveform peak caches
+//==============================================================================
+
+void MainComponent::buildPeakCacheAsync(const juce::File& file,
+    std::function<void(std::shared_ptr<WaveformPeakCache>)> onReady)
+{
+    juce::Component::SafePointer<MainComponent> safeThis(this);
+
+    backgroundPool.addJob([this, safeThis, file, onReady]
+        {
+            std::shared_ptr<juce::AudioFormatReader> reader(readerPool.createReaderFor(file));
+            if (reader == nullptr)
+                return;
+
+            auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob();
+
+            std::shared_ptr<WaveformPeakCache> peaks(
+                WaveformPeakCache::createFromReader(*reader,
+                    [job] { return job != nullptr && job->shouldExit(); }));
+
+            if (peaks == nullptr)
+                return;
+
+            // Deep zoom reads the file directly (message thread, once handed over)
+            const int numChannels = juce::jmax(1, (int)reader->numChannels);
+            peaks->setRawSampleReader([reader, numChannels](juce::int64 start, int num, float* dest)
+                {
+                    juce::AudioBuffer<float> block(numChannels, num);
+                    reader->read(&block, 0, num, start, true, true);
+
+                    for (int ch = 1; ch < numChannels; ++ch)
+                        block.addFrom(0, 0, block, ch, 0, num);
+
+                    juce::FloatVectorOperations::copyWithMultiply(dest,
+                        block.getReadPointer(0), 1.0f / (float)numChannels, num);
+                });
+
+            juce::MessageManager::callAsync([safeThis, onReady, peaks]
+                {
+                    if (safeThis != nullptr)
+                        onReady(peaks);
+                });
+        });
+}
+
+void MainComponent::rebuildInstrumentalPeaks()
+{
+    instrumentalPeaks.reset();
+    const int generation = ++instrumentalPeaksGeneration;
+
+    if (!currentInstrumentalFile.existsAsFile())
+        return;
+
+    buildPeakCacheAsync(currentInstrumentalFile,
+        [this, generation](std::shared_ptr<WaveformPeakCache> peaks)
+        {
+            // A newer instrumental was loaded while this one was building
+            if (generation != instrumentalPeaksGeneration)
+                return;
+
+            instrumentalPeaks = std::move(peaks);
+            repaint();
+        });
+}
+
+void MainComponent::rebuildCompedPeaks()
+{
+    compedPeaks.reset();
+    const int generation = ++compedPeaksGeneration;
+
+    if (!lastCompedFile.existsAsFile())
+        return;
+
+    buildPeakCacheAsync(lastCompedFile,
+        [this, generation](std::shared_ptr<WaveformPeakCache> peaks)
+        {
+            if (generation != compedPeaksGeneration)
+                return;
+
+            compedPeaks = std::move(peaks);
+            repaint();
+        });
+}
+
+
 
 //==============================================================================
 // Takes view helpers
 //==============================================================================
 
+void MainComponent::addTakeTracksUpTo(int numSamples)
+{
+    if (loopLengthSamples <= 0 || numSamples <= 0)
+        return;
+
+    // Every loop with samples in it, the one still being recorded included
+    const int loopsToRepresent = (numSamples + loopLengthSamples - 1) / loopLengthSamples;
+
+    const juce::ScopedLock sl(vocalLock);
+
+    while (takeTracks.size() < loopsToRepresent)
+    {
+        const int idx = takeTracks.size();
+
+        TakeTrack t;
+        t.startSample = idx * loopLengthSamples;
+        t.numSamples = loopLengthSamples;   // full loop span
+        t.name = "Take " + juce::String(idx + 1);
+
+        takeTracks.add(t);
+    }
+}
+
 void MainComponent::syncTakeLanesWithTakeTracks()
 {
+    updateTakePeakCaches();
+
+    if (showSpectrogram)
+        updateTakeSpectrograms();
+
+    updateTakePitchCurves();
+
     // Capture take info under lock, then build UI without the lock.
     juce::Array<juce::String> takeNames;
     juce::Array<int>          startSamples;
     juce::Array<int>          numSamples;
+    juce::Array<std::shared_ptr<TakeOnsets>> onsets;   // written by the take split
     int numTakes = 0;
 
     {
@@ -795,12 +1008,24 @@ void MainComponent::syncTakeLanesWithTakeTracks()
             takeNames.add(t.name);
             startSamples.add(t.startSample);
             numSamples.add(t.numSamples);
+            onsets.add(takeOnsets[i]);
         }
     }
 
 
     if (numTakes == takeLaneComponents.size())
+    {
+        // Same lanes; only re-point them in case the peak caches were rebuilt
+        for (int i = 0; i < numTakes; ++i)
+        {
+            takeLaneComponents[i]->setWaveformSource(takePeakCaches[i], numSamples[i]);
+            takeLaneComponents[i]->setSpectrogramSource(takeSpectrograms[i]);
+            takeLaneComponents[i]->setPitchCurve(takePitchCurves[i]);
+            takeLaneComponents[i]->setOnsets(onsets[i]);
+        }
+
         return; // already in sync
+    }
 
     takesContainer.removeAllChildren();
     takeLaneComponents.clear(true);
@@ -809,10 +1034,13 @@ void MainComponent::syncTakeLanesWithTakeTracks()
     {
         auto* lane = new TakeLaneComponent(takeNames[i], i);
 
-        // Waveform slice for this take
-        lane->setWaveformSource(&vocalWaveBuffer,
-            startSamples[i],
-            numSamples[i]);
+        // Waveform peaks for this take, rasterised on backgroundPool
+        lane->setWaveformRenderer(&waveformRenderer);
+        lane->setWaveformSource(takePeakCaches[i], numSamples[i]);
+        lane->setSpectrogramSource(takeSpectrograms[i]);
+        lane->setShowSpectrogram(showSpectrogram);
+        lane->setPitchCurve(takePitchCurves[i]);
+        lane->setOnsets(onsets[i]);
 
         // All lanes share the same time range = current loop (or 0..loopLen)
         double startSec = loopStartSec;
@@ -821,6 +1049,18 @@ void MainComponent::syncTakeLanesWithTakeTracks()
             endSec = startSec + cachedLoopLengthSec;
 
         lane->setTimeRange(startSec, endSec);
+
+        const auto view = getLoopViewRange();
+        lane->setVisibleRange(view.getStart(), view.getEnd());
+
+        // Ctrl/Cmd+wheel and horizontal wheel over a lane drive the shared timeline
+        lane->setTimelineWheelCallback(
+            [this](double proportion, const juce::MouseWheelDetails& wheel, juce::ModifierKeys mods)
+            {
+                const auto laneView = getLoopViewRange();
+                return handleTimelineWheel(laneView.getStart() + proportion * laneView.getLength(),
+                    wheel, mods, false);
+            });
         lane->setSelected(i == selectedTakeIndex);
         lane->setSoloed(i == soloTakeIndex);
 
@@ -844,6 +1084,297 @@ void MainComponent::syncTakeLanesWithTakeTracks()
     layoutTakeLanes();
 }
 
+void MainComponent::updateTakePeakCaches()
+{
+    // Peaks are extended incrementally: while recording only the samples
+    // appended since the last timer tick are scanned.
+    const juce::ScopedLock sl(vocalLock);
+
+    const int numTakes = takeTracks.size();
+
+    while (takePeakCaches.size() > numTakes)
+        takePeakCaches.removeLast();
+
+    while (takePeakCaches.size() < numTakes)
+    {
+        const int takeStart = takeTracks.getReference(takePeakCaches.size()).startSample;
+
+        auto cache = std::make_shared<WaveformPeakCache>();
+        cache->setSampleRate(currentSampleRate > 0.0 ? currentSampleRate : 44100.0);
+        cache->setRawSampleReader([this, takeStart](juce::int64 start, int num, float* dest)
+            {
+                const juce::ScopedLock rawLock(vocalLock);
+
+                vocalStore.read((int)((juce::int64)takeStart + start), num, dest);
+            });
+
+        takePeakCaches.add(cache);
+    }
+
+    for (int i = 0; i < numTakes; ++i)
+    {
+        const auto& t = takeTracks.getReference(i);
+        const auto cache = takePeakCaches[i];
+
+        const int recorded = juce::jlimit(0, t.numSamples,
+            juce::jmin(totalRecordedSamples.load(), vocalStore.getNumSamples()) - t.startSample);
+
+        if (cache->getNumSamples() > recorded)
+            cache->clear();
+
+        const int done = (int)cache->getNumSamples();
+        if (recorded <= done)
+            continue;
+
+        // Takes with an activity map: the gaps go in as silence, unread
+        const auto activity = takeActivity[i];
+        const auto runs = activity != nullptr
+            ? activity->getRunsInSamples(cache->getSampleRate(), recorded)
+            : std::vector<juce::Range<juce::int64>>{ { 0, recorded } };
+
+        std::vector<float> samples;
+        juce::int64 pos = done;
+
+        for (const auto& run : runs)
+        {
+            if (run.getEnd() <= pos)
+                continue;
+
+            cache->appendSilence(run.getStart() - pos);
+
+            const int first = (int)juce::jmax(pos, run.getStart());
+            const int num = (int)run.getEnd() - first;
+
+            samples.resize((size_t)num);
+            vocalStore.read(t.startSample + first, num, samples.data());
+            cache->appendSamples(samples.data(), num);
+
+            pos = run.getEnd();
+        }
+
+        cache->appendSilence(recorded - pos);
+    }
+}
+
+void MainComponent::updateTakeSpectrograms()
+{
+    // Hands newly recorded samples to each take's spectrogram; the STFT and
+    // tile rendering run on backgroundPool, in order, per take.
+    juce::Component::SafePointer<MainComponent> safeThis(this);
+    auto onUpdated = [safeThis]
+        {
+            if (safeThis != nullptr)
+                safeThis->takesContainer.repaint();
+        };
+
+    const juce::ScopedLock sl(vocalLock);
+
+    const int numTakes = takeTracks.size();
+
+    while (takeSpectrograms.size() > numTakes)
+        takeSpectrograms.removeLast();
+
+    while (takeSpectrograms.size() < numTakes)
+        takeSpectrograms.add(std::make_shared<SpectrogramCache>(
+            currentSampleRate > 0.0 ? currentSampleRate : 44100.0));
+
+    for (int i = 0; i < numTakes; ++i)
+    {
+        const auto& t = takeTracks.getReference(i);
+
+        const int recorded = juce::jlimit(0, t.numSamples,
+            juce::jmin(totalRecordedSamples.load(), vocalStore.getNumSamples()) - t.startSample);
+
+        // Buffer was reset underneath this take: start a fresh spectrogram
+        if (takeSpectrograms[i]->getNumSamplesQueued() > recorded)
+            takeSpectrograms.set(i, std::make_shared<SpectrogramCache>(
+                currentSampleRate > 0.0 ? currentSampleRate : 44100.0));
+
+        auto spectrogram = takeSpectrograms[i];
+        const int queued = (int)spectrogram->getNumSamplesQueued();
+
+        if (recorded <= queued)
+            continue;
+
+        std::vector<float> samples((size_t)(recorded - queued));
+        vocalStore.read(t.startSample + queued, recorded - queued, samples.data());
+        spectrogram->appendAsync(backgroundPool, std::move(samples), onUpdated);
+    }
+}
+
+void MainComponent::updateTakePitchCurves()
+{
+    // Takes still without a curve pick up the live one (if they were recorded
+    // in this session); files from disk are filled in by analyseTakeFilesAsync().
+    int numTakes = 0;
+    {
+        const juce::ScopedLock sl(vocalLock);
+        numTakes = takeTracks.size();
+    }
+
+    while (takePitchCurves.size() > numTakes)
+        takePitchCurves.removeLast();
+
+    while (takePitchCurves.size() < numTakes)
+        takePitchCurves.add(nullptr);
+
+    for (int i = 0; i < numTakes; ++i)
+    {
+        if (takePitchCurves[i] == nullptr)
+            takePitchCurves.set(i, livePitch.getCurveForTake(i));
+    }
+}
+
+void MainComponent::analyseTakeFilesAsync()
+{
+    // Takes on disk without a pitch curve, loudness or onsets: read the
+    // sidecars (take_N.f0, take_N.loudness.json, take_N.onsets.json) if they
+    // are newer than the WAV, otherwise analyse the file and write them.
+    juce::Array<int>        indices;
+    juce::Array<juce::File> files;
+    juce::Array<bool>       needsPitch, needsLoudness, needsOnsets;
+    juce::Array<std::shared_ptr<TakeActivity>> activities;
+
+    {
+        const juce::ScopedLock sl(vocalLock);
+
+        for (int i = 0; i < takeTracks.size(); ++i)
+        {
+            const auto& file = takeTracks.getReference(i).sourceFile;
+            const bool pitch = takePitchCurves[i] == nullptr;
+            const bool loudness = takeLoudness[i] == nullptr;
+            const bool onsets = takeOnsets[i] == nullptr;
+
+            if (file.existsAsFile() && (pitch || loudness || onsets))
+            {
+                indices.add(i);
+                files.add(file);
+                needsPitch.add(pitch);
+                needsLoudness.add(loudness);
+                needsOnsets.add(onsets);
+                activities.add(takeActivity[i]);
+            }
+        }
+    }
+
+    if (files.isEmpty())
+        return;
+
+    juce::Component::SafePointer<MainComponent> safeThis(this);
+    const int generation = takePitchGeneration;
+
+    backgroundPool.addJob([this, safeThis, indices, files, needsPitch, needsLoudness, needsOnsets, activities, generation]
+        {
+            auto* job = juce::ThreadPoolJob::getCurrentThreadPoolJob();
+            const auto shouldExit = [job] { return job != nullptr && job->shouldExit(); };
+
+            for (int n = 0; n < files.size() && !shouldExit(); ++n)
+            {
+                const auto& file = files.getReference(n);
+                const auto sidecar = file.withFileExtension("f0");
+
+                std::shared_ptr<PitchCurve> curve;
+                std::shared_ptr<TakeLoudness> loudness;
+                std::shared_ptr<TakeOnsets> onsets;
+
+                if (needsPitch[n] && sidecar.existsAsFile()
+                    && sidecar.getLastModificationTime() >= file.getLastModificationTime())
+                    curve = PitchCurve::readFromFile(sidecar);
+
+                if (needsLoudness[n])
+                    loudness = TakeLoudness::readSidecarFor(file);
+
+                if (needsOnsets[n])
+                    onsets = TakeOnsets::readSidecarFor(file);
+
+                if ((needsPitch[n] && curve == nullptr) || (needsLoudness[n] && loudness == nullptr)
+                    || (needsOnsets[n] && onsets == nullptr))
+                {
+                    std::unique_ptr<juce::AudioFormatReader> reader(readerPool.createReaderFor(file));
+                    if (reader == nullptr)
+                        continue;
+
+                    if (needsPitch[n] && curve == nullptr)
+                    {
+                        // Only where the take is sung
+                        curve = PitchTracker::analyse(*reader, shouldExit, activities[n].get());
+                        if (curve == nullptr)
+                            return;
+
+                        curve->writeToFile(sidecar);
+                    }
+
+                    if (needsLoudness[n] && loudness == nullptr)
+                    {
+                        loudness = LoudnessAnalyser::analyse(*reader, shouldExit);
+                        if (loudness == nullptr)
+                            return;
+
+                        loudness->writeToFile(TakeLoudness::getSidecarFile(file));
+                    }
+
+                    if (needsOnsets[n] && onsets == nullptr)
+                    {
+                        onsets = OnsetAnalyser::analyse(*reader, shouldExit);
+                        if (onsets == nullptr)
+                            return;
+
+                        onsets->writeToFile(TakeOnsets::getSidecarFile(file));
+                    }
+                }
+
+                const int index = indices[n];
+
+                juce::MessageManager::callAsync([safeThis, index, curve, loudness, onsets, generation]
+                    {
+                        if (safeThis == nullptr || generation != safeThis->takePitchGeneration
+                            || index >= safeThis->takePitchCurves.size())
+                            return;
+
+                        if (curve != nullptr)
+                        {
+                            safeThis->takePitchCurves.set(index, curve);
+
+                            if (index < safeThis->takeLaneComponents.size())
+                                safeThis->takeLaneComponents[index]->setPitchCurve(curve);
+                        }
+
+                        if (loudness != nullptr)
+                            safeThis->setTakeLoudness(index, loudness);
+
+                        if (onsets != nullptr)
+                        {
+                            {
+                                const juce::ScopedLock sl(safeThis->vocalLock);
+
+                                if (safeThis->takeOnsets.size() <= index)
+                                    safeThis->takeOnsets.resize(index + 1);
+
+                                safeThis->takeOnsets.set(index, onsets);
+                            }
+
+                            if (index < safeThis->takeLaneComponents.size())
+                                safeThis->takeLaneComponents[index]->setOnsets(onsets);
+                        }
+                    });
+            }
+        });
+}
+
+void MainComponent::clearTakeAnalysis()
+{
+    // Everything derived from the take buffer; in-flight results are dropped
+    takePeakCaches.clear();
+    takeSpectrograms.clear();
+    takePitchCurves.clear();
+    takeLoudness.clear();
+    takeActivity.clear();
+    takeOnsets.clear();
+    ++takePitchGeneration;
+
+    livePitch.clear();
+}
+
 void MainComponent::layoutTakeLanes()
 {
     const int width = takesAreaBounds.getWidth();
@@ -0,0 +1,131 @@
+// MemoryRegistry.cpp
+#include "MemoryRegistry.h"
+
+using int64 = juce::int64;
+
+namespace
+{
+    void atomicMax(std::atomic<int64>& a, int64 v) noexcept
+    {
+        int64 old = a.load(std::memory_order_relaxed);
+        while (v > old && !a.compare_exchange_weak(old, v, std::memory_order_relaxed)) {}
+    }
+
+    juce::String formatBytes(int64 bytes)
+    {
+        return juce::String((double)bytes / (1024.0 * 1024.0), 1) + " MB";
+    }
+}
+
+//==============================================================================
+
+const char* MemoryRegistry::getName(Category category) noexcept
+{
+    switch (category)
+    {
+        case Category::takeBlocks:        return "take_blocks";
+        case Category::takeDecoded:       return "take_decoded";
+        case Category::takeSpilled:       return "take_spilled";
+        case Category::audioBuffers:      return "audio_buffers";
+        case Category::instrumentalCache: return "instrumental_cache";
+        case Category::waveformPeaks:     return "waveform_peaks";
+        case Category::spectrograms:      return "spectrograms";
+        case Category::thumbnails:        return "thumbnails";
+        case Category::takeAnalysis:      return "take_analysis";
+        case Category::mappedFiles:       return "mapped_files";
+        case Category::numCategories:     break;
+    }
+
+    return "unknown";
+}
+
+void MemoryRegistry::set(Category category, int64 bytes) noexcept
+{
+    const int index = (int)category;
+    current[index].store(bytes);
+    updatePeaks(index, bytes);
+}
+
+void MemoryRegistry::add(Category category, int64 deltaBytes) noexcept
+{
+    const int index = (int)category;
+    updatePeaks(index, current[index].fetch_add(deltaBytes) + deltaBytes);
+}
+
+void MemoryRegistry::updatePeaks(int index, int64 bytes) noexcept
+{
+    atomicMax(peak[index], bytes);
+
+    if (!isOnDisk((Category)index))
+        atomicMax(peakTotal, getTotal());
+}
+
+int64 MemoryRegistry::getCurrent(Category category) const noexcept
+{
+    return current[(int)category].load();
+}
+
+int64 MemoryRegistry::getPeak(Category category) const noexcept
+{
+    return peak[(int)category].load();
+}
+
+int64 MemoryRegistry::getTotal() const noexcept
+{
+    int64 total = 0;
+
+    for (int i = 0; i < numCategories; ++i)
+        if (!isOnDisk((Category)i))
+            total += current[i].load();
+
+    return total;
+}
+
+void MemoryRegistry::resetPeaks() noexcept
+{
+    for (int i = 0; i < numCategories; ++i)
+        peak[i].store(current[i].load());
+
+    peakTotal.store(getTotal());
+}
+
+//==============================================================================
+
+juce::var MemoryRegistry::toVar() const
+{
+    auto* categories = new juce::DynamicObject();
+
+    for (int i = 0; i < numCategories; ++i)
+    {
+        auto* c = new juce::DynamicObject();
+        c->setProperty("current_bytes", current[i].load());
+        c->setProperty("peak_bytes", peak[i].load());
+        categories->setProperty(getName((Category)i), juce::var(c));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("total_bytes", getTotal());
+    root->setProperty("peak_total_bytes", getPeakTotal());
+    root->setProperty("categories", juce::var(categories));
+    return juce::var(root);
+}
+
+juce::StringArray MemoryRegistry::getDescription() const
+{
+    juce::StringArray lines;
+
+    for (int i = 0; i < numCategories; ++i)
+    {
+        const auto category = (Category)i;
+        lines.add(juce::String(getName(category)).paddedRight(' ', 20)
+            + formatBytes(getCurrent(category)).paddedLeft(' ', 10)
+            + "  (peak " + formatBytes(getPeak(category)) + ")"
+            + (isOnDisk(category) ? "  on disk" : ""));
+    }
+
+    lines.add(juce::String("total").paddedRight(' ', 20)
+        + formatBytes(getTotal()).paddedLeft(' ', 10)
+        + "  (peak " + formatBytes(getPeakTotal()) + ")");
+
+    return lines;
+}
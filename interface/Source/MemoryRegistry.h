@@ -0,0 +1,70 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+//==============================================================================
+// MemoryRegistry: how much memory a session holds, by category.
+//
+// Subsystems report their current footprint (or changes to it) from any
+// thread; the registry keeps the peak of every category and of the total.
+// MainComponent reports the subsystems it owns once per UI frame (at most
+// every sampleIntervalMs), so a peak between two reports can be missed.
+// Spilled take blocks and mapped files are on disk and are kept out of the total.
+//==============================================================================
+
+class MemoryRegistry
+{
+public:
+    enum class Category
+    {
+        takeBlocks,          // 16-bit take blocks in RAM (TakeStore)
+        takeDecoded,         // decoded float LRU (TakeStore)
+        takeSpilled,         // take blocks only in the spill file (disk)
+        audioBuffers,        // the rest of the realtime arena: callback buffers
+        instrumentalCache,   // rendered loop region (LoopRenderCache)
+        waveformPeaks,       // WaveformPeakCache, instrumental + comp + takes
+        spectrograms,        // SpectrogramCache columns and tiles
+        thumbnails,          // the two AudioThumbnails (estimated)
+        takeAnalysis,        // pitch curves and loudness
+        mappedFiles,         // WAVs mapped by the AudioReaderPool (disk)
+        numCategories
+    };
+
+    static constexpr int numCategories = (int)Category::numCategories;
+    static constexpr int sampleIntervalMs = 500;
+
+    MemoryRegistry() = default;
+
+    static const char* getName(Category category) noexcept;
+    static bool isOnDisk(Category category) noexcept
+    {
+        return category == Category::takeSpilled || category == Category::mappedFiles;
+    }
+
+    // Any thread
+    void set(Category category, juce::int64 bytes) noexcept;
+    void add(Category category, juce::int64 deltaBytes) noexcept;
+
+    juce::int64 getCurrent(Category category) const noexcept;
+    juce::int64 getPeak(Category category) const noexcept;
+    juce::int64 getTotal() const noexcept;       // RAM only
+    juce::int64 getPeakTotal() const noexcept { return peakTotal.load(); }
+
+    void resetPeaks() noexcept;
+
+    // {"total_bytes", "peak_total_bytes", "categories": {name: {current_bytes, peak_bytes}}}
+    juce::var toVar() const;
+
+    // One line per category: "Take blocks     12.5 MB (peak 40.1 MB)"
+    juce::StringArray getDescription() const;
+
+private:
+    void updatePeaks(int index, juce::int64 bytes) noexcept;
+
+    std::atomic<juce::int64> current[numCategories] = {};
+    std::atomic<juce::int64> peak[numCategories] = {};
+    std::atomic<juce::int64> peakTotal{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MemoryRegistry)
+};
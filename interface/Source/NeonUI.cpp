@@ -1,57 +1,5 @@
 #include "NeonUI.h"
 
-namespace
-{
-    void drawMonoBufferSegment(juce::Graphics& g,
-        const juce::AudioSampleBuffer* buffer,
-        int startSample,
-        int numSamples,
-        const juce::Rectangle<int>& area,
-        juce::Colour colour)
-    {
-        if (buffer == nullptr
-            || buffer->getNumChannels() == 0
-            || numSamples <= 1
-            || area.getWidth() <= 1)
-            return;
-
-        const int totalSamples = buffer->getNumSamples();
-        startSample = juce::jlimit(0, totalSamples, startSample);
-        numSamples = juce::jmin(numSamples, totalSamples - startSample);
-        if (numSamples <= 1)
-            return;
-
-        auto* data = buffer->getReadPointer(0);
-
-        const int   x0 = area.getX();
-        const int   w = area.getWidth();
-        const float top = (float)area.getY();
-        const float h = (float)area.getHeight();
-        const float midY = top + h * 0.5f;
-        const float amp = h * 0.5f;
-
-        juce::Path p;
-
-        for (int x = 0; x < w; ++x)
-        {
-            const float proportion = (float)x / (float)(w - 1);
-            const int   sampleIdx = startSample + (int)(proportion * (numSamples - 1));
-            const int   clamped = juce::jlimit(0, totalSamples - 1, sampleIdx);
-            const float sampleVal = data[clamped];
-            const float y = midY - sampleVal * amp;
-
-            if (x == 0)
-                p.startNewSubPath((float)x0, y);
-            else
-                p.lineTo((float)(x0 + x), y);
-        }
-
-        g.setColour(colour);
-        g.strokePath(p, juce::PathStrokeType(1.2f));
-    }
-}
-
-
 //==============================================================================
 // NeonTheme
 //==============================================================================
@@ -589,19 +537,265 @@ void TakeLaneComponent::setTimeRange(double startSec, double endSec)
 {
     timeStartSec = startSec;
     timeEndSec = endSec;
+    visibleStartSec = startSec;
+    visibleEndSec = endSec;
+    requestWaveformImage();
     repaint();
 }
 
-void TakeLaneComponent::setWaveformSource(const juce::AudioSampleBuffer* buffer,
-    int startSample,
-    int numSamples)
+void TakeLaneComponent::setVisibleRange(double startSec, double endSec)
 {
-    waveformBuffer = buffer;
-    waveformStartSample = startSample;
-    waveformNumSamples = numSamples;
+    if (visibleStartSec == startSec && visibleEndSec == endSec)
+        return;
+
+    visibleStartSec = startSec;
+    visibleEndSec = endSec;
+    requestWaveformImage();
     repaint();
 }
 
+void TakeLaneComponent::setWaveformRenderer(WaveformImageRenderer* renderer)
+{
+    waveformRenderer = renderer;
+    requestWaveformImage();
+}
+
+void TakeLaneComponent::setWaveformSource(std::shared_ptr<const WaveformPeakCache> peaks, int numSamples)
+{
+    if (waveformPeaks != peaks || waveformNumSamples != numSamples)
+    {
+        // A different take: the old image would be misleading even as a placeholder
+        if (waveformPeaks != peaks)
+            waveformImage = {};
+
+        waveformPeaks = std::move(peaks);
+        waveformNumSamples = numSamples;
+        repaint();
+    }
+
+    // Also called every tick while recording; only re-renders if the take grew
+    requestWaveformImage();
+}
+
+void TakeLaneComponent::setSpectrogramSource(std::shared_ptr<const SpectrogramCache> spectrogram)
+{
+    if (spectrogramSource == spectrogram)
+        return;
+
+    spectrogramSource = std::move(spectrogram);
+
+    if (showSpectrogram)
+        repaint();
+}
+
+void TakeLaneComponent::setShowSpectrogram(bool shouldShow)
+{
+    if (showSpectrogram == shouldShow)
+        return;
+
+    showSpectrogram = shouldShow;
+    repaint();
+}
+
+void TakeLaneComponent::setPitchCurve(std::shared_ptr<const PitchCurve> curve)
+{
+    const int numFrames = curve != nullptr ? curve->getNumFrames() : 0;
+
+    if (pitchCurve == curve && pitchFramesShown == numFrames)
+        return;
+
+    pitchCurve = std::move(curve);
+    pitchFramesShown = numFrames;
+    repaint();
+}
+
+void TakeLaneComponent::setOnsets(std::shared_ptr<const TakeOnsets> onsets)
+{
+    if (takeOnsets == onsets)
+        return;
+
+    takeOnsets = std::move(onsets);
+    repaint();
+}
+
+void TakeLaneComponent::drawOnsets(juce::Graphics& g, juce::Rectangle<int> area, juce::Colour colour) const
+{
+    const double visibleSec = visibleEndSec - visibleStartSec;
+
+    if (area.isEmpty() || visibleSec <= 0.0)
+        return;
+
+    // Onset times are from the start of the take, which sits at timeStartSec
+    const auto& times = takeOnsets->getTimes();
+    const auto visible = takeOnsets->getIndicesBetween(visibleStartSec - timeStartSec,
+        visibleEndSec - timeStartSec);
+    const float pixelsPerSec = (float)area.getWidth() / (float)visibleSec;
+    const float tickHeight = juce::jmin(6.0f, (float)area.getHeight());
+
+    g.setColour(colour);
+
+    for (int i = visible.getStart(); i < visible.getEnd(); ++i)
+    {
+        const float x = (float)area.getX() + (float)(timeStartSec + times[(size_t)i] - visibleStartSec) * pixelsPerSec;
+        g.drawLine(x, (float)area.getBottom() - tickHeight, x, (float)area.getBottom(), 1.0f);
+    }
+}
+
+void TakeLaneComponent::drawPitchCurve(juce::Graphics& g, juce::Rectangle<int> area, juce::Colour colour) const
+{
+    const double fps = pitchCurve->getFramesPerSecond();
+    const double visibleSec = visibleEndSec - visibleStartSec;
+
+    if (area.isEmpty() || fps <= 0.0 || visibleSec <= 0.0)
+        return;
+
+    // Frame k sits at timeStartSec + firstFrameTime + k / fps
+    const double frameZeroSec = timeStartSec + pitchCurve->getFirstFrameTimeSec();
+    const int firstFrame = juce::jmax(0, (int)std::floor((visibleStartSec - frameZeroSec) * fps) - 1);
+    const int lastFrame = juce::jmin(pitchFramesShown, (int)std::ceil((visibleEndSec - frameZeroSec) * fps) + 2);
+
+    if (lastFrame <= firstFrame)
+        return;
+
+    std::vector<float> f0((size_t)(lastFrame - firstFrame), 0.0f);
+    pitchCurve->copyFrames(firstFrame, lastFrame - firstFrame, f0.data());
+
+    // Log pitch axis covering the usual vocal range
+    const float lowHz = 80.0f;
+    const float highHz = 1000.0f;
+    const float logSpan = std::log(highHz / lowHz);
+    const float pixelsPerSec = (float)area.getWidth() / (float)visibleSec;
+
+    juce::Path path;
+    bool penDown = false;
+
+    for (size_t i = 0; i < f0.size(); ++i)
+    {
+        if (f0[i] <= 0.0f)
+        {
+            penDown = false;   // gaps at unvoiced frames
+            continue;
+        }
+
+        const double t = frameZeroSec + (double)(firstFrame + (int)i) / fps;
+        const float x = (float)area.getX() + (float)(t - visibleStartSec) * pixelsPerSec;
+        const float norm = juce::jlimit(0.0f, 1.0f, std::log(f0[i] / lowHz) / logSpan);
+        const float y = (float)area.getBottom() - norm * (float)area.getHeight();
+
+        if (penDown)
+            path.lineTo(x, y);
+        else
+            path.startNewSubPath(x, y);
+
+        penDown = true;
+    }
+
+    juce::Graphics::ScopedSaveState state(g);
+    g.reduceClipRegion(area);
+    g.setColour(colour);
+    g.strokePath(path, juce::PathStrokeType(1.5f, juce::PathStrokeType::curved, juce::PathStrokeType::rounded));
+}
+
+void TakeLaneComponent::requestWaveformImage()
+{
+    const auto area = getWaveArea().reduced(1);
+    const double spanSec = timeEndSec - timeStartSec;
+
+    if (waveformRenderer == nullptr
+        || waveformPeaks == nullptr
+        || waveformNumSamples <= 0
+        || spanSec <= 0.0
+        || area.isEmpty())
+        return;
+
+    const float  scale = juce::Component::getApproximateScaleFactorForComponent(this);
+    const double samplesPerSec = (double)waveformNumSamples / spanSec;
+
+    WaveformImageKey key;
+    key.peaks = waveformPeaks.get();
+    key.width = juce::roundToInt((float)area.getWidth() * scale);
+    key.height = juce::roundToInt((float)area.getHeight() * scale);
+    key.startSample = (visibleStartSec - timeStartSec) * samplesPerSec;
+    key.numSamples = (visibleEndSec - visibleStartSec) * samplesPerSec;
+    key.availableSamples = waveformPeaks->getNumSamples();
+
+    // One job in flight per lane; its completion re-checks for newer changes
+    if (key == renderedKey || renderPending)
+        return;
+
+    const NeonTheme* tPtr = nullptr;
+    if (auto* neon = dynamic_cast<NeonLookAndFeel*>(&getLookAndFeel()))
+        tPtr = &neon->getTheme();
+
+    auto panelCol = tPtr ? tPtr->panel : juce::Colours::darkgrey.darker(0.6f);
+
+    WaveformImageRenderer::Request request;
+    request.peaks = waveformPeaks;
+    request.startSample = key.startSample;
+    request.numSamples = key.numSamples;
+    request.width = key.width;
+    request.height = key.height;
+    request.colour = panelCol.brighter(0.8f);
+
+    renderPending = true;
+
+    juce::Component::SafePointer<TakeLaneComponent> safeThis(this);
+    waveformRenderer->renderAsync(std::move(request),
+        [safeThis, key](juce::Image image)
+        {
+            if (auto* lane = safeThis.getComponent())
+                lane->waveformImageReady(key, image);
+        });
+}
+
+void TakeLaneComponent::waveformImageReady(const WaveformImageKey& key, const juce::Image& image)
+{
+    renderPending = false;
+
+    if (key.peaks == waveformPeaks.get())
+    {
+        waveformImage = image;
+        renderedKey = key;
+        repaint();
+    }
+
+    requestWaveformImage();
+}
+
+void TakeLaneComponent::setTimelineWheelCallback(std::function<bool(double,
+    const juce::MouseWheelDetails&,
+    juce::ModifierKeys)> onWheel)
+{
+    wheelCallback = std::move(onWheel);
+}
+
+void TakeLaneComponent::mouseWheelMove(const juce::MouseEvent& event,
+    const juce::MouseWheelDetails& wheel)
+{
+    const auto waveArea = getWaveArea();
+
+    if (wheelCallback && waveArea.getWidth() > 0)
+    {
+        const double proportion = juce::jlimit(0.0, 1.0,
+            (event.position.x - (float)waveArea.getX()) / (double)waveArea.getWidth());
+
+        // Zoom / horizontal scroll is handled by the owner; plain vertical
+        // wheel falls through so the takes viewport can still scroll.
+        if (wheelCallback(proportion, wheel, event.mods))
+            return;
+    }
+
+    juce::Component::mouseWheelMove(event, wheel);
+}
+
+juce::Rectangle<int> TakeLaneComponent::getWaveArea() const
+{
+    auto bounds = getLocalBounds();
+    bounds.removeFromLeft(110);
+    bounds.removeFromRight(140);
+    return bounds.reduced(6, 8);
+}
+
 
 void TakeLaneComponent::setCallbacks(std::function<void(int)> onSelect,
     std::function<void(int)> onSolo)
@@ -632,6 +826,8 @@ void TakeLaneComponent::resized()
     auto selectArea = controlsArea.removeFromLeft(controlsArea.getWidth() / 2);
     selectButton.setBounds(selectArea.reduced(6, 6));
     soloButton.setBounds(controlsArea.reduced(6, 6));
+
+    requestWaveformImage();
 }
 
 void TakeLaneComponent::paint(juce::Graphics& g)
@@ -653,12 +849,7 @@ void TakeLaneComponent::paint(juce::Graphics& g)
     g.fillRoundedRectangle(r, 4.0f);
 
     // Slight darker band for waveform area
-    auto waveBoundsInt = getLocalBounds();
-    auto labelArea = waveBoundsInt.removeFromLeft(110);
-    juce::ignoreUnused(labelArea);
-    auto controlsArea = waveBoundsInt.removeFromRight(140);
-    juce::ignoreUnused(controlsArea);
-    auto waveArea = waveBoundsInt.reduced(6, 8);
+    auto waveArea = getWaveArea();
 
     g.setColour(panelCol.darker(0.5f));
     g.fillRect(waveArea);
@@ -666,15 +857,29 @@ void TakeLaneComponent::paint(juce::Graphics& g)
     g.setColour(panelCol.brighter(0.25f));
     g.drawRect(waveArea);
 
-    // Draw the actual waveform for this take if we have one.
-    if (waveformBuffer != nullptr && waveformNumSamples > 0)
+    const double spanSec = timeEndSec - timeStartSec;
+
+    if (showSpectrogram && spectrogramSource != nullptr && waveformNumSamples > 0 && spanSec > 0.0)
+    {
+        const double samplesPerSec = (double)waveformNumSamples / spanSec;
+
+        spectrogramSource->drawRange(g,
+            waveArea.reduced(1),
+            (visibleStartSec - timeStartSec) * samplesPerSec,
+            (visibleEndSec - visibleStartSec) * samplesPerSec);
+    }
+    else if (waveformImage.isValid())
+    {
+        // Rendered off-thread; stretched while a re-render for a new size/range is pending
+        g.drawImage(waveformImage, waveArea.reduced(1).toFloat());
+    }
+    else if (waveformPeaks != nullptr && waveformNumSamples > 0)
     {
-        drawMonoBufferSegment(g,
-            waveformBuffer,
-            waveformStartSample,
-            waveformNumSamples,
-            waveArea,
-            panelCol.brighter(0.8f));
+        // Placeholder until the first image arrives
+        g.setColour(panelCol.brighter(0.4f));
+        g.drawHorizontalLine(waveArea.getCentreY(),
+            (float)waveArea.getX(),
+            (float)waveArea.getRight());
     }
     else
     {
@@ -688,6 +893,12 @@ void TakeLaneComponent::paint(juce::Graphics& g)
         }
     }
 
+    if (pitchCurve != nullptr && pitchFramesShown > 0)
+        drawPitchCurve(g, waveArea.reduced(1, 4), soloCol.withAlpha(0.9f));
+
+    if (takeOnsets != nullptr)
+        drawOnsets(g, waveArea.reduced(1), selectCol.withAlpha(0.7f));
+
     // Selection / solo highlights
     if (isSoloed)
     {
@@ -701,11 +912,11 @@ void TakeLaneComponent::paint(juce::Graphics& g)
         g.drawRoundedRectangle(r.expanded(0.5f), 4.0f, 1.5f);
     }
 
-    // Playhead line (only when this lane is active)
-    if ((isSelected || isSoloed) && timeEndSec > timeStartSec)
+    // Playhead line (only when this lane is active and the playhead is in view)
+    if ((isSelected || isSoloed) && visibleEndSec > visibleStartSec
+        && currentPlayheadTime >= visibleStartSec && currentPlayheadTime <= visibleEndSec)
     {
-        double tNorm = (currentPlayheadTime - timeStartSec) / (timeEndSec - timeStartSec);
-        tNorm = juce::jlimit(0.0, 1.0, tNorm);
+        const double tNorm = (currentPlayheadTime - visibleStartSec) / (visibleEndSec - visibleStartSec);
 
         const int x = waveArea.getX() + juce::roundToInt(tNorm * (double)waveArea.getWidth());
 
@@ -906,10 +1117,152 @@ void NeonProgressBar::paint(juce::Graphics& g)
         1);
 }
 
+//==============================================================================
+// InputMeter
+//==============================================================================
+
+namespace
+{
+    // -60..0 dBFS onto 0..1
+    float meterPosition(float gain)
+    {
+        const float db = juce::Decibels::gainToDecibels(gain, -60.0f);
+        return juce::jlimit(0.0f, 1.0f, (db + 60.0f) / 60.0f);
+    }
+}
+
+void InputMeter::setNumChannels(int n)
+{
+    n = juce::jlimit(0, maxChannels, n);
+
+    if (n != numChannels)
+    {
+        numChannels = n;
+        repaint();
+    }
+}
+
+void InputMeter::setLevel(int channel, float peak, float rms, bool clipped)
+{
+    if (!juce::isPositiveAndBelow(channel, numChannels))
+        return;
+
+    auto& c = channels[channel];
+    const auto old = c;
+
+    // Fast attack, slow release, so short peaks stay readable
+    c.peak = juce::jmax(peak, c.peak * 0.85f);
+    c.rms = juce::jmax(rms, c.rms * 0.85f);
+
+    if (c.peak < 0.001f) c.peak = 0.0f;
+    if (c.rms < 0.001f)  c.rms = 0.0f;
+
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    const bool wasLit = old.clipUntilMs > now;
+
+    if (clipped)
+        c.clipUntilMs = now + clipHoldSeconds * 1000.0;
+
+    if (c.peak != old.peak || c.rms != old.rms || wasLit != (c.clipUntilMs > now))
+        repaint();
+}
+
+void InputMeter::mouseDown(const juce::MouseEvent&)
+{
+    for (auto& c : channels)
+        c.clipUntilMs = 0.0;
+
+    repaint();
+}
+
+void InputMeter::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+
+    auto* neonLF = dynamic_cast<NeonLookAndFeel*>(&getLookAndFeel());
+    const NeonTheme* t = neonLF ? &neonLF->getTheme() : nullptr;
+
+    auto trackCol = t ? t->controlBackground : juce::Colours::darkgrey;
+    auto outlineCol = t ? t->controlOutline : juce::Colours::grey;
+    auto peakCol = t ? t->accentCyan : juce::Colours::cyan;
+    auto rmsCol = t ? t->accentPurple : juce::Colours::purple;
+    auto clipCol = t ? t->accentPink : juce::Colours::red;
+
+    if (numChannels == 0)
+    {
+        g.setColour(trackCol);
+        g.fillRoundedRectangle(bounds.reduced(1.0f), 3.0f);
+        return;
+    }
+
+    const double now = juce::Time::getMillisecondCounterHiRes();
+
+    // Clip light on the right, one bar per channel stacked on the left
+    auto clipArea = bounds.removeFromRight(bounds.getHeight() * 0.6f).reduced(2.0f);
+    bool anyClip = false;
+
+    const float barHeight = bounds.getHeight() / (float)numChannels;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto& c = channels[ch];
+        anyClip = anyClip || c.clipUntilMs > now;
+
+        auto bar = bounds.withHeight(barHeight).withY(bounds.getY() + barHeight * (float)ch).reduced(1.0f, 1.5f);
+
+        g.setColour(trackCol);
+        g.fillRoundedRectangle(bar, 2.0f);
+
+        g.setColour(peakCol.withAlpha(0.55f));
+        g.fillRoundedRectangle(bar.withWidth(bar.getWidth() * meterPosition(c.peak)), 2.0f);
+
+        g.setColour(rmsCol);
+        g.fillRoundedRectangle(bar.withWidth(bar.getWidth() * meterPosition(c.rms)), 2.0f);
+
+        g.setColour(outlineCol.withAlpha(0.8f));
+        g.drawRoundedRectangle(bar, 2.0f, 1.0f);
+    }
+
+    g.setColour(anyClip ? clipCol : trackCol);
+    g.fillEllipse(clipArea.withSizeKeepingCentre(juce::jmin(clipArea.getWidth(), clipArea.getHeight()),
+                                                 juce::jmin(clipArea.getWidth(), clipArea.getHeight())));
+}
+
+//==============================================================================
+// MemoryPanel
+//==============================================================================
+
+void MemoryPanel::setLines(const juce::StringArray& newLines)
+{
+    if (newLines == lines)
+        return;
 
+    lines = newLines;
+    repaint();
+}
 
+void MemoryPanel::mouseDown(const juce::MouseEvent&)
+{
+    if (onClick != nullptr)
+        onClick();
+}
+
+void MemoryPanel::paint(juce::Graphics& g)
+{
+    auto* neonLF = dynamic_cast<NeonLookAndFeel*>(&getLookAndFeel());
+    const NeonTheme* t = neonLF ? &neonLF->getTheme() : nullptr;
 
+    g.setColour((t ? t->panel : juce::Colours::black).withAlpha(0.85f));
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 4.0f);
 
+    g.setColour(t ? t->controlOutline : juce::Colours::grey);
+    g.drawRoundedRectangle(getLocalBounds().toFloat().reduced(0.5f), 4.0f, 1.0f);
 
+    g.setColour(t ? t->textSecondary : juce::Colours::lightgrey);
+    g.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 11.0f, juce::Font::plain));
 
+    auto area = getLocalBounds().reduced(8, 6);
 
+    for (const auto& line : lines)
+        g.drawText(line, area.removeFromTop(lineHeight), juce::Justification::centredLeft, false);
+}
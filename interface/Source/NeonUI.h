@@ -2,6 +2,10 @@
 
 #include <JuceHeader.h>
 #include <functional>
+#include "WaveformCache.h"
+#include "SpectrogramCache.h"
+#include "PitchTracker.h"
+#include "TakeOnsets.h"
 
 //==============================================================================
 // NeonTheme: central colour palette for the app
@@ -149,18 +153,37 @@ public:
     void setSelected(bool shouldBeSelected);
     void setSoloed(bool shouldBeSoloed);
     void setPlayheadTime(double seconds);           // global time in seconds
-    void setTimeRange(double startSec, double endSec); // [start, end] visible range
+    void setTimeRange(double startSec, double endSec); // [start, end] time span of the whole take
+    void setVisibleRange(double startSec, double endSec); // zoomed part of the take span
     void setCallbacks(std::function<void(int)> onSelect,
         std::function<void(int)> onSolo);
 
-    void setWaveformSource(const juce::AudioSampleBuffer* buffer,
-        int startSample,
-        int numSamples);
+    // Called for zoom/scroll wheel gestures; proportion is the mouse x within the waveform
+    void setTimelineWheelCallback(std::function<bool(double proportion,
+        const juce::MouseWheelDetails&,
+        juce::ModifierKeys)> onWheel);
+
+    // Waveform images are rendered by the renderer off the message thread;
+    // paint() only composites the last finished image.
+    void setWaveformRenderer(WaveformImageRenderer* renderer);
+    void setWaveformSource(std::shared_ptr<const WaveformPeakCache> peaks, int numSamples);
+
+    // Optional spectrogram in place of the waveform (tiles are pre-rendered by the cache)
+    void setSpectrogramSource(std::shared_ptr<const SpectrogramCache> spectrogram);
+    void setShowSpectrogram(bool shouldShow);
+
+    // f0 overlay; may still be growing while recording (repaints when it has)
+    void setPitchCurve(std::shared_ptr<const PitchCurve> curve);
+
+    // Onset ticks along the bottom of the lane
+    void setOnsets(std::shared_ptr<const TakeOnsets> onsets);
 
     int  getTakeIndex() const noexcept { return index; }
 
     void paint(juce::Graphics& g) override;
     void resized() override;
+    void mouseWheelMove(const juce::MouseEvent& event,
+        const juce::MouseWheelDetails& wheel) override;
 
 private:
     void buttonClicked(juce::Button* b) override;
@@ -176,13 +199,58 @@ private:
     double currentPlayheadTime = 0.0;
     double timeStartSec = 0.0;
     double timeEndSec = 1.0;
+    double visibleStartSec = 0.0;
+    double visibleEndSec = 1.0;
+
+    juce::Rectangle<int> getWaveArea() const;
 
-    const juce::AudioSampleBuffer* waveformBuffer = nullptr;
-    int    waveformStartSample = 0;
+    // What an image was rendered for; a new request is made when this changes
+    struct WaveformImageKey
+    {
+        const void* peaks = nullptr;
+        int    width = 0;
+        int    height = 0;
+        double startSample = 0.0;
+        double numSamples = 0.0;
+        juce::int64 availableSamples = 0;
+
+        bool operator== (const WaveformImageKey& other) const noexcept
+        {
+            return peaks == other.peaks
+                && width == other.width
+                && height == other.height
+                && startSample == other.startSample
+                && numSamples == other.numSamples
+                && availableSamples == other.availableSamples;
+        }
+    };
+
+    void requestWaveformImage();
+    void waveformImageReady(const WaveformImageKey& key, const juce::Image& image);
+
+    std::shared_ptr<const WaveformPeakCache> waveformPeaks;
     int    waveformNumSamples = 0;
 
+    std::shared_ptr<const SpectrogramCache> spectrogramSource;
+    bool showSpectrogram = false;
+
+    void drawPitchCurve(juce::Graphics& g, juce::Rectangle<int> area, juce::Colour colour) const;
+
+    std::shared_ptr<const PitchCurve> pitchCurve;
+    int    pitchFramesShown = 0;
+
+    void drawOnsets(juce::Graphics& g, juce::Rectangle<int> area, juce::Colour colour) const;
+
+    std::shared_ptr<const TakeOnsets> takeOnsets;
+
+    WaveformImageRenderer* waveformRenderer = nullptr;
+    juce::Image      waveformImage;
+    WaveformImageKey renderedKey;
+    bool             renderPending = false;
+
     std::function<void(int)> selectCallback;
     std::function<void(int)> soloCallback;
+    std::function<bool(double, const juce::MouseWheelDetails&, juce::ModifierKeys)> wheelCallback;
 };
 
 //==============================================================================
@@ -226,6 +294,63 @@ private:
     static constexpr double maxDurationSeconds = 90.0;
 };
 
+//==============================================================================
+// InputMeter: peak / RMS bars per input with a held clip light.
+// Fed once per UI frame with what the audio thread measured since the last.
+//==============================================================================
+
+class InputMeter : public juce::Component,
+    public juce::SettableTooltipClient
+{
+public:
+    static constexpr int maxChannels = 8;
+    static constexpr double clipHoldSeconds = 2.0;
+
+    InputMeter() = default;
+
+    void setNumChannels(int n);
+    void setLevel(int channel, float peak, float rms, bool clipped);
+
+    // Click to clear a held clip light
+    void mouseDown(const juce::MouseEvent&) override;
+    void paint(juce::Graphics& g) override;
+
+private:
+    struct Channel
+    {
+        float  peak = 0.0f;         // displayed, with release
+        float  rms = 0.0f;
+        double clipUntilMs = 0.0;
+    };
+
+    Channel channels[maxChannels];
+    int numChannels = 0;
+};
+
+//==============================================================================
+// MemoryPanel: debug overlay listing MemoryRegistry categories.
+// Click to reset the peaks.
+//==============================================================================
+
+class MemoryPanel : public juce::Component,
+    public juce::SettableTooltipClient
+{
+public:
+    MemoryPanel() = default;
+
+    void setLines(const juce::StringArray& newLines);
+    int  getIdealHeight() const { return 12 + lineHeight * lines.size(); }
+
+    std::function<void()> onClick;
+
+    void mouseDown(const juce::MouseEvent&) override;
+    void paint(juce::Graphics& g) override;
+
+private:
+    static constexpr int lineHeight = 14;
+    juce::StringArray lines;
+};
+
 
 
 
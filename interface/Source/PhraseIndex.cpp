@@ -0,0 +1,356 @@
+// PhraseIndex.cpp
+#include "PhraseIndex.h"
+
+using int64 = juce::int64;
+
+namespace
+{
+    int64 getModifiedMs(const juce::File& f)
+    {
+        return f.getLastModificationTime().toMilliseconds();
+    }
+}
+
+//==============================================================================
+// Take / Phrase
+//==============================================================================
+
+juce::var PhraseIndex::Take::toVar() const
+{
+    auto* obj = new juce::DynamicObject();
+    obj->setProperty("file", fileName);
+    obj->setProperty("index", index);
+    obj->setProperty("numSamples", numSamples);
+    obj->setProperty("sampleRate", sampleRate);
+    obj->setProperty("fileSize", fileSize);
+    obj->setProperty("modifiedMs", modifiedMs);
+    obj->setProperty("md5", md5);
+    return obj;
+}
+
+PhraseIndex::Take PhraseIndex::Take::fromVar(const juce::var& v)
+{
+    Take t;
+    t.fileName = v.getProperty("file", {}).toString();
+    t.index = (int)v.getProperty("index", 0);
+    t.numSamples = (int64)v.getProperty("numSamples", 0);
+    t.sampleRate = (double)v.getProperty("sampleRate", 0.0);
+    t.fileSize = (int64)v.getProperty("fileSize", 0);
+    t.modifiedMs = (int64)v.getProperty("modifiedMs", 0);
+    t.md5 = v.getProperty("md5", {}).toString();
+    return t;
+}
+
+juce::var PhraseIndex::Phrase::toVar() const
+{
+    juce::Array<juce::var> takesVar;
+    for (const auto& t : takes)
+        takesVar.add(t.toVar());
+
+    auto* obj = new juce::DynamicObject();
+    obj->setProperty("name", name);
+    obj->setProperty("index", index);
+    obj->setProperty("modifiedMs", modifiedMs);
+    obj->setProperty("numFiles", numFiles);
+    obj->setProperty("takes", takesVar);
+    return obj;
+}
+
+PhraseIndex::Phrase PhraseIndex::Phrase::fromVar(const juce::var& v)
+{
+    Phrase p;
+    p.name = v.getProperty("name", {}).toString();
+    p.index = (int)v.getProperty("index", 0);
+    p.modifiedMs = (int64)v.getProperty("modifiedMs", 0);
+    p.numFiles = (int)v.getProperty("numFiles", 0);
+
+    if (const auto* takesVar = v.getProperty("takes", {}).getArray())
+        for (const auto& t : *takesVar)
+            p.takes.push_back(Take::fromVar(t));
+
+    return p;
+}
+
+//==============================================================================
+// PhraseIndex
+//==============================================================================
+
+PhraseIndex::PhraseIndex(const juce::File& dir)
+    : singerDirectory(dir)
+{
+}
+
+void PhraseIndex::open(juce::AudioFormatManager& formatManager)
+{
+    if (!load())
+    {
+        rebuild(formatManager);
+        return;
+    }
+
+    bool changed = false;
+
+    // Phrase directories added or removed change the singer directory's date
+    const int64 singerModified = getModifiedMs(singerDirectory);
+
+    if (singerModified != singerModifiedMs)
+    {
+        juce::Array<juce::File> dirs;
+        singerDirectory.findChildFiles(dirs, juce::File::findDirectories, false, "phrase*");
+
+        std::vector<Phrase> refreshed;
+
+        for (const auto& dir : dirs)
+        {
+            const int n = getPhraseNumber(dir.getFileName());
+            if (n <= 0)
+                continue;
+
+            const auto* existing = findPhrase(n);
+
+            if (existing != nullptr && existing->modifiedMs == getModifiedMs(dir))
+                refreshed.push_back(*existing);
+            else
+                refreshed.push_back(scanPhrase(dir, formatManager, existing));
+        }
+
+        std::sort(refreshed.begin(), refreshed.end(),
+            [](const Phrase& a, const Phrase& b) { return a.index < b.index; });
+
+        phrases = std::move(refreshed);
+        singerModifiedMs = singerModified;
+        changed = true;
+    }
+    else
+    {
+        for (auto& p : phrases)
+        {
+            const auto dir = singerDirectory.getChildFile(p.name);
+
+            if (getModifiedMs(dir) != p.modifiedMs)
+            {
+                p = scanPhrase(dir, formatManager, &p);
+                changed = true;
+            }
+        }
+    }
+
+    if (changed)
+        save();
+}
+
+const PhraseIndex::Phrase* PhraseIndex::refreshPhrase(const juce::File& phraseDirectory,
+    juce::AudioFormatManager& formatManager,
+    bool force,
+    const std::vector<Take>& writtenTakes)
+{
+    if (phraseDirectory.getParentDirectory() != singerDirectory)
+        return nullptr;
+
+    const int n = getPhraseNumber(phraseDirectory.getFileName());
+    if (n <= 0)
+        return nullptr;
+
+    auto* existing = findPhrase(n);
+
+    if (existing != nullptr && !force && existing->modifiedMs == getModifiedMs(phraseDirectory))
+        return existing;
+
+    // The written takes stand in for whatever was indexed under their names
+    Phrase known;
+    const Phrase* previous = existing;
+
+    if (!writtenTakes.empty())
+    {
+        if (existing != nullptr)
+            known = *existing;
+
+        for (const auto& wt : writtenTakes)
+        {
+            auto it = std::find_if(known.takes.begin(), known.takes.end(),
+                [&wt](const Take& t) { return t.fileName == wt.fileName; });
+
+            if (it != known.takes.end())
+                *it = wt;
+            else
+                known.takes.push_back(wt);
+        }
+
+        previous = &known;
+    }
+
+    auto scanned = scanPhrase(phraseDirectory, formatManager, previous);
+
+    if (existing != nullptr)
+    {
+        *existing = std::move(scanned);
+    }
+    else
+    {
+        auto pos = std::lower_bound(phrases.begin(), phrases.end(), n,
+            [](const Phrase& p, int index) { return p.index < index; });
+
+        existing = &*phrases.insert(pos, std::move(scanned));
+    }
+
+    // singerModifiedMs stays: other directories may have appeared as well,
+    // and the next open() lists the singer directory once to find out.
+    save();
+    return existing;
+}
+
+int PhraseIndex::findFirstEmptyPhrase(int maxPhrases) const
+{
+    auto it = phrases.begin();
+
+    for (int idx = 1; idx <= maxPhrases; ++idx)
+    {
+        while (it != phrases.end() && it->index < idx)
+            ++it;
+
+        if (it == phrases.end() || it->index != idx || it->numFiles == 0)
+            return idx;
+    }
+
+    return 0;
+}
+
+juce::String PhraseIndex::getPhraseName(int index)
+{
+    return "phrase" + juce::String(index).paddedLeft('0', 2);
+}
+
+int PhraseIndex::getPhraseNumber(const juce::String& name)
+{
+    if (!name.startsWith("phrase") || !name.substring(6).containsOnly("0123456789"))
+        return 0;
+
+    return name.substring(6).getIntValue();
+}
+
+//==============================================================================
+
+bool PhraseIndex::load()
+{
+    const auto file = getIndexFile();
+    if (!file.existsAsFile())
+        return false;
+
+    const auto root = juce::JSON::parse(file);
+    const auto* phrasesVar = root.getProperty("phrases", {}).getArray();
+
+    if (phrasesVar == nullptr || (int)root.getProperty("version", 0) != version)
+        return false;
+
+    singerModifiedMs = (int64)root.getProperty("singerModifiedMs", 0);
+    phrases.clear();
+
+    for (const auto& p : *phrasesVar)
+    {
+        auto phrase = Phrase::fromVar(p);
+        if (phrase.index > 0)
+            phrases.push_back(std::move(phrase));
+    }
+
+    std::sort(phrases.begin(), phrases.end(),
+        [](const Phrase& a, const Phrase& b) { return a.index < b.index; });
+
+    return true;
+}
+
+void PhraseIndex::save()
+{
+    juce::Array<juce::var> phrasesVar;
+    for (const auto& p : phrases)
+        phrasesVar.add(p.toVar());
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("version", version);
+    root->setProperty("singerModifiedMs", singerModifiedMs);
+    root->setProperty("phrases", phrasesVar);
+
+    if (!getIndexFile().replaceWithText(juce::JSON::toString(juce::var(root))))
+        DBG("PhraseIndex: could not write " << getIndexFile().getFullPathName());
+}
+
+void PhraseIndex::rebuild(juce::AudioFormatManager& formatManager)
+{
+    phrases.clear();
+
+    juce::Array<juce::File> dirs;
+    singerDirectory.findChildFiles(dirs, juce::File::findDirectories, false, "phrase*");
+
+    for (const auto& dir : dirs)
+        if (getPhraseNumber(dir.getFileName()) > 0)
+            phrases.push_back(scanPhrase(dir, formatManager, nullptr));
+
+    std::sort(phrases.begin(), phrases.end(),
+        [](const Phrase& a, const Phrase& b) { return a.index < b.index; });
+
+    singerModifiedMs = getModifiedMs(singerDirectory);
+    save();
+}
+
+PhraseIndex::Phrase PhraseIndex::scanPhrase(const juce::File& phraseDirectory,
+    juce::AudioFormatManager& formatManager,
+    const Phrase* previous) const
+{
+    Phrase p;
+    p.name = phraseDirectory.getFileName();
+    p.index = getPhraseNumber(p.name);
+    p.modifiedMs = getModifiedMs(phraseDirectory);
+
+    juce::Array<juce::File> files;
+    phraseDirectory.findChildFiles(files, juce::File::findFiles, false);
+    p.numFiles = files.size();
+
+    for (const auto& f : files)
+    {
+        const auto name = f.getFileName();
+
+        if (!name.startsWithIgnoreCase("take_") || !f.hasFileExtension("wav"))
+            continue;
+
+        Take t;
+        t.fileName = name;
+        t.index = f.getFileNameWithoutExtension().fromFirstOccurrenceOf("_", false, false).getIntValue();
+        t.fileSize = f.getSize();
+        t.modifiedMs = getModifiedMs(f);
+
+        const Take* old = nullptr;
+        if (previous != nullptr)
+            for (const auto& pt : previous->takes)
+                if (pt.fileName == name)
+                    old = &pt;
+
+        // Unchanged file: keep what was measured and hashed before
+        if (old != nullptr && old->fileSize == t.fileSize && old->modifiedMs == t.modifiedMs)
+        {
+            p.takes.push_back(*old);
+            continue;
+        }
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(f));
+        if (reader == nullptr)
+            continue;
+
+        t.numSamples = reader->lengthInSamples;
+        t.sampleRate = reader->sampleRate;
+        t.md5 = juce::MD5(f).toHexString();
+
+        p.takes.push_back(t);
+    }
+
+    std::sort(p.takes.begin(), p.takes.end(),
+        [](const Take& a, const Take& b) { return a.index < b.index; });
+
+    return p;
+}
+
+PhraseIndex::Phrase* PhraseIndex::findPhrase(int index)
+{
+    auto it = std::lower_bound(phrases.begin(), phrases.end(), index,
+        [](const Phrase& p, int i) { return p.index < i; });
+
+    return (it != phrases.end() && it->index == index) ? &*it : nullptr;
+}
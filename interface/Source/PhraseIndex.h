@@ -0,0 +1,89 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+//==============================================================================
+// PhraseIndex: data_pilot/<singer>.index.json, listing every phraseNN
+// directory of that singer with its take_*.wav files (length, sample rate,
+// size, MD5). It sits next to the singer directory rather than inside it, so
+// saving the index does not change the date it checks for new phrases.
+//
+// Startup reads the index and stats each listed directory instead of walking
+// them. A phrase whose directory changed since it was indexed is rescanned
+// on its own (takes with the same size and date keep their hash); the whole
+// singer directory is only rescanned when the index is missing, unreadable
+// or from another version.
+//==============================================================================
+
+class PhraseIndex
+{
+public:
+    struct Take
+    {
+        juce::String fileName;     // "take_3.wav"
+        int          index = 0;    // 3
+        juce::int64  numSamples = 0;
+        double       sampleRate = 0.0;
+        juce::int64  fileSize = 0;
+        juce::int64  modifiedMs = 0;
+        juce::String md5;
+
+        juce::var toVar() const;
+        static Take fromVar(const juce::var& v);
+    };
+
+    struct Phrase
+    {
+        juce::String name;         // "phrase07"
+        int          index = 0;    // 7
+        juce::int64  modifiedMs = 0;   // of the directory when it was scanned
+        int          numFiles = 0;     // any file, not only takes
+        std::vector<Take> takes;       // sorted by index
+
+        juce::var toVar() const;
+        static Phrase fromVar(const juce::var& v);
+    };
+
+    static constexpr int version = 1;
+
+    explicit PhraseIndex(const juce::File& singerDirectory);
+
+    // Reads the index, refreshing what is stale, and saves it if anything changed.
+    void open(juce::AudioFormatManager& formatManager);
+
+    // Rescans phraseDirectory if forced or changed since it was indexed, and
+    // saves. Call with force after the app wrote into the directory. Returns
+    // nullptr for directories outside this singer directory.
+    //
+    // writtenTakes are takes the caller has just written and hashed itself;
+    // they are kept as given while their size and date match the file, so
+    // the rescan does not read them back to hash them again.
+    const Phrase* refreshPhrase(const juce::File& phraseDirectory,
+        juce::AudioFormatManager& formatManager,
+        bool force = false,
+        const std::vector<Take>& writtenTakes = {});
+
+    // First phraseNN (1..maxPhrases) that does not exist or has no files; 0 if none.
+    int findFirstEmptyPhrase(int maxPhrases) const;
+
+    static juce::String getPhraseName(int index);   // 7 -> "phrase07"
+    static int getPhraseNumber(const juce::String& name);   // "phrase07" -> 7, else 0
+
+    juce::File getIndexFile() const { return singerDirectory.getSiblingFile(singerDirectory.getFileName() + ".index.json"); }
+
+private:
+    bool load();
+    void save();
+    void rebuild(juce::AudioFormatManager& formatManager);
+    Phrase scanPhrase(const juce::File& phraseDirectory,
+        juce::AudioFormatManager& formatManager,
+        const Phrase* previous) const;
+    Phrase* findPhrase(int index);
+
+    const juce::File singerDirectory;
+    juce::int64 singerModifiedMs = 0;
+    std::vector<Phrase> phrases;   // sorted by index
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PhraseIndex)
+};
@@ -0,0 +1,483 @@
+// PitchTracker.cpp
+#include "PitchTracker.h"
+#include "ActivityAnalyser.h"
+
+using int64 = juce::int64;
+
+namespace
+{
+    constexpr double minPitchHz = 60.0;
+    constexpr double maxPitchHz = 1100.0;
+    constexpr float  yinThreshold = 0.15f;
+    constexpr float  silenceMeanSquare = 1.0e-5f;   // ~ -50 dBFS RMS
+
+    int getYinWindowSize(double sampleRate)
+    {
+        // ~20 ms, rounded up to a power of two (1024 at 44.1/48 kHz)
+        return juce::nextPowerOfTwo(juce::jmax(256, juce::roundToInt(sampleRate * 0.02)));
+    }
+
+    constexpr juce::uint32 pitchFileMagic = 0x31433046;   // "F0C1"
+}
+
+//==============================================================================
+// PitchTracker
+//==============================================================================
+
+PitchTracker::PitchTracker(double rate)
+    : sampleRate(rate > 0.0 ? rate : 44100.0),
+      windowSize(getYinWindowSize(sampleRate)),
+      hopSize(windowSize / 2),
+      minLag(juce::jmax(2, (int)(sampleRate / maxPitchHz))),
+      maxLag(juce::jmin(windowSize - 2, (int)(sampleRate / minPitchHz))),
+      fft(juce::roundToInt(std::log2((double)windowSize * 4.0)))
+{
+    const int n = fft.getSize();
+    spectrumA.resize((size_t)n * 2, 0.0f);
+    spectrumB.resize((size_t)n * 2, 0.0f);
+    energy.resize((size_t)windowSize * 2 + 1, 0.0f);
+    difference.resize((size_t)windowSize, 1.0f);
+
+    reset();
+}
+
+void PitchTracker::reset()
+{
+    // Prime with W zeros so frame k is centred on input sample k * hopSize
+    carry.assign((size_t)windowSize, 0.0f);
+}
+
+void PitchTracker::process(const float* samples, int numSamples, std::vector<float>& f0Out)
+{
+    if (samples == nullptr || numSamples <= 0)
+        return;
+
+    carry.insert(carry.end(), samples, samples + numSamples);
+
+    const size_t frameLength = (size_t)windowSize * 2;
+    size_t pos = 0;
+
+    while (carry.size() - pos >= frameLength)
+    {
+        f0Out.push_back(estimateFrame(carry.data() + pos));
+        pos += (size_t)hopSize;
+    }
+
+    carry.erase(carry.begin(), carry.begin() + (std::ptrdiff_t)pos);
+}
+
+void PitchTracker::processSilence(int64 numSamples, std::vector<float>& f0Out)
+{
+    // Frames that still see the last real samples are computed; once a whole
+    // frame of zeros is queued every further frame is silent, and only counted
+    const int64 frameLength = (int64)windowSize * 2;
+    const int64 computed = juce::jmin(numSamples, frameLength);
+
+    if (computed > 0)
+    {
+        const std::vector<float> zeros((size_t)computed, 0.0f);
+        process(zeros.data(), (int)computed, f0Out);
+    }
+
+    const int64 total = (int64)carry.size() + (numSamples - computed);
+    if (numSamples <= computed || total < frameLength)
+    {
+        carry.resize((size_t)total, 0.0f);
+        return;
+    }
+
+    const int64 numFrames = (total - frameLength) / hopSize + 1;
+    f0Out.insert(f0Out.end(), (size_t)numFrames, 0.0f);
+
+    carry.assign((size_t)(total - numFrames * hopSize), 0.0f);
+}
+
+float PitchTracker::estimateFrame(const float* frame)
+{
+    const int w = windowSize;
+    const int n = fft.getSize();
+
+    // Running energies: energy[i] = sum of x^2 over frame[0, i)
+    energy[0] = 0.0f;
+    for (int i = 0; i < w * 2; ++i)
+        energy[(size_t)i + 1] = energy[(size_t)i] + frame[i] * frame[i];
+
+    const float e0 = energy[(size_t)w];
+    if (e0 / (float)w < silenceMeanSquare)
+        return 0.0f;
+
+    // c[tau] = sum_j x[j] * x[j + tau] for j < W, as IFFT(conj(A) * B)
+    std::fill(spectrumA.begin(), spectrumA.end(), 0.0f);
+    std::fill(spectrumB.begin(), spectrumB.end(), 0.0f);
+    std::copy(frame, frame + w, spectrumA.begin());
+    std::copy(frame, frame + w * 2, spectrumB.begin());
+
+    fft.performRealOnlyForwardTransform(spectrumA.data());
+    fft.performRealOnlyForwardTransform(spectrumB.data());
+
+    for (int k = 0; k < n; ++k)
+    {
+        const float ar = spectrumA[(size_t)k * 2];
+        const float ai = spectrumA[(size_t)k * 2 + 1];
+        const float br = spectrumB[(size_t)k * 2];
+        const float bi = spectrumB[(size_t)k * 2 + 1];
+
+        spectrumA[(size_t)k * 2] = ar * br + ai * bi;
+        spectrumA[(size_t)k * 2 + 1] = ar * bi - ai * br;
+    }
+
+    fft.performRealOnlyInverseTransform(spectrumA.data());
+    const float* correlation = spectrumA.data();
+
+    // Cumulative-mean-normalised difference d'(tau)
+    difference[0] = 1.0f;
+    float runningSum = 0.0f;
+
+    for (int tau = 1; tau <= maxLag; ++tau)
+    {
+        const float eTau = energy[(size_t)(tau + w)] - energy[(size_t)tau];
+        const float d = juce::jmax(0.0f, e0 + eTau - 2.0f * correlation[tau]);
+
+        runningSum += d;
+        difference[(size_t)tau] = runningSum > 0.0f ? d * (float)tau / runningSum : 1.0f;
+    }
+
+    // First dip under the threshold, then walk down to its local minimum
+    int bestLag = -1;
+    for (int tau = minLag; tau <= maxLag; ++tau)
+    {
+        if (difference[(size_t)tau] < yinThreshold)
+        {
+            while (tau + 1 <= maxLag && difference[(size_t)tau + 1] < difference[(size_t)tau])
+                ++tau;
+
+            bestLag = tau;
+            break;
+        }
+    }
+
+    if (bestLag < 0)
+        return 0.0f;
+
+    double refinedLag = (double)bestLag;
+
+    if (bestLag > minLag && bestLag < maxLag)
+    {
+        const double s0 = difference[(size_t)bestLag - 1];
+        const double s1 = difference[(size_t)bestLag];
+        const double s2 = difference[(size_t)bestLag + 1];
+        const double denom = s0 - 2.0 * s1 + s2;
+
+        if (std::abs(denom) > 1.0e-12)
+            refinedLag += 0.5 * (s0 - s2) / denom;
+    }
+
+    return (float)(sampleRate / refinedLag);
+}
+
+std::shared_ptr<PitchCurve> PitchTracker::analyse(juce::AudioFormatReader& reader,
+    const std::function<bool()>& shouldExit, const TakeActivity* activity)
+{
+    PitchTracker tracker(reader.sampleRate);
+    std::vector<float> f0;
+
+    const int   numChannels = juce::jmax(1, (int)reader.numChannels);
+    const int   blockSize = 65536;
+    const int64 totalSamples = reader.lengthInSamples;
+
+    // Without a map the whole file is one active run
+    std::vector<juce::Range<int64>> runs{ { 0, totalSamples } };
+    if (activity != nullptr)
+        runs = activity->getRunsInSamples(reader.sampleRate, totalSamples);
+
+    juce::AudioBuffer<float> block(numChannels, blockSize);
+    size_t nextRun = 0;
+
+    for (int64 pos = 0; pos < totalSamples;)
+    {
+        if (shouldExit != nullptr && shouldExit())
+            return nullptr;
+
+        while (nextRun < runs.size() && runs[nextRun].getEnd() <= pos)
+            ++nextRun;
+
+        // Gaps between runs are silence as far as the tracker is concerned
+        const int64 runStart = nextRun < runs.size() ? runs[nextRun].getStart() : totalSamples;
+        if (pos < runStart)
+        {
+            tracker.processSilence(runStart - pos, f0);
+            pos = runStart;
+            continue;
+        }
+
+        const int n = (int)juce::jmin<int64>(blockSize, runs[nextRun].getEnd() - pos);
+
+        reader.read(&block, 0, n, pos, true, true);
+
+        if (numChannels > 1)
+        {
+            for (int ch = 1; ch < numChannels; ++ch)
+                block.addFrom(0, 0, block, ch, 0, n);
+
+            block.applyGain(0, 0, n, 1.0f / (float)numChannels);
+        }
+
+        tracker.process(block.getReadPointer(0), n, f0);
+        pos += n;
+    }
+
+    auto curve = std::make_shared<PitchCurve>(tracker.getFramesPerSecond(), 0.0);
+    curve->append(f0.data(), (int)f0.size());
+    return curve;
+}
+
+//==============================================================================
+// PitchCurve
+//==============================================================================
+
+PitchCurve::PitchCurve(double fps, double firstTimeSec)
+    : framesPerSecond(fps),
+      firstFrameTimeSec(firstTimeSec)
+{
+}
+
+void PitchCurve::append(const float* f0, int numFrames)
+{
+    if (f0 == nullptr || numFrames <= 0)
+        return;
+
+    const juce::SpinLock::ScopedLockType sl(lock);
+    frames.insert(frames.end(), f0, f0 + numFrames);
+}
+
+int PitchCurve::getNumFrames() const
+{
+    const juce::SpinLock::ScopedLockType sl(lock);
+    return (int)frames.size();
+}
+
+int PitchCurve::copyFrames(int first, int num, float* dest) const
+{
+    const juce::SpinLock::ScopedLockType sl(lock);
+
+    const int start = juce::jmax(0, first);
+    const int end = juce::jmin((int)frames.size(), first + num);
+
+    if (end <= start)
+        return 0;
+
+    std::copy(frames.begin() + start, frames.begin() + end, dest + (start - first));
+    return end - start;
+}
+
+bool PitchCurve::writeToFile(const juce::File& file) const
+{
+    std::vector<float> snapshot;
+    {
+        const juce::SpinLock::ScopedLockType sl(lock);
+        snapshot = frames;
+    }
+
+    juce::TemporaryFile temp(file);
+
+    {
+        juce::FileOutputStream out(temp.getFile());
+        if (!out.openedOk())
+            return false;
+
+        out.writeInt((int)pitchFileMagic);
+        out.writeDouble(framesPerSecond);
+        out.writeDouble(firstFrameTimeSec);
+        out.writeInt((int)snapshot.size());
+
+        for (float f : snapshot)
+            out.writeFloat(f);
+
+        out.flush();
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+std::shared_ptr<PitchCurve> PitchCurve::readFromFile(const juce::File& file)
+{
+    juce::FileInputStream in(file);
+    if (!in.openedOk() || (juce::uint32)in.readInt() != pitchFileMagic)
+        return nullptr;
+
+    const double fps = in.readDouble();
+    const double firstTime = in.readDouble();
+    const int    count = in.readInt();
+
+    if (fps <= 0.0 || count < 0 || (int64)count * 4 > in.getNumBytesRemaining())
+        return nullptr;
+
+    auto curve = std::make_shared<PitchCurve>(fps, firstTime);
+    curve->frames.resize((size_t)count);
+
+    for (auto& f : curve->frames)
+        f = in.readFloat();
+
+    return curve;
+}
+
+//==============================================================================
+// LivePitchAnalyser
+//==============================================================================
+
+LivePitchAnalyser::LivePitchAnalyser()
+    : juce::Thread("Live pitch analysis")
+{
+    ring.resize((size_t)fifoSize, 0.0f);
+    readScratch.resize(8192);
+
+    startThread();
+}
+
+LivePitchAnalyser::~LivePitchAnalyser()
+{
+    stopThread(2000);
+}
+
+void LivePitchAnalyser::prepare(double newSampleRate, int newLoopLengthSamples)
+{
+    const juce::ScopedLock sl(stateLock);
+
+    if (newSampleRate <= 0.0)
+        newSampleRate = 44100.0;
+
+    if (tracker != nullptr
+        && newSampleRate == sampleRate
+        && newLoopLengthSamples == loopLengthSamples)
+        return;
+
+    // Frames already filed would no longer line up with the takes
+    processPending();
+
+    sampleRate = newSampleRate;
+    loopLengthSamples = newLoopLengthSamples;
+    tracker = std::make_unique<PitchTracker>(sampleRate);
+    curves.clear();
+
+    segmentStartSample = 0;
+    framesInSegment = 0;
+}
+
+void LivePitchAnalyser::beginRecording(juce::int64 startSample)
+{
+    const juce::ScopedLock sl(stateLock);
+
+    // Whatever the previous pass left in the FIFO still belongs to it
+    processPending();
+
+    if (tracker != nullptr)
+        tracker->reset();
+
+    segmentStartSample = startSample;
+    framesInSegment = 0;
+}
+
+void LivePitchAnalyser::pushSamples(const float* samples, int numSamples) noexcept
+{
+    if (samples == nullptr || numSamples <= 0)
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    if (size1 > 0)
+        std::copy(samples, samples + size1, ring.data() + start1);
+
+    if (size2 > 0)
+        std::copy(samples + size1, samples + size1 + size2, ring.data() + start2);
+
+    fifo.finishedWrite(size1 + size2);
+
+    if (size1 + size2 < numSamples)
+        droppedSamples += numSamples - (size1 + size2);
+}
+
+void LivePitchAnalyser::flush()
+{
+    const juce::ScopedLock sl(stateLock);
+    processPending();
+}
+
+void LivePitchAnalyser::clear()
+{
+    const juce::ScopedLock sl(stateLock);
+
+    // Anything still queued is discarded by processPending() until prepare()
+    tracker.reset();
+    curves.clear();
+}
+
+std::shared_ptr<PitchCurve> LivePitchAnalyser::getCurveForTake(int takeIndex) const
+{
+    const juce::ScopedLock sl(stateLock);
+    return curves[takeIndex];
+}
+
+void LivePitchAnalyser::run()
+{
+    while (!threadShouldExit())
+    {
+        {
+            const juce::ScopedLock sl(stateLock);
+            processPending();
+        }
+
+        // Polling keeps pushSamples() free of any signalling on the audio thread
+        wait(10);
+    }
+}
+
+void LivePitchAnalyser::processPending()
+{
+    for (;;)
+    {
+        const int ready = fifo.getNumReady();
+        if (ready <= 0)
+            return;
+
+        const int num = juce::jmin(ready, (int)readScratch.size());
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(num, start1, size1, start2, size2);
+
+        if (size1 > 0)
+            std::copy(ring.data() + start1, ring.data() + start1 + size1, readScratch.data());
+
+        if (size2 > 0)
+            std::copy(ring.data() + start2, ring.data() + start2 + size2, readScratch.data() + size1);
+
+        fifo.finishedRead(size1 + size2);
+
+        if (tracker == nullptr)
+            continue;
+
+        frameScratch.clear();
+        tracker->process(readScratch.data(), size1 + size2, frameScratch);
+
+        // File each frame under the take its centre sample falls into
+        for (const float f0 : frameScratch)
+        {
+            const int64 pos = segmentStartSample + framesInSegment * tracker->getHopSize();
+            ++framesInSegment;
+
+            const int   takeIndex = loopLengthSamples > 0 ? (int)(pos / loopLengthSamples) : 0;
+            const int64 takeStart = (int64)takeIndex * loopLengthSamples;
+
+            while (curves.size() <= takeIndex)
+                curves.add(nullptr);
+
+            if (curves[takeIndex] == nullptr)
+                curves.set(takeIndex, std::make_shared<PitchCurve>(tracker->getFramesPerSecond(),
+                    (double)(pos - takeStart) / sampleRate));
+
+            curves[takeIndex]->append(&f0, 1);
+        }
+    }
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class PitchCurve;
+class TakeActivity;
+
+//==============================================================================
+// PitchTracker: streaming YIN f0 estimator.
+//
+// The difference function is computed from an FFT cross-correlation plus
+// running energies, so each frame costs two forward FFTs and one inverse
+// instead of a window x lag double loop. One value per hop is produced;
+// 0 means unvoiced. Frame k is centred on input sample k * hopSize.
+//==============================================================================
+
+class PitchTracker
+{
+public:
+    explicit PitchTracker(double sampleRate);
+
+    void reset();
+
+    // Appends one f0 value (Hz, 0 = unvoiced) per completed hop to f0Out.
+    void process(const float* samples, int numSamples, std::vector<float>& f0Out);
+
+    // Same frames as process() on numSamples zeros, without computing them.
+    void processSilence(juce::int64 numSamples, std::vector<float>& f0Out);
+
+    int    getHopSize() const noexcept { return hopSize; }
+    double getFramesPerSecond() const noexcept { return sampleRate / (double)hopSize; }
+
+    // Whole file, mixed to mono, as a curve starting at 0 s. With an activity
+    // map, only its active runs are read; the rest is unvoiced.
+    // Returns nullptr if shouldExit() turned true.
+    static std::shared_ptr<PitchCurve> analyse(juce::AudioFormatReader& reader,
+        const std::function<bool()>& shouldExit, const TakeActivity* activity = nullptr);
+
+private:
+    float estimateFrame(const float* frame);
+
+    const double sampleRate;
+    const int    windowSize;   // YIN integration window W; frames are 2W long
+    const int    hopSize;
+    const int    minLag, maxLag;
+
+    juce::dsp::FFT fft;
+    std::vector<float> carry;
+    std::vector<float> spectrumA, spectrumB;
+    std::vector<float> energy;      // prefix sums of x^2 over the frame
+    std::vector<float> difference;  // cumulative-mean-normalised d'(tau)
+};
+
+//==============================================================================
+// PitchCurve: f0 frames for one take, appendable from a worker thread while
+// the message thread draws it. Times are relative to the take start.
+//==============================================================================
+
+class PitchCurve
+{
+public:
+    PitchCurve(double framesPerSecond, double firstFrameTimeSec);
+
+    void append(const float* f0, int numFrames);
+
+    int    getNumFrames() const;
+    double getFramesPerSecond() const noexcept { return framesPerSecond; }
+    double getFirstFrameTimeSec() const noexcept { return firstFrameTimeSec; }
+
+    // Copies frames [first, first + num) that exist; returns how many were copied.
+    int copyFrames(int first, int num, float* dest) const;
+
+    // Sidecar next to a take WAV (take_N.f0), so loaded takes are analysed once.
+    bool writeToFile(const juce::File& file) const;
+    static std::shared_ptr<PitchCurve> readFromFile(const juce::File& file);
+
+private:
+    const double framesPerSecond;
+    const double firstFrameTimeSec;
+
+    std::vector<float> frames;
+    mutable juce::SpinLock lock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PitchCurve)
+};
+
+//==============================================================================
+// LivePitchAnalyser: tracks pitch of the recording input on its own thread.
+//
+// The audio thread only copies samples into a lock-free FIFO (pushSamples);
+// the analyser thread drains it, runs the PitchTracker and files the frames
+// into one PitchCurve per loop-length take.
+//==============================================================================
+
+class LivePitchAnalyser : private juce::Thread
+{
+public:
+    LivePitchAnalyser();
+    ~LivePitchAnalyser() override;
+
+    // Message thread, before each recording pass. Curves are kept unless the
+    // sample rate or loop length changed.
+    void prepare(double sampleRate, int loopLengthSamples);
+
+    // Message thread, before recording starts: position (in the take buffer)
+    // of the next pushed sample.
+    void beginRecording(juce::int64 startSample);
+
+    // Audio thread. Never blocks; samples are dropped if the FIFO is full.
+    void pushSamples(const float* samples, int numSamples) noexcept;
+
+    // Message thread, after recording stops: analyses whatever is still queued.
+    void flush();
+
+    // Drops all curves; pushed samples are ignored until the next prepare().
+    void clear();
+
+    std::shared_ptr<PitchCurve> getCurveForTake(int takeIndex) const;
+
+    int getNumDroppedSamples() const noexcept { return droppedSamples.load(); }
+
+private:
+    void run() override;
+    void processPending();   // caller holds stateLock
+
+    static constexpr int fifoSize = 1 << 18;   // ~5 s at 48 kHz
+
+    juce::AbstractFifo fifo{ fifoSize };
+    std::vector<float> ring;
+    std::atomic<int>   droppedSamples{ 0 };
+
+    mutable juce::CriticalSection stateLock;
+    std::unique_ptr<PitchTracker> tracker;
+    std::vector<float> readScratch, frameScratch;
+    double      sampleRate = 44100.0;
+    int         loopLengthSamples = 0;
+    juce::int64 segmentStartSample = 0;
+    juce::int64 framesInSegment = 0;
+    juce::Array<std::shared_ptr<PitchCurve>> curves;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LivePitchAnalyser)
+};
@@ -44,6 +44,7 @@ juce::var ProjectState::toVar() const
     root->setProperty("loopEndSec", loopEndSec);
     root->setProperty("loopLocked", loopLocked);
     root->setProperty("cachedLoopLengthSec", cachedLoopLengthSec);
+    root->setProperty("projectSampleRate", projectSampleRate);
 
     // Tempo
     root->setProperty("bpm", bpm);
@@ -98,6 +99,7 @@ ProjectState ProjectState::fromVar(const juce::var& v)
         s.loopEndSec = (double)root->getProperty("loopEndSec");
         s.loopLocked = (bool)root->getProperty("loopLocked");
         s.cachedLoopLengthSec = (double)root->getProperty("cachedLoopLengthSec");
+        s.projectSampleRate = (double)root->getProperty("projectSampleRate");   // 0 in older projects
 
         s.bpm = (int)root->getProperty("bpm");
         s.bpmSet = (bool)root->getProperty("bpmSet");
@@ -138,6 +140,23 @@ ProjectState ProjectState::fromVar(const juce::var& v)
     return s;
 }
 
+int ProjectState::gridLoopLengthSamples(double loopSeconds, int bpm, double sampleRate)
+{
+    if (loopSeconds <= 0.0 || sampleRate <= 0.0)
+        return 0;
+
+    if (bpm > 0)
+    {
+        const double secondsPerBeat = 60.0 / (double)bpm;
+        const double beats = std::round(loopSeconds / secondsPerBeat);
+
+        if (beats >= 1.0 && std::abs(beats * secondsPerBeat - loopSeconds) <= gridToleranceSec)
+            return juce::roundToInt(beats * secondsPerBeat * sampleRate);
+    }
+
+    return juce::roundToInt(loopSeconds * sampleRate);
+}
+
 bool ProjectState::saveToFile(const ProjectState& state,
     const juce::File& file,
     juce::String& errorMessage)
@@ -25,6 +25,9 @@ struct ProjectState
     bool   loopLocked = false;
     double cachedLoopLengthSec = 0.0;
 
+    // Rate every take_N.wav is stored (and analysed) at; 0 until the first take
+    double projectSampleRate = 0.0;
+
     // Tempo / metronome
     int  bpm = 120;
     bool bpmSet = false;
@@ -60,6 +63,12 @@ struct ProjectState
     // Optional cached segments (in addition to compmap JSON)
     juce::Array<CompSegmentState> compSegments;
 
+    // Loop length as a whole number of samples at sampleRate. A loop within
+    // gridToleranceSec of a whole number of beats is taken as exactly that many
+    // beats, so the same loop is the same length at any rate.
+    static constexpr double gridToleranceSec = 0.010;
+    static int gridLoopLengthSamples(double loopSeconds, int bpm, double sampleRate);
+
     // Serialisation helpers
     juce::var      toVar() const;
     static ProjectState fromVar(const juce::var& v);
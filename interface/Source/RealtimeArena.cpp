@@ -0,0 +1,282 @@
+// RealtimeArena.cpp
+#include "RealtimeArena.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <sys/mman.h>
+#endif
+
+namespace
+{
+    size_t roundUpToPages(size_t numBytes)
+    {
+        const size_t page = (size_t)juce::jmax(4096, juce::SystemStats::getPageSize());
+        return ((juce::jmax((size_t)1, numBytes) + page - 1) / page) * page;
+    }
+
+    void* mapPages(size_t numBytes)
+    {
+       #if JUCE_WINDOWS
+        return VirtualAlloc(nullptr, numBytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+       #else
+        void* p = mmap(nullptr, numBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return p == MAP_FAILED ? nullptr : p;
+       #endif
+    }
+
+    void unmapPages(void* p, size_t numBytes, bool locked)
+    {
+       #if JUCE_WINDOWS
+        if (locked)
+            VirtualUnlock(p, numBytes);
+
+        VirtualFree(p, 0, MEM_RELEASE);
+       #else
+        if (locked)
+            munlock(p, numBytes);
+
+        munmap(p, numBytes);
+       #endif
+    }
+
+    bool lockPages(void* p, size_t numBytes)
+    {
+       #if JUCE_WINDOWS
+        return VirtualLock(p, numBytes) != 0;
+       #else
+        return mlock(p, numBytes) == 0;
+       #endif
+    }
+}
+
+//==============================================================================
+
+RealtimeArena::~RealtimeArena()
+{
+    // Attached buffers are still holding theirs; owners declare the arena
+    // first, so those buffers are already gone
+    for (auto& slab : slabs)
+        unmapPages(slab->base, slab->numBytes, slab->locked);
+}
+
+void* RealtimeArena::allocate(size_t numBytes)
+{
+    numBytes = roundUpToPages(numBytes);
+
+    // Never taken on the audio thread, so mapping a slab under it is fine
+    const juce::ScopedLock sl(lock);
+
+    void* p = nullptr;
+    Slab* from = nullptr;
+
+    for (auto& slab : slabs)
+    {
+        if ((p = takeRange(*slab, numBytes)) != nullptr)
+        {
+            from = slab.get();
+            break;
+        }
+    }
+
+    if (p == nullptr)
+    {
+        auto slab = std::make_unique<Slab>();
+        slab->numBytes = juce::jmax(roundUpToPages(slabSize), numBytes);
+        slab->base = static_cast<char*>(mapPages(slab->numBytes));
+
+        if (slab->base == nullptr)
+            return nullptr;
+
+        slab->locked = lockPages(slab->base, slab->numBytes);
+
+        // Fresh anonymous pages are mapped on first write, so write them all now.
+        // Locking usually does this already; unlocked memory needs it regardless.
+        const size_t page = (size_t)juce::jmax(4096, juce::SystemStats::getPageSize());
+        auto* bytes = static_cast<volatile char*>(slab->base);
+
+        for (size_t i = 0; i < slab->numBytes; i += page)
+            bytes[i] = 0;
+
+        slab->freeRanges[0] = slab->numBytes;
+
+        stats.mappedBytes += slab->numBytes;
+        stats.lockedBytes += slab->locked ? slab->numBytes : 0;
+        ++stats.numSlabs;
+
+        if (!slab->locked && !reportedLockFailure)
+        {
+            reportedLockFailure = true;
+            DBG("RealtimeArena: could not lock " << (int)slab->numBytes << " bytes, "
+                << getDescription() << " (raise the memlock limit to lock more)");
+        }
+
+        from = slab.get();
+        p = takeRange(*from, numBytes);
+        slabs.push_back(std::move(slab));
+    }
+
+    allocations[p] = { numBytes, from };
+    stats.allocatedBytes += numBytes;
+    ++stats.numAllocations;
+
+    return p;
+}
+
+void RealtimeArena::free(void* data)
+{
+    if (data == nullptr)
+        return;
+
+    std::unique_ptr<Slab> emptySlab;
+
+    {
+        const juce::ScopedLock sl(lock);
+
+        auto it = allocations.find(data);
+        if (it == allocations.end())
+        {
+            jassertfalse;   // not from this arena
+            return;
+        }
+
+        const auto a = it->second;
+        allocations.erase(it);
+
+        returnRange(*a.slab, (size_t)(static_cast<char*>(data) - a.slab->base), a.numBytes);
+
+        stats.allocatedBytes -= a.numBytes;
+        --stats.numAllocations;
+
+        if (a.slab->usedBytes == 0)
+        {
+            auto s = std::find_if(slabs.begin(), slabs.end(),
+                [&a](const std::unique_ptr<Slab>& slab) { return slab.get() == a.slab; });
+
+            emptySlab = std::move(*s);
+            slabs.erase(s);
+
+            stats.mappedBytes -= emptySlab->numBytes;
+            stats.lockedBytes -= emptySlab->locked ? emptySlab->numBytes : 0;
+            --stats.numSlabs;
+        }
+    }
+
+    if (emptySlab != nullptr)
+        unmapPages(emptySlab->base, emptySlab->numBytes, emptySlab->locked);
+}
+
+void* RealtimeArena::takeRange(Slab& slab, size_t numBytes)
+{
+    for (auto it = slab.freeRanges.begin(); it != slab.freeRanges.end(); ++it)
+    {
+        if (it->second < numBytes)
+            continue;
+
+        const size_t offset = it->first;
+        const size_t rest = it->second - numBytes;
+
+        slab.freeRanges.erase(it);
+
+        if (rest > 0)
+            slab.freeRanges[offset + numBytes] = rest;
+
+        slab.usedBytes += numBytes;
+
+        // Already faulted in and locked; a reused range still holds what was
+        // freed there
+        std::memset(slab.base + offset, 0, numBytes);
+        return slab.base + offset;
+    }
+
+    return nullptr;
+}
+
+void RealtimeArena::returnRange(Slab& slab, size_t offset, size_t numBytes)
+{
+    slab.usedBytes -= numBytes;
+
+    auto next = slab.freeRanges.lower_bound(offset);
+
+    if (next != slab.freeRanges.begin())
+    {
+        auto prev = std::prev(next);
+
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            numBytes += prev->second;
+            slab.freeRanges.erase(prev);
+        }
+    }
+
+    if (next != slab.freeRanges.end() && offset + numBytes == next->first)
+    {
+        numBytes += next->second;
+        slab.freeRanges.erase(next);
+    }
+
+    slab.freeRanges[offset] = numBytes;
+}
+
+bool RealtimeArena::attach(juce::AudioBuffer<float>& buffer, int numChannels, int numSamples)
+{
+    detach(buffer);
+
+    auto* data = allocateArray<float>((size_t)numChannels * (size_t)numSamples);
+
+    if (data == nullptr)
+    {
+        buffer.setSize(numChannels, numSamples, false, true, false);
+        return false;
+    }
+
+    juce::HeapBlock<float*> channels((size_t)numChannels);
+    for (int ch = 0; ch < numChannels; ++ch)
+        channels[ch] = data + (size_t)ch * (size_t)numSamples;
+
+    buffer.setDataToReferTo(channels.get(), numChannels, numSamples);
+
+    const juce::ScopedLock sl(lock);
+    attached[&buffer] = data;
+    return true;
+}
+
+void RealtimeArena::detach(juce::AudioBuffer<float>& buffer)
+{
+    void* data = nullptr;
+
+    {
+        const juce::ScopedLock sl(lock);
+
+        auto it = attached.find(&buffer);
+        if (it == attached.end())
+            return;
+
+        data = it->second;
+        attached.erase(it);
+    }
+
+    buffer.setSize(0, 0);
+    free(data);
+}
+
+RealtimeArena::Stats RealtimeArena::getStats() const
+{
+    const juce::ScopedLock sl(lock);
+    return stats;
+}
+
+juce::String RealtimeArena::getDescription() const
+{
+    const auto s = getStats();
+
+    return juce::String((double)s.allocatedBytes / (1024.0 * 1024.0), 1) + " MB in "
+        + juce::String(s.numAllocations) + " blocks, "
+        + juce::String((double)s.lockedBytes / (1024.0 * 1024.0), 1) + " MB locked of "
+        + juce::String((double)s.mappedBytes / (1024.0 * 1024.0), 1) + " MB in "
+        + juce::String(s.numSlabs) + " slabs";
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// RealtimeArena: memory for buffers the audio thread reads or writes.
+//
+// Memory is mapped in slabs of a few MB, each faulted in and locked into RAM
+// (mlock / VirtualLock) as far as the OS allows when it is mapped, so the
+// first pass of the audio thread over it costs the same as any later one.
+// Allocations are whole pages carved out of the slabs (first fit) and come
+// back zeroed; a slab is unmapped once nothing in it is allocated. A slab
+// that could not be locked (e.g. over RLIMIT_MEMLOCK) is still faulted in;
+// getStats() reports how much of the footprint is locked.
+//
+// Only for what the callback touches: the recording reservation and the
+// callback's scratch buffers. Allocate and free from any thread but the
+// audio thread.
+//==============================================================================
+
+class RealtimeArena
+{
+public:
+    static constexpr size_t slabSize = (size_t)4 << 20;   // larger requests get a slab of their own
+
+    struct Stats
+    {
+        size_t allocatedBytes = 0;   // handed out, page-rounded
+        size_t mappedBytes = 0;      // slabs, free space included
+        size_t lockedBytes = 0;      // the part of the slabs locked into RAM
+        int    numAllocations = 0;
+        int    numSlabs = 0;
+    };
+
+    RealtimeArena() = default;
+    ~RealtimeArena();
+
+    // Returns nullptr if the memory cannot be allocated at all.
+    void* allocate(size_t numBytes);
+    void  free(void* data);
+
+    template <typename T>
+    T* allocateArray(size_t num) { return static_cast<T*>(allocate(num * sizeof(T))); }
+
+    // Points buffer at arena memory for numChannels x numSamples; memory
+    // attached to the same buffer earlier is released. False if allocation
+    // failed, in which case the buffer allocates on its own heap as usual.
+    bool attach(juce::AudioBuffer<float>& buffer, int numChannels, int numSamples);
+    void detach(juce::AudioBuffer<float>& buffer);
+
+    Stats getStats() const;
+    juce::String getDescription() const;   // "12.5 MB in 101 blocks, 16.0 MB locked of 16.0 MB in 4 slabs"
+
+private:
+    struct Slab
+    {
+        char*  base = nullptr;
+        size_t numBytes = 0;
+        size_t usedBytes = 0;
+        bool   locked = false;
+        std::map<size_t, size_t> freeRanges;   // offset -> size; neighbours are merged
+    };
+
+    struct Allocation
+    {
+        size_t numBytes = 0;
+        Slab*  slab = nullptr;
+    };
+
+    static void* takeRange(Slab& slab, size_t numBytes);
+    static void  returnRange(Slab& slab, size_t offset, size_t numBytes);
+
+    mutable juce::CriticalSection lock;
+    std::vector<std::unique_ptr<Slab>> slabs;
+    std::map<void*, Allocation> allocations;
+    std::map<const juce::AudioBuffer<float>*, void*> attached;
+    Stats stats;
+    bool reportedLockFailure = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RealtimeArena)
+};
@@ -0,0 +1,113 @@
+// RefreshScheduler.cpp
+#include "RefreshScheduler.h"
+
+//==============================================================================
+
+RefreshScheduler::RefreshScheduler(juce::Component& displayToUse,
+    FrameCallback frameCallback,
+    std::function<bool()> animatingQuery)
+    : display(displayToUse),
+      onFrame(std::move(frameCallback)),
+      isAnimating(std::move(animatingQuery))
+{
+}
+
+RefreshScheduler::~RefreshScheduler()
+{
+    cancelPendingUpdate();
+    stopTimer();
+    vblank.reset();
+}
+
+void RefreshScheduler::invalidate(juce::uint32 reasons)
+{
+    // Only the first invalidation since the last frame needs to wake us up
+    if (pending.fetch_or(reasons) == 0)
+        triggerAsyncUpdate();
+}
+
+void RefreshScheduler::setIdleFrames(bool shouldRun)
+{
+    idleFrames = shouldRun;
+    updateTimer();
+}
+
+void RefreshScheduler::updateTimer()
+{
+    // Fallback for a hidden window while animating; idle frames otherwise
+    if (vblank != nullptr || idleFrames)
+    {
+        if (!isTimerRunning())
+            startTimer(fallbackIntervalMs);
+    }
+    else
+    {
+        stopTimer();
+    }
+}
+
+bool RefreshScheduler::isNeeded() const
+{
+    return pending.load() != 0 || isAnimating();
+}
+
+void RefreshScheduler::handleAsyncUpdate()
+{
+    // Attach or detach here rather than inside the vblank callback itself
+    if (isNeeded())
+    {
+        if (vblank == nullptr)
+            vblank = std::make_unique<juce::VBlankAttachment>(&display, [this] { runFrame(); });
+    }
+    else
+    {
+        vblank.reset();
+    }
+
+    updateTimer();
+}
+
+void RefreshScheduler::timerCallback()
+{
+    const double now = juce::Time::getMillisecondCounterHiRes();
+
+    if (vblank == nullptr)
+    {
+        // Started animating without anyone calling invalidate()
+        if (isNeeded())
+        {
+            triggerAsyncUpdate();
+            return;
+        }
+
+        lastFrameMs = now;
+        ++numFrames;
+        onFrame(idle);
+        return;
+    }
+
+    // No vblank arrives while the window is hidden
+    if (now - lastFrameMs >= fallbackIntervalMs)
+        runFrame();
+}
+
+void RefreshScheduler::runFrame()
+{
+    lastFrameMs = juce::Time::getMillisecondCounterHiRes();
+
+    juce::uint32 reasons = pending.exchange(0);
+    const bool animatingNow = isAnimating();
+
+    if (animatingNow)
+        reasons |= animating;
+
+    if (reasons != 0)
+    {
+        ++numFrames;
+        onFrame(reasons);
+    }
+
+    // Idle: stop listening for vblanks until the next invalidate()
+    if (!animatingNow && pending.load() == 0)
+        triggerAsyncUpdate();
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+
+//==============================================================================
+// RefreshScheduler: runs the UI's frame callback only when there is something
+// to show.
+//
+// While isAnimating() holds (playback, recording) frames follow the display's
+// refresh through a VBlankAttachment. Otherwise nothing runs until something
+// calls invalidate(); everything invalidated before the next vblank is handed
+// to a single frame as a set of reasons. A slow timer stands in for the
+// vblank while the window is hidden or minimised, so the frame's
+// housekeeping (loop wrap) keeps going.
+//
+// With setIdleFrames(true) (an input device is open) the timer also runs
+// while idle: it notices isAnimating() turning true without an invalidate(),
+// and otherwise runs an idle frame at its own rate, so what the audio thread
+// accumulates for the UI (input meters) is still taken and shown. Without
+// it, an idle UI does no work at all.
+//==============================================================================
+
+class RefreshScheduler : private juce::AsyncUpdater,
+                         private juce::Timer
+{
+public:
+    enum Reason : juce::uint32
+    {
+        playback  = 1u << 0,   // a transport started, stopped or moved
+        recording = 1u << 1,   // recording started or stopped
+        thumbnail = 1u << 2,   // a waveform finished (more of) its loading
+        takes     = 1u << 3,   // takes were added, removed or re-analysed
+        idle      = 1u << 30,  // the slow frame while nothing else runs; only this bit is set
+        animating = 1u << 31   // set on frames that run because isAnimating() held
+    };
+
+    using FrameCallback = std::function<void(juce::uint32 reasons)>;
+
+    RefreshScheduler(juce::Component& display,
+        FrameCallback onFrame,
+        std::function<bool()> isAnimating);
+
+    ~RefreshScheduler() override;
+
+    // Any thread but the audio thread.
+    void invalidate(juce::uint32 reasons);
+
+    // Message thread. Slow idle frames while nothing animates; off by default.
+    void setIdleFrames(bool shouldRun);
+
+    juce::uint64 getNumFrames() const noexcept { return numFrames; }
+    bool isRunning() const noexcept { return vblank != nullptr; }
+
+private:
+    void handleAsyncUpdate() override;
+    void timerCallback() override;
+    void runFrame();
+    bool isNeeded() const;
+    void updateTimer();
+
+    static constexpr int fallbackIntervalMs = 100;
+
+    juce::Component& display;
+    FrameCallback onFrame;
+    std::function<bool()> isAnimating;
+
+    std::atomic<juce::uint32> pending{ 0 };
+    std::unique_ptr<juce::VBlankAttachment> vblank;
+    bool idleFrames = false;
+    double lastFrameMs = 0.0;
+    juce::uint64 numFrames = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RefreshScheduler)
+};
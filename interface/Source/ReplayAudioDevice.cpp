@@ -0,0 +1,381 @@
+// ReplayAudioDevice.cpp
+#include "ReplayAudioDevice.h"
+
+using int64 = juce::int64;
+
+namespace
+{
+    const juce::String deviceName{ "Replay" };
+
+    double percentile(juce::Array<double> values, double p)
+    {
+        if (values.isEmpty())
+            return 0.0;
+
+        values.sort();
+        const int index = juce::jlimit(0, values.size() - 1, (int)std::ceil(p * values.size()) - 1);
+        return values[index];
+    }
+}
+
+//==============================================================================
+// ReplaySettings
+//==============================================================================
+
+ReplaySettings ReplaySettings::fromCommandLine(const juce::String& commandLine)
+{
+    ReplaySettings s;
+
+    juce::StringArray args;
+    args.addTokens(commandLine, true);
+    args.trim();
+    args.removeEmptyStrings();
+
+    auto fileArg = [](const juce::String& arg)
+        {
+            return juce::File::getCurrentWorkingDirectory().getChildFile(arg.unquoted());
+        };
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+        const auto value = i + 1 < args.size() ? args[i + 1] : juce::String();
+
+        if (arg == "--replay-quit")
+        {
+            s.quitWhenDone = true;
+            continue;
+        }
+
+        if (!arg.startsWith("--replay") || value.isEmpty())
+            continue;
+
+        ++i;
+
+        if (arg == "--replay")               s.inputFile = fileArg(value);
+        else if (arg == "--replay-out")      s.outputFile = fileArg(value);
+        else if (arg == "--replay-project")  s.projectFile = fileArg(value);
+        else if (arg == "--replay-block")    s.blockSize = juce::jlimit(16, 8192, value.getIntValue());
+        else if (arg == "--replay-speed")    s.speed = juce::jmax(0.0, value.getDoubleValue());
+        else if (arg == "--replay-tail")     s.tailSeconds = juce::jmax(0.0, value.getDoubleValue());
+        else if (arg == "--replay-at")
+        {
+            Action a;
+            a.atSeconds = value.upToFirstOccurrenceOf(":", false, false).getDoubleValue();
+            a.name = value.fromFirstOccurrenceOf(":", false, false).trim();
+
+            if (a.name.isNotEmpty())
+                s.actions.add(a);
+        }
+    }
+
+    std::stable_sort(s.actions.begin(), s.actions.end(),
+        [](const Action& a, const Action& b) { return a.atSeconds < b.atSeconds; });
+
+    // The project is loaded by the first action, once the device is running at its rate
+    if (s.projectFile != juce::File())
+        s.actions.insert(0, { 0.0, "load" });
+
+    return s;
+}
+
+//==============================================================================
+// ReplayAudioIODevice
+//==============================================================================
+
+ReplayAudioIODevice::ReplayAudioIODevice(const ReplaySettings& s, ActionCallback actionCallback,
+    std::function<void()> finishedCallback)
+    : juce::AudioIODevice(deviceName, ReplayAudioIODeviceType::typeName),
+      juce::Thread("Replay device"),
+      settings(s),
+      onAction(std::move(actionCallback)),
+      onFinished(std::move(finishedCallback))
+{
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(settings.inputFile));
+
+    if (reader == nullptr || reader->lengthInSamples <= 0)
+    {
+        lastError = "Cannot read " + settings.inputFile.getFullPathName();
+        return;
+    }
+
+    sampleRate = reader->sampleRate;
+    numFileChannels = (int)reader->numChannels;
+
+    // All of it up front: the replay never waits on the disk
+    input.setSize(numFileChannels, (int)reader->lengthInSamples);
+    reader->read(&input, 0, input.getNumSamples(), 0, true, true);
+}
+
+ReplayAudioIODevice::~ReplayAudioIODevice()
+{
+    close();
+}
+
+juce::StringArray ReplayAudioIODevice::getOutputChannelNames()
+{
+    return { "Replay out 1", "Replay out 2" };
+}
+
+juce::StringArray ReplayAudioIODevice::getInputChannelNames()
+{
+    juce::StringArray names;
+
+    for (int ch = 0; ch < juce::jmax(1, numFileChannels); ++ch)
+        names.add("Replay in " + juce::String(ch + 1));
+
+    return names;
+}
+
+juce::Array<double> ReplayAudioIODevice::getAvailableSampleRates()
+{
+    return { sampleRate > 0.0 ? sampleRate : 48000.0 };
+}
+
+juce::Array<int> ReplayAudioIODevice::getAvailableBufferSizes()
+{
+    return { settings.blockSize };
+}
+
+juce::String ReplayAudioIODevice::open(const juce::BigInteger& inputChannels,
+    const juce::BigInteger& outputChannels, double, int)
+{
+    close();
+
+    if (lastError.isNotEmpty())
+        return lastError;
+
+    activeInputs = inputChannels;
+    activeInputs.setRange(getInputChannelNames().size(), 256, false);
+    activeOutputs = outputChannels;
+    activeOutputs.setRange(2, 256, false);
+
+    if (settings.outputFile != juce::File())
+    {
+        settings.outputFile.deleteFile();
+        std::unique_ptr<juce::FileOutputStream> stream(settings.outputFile.createOutputStream());
+
+        if (stream == nullptr || !stream->openedOk())
+            return lastError = "Cannot write " + settings.outputFile.getFullPathName();
+
+        juce::WavAudioFormat wav;
+        writer.reset(wav.createWriterFor(stream.get(), sampleRate,
+            (unsigned int)juce::jmax(1, activeOutputs.countNumberOfSetBits()), 32, {}, 0));
+
+        if (writer == nullptr)
+            return lastError = "Cannot write " + settings.outputFile.getFullPathName();
+
+        stream.release();
+    }
+
+    opened = true;
+    return {};
+}
+
+void ReplayAudioIODevice::close()
+{
+    stop();
+    writer.reset();
+    opened = false;
+}
+
+void ReplayAudioIODevice::start(juce::AudioIODeviceCallback* newCallback)
+{
+    if (!opened || newCallback == nullptr)
+        return;
+
+    stop();
+
+    newCallback->audioDeviceAboutToStart(this);
+
+    {
+        const juce::ScopedLock sl(callbackLock);
+        callback = newCallback;
+    }
+
+    startThread();
+}
+
+void ReplayAudioIODevice::stop()
+{
+    stopThread(2000);
+
+    juce::AudioIODeviceCallback* old = nullptr;
+    {
+        const juce::ScopedLock sl(callbackLock);
+        std::swap(old, callback);
+    }
+
+    if (old != nullptr)
+        old->audioDeviceStopped();
+}
+
+//==============================================================================
+
+void ReplayAudioIODevice::run()
+{
+    const int blockSize = settings.blockSize;
+    const int numIn = activeInputs.countNumberOfSetBits();
+    const int numOut = activeOutputs.countNumberOfSetBits();
+    const int64 endSample = input.getNumSamples() + (int64)(settings.tailSeconds * sampleRate);
+
+    juce::AudioBuffer<float> in(juce::jmax(1, numIn), blockSize);
+    juce::AudioBuffer<float> out(juce::jmax(1, numOut), blockSize);
+
+    juce::Array<double> callbackMicros;
+    callbackMicros.ensureStorageAllocated((int)(endSample / blockSize) + 1);
+
+    const double startMs = juce::Time::getMillisecondCounterHiRes();
+    int nextAction = 0;
+    int64 pos = 0;
+
+    while (pos < endSample && !threadShouldExit())
+    {
+        // Actions due by the start of this block, before it is rendered
+        while (nextAction < settings.actions.size()
+            && settings.actions.getReference(nextAction).atSeconds * sampleRate <= (double)pos)
+        {
+            if (!runAction(settings.actions.getReference(nextAction++).name))
+                return;
+        }
+
+        // Input file channels to the open inputs; silence past its end
+        in.clear();
+        const int available = (int)juce::jlimit<int64>(0, blockSize, input.getNumSamples() - pos);
+
+        if (available > 0)
+            for (int ch = 0; ch < numIn; ++ch)
+                in.copyFrom(ch, 0, input, juce::jmin(ch, numFileChannels - 1), (int)pos, available);
+
+        out.clear();
+
+        {
+            const juce::ScopedLock sl(callbackLock);
+
+            if (callback != nullptr)
+            {
+                const auto t0 = juce::Time::getHighResolutionTicks();
+
+                callback->audioDeviceIOCallbackWithContext(in.getArrayOfReadPointers(), numIn,
+                    out.getArrayOfWritePointers(), numOut, blockSize, {});
+
+                callbackMicros.add(1.0e6 * juce::Time::highResolutionTicksToSeconds(
+                    juce::Time::getHighResolutionTicks() - t0));
+            }
+        }
+
+        if (writer != nullptr)
+            writer->writeFromAudioSampleBuffer(out, 0, blockSize);
+
+        pos += blockSize;
+
+        // Paced to the wall clock unless running flat out
+        if (settings.speed > 0.0)
+        {
+            const double dueMs = startMs + 1000.0 * (double)pos / (sampleRate * settings.speed);
+            const double waitMs = dueMs - juce::Time::getMillisecondCounterHiRes();
+
+            if (waitMs > 1.0)
+                wait((int)waitMs);
+        }
+    }
+
+    finish(callbackMicros, pos, (juce::Time::getMillisecondCounterHiRes() - startMs) / 1000.0);
+}
+
+bool ReplayAudioIODevice::runAction(const juce::String& name)
+{
+    if (onAction == nullptr)
+        return true;
+
+    // Shared, in case we are stopped before the message thread gets to it
+    auto done = std::make_shared<juce::WaitableEvent>();
+    auto action = onAction;
+
+    juce::MessageManager::callAsync([action, name, done]
+        {
+            action(name);
+            done->signal();
+        });
+
+    while (!done->wait(50))
+        if (threadShouldExit())
+            return false;
+
+    return true;
+}
+
+void ReplayAudioIODevice::finish(const juce::Array<double>& callbackMicros, int64 samplesRendered,
+    double wallSeconds)
+{
+    if (writer != nullptr)
+        writer->flush();
+
+    double total = 0.0, worst = 0.0;
+    for (auto us : callbackMicros)
+    {
+        total += us;
+        worst = juce::jmax(worst, us);
+    }
+
+    const double audioSeconds = (double)samplesRendered / sampleRate;
+    const double blockMicros = 1.0e6 * settings.blockSize / sampleRate;
+    const double mean = callbackMicros.isEmpty() ? 0.0 : total / callbackMicros.size();
+
+    auto* stats = new juce::DynamicObject();
+    stats->setProperty("input", settings.inputFile.getFullPathName());
+    stats->setProperty("sample_rate", sampleRate);
+    stats->setProperty("block_size", settings.blockSize);
+    stats->setProperty("blocks", callbackMicros.size());
+    stats->setProperty("audio_s", audioSeconds);
+    stats->setProperty("wall_s", wallSeconds);
+    stats->setProperty("callback_mean_us", mean);
+    stats->setProperty("callback_p99_us", percentile(callbackMicros, 0.99));
+    stats->setProperty("callback_max_us", worst);
+    stats->setProperty("callback_mean_load", blockMicros > 0.0 ? mean / blockMicros : 0.0);
+
+    const auto json = juce::JSON::toString(juce::var(stats), true);
+    juce::Logger::writeToLog("Replay finished: " + json);
+
+    if (settings.outputFile != juce::File())
+        settings.outputFile.withFileExtension("stats.json").replaceWithText(json);
+
+    if (onFinished != nullptr)
+        juce::MessageManager::callAsync(onFinished);
+}
+
+//==============================================================================
+// ReplayAudioIODeviceType
+//==============================================================================
+
+ReplayAudioIODeviceType::ReplayAudioIODeviceType(const ReplaySettings& s,
+    ReplayAudioIODevice::ActionCallback actionCallback, std::function<void()> finishedCallback)
+    : juce::AudioIODeviceType(typeName),
+      settings(s),
+      onAction(std::move(actionCallback)),
+      onFinished(std::move(finishedCallback))
+{
+}
+
+juce::StringArray ReplayAudioIODeviceType::getDeviceNames(bool) const
+{
+    return { deviceName };
+}
+
+int ReplayAudioIODeviceType::getIndexOfDevice(juce::AudioIODevice* device, bool) const
+{
+    return dynamic_cast<ReplayAudioIODevice*>(device) != nullptr ? 0 : -1;
+}
+
+juce::AudioIODevice* ReplayAudioIODeviceType::createDevice(const juce::String& outputDeviceName,
+    const juce::String& inputDeviceName)
+{
+    if ((outputDeviceName.isNotEmpty() && outputDeviceName != deviceName)
+        || (inputDeviceName.isNotEmpty() && inputDeviceName != deviceName))
+        return nullptr;
+
+    return new ReplayAudioIODevice(settings, onAction, onFinished);
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+
+//==============================================================================
+// ReplaySettings: what a replay run does, from the command line.
+//
+//   --replay input.wav            feed this to the inputs instead of a sound card
+//   --replay-out output.wav       capture the outputs (32-bit float WAV)
+//   --replay-block 256            block size (default 512)
+//   --replay-speed 0              x real time; 0 = as fast as the callback allows
+//   --replay-project p.json       load this project first (a "load" action at 0 s)
+//   --replay-at 2.5:record        run an action when the input reaches 2.5 s
+//   --replay-tail 2               seconds of silence after the input (default 1)
+//   --replay-quit                 quit when the replay is done
+//
+// Actions run on the message thread while the device waits, so they always
+// land on the same block and a replay renders the same output every time.
+//==============================================================================
+
+struct ReplaySettings
+{
+    struct Action
+    {
+        double       atSeconds = 0.0;
+        juce::String name;            // play, stop, record, load
+    };
+
+    juce::File inputFile;
+    juce::File outputFile;
+    juce::File projectFile;
+    int        blockSize = 512;
+    double     speed = 1.0;
+    double     tailSeconds = 1.0;
+    bool       quitWhenDone = false;
+    juce::Array<Action> actions;      // in time order
+
+    bool isEnabled() const { return inputFile != juce::File(); }
+
+    static ReplaySettings fromCommandLine(const juce::String& commandLine);
+};
+
+//==============================================================================
+// ReplayAudioIODevice: a virtual device that runs the callback on its own
+// thread, feeding the inputs from a WAV file and writing the outputs to one.
+// Callback times are collected and written next to the output as
+// <output>.stats.json (and to the log) when the replay ends.
+//==============================================================================
+
+class ReplayAudioIODevice : public juce::AudioIODevice,
+    private juce::Thread
+{
+public:
+    using ActionCallback = std::function<void(const juce::String& action)>;
+
+    ReplayAudioIODevice(const ReplaySettings& settings, ActionCallback onAction,
+        std::function<void()> onFinished);
+    ~ReplayAudioIODevice() override;
+
+    juce::StringArray getOutputChannelNames() override;
+    juce::StringArray getInputChannelNames() override;
+    juce::Array<double> getAvailableSampleRates() override;
+    juce::Array<int> getAvailableBufferSizes() override;
+    int getDefaultBufferSize() override { return settings.blockSize; }
+
+    juce::String open(const juce::BigInteger& inputChannels, const juce::BigInteger& outputChannels,
+        double sampleRate, int bufferSizeSamples) override;
+    void close() override;
+    bool isOpen() override { return opened; }
+
+    void start(juce::AudioIODeviceCallback* callback) override;
+    void stop() override;
+    bool isPlaying() override { return isThreadRunning(); }
+
+    juce::String getLastError() override { return lastError; }
+    int getCurrentBufferSizeSamples() override { return settings.blockSize; }
+    double getCurrentSampleRate() override { return sampleRate; }
+    int getCurrentBitDepth() override { return 32; }
+
+    juce::BigInteger getActiveOutputChannels() const override { return activeOutputs; }
+    juce::BigInteger getActiveInputChannels() const override { return activeInputs; }
+    int getOutputLatencyInSamples() override { return 0; }
+    int getInputLatencyInSamples() override { return 0; }
+    int getXRunCount() const noexcept override { return 0; }
+
+private:
+    void run() override;
+    bool runAction(const juce::String& name);
+    void finish(const juce::Array<double>& callbackMicros, juce::int64 samplesRendered, double wallSeconds);
+
+    const ReplaySettings settings;
+    const ActionCallback onAction;
+    const std::function<void()> onFinished;
+
+    juce::AudioBuffer<float> input;                  // the whole file
+    double sampleRate = 0.0;
+    int    numFileChannels = 0;
+    bool   opened = false;
+    juce::String lastError;
+
+    juce::BigInteger activeInputs, activeOutputs;
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+
+    juce::CriticalSection callbackLock;
+    juce::AudioIODeviceCallback* callback = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ReplayAudioIODevice)
+};
+
+//==============================================================================
+// ReplayAudioIODeviceType: the one device type registered for a replay run,
+// so no sound card is ever opened.
+//==============================================================================
+
+class ReplayAudioIODeviceType : public juce::AudioIODeviceType
+{
+public:
+    static constexpr const char* typeName = "Replay";
+
+    ReplayAudioIODeviceType(const ReplaySettings& settings,
+        ReplayAudioIODevice::ActionCallback onAction, std::function<void()> onFinished);
+
+    void scanForDevices() override {}
+    juce::StringArray getDeviceNames(bool wantInputNames = false) const override;
+    int getDefaultDeviceIndex(bool forInput) const override { juce::ignoreUnused(forInput); return 0; }
+    int getIndexOfDevice(juce::AudioIODevice* device, bool asInput) const override;
+    bool hasSeparateInputsAndOutputs() const override { return false; }
+
+    juce::AudioIODevice* createDevice(const juce::String& outputDeviceName,
+        const juce::String& inputDeviceName) override;
+
+private:
+    const ReplaySettings settings;
+    const ReplayAudioIODevice::ActionCallback onAction;
+    const std::function<void()> onFinished;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ReplayAudioIODeviceType)
+};
@@ -0,0 +1,342 @@
+// SessionGenerator.cpp
+#include "SessionGenerator.h"
+#include "ProjectState.h"
+
+using int64 = juce::int64;
+
+namespace
+{
+    // A minor pentatonic, two octaves up from A2
+    const float scaleHz[] = { 110.0f, 130.81f, 146.83f, 164.81f, 196.0f,
+                              220.0f, 261.63f, 293.66f, 329.63f, 392.0f };
+
+    juce::String phraseName(int index)
+    {
+        return "phrase" + juce::String(index).paddedLeft('0', 2);
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> createWavWriter(const juce::File& file,
+        double sampleRate, int numChannels)
+    {
+        file.deleteFile();
+        std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+
+        if (stream == nullptr || !stream->openedOk())
+            return nullptr;
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(
+            wav.createWriterFor(stream.get(), sampleRate, (unsigned int)numChannels, 16, {}, 0));
+
+        if (writer != nullptr)
+            stream.release();
+
+        return writer;
+    }
+
+    int loopLengthSamples(const SessionGenerator::Settings& s)
+    {
+        return ProjectState::gridLoopLengthSamples(s.loopSeconds, s.bpm, s.sampleRate);
+    }
+}
+
+//==============================================================================
+// Settings
+//==============================================================================
+
+SessionGenerator::Settings SessionGenerator::Settings::fromCommandLine(const juce::String& commandLine)
+{
+    Settings s;
+
+    juce::StringArray args;
+    args.addTokens(commandLine, true);
+    args.trim();
+    args.removeEmptyStrings();
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+        const auto value = i + 1 < args.size() ? args[i + 1].unquoted() : juce::String();
+
+        if (arg == "--scale-quit")
+        {
+            s.quitWhenDone = true;
+            continue;
+        }
+
+        if (!arg.startsWith("--scale") || value.isEmpty())
+            continue;
+
+        ++i;
+
+        if (arg == "--scale-test")              s.rootDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+        else if (arg == "--scale-phrases")      s.numPhrases = juce::jlimit(1, 999, value.getIntValue());
+        else if (arg == "--scale-instrumental") s.instrumentalSeconds = juce::jmax(1.0, value.getDoubleValue());
+        else if (arg == "--scale-loop")         s.loopSeconds = juce::jmax(0.5, value.getDoubleValue());
+        else if (arg == "--scale-segments")     s.segmentsPerComp = juce::jlimit(1, 1000, value.getIntValue());
+        else if (arg == "--scale-takes")
+        {
+            juce::StringArray counts;
+            counts.addTokens(value, ",", {});
+
+            s.takeCounts.clear();
+            for (const auto& c : counts)
+                if (c.getIntValue() > 0)
+                    s.takeCounts.add(c.getIntValue());
+
+            if (s.takeCounts.isEmpty())
+                s.takeCounts.add(10);
+        }
+    }
+
+    return s;
+}
+
+//==============================================================================
+
+juce::Result SessionGenerator::generate(const Settings& settings,
+    juce::Array<Phrase>& phrases,
+    std::function<bool()> shouldStop)
+{
+    phrases.clear();
+
+    auto stopped = [&shouldStop] { return shouldStop != nullptr && shouldStop(); };
+
+    // The loop has to fit the instrumental
+    if (settings.loopStartSeconds + settings.loopSeconds > settings.instrumentalSeconds)
+        return juce::Result::fail("The instrumental is shorter than the loop");
+
+    const auto singerDir = settings.rootDirectory.getChildFile("singer_user");
+
+    if (!singerDir.createDirectory())
+        return juce::Result::fail("Cannot create " + singerDir.getFullPathName());
+
+    const auto instrumentalFile = settings.rootDirectory.getChildFile("instrumental.wav");
+
+    if (auto r = writeInstrumental(settings, instrumentalFile); r.failed())
+        return r;
+
+    for (int p = 0; p < settings.getNumPhrases(); ++p)
+    {
+        Phrase phrase;
+        phrase.index = p + 1;
+        phrase.numTakes = settings.takeCounts[p % settings.takeCounts.size()];
+        phrase.directory = singerDir.getChildFile(phraseName(phrase.index));
+        phrase.projectFile = phrase.directory.getChildFile("project_" + phraseName(phrase.index) + ".json");
+        phrase.compmapFile = phrase.directory.getChildFile("compmap-50.json");
+        phrase.compedFile = phrase.directory.getChildFile("comped-50-50.wav");
+
+        // Leftovers from a run with more takes would be picked up as takes
+        phrase.directory.deleteRecursively();
+
+        if (!phrase.directory.createDirectory())
+            return juce::Result::fail("Cannot create " + phrase.directory.getFullPathName());
+
+        for (int t = 1; t <= phrase.numTakes; ++t)
+        {
+            if (stopped())
+                return juce::Result::fail("Stopped");
+
+            if (auto r = writeTake(settings, phrase.directory.getChildFile("take_" + juce::String(t) + ".wav"),
+                    phrase.index, t); r.failed())
+                return r;
+        }
+
+        if (auto r = writeCompmap(settings, phrase); r.failed())
+            return r;
+
+        if (auto r = writeProject(settings, phrase, instrumentalFile); r.failed())
+            return r;
+
+        phrases.add(phrase);
+    }
+
+    return juce::Result::ok();
+}
+
+//==============================================================================
+
+juce::Result SessionGenerator::writeInstrumental(const Settings& settings, const juce::File& file)
+{
+    auto writer = createWavWriter(file, settings.sampleRate, 2);
+
+    if (writer == nullptr)
+        return juce::Result::fail("Cannot write " + file.getFullPathName());
+
+    const double rate = settings.sampleRate;
+    const double samplesPerBeat = rate * 60.0 / (double)settings.bpm;
+    const int64 total = (int64)(settings.instrumentalSeconds * rate);
+
+    // In chunks: a 20-minute instrumental is never in memory at once
+    const int chunk = 65536;
+    juce::AudioBuffer<float> buffer(2, chunk);
+
+    for (int64 pos = 0; pos < total; pos += chunk)
+    {
+        const int num = (int)juce::jmin<int64>(chunk, total - pos);
+
+        for (int i = 0; i < num; ++i)
+        {
+            const int64 n = pos + i;
+            const int64 beat = (int64)((double)n / samplesPerBeat);
+            const double sinceBeat = ((double)n - (double)beat * samplesPerBeat) / rate;
+
+            // Click, higher on the bar; bass on the bar's root
+            const double clickHz = (beat % 4 == 0) ? 1000.0 : 800.0;
+            const double click = 0.3 * std::exp(-sinceBeat * 60.0)
+                * std::sin(juce::MathConstants<double>::twoPi * clickHz * sinceBeat);
+
+            const double bassHz = 0.5 * scaleHz[(beat / 4) % 5];
+            const double bass = 0.2 * std::exp(-sinceBeat * 3.0)
+                * std::sin(juce::MathConstants<double>::twoPi * bassHz * (double)n / rate);
+
+            buffer.setSample(0, i, (float)(click + bass));
+            buffer.setSample(1, i, (float)(0.8 * click + bass));
+        }
+
+        if (!writer->writeFromAudioSampleBuffer(buffer, 0, num))
+            return juce::Result::fail("Cannot write " + file.getFullPathName());
+    }
+
+    return juce::Result::ok();
+}
+
+juce::Result SessionGenerator::writeTake(const Settings& settings, const juce::File& file,
+    int phraseIndex, int takeIndex)
+{
+    auto writer = createWavWriter(file, settings.sampleRate, 1);
+
+    if (writer == nullptr)
+        return juce::Result::fail("Cannot write " + file.getFullPathName());
+
+    // The phrase's melody is the same in every take; each take sings it
+    // a little sharp or flat, early or late, loud or soft
+    juce::Random melody(settings.seed * 7919 + phraseIndex);
+    juce::Random take(settings.seed * 104729 + phraseIndex * 1000 + takeIndex);
+
+    const double rate = settings.sampleRate;
+    const int numSamples = loopLengthSamples(settings);
+    const double secondsPerNote = 60.0 / (double)settings.bpm;
+    const int numNotes = juce::jmax(1, (int)(settings.loopSeconds / secondsPerNote));
+
+    const double detune = std::pow(2.0, (take.nextDouble() - 0.5) * 60.0 / 1200.0);  // +-30 cents
+    const double lateBy = (take.nextDouble() - 0.5) * 0.04;                          // +-20 ms
+    const double level = juce::Decibels::decibelsToGain((take.nextDouble() - 0.5) * 6.0);
+
+    juce::Array<double> noteHz;
+    for (int n = 0; n < numNotes; ++n)
+        noteHz.add(scaleHz[melody.nextInt(juce::numElementsInArray(scaleHz) - 3) + 3]);
+
+    juce::AudioBuffer<float> buffer(1, numSamples);
+    auto* out = buffer.getWritePointer(0);
+    double phase = 0.0;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const double t = (double)i / rate - lateBy;
+        const int note = juce::jlimit(0, numNotes - 1, (int)std::floor(t / secondsPerNote));
+        const double inNote = t - note * secondsPerNote;
+
+        // Sung for 80% of the beat, with a short attack and release
+        const double gate = (t < 0.0 || inNote > 0.8 * secondsPerNote) ? 0.0
+            : juce::jmin(1.0, inNote / 0.03, (0.8 * secondsPerNote - inNote) / 0.05);
+
+        const double vibrato = 1.0 + 0.006 * std::sin(juce::MathConstants<double>::twoPi * 5.5 * t);
+        phase += juce::MathConstants<double>::twoPi * noteHz[note] * detune * vibrato / rate;
+
+        const double voice = std::sin(phase) + 0.5 * std::sin(2.0 * phase) + 0.25 * std::sin(3.0 * phase);
+        const double breath = 0.01 * (take.nextDouble() * 2.0 - 1.0);
+
+        out[i] = (float)(level * (0.25 * gate * voice + breath));
+    }
+
+    if (!writer->writeFromAudioSampleBuffer(buffer, 0, numSamples))
+        return juce::Result::fail("Cannot write " + file.getFullPathName());
+
+    return juce::Result::ok();
+}
+
+juce::Result SessionGenerator::writeCompmap(const Settings& settings, const Phrase& phrase)
+{
+    juce::Random random(settings.seed * 31 + phrase.index);
+
+    const double loopSeconds = (double)loopLengthSamples(settings) / settings.sampleRate;
+    const double segmentSeconds = loopSeconds / (double)settings.segmentsPerComp;
+
+    auto takeName = [](int t) { return "take_" + juce::String(t); };
+
+    juce::Array<juce::var> segments;
+
+    for (int s = 0; s < settings.segmentsPerComp; ++s)
+    {
+        auto* winner = new juce::DynamicObject();
+        const int winnerTake = random.nextInt(phrase.numTakes) + 1;
+        winner->setProperty("take", takeName(winnerTake));
+        winner->setProperty("offset_s", 0.0);
+        winner->setProperty("score", 1.0);
+
+        juce::Array<juce::var> candidates;
+
+        for (int c = 0; c < juce::jmin(3, phrase.numTakes); ++c)
+        {
+            auto* candidate = new juce::DynamicObject();
+            candidate->setProperty("take", takeName(c == 0 ? winnerTake : random.nextInt(phrase.numTakes) + 1));
+            candidate->setProperty("offset_s", 0.0);
+            candidate->setProperty("score", c == 0 ? 1.0 : random.nextDouble());
+            candidates.add(juce::var(candidate));
+        }
+
+        auto* segment = new juce::DynamicObject();
+        segment->setProperty("start_s", s * segmentSeconds);
+        segment->setProperty("end_s", (s + 1) * segmentSeconds);
+        segment->setProperty("winner", juce::var(winner));
+        segment->setProperty("candidates", candidates);
+        segments.add(juce::var(segment));
+    }
+
+    auto* offsets = new juce::DynamicObject();
+    for (int t = 1; t <= phrase.numTakes; ++t)
+        offsets->setProperty(takeName(t), 0.0);
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("segments", segments);
+    root->setProperty("take_offsets_s", juce::var(offsets));
+    root->setProperty("synthetic", true);
+
+    if (!phrase.compmapFile.replaceWithText(juce::JSON::toString(juce::var(root), true)))
+        return juce::Result::fail("Cannot write " + phrase.compmapFile.getFullPathName());
+
+    return juce::Result::ok();
+}
+
+juce::Result SessionGenerator::writeProject(const Settings& settings, const Phrase& phrase,
+    const juce::File& instrumentalFile)
+{
+    const double loopSeconds = (double)loopLengthSamples(settings) / settings.sampleRate;
+
+    ProjectState state;
+    state.instrumentalPath = instrumentalFile.getFullPathName();
+    state.loopStartSec = settings.loopStartSeconds;
+    state.loopEndSec = settings.loopStartSeconds + loopSeconds;
+    state.loopLocked = true;
+    state.cachedLoopLengthSec = loopSeconds;
+    state.projectSampleRate = settings.sampleRate;
+    state.bpm = settings.bpm;
+    state.bpmSet = true;
+    state.currentPhraseIndex = phrase.index;
+    state.currentPhraseDirectory = phrase.directory.getFullPathName();
+    state.nextTakeIndex = phrase.numTakes + 1;
+    state.hasLastCompResult = true;
+    state.lastCompedFilePath = phrase.compedFile.getFullPathName();
+    state.lastCompmapFilePath = phrase.compmapFile.getFullPathName();
+    state.lastCompAlphaPct = 50;
+    state.lastCompCrossfadePct = 50;
+    state.lastCompFadeFraction = 0.15;
+
+    juce::String error;
+
+    if (!ProjectState::saveToFile(state, phrase.projectFile, error))
+        return juce::Result::fail(error);
+
+    return juce::Result::ok();
+}
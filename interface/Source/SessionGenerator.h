@@ -0,0 +1,75 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+
+//==============================================================================
+// SessionGenerator: synthetic sessions for scaling tests, so a 500-take
+// phrase or a 20-minute instrumental doesn't have to be recorded.
+//
+// Writes, under rootDirectory:
+//   instrumental.wav                  click + bass on the grid, instrumentalSeconds long
+//   singer_user/phraseNN/take_N.wav   loop-length takes of a synthetic sung line,
+//                                     each a little off in pitch, timing and level
+//   singer_user/phraseNN/compmap-50.json
+//   singer_user/phraseNN/project_phraseNN.json
+//
+// Phrase N gets takeCounts[N % size] takes, so one run covers the range.
+// The comped file the project names is not written: making it is the comping
+// step the scaling test times. Everything is seeded, so a run is repeatable.
+//
+//   --scale-test dir              generate under dir and time the app on it
+//   --scale-takes 10,50,500       takes per phrase, in turn
+//   --scale-phrases 6             number of phrases (default: one per take count)
+//   --scale-instrumental 1200     instrumental length in seconds
+//   --scale-loop 8                loop (take) length in seconds
+//   --scale-segments 16           compmap segments per phrase
+//   --scale-quit                  quit when the report is written
+//==============================================================================
+
+class SessionGenerator
+{
+public:
+    struct Settings
+    {
+        juce::File rootDirectory;
+        juce::Array<int> takeCounts{ 10, 50, 100, 250, 500 };
+        int    numPhrases = 0;              // 0 = one per take count
+        double instrumentalSeconds = 180.0;
+        double loopSeconds = 8.0;
+        double loopStartSeconds = 4.0;
+        int    bpm = 120;
+        double sampleRate = 48000.0;
+        int    segmentsPerComp = 16;
+        juce::int64 seed = 1;
+        bool   quitWhenDone = false;
+
+        bool isEnabled() const { return rootDirectory != juce::File(); }
+        int getNumPhrases() const { return numPhrases > 0 ? numPhrases : takeCounts.size(); }
+
+        static Settings fromCommandLine(const juce::String& commandLine);
+    };
+
+    struct Phrase
+    {
+        int        index = 0;               // 1-based, as phraseNN
+        int        numTakes = 0;
+        juce::File directory;
+        juce::File projectFile;
+        juce::File compmapFile;
+        juce::File compedFile;              // named by the project, not written
+    };
+
+    // Message or background thread; shouldStop is polled between files
+    static juce::Result generate(const Settings& settings,
+        juce::Array<Phrase>& phrases,
+        std::function<bool()> shouldStop = nullptr);
+
+private:
+    static juce::Result writeInstrumental(const Settings& settings, const juce::File& file);
+    static juce::Result writeTake(const Settings& settings, const juce::File& file,
+        int phraseIndex, int takeIndex);
+    static juce::Result writeCompmap(const Settings& settings, const Phrase& phrase);
+    static juce::Result writeProject(const Settings& settings, const Phrase& phrase,
+        const juce::File& instrumentalFile);
+};
@@ -0,0 +1,173 @@
+// SincResampler.cpp
+#include "SincResampler.h"
+#include "AudioReaderPool.h"
+
+using int64 = juce::int64;
+
+namespace
+{
+    // Windowed sinc (Blackman) over +-zeroCrossings, tabulated on [0, zeroCrossings]
+    constexpr int zeroCrossings = 16;
+    constexpr int tableResolution = 512;     // entries per zero crossing
+    constexpr int chunkSamples = 16384;      // output samples rendered between stop checks
+
+    const std::vector<float>& sincTable()
+    {
+        static const std::vector<float> table = []
+            {
+                std::vector<float> t((size_t)(zeroCrossings * tableResolution + 2), 0.0f);
+
+                for (int i = 0; i <= zeroCrossings * tableResolution; ++i)
+                {
+                    const double u = (double)i / tableResolution;
+                    const double x = juce::MathConstants<double>::pi * u;
+                    const double sinc = i == 0 ? 1.0 : std::sin(x) / x;
+                    const double w = 0.42 + 0.5 * std::cos(x / zeroCrossings)
+                                   + 0.08 * std::cos(2.0 * x / zeroCrossings);
+                    t[(size_t)i] = (float)(sinc * w);
+                }
+
+                return t;
+            }();
+
+        return table;
+    }
+}
+
+//==============================================================================
+
+bool SincResampler::render(juce::AudioFormatReader& reader, double targetRate,
+    int64 from, int64 to,
+    juce::AudioBuffer<float>& dest, int destStart,
+    const std::function<bool()>& shouldStop)
+{
+    const int numChannels = juce::jlimit(1, 2, dest.getNumChannels());
+    const double ratio = reader.sampleRate / targetRate;          // source samples per output sample
+    const double cutoff = juce::jmin(1.0, 1.0 / ratio);           // of the source Nyquist
+    const double halfWidth = zeroCrossings / cutoff;              // in source samples
+    const auto& table = sincTable();
+
+    juce::AudioBuffer<float> source;
+
+    for (int64 chunkFrom = from; chunkFrom < to; chunkFrom += chunkSamples)
+    {
+        if (shouldStop != nullptr && shouldStop())
+            return false;
+
+        const int64 chunkTo = juce::jmin(to, chunkFrom + (int64)chunkSamples);
+        const int n = (int)(chunkTo - chunkFrom);
+        float* const out[2] = { dest.getWritePointer(0, destStart + (int)(chunkFrom - from)),
+                                dest.getWritePointer(numChannels - 1, destStart + (int)(chunkFrom - from)) };
+
+        if (ratio == 1.0)
+        {
+            // Same rate: a straight read
+            juce::AudioBuffer<float> view(out, numChannels, n);
+            reader.read(&view, 0, n, chunkFrom, true, true);
+            continue;
+        }
+
+        // Reading before 0 or past the end gives silence
+        const int64 sourceStart = (int64)std::floor((double)chunkFrom * ratio - halfWidth) - 1;
+        const int64 sourceEnd = (int64)std::ceil((double)(chunkTo - 1) * ratio + halfWidth) + 2;
+        const int sourceLength = (int)(sourceEnd - sourceStart);
+
+        source.setSize(numChannels, sourceLength, false, false, true);
+        reader.read(&source, 0, sourceLength, sourceStart, true, true);
+
+        const float* const in[2] = { source.getReadPointer(0), source.getReadPointer(numChannels - 1) };
+
+        for (int i = 0; i < n; ++i)
+        {
+            const double t = (double)(chunkFrom + i) * ratio - (double)sourceStart;
+            const int k0 = (int)std::ceil(t - halfWidth);
+            const int k1 = (int)std::floor(t + halfWidth);
+
+            float sum[2] = { 0.0f, 0.0f };
+
+            for (int k = k0; k <= k1; ++k)
+            {
+                const double d = std::abs(t - (double)k) * cutoff * tableResolution;
+                const int index = (int)d;
+                const float frac = (float)(d - index);
+                const float w = table[(size_t)index] + frac * (table[(size_t)index + 1] - table[(size_t)index]);
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                    sum[ch] += in[ch][k] * w;
+            }
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                out[ch][i] = sum[ch] * (float)cutoff;
+        }
+    }
+
+    return true;
+}
+
+bool SincResampler::convertFile(AudioReaderPool& readers,
+    const juce::File& source, const juce::File& dest,
+    double targetRate, int64 numSamples,
+    const std::function<bool()>& shouldStop)
+{
+    auto reader = readers.createReaderFor(source);
+
+    if (reader == nullptr || targetRate <= 0.0 || numSamples <= 0)
+        return false;
+
+    if (reader->sampleRate == targetRate && reader->lengthInSamples == numSamples
+        && reader->numChannels == 1 && source.hasFileExtension("wav"))
+        return source == dest || source.copyFileTo(dest);
+
+    // Written next to dest (under a name no take_*.wav scan picks up) and
+    // moved over it, so dest may be the source
+    const auto temp = dest.getSiblingFile("~" + dest.getFileName() + ".part");
+
+    {
+        temp.deleteFile();
+
+        std::unique_ptr<juce::FileOutputStream> outStream(temp.createOutputStream());
+        if (outStream == nullptr || !outStream->openedOk())
+            return false;
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(
+            wav.createWriterFor(outStream.get(), targetRate, 1, 16, {}, 0));
+
+        if (writer == nullptr)
+            return false;
+
+        outStream.release();
+
+        // Rendered at the source's width (render() takes up to two channels)
+        // and mixed down to mono, like every other import and analysis path
+        const int numChannels = juce::jlimit(1, 2, (int)reader->numChannels);
+        juce::AudioBuffer<float> block(numChannels, chunkSamples);
+
+        for (int64 pos = 0; pos < numSamples; pos += chunkSamples)
+        {
+            const int n = (int)juce::jmin<int64>(chunkSamples, numSamples - pos);
+            block.clear();
+
+            if (!render(*reader, targetRate, pos, pos + n, block, 0, shouldStop))
+            {
+                writer.reset();
+                temp.deleteFile();
+                return false;
+            }
+
+            if (numChannels > 1)
+            {
+                for (int ch = 1; ch < numChannels; ++ch)
+                    block.addFrom(0, 0, block, ch, 0, n);
+
+                block.applyGain(0, 0, n, 1.0f / (float)numChannels);
+            }
+
+            // Only the mix: the writer is mono
+            writer->writeFromFloatArrays(block.getArrayOfReadPointers(), 1, n);
+        }
+    }
+
+    reader.reset();
+    return temp.moveFileTo(dest);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+
+class AudioReaderPool;
+
+//==============================================================================
+// SincResampler: offline, high-quality sample rate conversion straight from
+// an AudioFormatReader (windowed sinc, 16 zero crossings, low-passed when
+// going down). Far too slow for the audio thread; used where a file or a
+// region is converted once, on a background thread.
+//
+// Output sample n is the source evaluated at n * sourceRate / targetRate, so
+// any range of the output can be rendered on its own and lines up exactly
+// with the rest.
+//==============================================================================
+
+class SincResampler
+{
+public:
+    // Output samples [from, to) at targetRate into dest (1 or 2 channels)
+    // from destStart. Returns false if shouldStop() turned true on the way.
+    static bool render(juce::AudioFormatReader& reader, double targetRate,
+        juce::int64 from, juce::int64 to,
+        juce::AudioBuffer<float>& dest, int destStart,
+        const std::function<bool()>& shouldStop);
+
+    // Writes source as a mono 16-bit WAV at targetRate, numSamples long
+    // (padded with silence or trimmed). Same-rate files are just copied over.
+    static bool convertFile(AudioReaderPool& readers,
+        const juce::File& source, const juce::File& dest,
+        double targetRate, juce::int64 numSamples,
+        const std::function<bool()>& shouldStop);
+};
@@ -0,0 +1,325 @@
+// SpectrogramCache.cpp
+#include "SpectrogramCache.h"
+
+using int64 = juce::int64;
+
+namespace
+{
+    constexpr float floorDb = -100.0f;
+
+    // 8-bit dB value -> colour (dark purple .. orange .. pale yellow)
+    const juce::Colour* getColourMap()
+    {
+        static const auto map = []
+            {
+                juce::ColourGradient gradient(juce::Colour(0xff05030a), 0.0f, 0.0f,
+                    juce::Colour(0xfffff2b0), 1.0f, 0.0f,
+                    false);
+                gradient.addColour(0.35, juce::Colour(0xff3a0a5c));
+                gradient.addColour(0.65, juce::Colour(0xffd0406a));
+                gradient.addColour(0.85, juce::Colour(0xfff59a30));
+
+                std::vector<juce::Colour> colours(256);
+                for (int i = 0; i < 256; ++i)
+                    colours[(size_t)i] = gradient.getColourAtPosition((double)i / 255.0);
+
+                return colours;
+            }();
+
+        return map.data();
+    }
+}
+
+//==============================================================================
+
+SpectrogramCache::SpectrogramCache(double rate)
+    : sampleRate(rate > 0.0 ? rate : 44100.0)
+{
+    fftBuffer.resize((size_t)fftSize * 2, 0.0f);
+
+    // Centre the first window on sample 0
+    carry.assign((size_t)fftSize / 2, 0.0f);
+
+    // Log-spaced rows; every row covers at least one FFT bin
+    const double binHz = sampleRate / (double)fftSize;
+    const double lowHz = 40.0;
+    const double highHz = sampleRate * 0.5;
+
+    rowFirstBin.resize(numRows);
+    rowEndBin.resize(numRows);
+
+    for (int r = 0; r < numRows; ++r)
+    {
+        const double f0 = lowHz * std::pow(highHz / lowHz, (double)r / numRows);
+        const double f1 = lowHz * std::pow(highHz / lowHz, (double)(r + 1) / numRows);
+
+        const int b0 = juce::jlimit(1, fftSize / 2, (int)std::floor(f0 / binHz));
+        const int b1 = juce::jlimit(b0 + 1, fftSize / 2 + 1, (int)std::ceil(f1 / binHz));
+
+        rowFirstBin[(size_t)r] = b0;
+        rowEndBin[(size_t)r] = b1;
+    }
+}
+
+void SpectrogramCache::appendAsync(juce::ThreadPool& pool,
+    std::vector<float> samples,
+    std::function<void()> onUpdated)
+{
+    if (samples.empty())
+        return;
+
+    {
+        const juce::ScopedLock sl(queueLock);
+        samplesQueued += (int64)samples.size();
+        queue.push_back(std::move(samples));
+
+        // A running job picks this batch up before it finishes
+        if (workerActive)
+            return;
+
+        workerActive = true;
+    }
+
+    auto self = shared_from_this();
+
+    pool.addJob([self, onUpdated]
+        {
+            for (;;)
+            {
+                std::vector<float> next;
+
+                {
+                    const juce::ScopedLock sl(self->queueLock);
+                    if (self->queue.empty())
+                    {
+                        self->workerActive = false;
+                        break;
+                    }
+
+                    next = std::move(self->queue.front());
+                    self->queue.pop_front();
+                }
+
+                self->appendSamples(next.data(), (int)next.size());
+            }
+
+            if (onUpdated != nullptr)
+                juce::MessageManager::callAsync(onUpdated);
+        });
+}
+
+void SpectrogramCache::appendSamples(const float* samples, int numSamples)
+{
+    if (samples == nullptr || numSamples <= 0)
+        return;
+
+    carry.insert(carry.end(), samples, samples + numSamples);
+
+    const float magnitudeScale = 4.0f / (float)fftSize;   // full-scale sine ~ 0 dB with Hann
+    std::vector<juce::uint8> newColumns;
+    int count = 0;
+    size_t pos = 0;
+
+    while (carry.size() - pos >= (size_t)fftSize)
+    {
+        std::fill(fftBuffer.begin(), fftBuffer.end(), 0.0f);
+        std::copy(carry.begin() + (std::ptrdiff_t)pos,
+            carry.begin() + (std::ptrdiff_t)(pos + (size_t)fftSize),
+            fftBuffer.begin());
+
+        window.multiplyWithWindowingTable(fftBuffer.data(), (size_t)fftSize);
+        fft.performFrequencyOnlyForwardTransform(fftBuffer.data(), true);
+
+        for (int r = 0; r < numRows; ++r)
+        {
+            const int b0 = rowFirstBin[(size_t)r];
+            const int n = rowEndBin[(size_t)r] - b0;
+
+            const float mag = juce::FloatVectorOperations::findMaximum(fftBuffer.data() + b0, n);
+            const float db = juce::Decibels::gainToDecibels(mag * magnitudeScale, floorDb);
+
+            newColumns.push_back((juce::uint8)juce::jlimit(0, 255,
+                juce::roundToInt((db - floorDb) / -floorDb * 255.0f)));
+        }
+
+        ++count;
+        pos += (size_t)hopSize;
+    }
+
+    carry.erase(carry.begin(), carry.begin() + (std::ptrdiff_t)pos);
+
+    if (count > 0)
+        addColumns(newColumns, count);
+}
+
+void SpectrogramCache::addColumns(const std::vector<juce::uint8>& newColumns, int count)
+{
+    int firstDirty = levels[0].numColumns;
+
+    levels[0].columns.insert(levels[0].columns.end(), newColumns.begin(), newColumns.end());
+    levels[0].numColumns += count;
+
+    size_t bytes = 0;
+
+    for (int level = 0; level < numLevels; ++level)
+    {
+        auto& current = levels[level];
+
+        if (level > 0)
+        {
+            // Each parent column is the max of two children
+            const auto& child = levels[level - 1];
+            firstDirty /= 2;
+
+            current.numColumns = (child.numColumns + 1) / 2;
+            current.columns.resize((size_t)current.numColumns * numRows);
+
+            for (int p = firstDirty; p < current.numColumns; ++p)
+            {
+                const int c0 = p * 2;
+                const int c1 = juce::jmin(child.numColumns - 1, c0 + 1);
+
+                for (int r = 0; r < numRows; ++r)
+                {
+                    current.columns[(size_t)p * numRows + (size_t)r] =
+                        juce::jmax(child.columns[(size_t)c0 * numRows + (size_t)r],
+                            child.columns[(size_t)c1 * numRows + (size_t)r]);
+                }
+            }
+        }
+
+        // Re-render only the tiles whose columns changed, then swap them in
+        const int firstTile = firstDirty / tileColumns;
+        const int numTiles = (current.numColumns + tileColumns - 1) / tileColumns;
+
+        std::vector<juce::Image> rendered;
+        for (int t = firstTile; t < numTiles; ++t)
+            rendered.push_back(renderTile(level, t));
+
+        const juce::SpinLock::ScopedLockType sl(tileLock);
+        auto& set = tileSets[level];
+        set.tiles.resize((size_t)numTiles);
+
+        for (int t = firstTile; t < numTiles; ++t)
+            set.tiles[(size_t)t] = rendered[(size_t)(t - firstTile)];
+
+        set.numColumns = current.numColumns;
+
+        // ARGB tiles
+        bytes += current.columns.capacity() + (size_t)numTiles * tileColumns * numRows * 4;
+    }
+
+    memoryBytes.store(bytes);
+}
+
+juce::Image SpectrogramCache::renderTile(int level, int tileIndex) const
+{
+    const auto& current = levels[level];
+    const int first = tileIndex * tileColumns;
+    const int count = juce::jmin(tileColumns, current.numColumns - first);
+
+    // Software image: rendered on a worker thread, columns past the end stay transparent
+    juce::Image image(juce::Image::ARGB, tileColumns, numRows, true, juce::SoftwareImageType());
+    juce::Image::BitmapData data(image, juce::Image::BitmapData::writeOnly);
+
+    const auto* colours = getColourMap();
+
+    for (int c = 0; c < count; ++c)
+    {
+        const auto* column = current.columns.data() + (size_t)(first + c) * numRows;
+
+        for (int r = 0; r < numRows; ++r)
+            data.setPixelColour(c, numRows - 1 - r, colours[column[r]]);
+    }
+
+    return image;
+}
+
+void SpectrogramCache::drawRange(juce::Graphics& g,
+    juce::Rectangle<int> area,
+    double startSample,
+    double numSamples) const
+{
+    if (area.isEmpty() || numSamples <= 0.0)
+        return;
+
+    const double startColumn = startSample / (double)hopSize;
+    const double numColumns = numSamples / (double)hopSize;
+    const double columnsPerPixel = numColumns / (double)area.getWidth();
+
+    // Coarsest level that still has at least one column per pixel
+    int level = 0;
+    while (level + 1 < numLevels && (double)(1 << (level + 1)) <= columnsPerPixel)
+        ++level;
+
+    const double levelScale = (double)(1 << level);
+    const double levelStart = startColumn / levelScale;
+    const double levelCount = numColumns / levelScale;
+    const double pixelsPerColumn = (double)area.getWidth() / levelCount;
+
+    const int firstTile = juce::jmax(0, (int)std::floor(levelStart / tileColumns));
+    const int lastTile = (int)std::ceil((levelStart + levelCount) / tileColumns);
+
+    std::vector<juce::Image> tiles;
+    {
+        const juce::SpinLock::ScopedLockType sl(tileLock);
+        const auto& set = tileSets[level];
+        const int end = juce::jmin(lastTile, (int)set.tiles.size());
+
+        for (int t = firstTile; t < end; ++t)
+            tiles.push_back(set.tiles[(size_t)t]);
+    }
+
+    juce::Graphics::ScopedSaveState state(g);
+    g.reduceClipRegion(area);
+    g.setImageResamplingQuality(juce::Graphics::lowResamplingQuality);
+
+    for (size_t i = 0; i < tiles.size(); ++i)
+    {
+        if (!tiles[i].isValid())
+            continue;
+
+        const double tileStart = (double)((firstTile + (int)i) * tileColumns);
+        const double x = (double)area.getX() + (tileStart - levelStart) * pixelsPerColumn;
+
+        g.drawImage(tiles[i],
+            juce::Rectangle<float>((float)x,
+                (float)area.getY(),
+                (float)(tileColumns * pixelsPerColumn),
+                (float)area.getHeight()));
+    }
+}
+
+std::shared_ptr<SpectrogramCache> SpectrogramCache::createFromReader(juce::AudioFormatReader& reader,
+    const std::function<bool()>& shouldExit)
+{
+    auto cache = std::make_shared<SpectrogramCache>(reader.sampleRate);
+
+    const int   numChannels = juce::jmax(1, (int)reader.numChannels);
+    const int   blockSize = 65536;
+    const int64 totalSamples = reader.lengthInSamples;
+
+    juce::AudioBuffer<float> block(numChannels, blockSize);
+
+    for (int64 pos = 0; pos < totalSamples; pos += blockSize)
+    {
+        if (shouldExit != nullptr && shouldExit())
+            return nullptr;
+
+        const int n = (int)juce::jmin<int64>(blockSize, totalSamples - pos);
+
+        reader.read(&block, 0, n, pos, true, true);
+
+        if (numChannels > 1)
+        {
+            for (int ch = 1; ch < numChannels; ++ch)
+                block.addFrom(0, 0, block, ch, 0, n);
+
+            block.applyGain(0, 0, n, 1.0f / (float)numChannels);
+        }
+
+        cache->appendSamples(block.getReadPointer(0), n);
+    }
+
+    return cache;
+}
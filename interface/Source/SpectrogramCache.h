@@ -0,0 +1,99 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// SpectrogramCache: STFT magnitudes for one mono signal, kept as 8-bit dB
+// columns on a log frequency axis and pre-rendered into image tiles.
+//
+// Columns are computed with juce::dsp::FFT on a worker thread. Every level
+// above 0 merges pairs of columns (max), and each level is cut into tiles of
+// tileColumns columns that are re-rendered only when their columns change.
+// drawRange() just blits tiles, so scrolling and zooming never run the FFT.
+//==============================================================================
+
+class SpectrogramCache : public std::enable_shared_from_this<SpectrogramCache>
+{
+public:
+    static constexpr int fftOrder = 10;
+    static constexpr int fftSize = 1 << fftOrder;   // 1024
+    static constexpr int hopSize = 256;
+    static constexpr int numRows = 128;             // log-spaced, 40 Hz .. Nyquist
+    static constexpr int tileColumns = 256;
+    static constexpr int numLevels = 6;
+
+    explicit SpectrogramCache(double sampleRate);
+
+    double getSampleRate() const noexcept { return sampleRate; }
+
+    // Samples handed to appendAsync() so far (processed or still queued).
+    juce::int64 getNumSamplesQueued() const noexcept { return samplesQueued.load(); }
+
+    // Bytes held by the columns and tiles, as of the last append
+    size_t getMemoryUsage() const noexcept { return memoryBytes.load(); }
+
+    // Queues samples for the pool; batches are processed strictly in order.
+    // onUpdated runs on the message thread once the queue has drained.
+    void appendAsync(juce::ThreadPool& pool,
+        std::vector<float> samples,
+        std::function<void()> onUpdated);
+
+    // Synchronous append; worker thread only, never concurrently with itself.
+    void appendSamples(const float* samples, int numSamples);
+
+    // Blits the tiles covering [startSample, startSample + numSamples) into area.
+    void drawRange(juce::Graphics& g,
+        juce::Rectangle<int> area,
+        double startSample,
+        double numSamples) const;
+
+    // Whole file, mixed to mono. Returns nullptr if shouldExit() turned true.
+    static std::shared_ptr<SpectrogramCache> createFromReader(juce::AudioFormatReader& reader,
+        const std::function<bool()>& shouldExit);
+
+private:
+    struct Level
+    {
+        std::vector<juce::uint8> columns;   // numRows bytes per column, low rows first
+        int numColumns = 0;
+    };
+
+    struct TileSet
+    {
+        std::vector<juce::Image> tiles;
+        int numColumns = 0;
+    };
+
+    void addColumns(const std::vector<juce::uint8>& newColumns, int count);
+    juce::Image renderTile(int level, int tileIndex) const;
+
+    const double sampleRate;
+
+    // Worker-side state
+    juce::dsp::FFT fft{ fftOrder };
+    juce::dsp::WindowingFunction<float> window{ (size_t)fftSize,
+        juce::dsp::WindowingFunction<float>::hann,
+        false };
+    std::vector<float> fftBuffer;
+    std::vector<float> carry;                // samples not yet covered by a full hop
+    std::vector<int>   rowFirstBin, rowEndBin;
+    Level levels[numLevels];
+
+    // Published to the message thread
+    TileSet tileSets[numLevels];
+    juce::SpinLock tileLock;
+
+    // appendAsync queue
+    std::deque<std::vector<float>> queue;
+    juce::CriticalSection queueLock;
+    bool workerActive = false;
+    std::atomic<juce::int64> samplesQueued{ 0 };
+    std::atomic<size_t> memoryBytes{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrogramCache)
+};
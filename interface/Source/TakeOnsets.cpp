@@ -0,0 +1,139 @@
+// TakeOnsets.cpp
+#include "TakeOnsets.h"
+
+using int64 = juce::int64;
+
+//==============================================================================
+// TakeOnsets
+//==============================================================================
+
+TakeOnsets::TakeOnsets(double seconds, std::vector<double> onsetTimes)
+    : lengthSeconds(juce::jmax(0.0, seconds)),
+      times(std::move(onsetTimes))
+{
+}
+
+juce::Range<int> TakeOnsets::getIndicesBetween(double startSec, double endSec) const noexcept
+{
+    const auto first = std::lower_bound(times.begin(), times.end(), startSec);
+    const auto last = std::lower_bound(first, times.end(), endSec);
+
+    return { (int)(first - times.begin()), (int)(last - times.begin()) };
+}
+
+bool TakeOnsets::writeToFile(const juce::File& file) const
+{
+    juce::Array<juce::var> onsetList;
+    onsetList.ensureStorageAllocated((int)times.size());
+
+    for (const double t : times)
+        onsetList.add(t);
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("length_s", lengthSeconds);
+    root->setProperty("hop_length", FeatureKernels::hopLength);
+    root->setProperty("onset_s", onsetList);
+
+    return file.replaceWithText(juce::JSON::toString(juce::var(root), true));
+}
+
+std::shared_ptr<TakeOnsets> TakeOnsets::readFromFile(const juce::File& file)
+{
+    if (!file.existsAsFile())
+        return nullptr;
+
+    const auto root = juce::JSON::parse(file);
+    const double length = (double)root.getProperty("length_s", -1.0);
+    const auto* onsetList = root.getProperty("onset_s", {}).getArray();
+
+    if (length < 0.0 || onsetList == nullptr)
+        return nullptr;
+
+    std::vector<double> onsetTimes;
+    onsetTimes.reserve((size_t)onsetList->size());
+
+    for (const auto& t : *onsetList)
+        onsetTimes.push_back((double)t);
+
+    // Kept ascending whatever the file says
+    std::sort(onsetTimes.begin(), onsetTimes.end());
+
+    return std::make_shared<TakeOnsets>(length, std::move(onsetTimes));
+}
+
+juce::File TakeOnsets::getSidecarFile(const juce::File& takeFile)
+{
+    return takeFile.withFileExtension("onsets.json");
+}
+
+std::shared_ptr<TakeOnsets> TakeOnsets::readSidecarFor(const juce::File& takeFile)
+{
+    const auto sidecar = getSidecarFile(takeFile);
+
+    if (!sidecar.existsAsFile()
+        || sidecar.getLastModificationTime() < takeFile.getLastModificationTime())
+        return nullptr;
+
+    return readFromFile(sidecar);
+}
+
+//==============================================================================
+// OnsetAnalyser
+//==============================================================================
+
+OnsetAnalyser::OnsetAnalyser(double rate)
+    : sampleRate(rate > 0.0 ? rate : 44100.0),
+      detector(sampleRate)
+{
+}
+
+void OnsetAnalyser::process(const float* samples, int numSamples)
+{
+    if (samples == nullptr || numSamples <= 0)
+        return;
+
+    detector.process(samples, numSamples);
+    numSamplesProcessed += numSamples;
+}
+
+std::shared_ptr<TakeOnsets> OnsetAnalyser::getResult()
+{
+    detector.finish();
+
+    return std::make_shared<TakeOnsets>((double)numSamplesProcessed / sampleRate,
+        detector.getOnsetTimes());
+}
+
+std::shared_ptr<TakeOnsets> OnsetAnalyser::analyse(juce::AudioFormatReader& reader,
+    const std::function<bool()>& shouldExit)
+{
+    OnsetAnalyser analyser(reader.sampleRate);
+
+    const int   numChannels = juce::jmax(1, (int)reader.numChannels);
+    const int   chunkSize = 65536;
+    const int64 totalSamples = reader.lengthInSamples;
+
+    juce::AudioBuffer<float> chunk(numChannels, chunkSize);
+
+    for (int64 pos = 0; pos < totalSamples; pos += chunkSize)
+    {
+        if (shouldExit != nullptr && shouldExit())
+            return nullptr;
+
+        const int n = (int)juce::jmin<int64>(chunkSize, totalSamples - pos);
+
+        reader.read(&chunk, 0, n, pos, true, true);
+
+        if (numChannels > 1)
+        {
+            for (int ch = 1; ch < numChannels; ++ch)
+                chunk.addFrom(0, 0, chunk, ch, 0, n);
+
+            chunk.applyGain(0, 0, n, 1.0f / (float)numChannels);
+        }
+
+        analyser.process(chunk.getReadPointer(0), n);
+    }
+
+    return analyser.getResult();
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "../../native/FeatureKernels.h"
+
+//==============================================================================
+// TakeOnsets: note onset times of a take, in seconds from its start.
+//
+// Found once per take by FeatureKernels::OnsetDetector (the same detector
+// the Python pipeline's microtiming score and phrase boundary snapping use)
+// and saved as take_N.onsets.json next to the take, so neither side has to
+// look for them again.
+//==============================================================================
+
+class TakeOnsets
+{
+public:
+    TakeOnsets(double lengthSeconds, std::vector<double> onsetTimes);
+
+    double getLengthSeconds() const noexcept { return lengthSeconds; }
+    const std::vector<double>& getTimes() const noexcept { return times; }
+
+    // Onsets in [startSec, endSec), as a range of indices into getTimes()
+    juce::Range<int> getIndicesBetween(double startSec, double endSec) const noexcept;
+
+    size_t getMemoryUsage() const noexcept { return times.capacity() * sizeof(double); }
+
+    bool writeToFile(const juce::File& file) const;
+    static std::shared_ptr<TakeOnsets> readFromFile(const juce::File& file);
+
+    // take_N.wav -> take_N.onsets.json
+    static juce::File getSidecarFile(const juce::File& takeFile);
+
+    // The take's sidecar, if there is one at least as new as the take.
+    static std::shared_ptr<TakeOnsets> readSidecarFor(const juce::File& takeFile);
+
+private:
+    const double lengthSeconds;
+    const std::vector<double> times;   // ascending
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TakeOnsets)
+};
+
+//==============================================================================
+// OnsetAnalyser: FeatureKernels::OnsetDetector fed from a take as it is
+// written or read.
+//==============================================================================
+
+class OnsetAnalyser
+{
+public:
+    explicit OnsetAnalyser(double sampleRate);
+
+    // Mono samples, any block size.
+    void process(const float* samples, int numSamples);
+
+    // Onsets of everything processed; no more samples after this.
+    std::shared_ptr<TakeOnsets> getResult();
+
+    // Whole file, mixed to mono. Returns nullptr if shouldExit() turned true.
+    static std::shared_ptr<TakeOnsets> analyse(juce::AudioFormatReader& reader,
+        const std::function<bool()>& shouldExit);
+
+private:
+    const double sampleRate;
+    FeatureKernels::OnsetDetector detector;
+    juce::int64 numSamplesProcessed = 0;
+};
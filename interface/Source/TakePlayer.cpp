@@ -0,0 +1,288 @@
+// TakePlayer.cpp
+#include "TakePlayer.h"
+
+using int64 = juce::int64;
+
+static_assert(std::atomic<float>::is_always_lock_free
+    && std::atomic<double>::is_always_lock_free,
+    "TakePlayer shares its gain and position with the audio thread");
+
+//==============================================================================
+
+TakePlayer::TakePlayer()
+{
+}
+
+TakePlayer::~TakePlayer()
+{
+    // The audio callback has stopped: whatever is still queued belongs to us
+    int start1, size1, start2, size2;
+    commandFifo.prepareToRead(commandFifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1 + size2; ++i)
+    {
+        const auto& c = commands[i < size1 ? start1 + i : start2 + i - size1];
+        if (c.type == Command::Type::setSource)
+            delete c.source;
+    }
+
+    commandFifo.finishedRead(size1 + size2);
+
+    delete current;
+    current = nullptr;
+
+    releaseRetiredSources();
+}
+
+//==============================================================================
+// Message thread
+//==============================================================================
+
+bool TakePlayer::load(std::unique_ptr<juce::AudioFormatReader> reader)
+{
+    if (reader == nullptr)
+        return false;
+
+    auto s = std::make_unique<Source>();
+    s->sampleRate = reader->sampleRate;
+    s->reader = std::make_unique<juce::AudioFormatReaderSource>(reader.release(), true);
+    s->reader->setLooping(true);
+    s->resampler = std::make_unique<juce::ResamplingAudioSource>(s->reader.get(), false, 1);
+
+    // Allocates, so it happens here rather than when the source is swapped in
+    prepareSource(*s);
+
+    Command c;
+    c.type = Command::Type::setSource;
+    c.source = s.get();
+
+    if (!push(c))
+        return false;
+
+    s.release();
+
+    sourceRequested = true;
+    playRequested = false;
+    requestedSampleRate = c.source->sampleRate;
+    position.store(0.0);
+    return true;
+}
+
+void TakePlayer::unload()
+{
+    Command c;
+    c.type = Command::Type::setSource;
+
+    if (push(c))
+    {
+        sourceRequested = false;
+        playRequested = false;
+        position.store(0.0);
+    }
+}
+
+void TakePlayer::start()
+{
+    Command c;
+    c.type = Command::Type::start;
+
+    if (sourceRequested && push(c))
+        playRequested = true;
+}
+
+void TakePlayer::stop()
+{
+    Command c;
+    c.type = Command::Type::stop;
+
+    if (push(c))
+        playRequested = false;
+}
+
+void TakePlayer::setPosition(double seconds)
+{
+    if (!sourceRequested)
+        return;
+
+    Command c;
+    c.type = Command::Type::setPosition;
+    c.position = (int64)std::llround(juce::jmax(0.0, seconds) * requestedSampleRate);
+
+    if (push(c))
+        position.store(seconds);
+}
+
+void TakePlayer::releaseRetiredSources()
+{
+    int start1, size1, start2, size2;
+    retireFifo.prepareToRead(retireFifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1 + size2; ++i)
+    {
+        auto& s = retired[i < size1 ? start1 + i : start2 + i - size1];
+        delete s;
+        s = nullptr;
+    }
+
+    retireFifo.finishedRead(size1 + size2);
+}
+
+bool TakePlayer::push(const Command& c)
+{
+    // Single producer: free space can only grow until we write
+    if (commandFifo.getFreeSpace() < 1)
+    {
+        jassertfalse;   // the audio thread has not run for queueSize commands
+        return false;
+    }
+
+    int start1, size1, start2, size2;
+    commandFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    commands[size1 > 0 ? start1 : start2] = c;
+    commandFifo.finishedWrite(1);
+    return true;
+}
+
+void TakePlayer::prepareSource(Source& s) const
+{
+    const double rate = deviceSampleRate.load();
+
+    s.blockSize = deviceBlockSize.load();
+    s.resampler->setResamplingRatio(s.sampleRate / rate);
+    s.resampler->prepareToPlay(s.blockSize, rate);
+}
+
+//==============================================================================
+// Audio device
+//==============================================================================
+
+void TakePlayer::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+    deviceBlockSize.store(juce::jmax(1, samplesPerBlockExpected));
+    deviceSampleRate.store(sampleRate);
+
+    // Nothing renders until this returns, so the playing source can be redone
+    applyCommands();
+
+    if (current != nullptr)
+        prepareSource(*current);
+}
+
+void TakePlayer::releaseResources()
+{
+    if (current != nullptr)
+        current->resampler->releaseResources();
+}
+
+//==============================================================================
+// Audio thread
+//==============================================================================
+
+void TakePlayer::applyCommands() noexcept
+{
+    const int numReady = commandFifo.getNumReady();
+    if (numReady == 0)
+        return;
+
+    int start1, size1, start2, size2;
+    commandFifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+    int done = 0;
+
+    auto apply = [this](const Command& c)
+        {
+            switch (c.type)
+            {
+            case Command::Type::setSource:
+                // The old source can only go if the message thread can take it back
+                if (current != nullptr && retireFifo.getFreeSpace() < 1)
+                    return false;
+
+                retire(current);
+                current = c.source;
+                playing = false;
+                fadingOut = false;
+                lastGain = 0.0f;
+
+                // Normally already set when the source was prepared
+                if (current != nullptr)
+                    current->resampler->setResamplingRatio(current->sampleRate / deviceSampleRate.load());
+                break;
+
+            case Command::Type::start:
+                playing = (current != nullptr);
+                fadingOut = false;
+                break;
+
+            case Command::Type::stop:
+                fadingOut = playing;
+                playing = false;
+                break;
+
+            case Command::Type::setPosition:
+                if (current != nullptr)
+                {
+                    current->reader->setNextReadPosition(c.position);
+                    current->resampler->flushBuffers();
+                }
+                break;
+            }
+
+            return true;
+        };
+
+    for (int i = 0; i < size1 && apply(commands[start1 + i]); ++i)
+        ++done;
+
+    if (done == size1)
+        for (int i = 0; i < size2 && apply(commands[start2 + i]); ++i)
+            ++done;
+
+    // Anything not applied stays queued for the next block
+    commandFifo.finishedRead(done);
+}
+
+void TakePlayer::retire(Source* s) noexcept
+{
+    if (s == nullptr)
+        return;
+
+    // applyCommands() checked there is room
+    int start1, size1, start2, size2;
+    retireFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    retired[size1 > 0 ? start1 : start2] = s;
+    retireFifo.finishedWrite(1);
+}
+
+void TakePlayer::getNextAudioBlock(const juce::AudioSourceChannelInfo& info) noexcept
+{
+    applyCommands();
+
+    if (current == nullptr || (!playing && !fadingOut))
+    {
+        info.clearActiveBufferRegion();
+        lastGain = 0.0f;
+        return;
+    }
+
+    // Never more than prepared for, so the resampler does not reallocate
+    for (int done = 0; done < info.numSamples;)
+    {
+        const int n = juce::jmin(info.numSamples - done, current->blockSize);
+        current->resampler->getNextAudioBlock({ info.buffer, info.startSample + done, n });
+        done += n;
+    }
+
+    // Ramp to the new gain, or to silence on the block after stop()
+    const float targetGain = playing ? gain.load() : 0.0f;
+
+    for (int ch = 0; ch < info.buffer->getNumChannels(); ++ch)
+        info.buffer->applyGainRamp(ch, info.startSample, info.numSamples, lastGain, targetGain);
+
+    lastGain = targetGain;
+    fadingOut = false;
+
+    position.store((double)current->reader->getNextReadPosition() / current->sampleRate);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+
+//==============================================================================
+// TakePlayer: plays one take (or the comp) in a loop next to the instrumental.
+//
+// The message thread never touches what the audio thread renders. Sources
+// are opened and prepared on the message thread and handed over through a
+// lock-free command queue, together with start / stop / seek; the audio
+// thread applies the queued commands at the start of each block. A source
+// the audio thread lets go of goes back through a second queue and is
+// deleted by releaseRetiredSources() on the message thread.
+//
+// Position is published by the audio thread after each block; isPlaying()
+// and hasSource() reflect what the message thread last asked for.
+//==============================================================================
+
+class TakePlayer
+{
+public:
+    static constexpr int queueSize = 256;
+
+    TakePlayer();
+    ~TakePlayer();
+
+    // --- Message thread ---
+
+    // Queues reader as the new (looping, stopped) source; false if the queue is full.
+    bool load(std::unique_ptr<juce::AudioFormatReader> reader);
+    void unload();
+
+    void start();
+    void stop();
+    void setPosition(double seconds);
+    void setGain(float newGain) noexcept { gain.store(newGain); }
+
+    bool hasSource() const noexcept { return sourceRequested; }
+    bool isPlaying() const noexcept { return sourceRequested && playRequested; }
+    double getCurrentPosition() const noexcept { return position.load(); }
+
+    // Deletes the sources the audio thread has finished with.
+    void releaseRetiredSources();
+
+    // --- Audio device (the callback is not running) ---
+    void prepareToPlay(int samplesPerBlockExpected, double sampleRate);
+    void releaseResources();
+
+    // --- Audio thread ---
+    // Replaces the samples in info (all channels get the mono take).
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& info) noexcept;
+
+private:
+    struct Source
+    {
+        std::unique_ptr<juce::AudioFormatReaderSource> reader;
+        std::unique_ptr<juce::ResamplingAudioSource> resampler;
+        double sampleRate = 0.0;
+        int blockSize = 0;        // it was prepared for; larger blocks are split
+    };
+
+    struct Command
+    {
+        enum class Type { setSource, start, stop, setPosition };
+
+        Type    type = Type::stop;
+        Source* source = nullptr;        // setSource: ownership moves with the command
+        juce::int64 position = 0;        // setPosition: in source samples
+    };
+
+    bool push(const Command& c);
+    void applyCommands() noexcept;
+    void retire(Source* s) noexcept;
+    void prepareSource(Source& s) const;
+
+    // Message thread
+    bool sourceRequested = false;
+    bool playRequested = false;
+    double requestedSampleRate = 0.0;    // of the last loaded source
+
+    // Shared
+    juce::AbstractFifo commandFifo{ queueSize };
+    Command commands[queueSize];
+    juce::AbstractFifo retireFifo{ queueSize };
+    Source* retired[queueSize] = {};
+
+    std::atomic<float>  gain{ 1.0f };
+    std::atomic<double> position{ 0.0 };                 // seconds
+    std::atomic<double> deviceSampleRate{ 44100.0 };
+    std::atomic<int>    deviceBlockSize{ 512 };
+
+    // Audio thread
+    Source* current = nullptr;
+    bool    playing = false;
+    bool    fadingOut = false;
+    float   lastGain = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TakePlayer)
+};
@@ -0,0 +1,450 @@
+// TakeStore.cpp
+#include "TakeStore.h"
+
+using int64 = juce::int64;
+
+namespace
+{
+    using Int16Samples = juce::AudioData::Pointer<juce::AudioData::Int16,
+        juce::AudioData::NativeEndian, juce::AudioData::NonInterleaved, juce::AudioData::NonConst>;
+    using ConstInt16Samples = juce::AudioData::Pointer<juce::AudioData::Int16,
+        juce::AudioData::NativeEndian, juce::AudioData::NonInterleaved, juce::AudioData::Const>;
+    using FloatSamples = juce::AudioData::Pointer<juce::AudioData::Float32,
+        juce::AudioData::NativeEndian, juce::AudioData::NonInterleaved, juce::AudioData::NonConst>;
+    using ConstFloatSamples = juce::AudioData::Pointer<juce::AudioData::Float32,
+        juce::AudioData::NativeEndian, juce::AudioData::NonInterleaved, juce::AudioData::Const>;
+}
+
+//==============================================================================
+
+TakeStore::~TakeStore()
+{
+    closeSpillFile();
+    freeBlocks();
+}
+
+void TakeStore::reset()
+{
+    closeSpillFile();
+    freeBlocks();
+
+    numSamples = 0;
+
+    for (auto& d : decoded)
+    {
+        d.blockIndex = -1;
+        d.numDecoded = 0;
+    }
+}
+
+void TakeStore::reserve(int total, const juce::CriticalSection& ownerLock)
+{
+    addBlocks(total, false, ownerLock);
+}
+
+void TakeStore::reserveForRecording(int total, const juce::CriticalSection& ownerLock)
+{
+    // Zeroed, faulted in and locked, so append() never page-faults
+    addBlocks(total, true, ownerLock);
+}
+
+void TakeStore::addBlocks(int total, bool realtime, const juce::CriticalSection& ownerLock)
+{
+    // Only this thread adds blocks, so the count can be read without the lock
+    const int numBlocks = (total + blockSize - 1) / blockSize;
+    std::vector<juce::int16*> added;
+
+    for (int i = (int)blocks.size(); i < numBlocks; ++i)
+    {
+        // Zeroed either way: appendSilence() only moves the count
+        auto* samples = realtime
+            ? arena.allocateArray<juce::int16>((size_t)blockSize)
+            : static_cast<juce::int16*>(std::calloc((size_t)blockSize, sizeof(juce::int16)));
+
+        if (samples == nullptr)
+            break;
+
+        added.push_back(samples);
+    }
+
+    if (added.empty())
+        return;
+
+    const juce::ScopedLock sl(ownerLock);
+
+    for (auto* samples : added)
+    {
+        blocks.emplace_back();
+        blocks.back().samples = samples;
+        blocks.back().realtime = realtime;
+    }
+}
+
+void TakeStore::freeSamples(juce::int16* samples, bool realtime)
+{
+    if (realtime)
+        arena.free(samples);
+    else
+        std::free(samples);
+}
+
+int TakeStore::append(const float* samples, int num) noexcept
+{
+    // Only the appending thread writes numSamples
+    int count = numSamples.load(std::memory_order_relaxed);
+    num = juce::jlimit(0, getCapacity() - count, num);
+
+    for (int done = 0; done < num;)
+    {
+        const int block = count / blockSize;
+        const int offset = count % blockSize;
+        const int n = juce::jmin(num - done, blockSize - offset);
+
+        // Clips to the 16-bit range, like the take WAV writer. The block
+        // being written is not full, so it is never spilled or released.
+        Int16Samples(blocks[(size_t)block].samples + offset)
+            .convertSamples(ConstFloatSamples(samples + done), n);
+
+        count += n;
+        done += n;
+    }
+
+    // Readers see the samples before the count that covers them
+    numSamples.store(count, std::memory_order_release);
+    return num;
+}
+
+int TakeStore::appendSilence(int num) noexcept
+{
+    // Blocks are zeroed when reserved, so skipping ahead is enough
+    const int count = numSamples.load(std::memory_order_relaxed);
+    num = juce::jlimit(0, getCapacity() - count, num);
+    numSamples.store(count + num, std::memory_order_release);
+    return num;
+}
+
+void TakeStore::read(int start, int num, float* dest)
+{
+    if (num <= 0)
+        return;
+
+    const int count = getNumSamples();
+    const int first = (int)juce::jlimit<int64>(0, count, start);
+    const int last = (int)juce::jlimit<int64>(first, count, (int64)start + num);
+
+    if (last <= first)
+    {
+        std::fill(dest, dest + num, 0.0f);
+        return;
+    }
+
+    // Zero the parts outside the recording
+    std::fill(dest, dest + (first - start), 0.0f);
+    std::fill(dest + (last - start), dest + num, 0.0f);
+
+    for (int pos = first; pos < last;)
+    {
+        const int block = pos / blockSize;
+        const int offset = pos % blockSize;
+        const int n = juce::jmin(last - pos, blockSize - offset);
+
+        // Silent blocks never go through the decoded LRU
+        if (blocks[(size_t)block].silent)
+        {
+            std::fill(dest + (pos - start), dest + (pos - start) + n, 0.0f);
+            pos += n;
+            continue;
+        }
+
+        const float* src = getDecoded(block, offset + n);
+        std::copy(src + offset, src + offset + n, dest + (pos - start));
+
+        pos += n;
+    }
+}
+
+int TakeStore::spillColdBlocks(const juce::CriticalSection& ownerLock)
+{
+    if (budget == 0 || spillDirectory == juce::File())
+        return 0;
+
+    const size_t blockBytes = (size_t)blockSize * sizeof(juce::int16);
+    size_t resident = 0;
+    std::vector<HeldBlock> cold;
+
+    {
+        // Only which blocks go is decided under the lock
+        const juce::ScopedLock sl(ownerLock);
+
+        const int numFullBlocks = getNumSamples() / blockSize;
+        std::vector<int> candidates;
+
+        for (int i = 0; i < (int)blocks.size(); ++i)
+        {
+            if (blocks[(size_t)i].samples == nullptr)
+                continue;
+
+            resident += blockBytes;
+
+            // Partly written and reserved blocks stay, append() may need them
+            if (i < numFullBlocks)
+                candidates.push_back(i);
+        }
+
+        if (resident <= budget || candidates.empty())
+            return 0;
+
+        std::sort(candidates.begin(), candidates.end(), [this](int a, int b)
+            {
+                return blocks[(size_t)a].lastUse < blocks[(size_t)b].lastUse;
+            });
+
+        for (int index : candidates)
+        {
+            if (resident <= budget)
+                break;
+
+            const auto& b = blocks[(size_t)index];
+            cold.push_back({ index, b.samples, b.realtime });
+            resident -= blockBytes;
+        }
+    }
+
+    // Full blocks never change and are only freed on this thread, so they
+    // are written, flushed and mapped with the lock released
+    std::vector<HeldBlock> written;
+
+    for (const auto& c : cold)
+    {
+        if (!writeToSpillFile(c.index, c.samples))
+            break;
+
+        written.push_back(c);
+    }
+
+    if (written.empty())
+        return 0;
+
+    spillStream->flush();
+
+    // Remap the whole file; if that fails the blocks simply stay resident
+    auto newMap = std::make_unique<juce::MemoryMappedFile>(spillFile, juce::MemoryMappedFile::readOnly);
+    int highest = 0;
+
+    for (const auto& c : written)
+        highest = juce::jmax(highest, c.index);
+
+    if (newMap->getData() == nullptr || newMap->getSize() < (size_t)(highest + 1) * blockBytes)
+        return 0;
+
+    {
+        // Readers only reach the mapping under the lock, so after the swap
+        // nobody holds a pointer into the old one
+        const juce::ScopedLock sl(ownerLock);
+
+        std::swap(spillMap, newMap);
+
+        for (const auto& c : written)
+            blocks[(size_t)c.index].samples = nullptr;
+    }
+
+    // The old mapping (now in newMap) and the blocks go without the lock
+    newMap.reset();
+
+    for (const auto& c : written)
+        freeSamples(c.samples, c.realtime);
+
+    DBG("TakeStore: spilled " << (int)written.size() << " blocks, "
+        << (int)(resident / (1024 * 1024)) << " MB resident");
+
+    return (int)written.size();
+}
+
+int TakeStore::releaseSilentBlocks(const juce::CriticalSection& ownerLock)
+{
+    std::vector<HeldBlock> unscanned;
+
+    {
+        const juce::ScopedLock sl(ownerLock);
+
+        const int numFullBlocks = juce::jmin(getNumSamples() / blockSize, (int)blocks.size());
+
+        for (int i = 0; i < numFullBlocks; ++i)
+        {
+            auto& b = blocks[(size_t)i];
+
+            if (b.scanned)
+                continue;
+
+            b.scanned = true;
+
+            // Spilled blocks are not scanned; they are already off the heap
+            if (b.samples != nullptr)
+                unscanned.push_back({ i, b.samples, b.realtime });
+        }
+    }
+
+    // Full blocks never change, so they are scanned without the lock
+    std::vector<HeldBlock> silent;
+
+    for (const auto& u : unscanned)
+        if (std::all_of(u.samples, u.samples + blockSize, [](juce::int16 s) { return s == 0; }))
+            silent.push_back(u);
+
+    if (silent.empty())
+        return 0;
+
+    {
+        const juce::ScopedLock sl(ownerLock);
+
+        for (const auto& s : silent)
+        {
+            // Its decoded copy is zeros too, but no longer needed
+            for (auto& d : decoded)
+            {
+                if (d.blockIndex == s.index)
+                {
+                    d.blockIndex = -1;
+                    d.numDecoded = 0;
+                    d.lastUse = 0;
+                }
+            }
+
+            auto& b = blocks[(size_t)s.index];
+            b.samples = nullptr;
+            b.silent = true;
+        }
+    }
+
+    for (const auto& s : silent)
+        freeSamples(s.samples, s.realtime);
+
+    DBG("TakeStore: released " << (int)silent.size() << " silent blocks");
+
+    return (int)silent.size();
+}
+
+TakeStore::Stats TakeStore::getStats() const noexcept
+{
+    const size_t blockBytes = (size_t)blockSize * sizeof(juce::int16);
+
+    Stats s;
+    s.budgetBytes = budget;
+    s.hits = numHits;
+    s.misses = numMisses;
+    s.pageIns = numPageIns;
+
+    for (const auto& b : blocks)
+    {
+        (b.silent ? s.silentBytes : b.samples != nullptr ? s.residentBytes : s.spilledBytes) += blockBytes;
+
+        if (b.realtime && b.samples != nullptr)
+            s.realtimeBytes += blockBytes;
+    }
+
+    for (const auto& d : decoded)
+        if (d.samples != nullptr)
+            s.decodedBytes += (size_t)blockSize * sizeof(float);
+
+    return s;
+}
+
+bool TakeStore::writeToSpillFile(int blockIndex, const juce::int16* samples)
+{
+    if (spillStream == nullptr)
+    {
+        spillDirectory.createDirectory();
+        spillFile = spillDirectory.getNonexistentChildFile("takes", ".spill", false);
+        spillStream = spillFile.createOutputStream();
+
+        if (spillStream == nullptr || !spillStream->openedOk())
+        {
+            spillStream.reset();
+            return false;
+        }
+    }
+
+    const size_t blockBytes = (size_t)blockSize * sizeof(juce::int16);
+
+    return spillStream->setPosition((int64)blockIndex * (int64)blockBytes)
+        && spillStream->write(samples, blockBytes);
+}
+
+void TakeStore::freeBlocks()
+{
+    for (auto& b : blocks)
+        freeSamples(b.samples, b.realtime);
+
+    blocks.clear();
+}
+
+void TakeStore::closeSpillFile()
+{
+    spillMap.reset();
+    spillStream.reset();
+
+    if (spillFile != juce::File())
+        spillFile.deleteFile();
+
+    spillFile = juce::File();
+}
+
+const juce::int16* TakeStore::getEncoded(int blockIndex) const noexcept
+{
+    const auto& b = blocks[(size_t)blockIndex];
+
+    if (b.samples != nullptr)
+        return b.samples;
+
+    // Spilled blocks are always covered by the current mapping
+    return static_cast<const juce::int16*>(spillMap->getData()) + (size_t)blockIndex * blockSize;
+}
+
+const float* TakeStore::getDecoded(int blockIndex, int numNeeded)
+{
+    DecodedBlock* entry = nullptr;
+
+    for (auto& d : decoded)
+    {
+        if (d.blockIndex == blockIndex)
+        {
+            entry = &d;
+            break;
+        }
+    }
+
+    if (entry != nullptr)
+    {
+        ++numHits;
+    }
+    else
+    {
+        ++(blocks[(size_t)blockIndex].samples != nullptr ? numMisses : numPageIns);
+
+        // Least recently used (unused slots have lastUse 0)
+        entry = &decoded[0];
+        for (auto& d : decoded)
+            if (d.lastUse < entry->lastUse)
+                entry = &d;
+
+        if (entry->samples == nullptr)
+            entry->samples.malloc((size_t)blockSize);
+
+        entry->blockIndex = blockIndex;
+        entry->numDecoded = 0;
+    }
+
+    entry->lastUse = ++useCounter;
+    blocks[(size_t)blockIndex].lastUse = useCounter;
+
+    if (numNeeded > entry->numDecoded)
+    {
+        FloatSamples(entry->samples.get() + entry->numDecoded)
+            .convertSamples(ConstInt16Samples(getEncoded(blockIndex) + entry->numDecoded),
+                numNeeded - entry->numDecoded);
+
+        entry->numDecoded = numNeeded;
+    }
+
+    return entry->samples.get();
+}
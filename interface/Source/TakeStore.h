@@ -0,0 +1,148 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "RealtimeArena.h"
+
+//==============================================================================
+// TakeStore: the session's recorded vocal (all takes back to back, mono),
+// kept as 16-bit samples in fixed-size blocks.
+//
+// Takes are written to disk as 16-bit WAVs anyway, so this is lossless with
+// respect to the files and half the size of a float buffer. Reads decode
+// whole blocks into a small LRU, so repeated reads of the same region
+// (waveform zoom, spectrogram, analysis) only convert once.
+//
+// With a memory budget, spillColdBlocks() moves the least recently used full
+// blocks to a spill file, which is memory-mapped for reading; the OS pages
+// them back in when they are decoded again. Full blocks that hold nothing but
+// zeros (digital silence, e.g. padding after a stop) are released by
+// releaseSilentBlocks() and read back as zeros, on disk or in RAM.
+//
+// Append-only between reset() calls. Not thread safe: every call must hold
+// the owner's lock (vocalLock), except spillColdBlocks() and
+// releaseSilentBlocks(). Those take the lock themselves, only while blocks
+// change hands; the disk I/O, remapping and freeing happen without it, so
+// nothing that waits on the lock waits on the disk. Full blocks never
+// change, which is what makes reading them unlocked safe.
+//
+// append() is the other exception: the audio thread calls it without any
+// lock while recording. It never allocates or touches the disk, only writes
+// past getNumSamples() into blocks reserved beforehand, and publishes the
+// new count with a release store. Nothing may reserve or reset() while it
+// can run. Blocks reserved with reserveForRecording() come from a
+// RealtimeArena, so they are already faulted in and locked when the take is
+// recorded; loaded takes only need reserve(), which uses the ordinary heap.
+//==============================================================================
+
+class TakeStore
+{
+public:
+    static constexpr int blockSize = 1 << 16;    // samples per block
+    static constexpr int numDecodedBlocks = 8;   // LRU size
+
+    struct Stats
+    {
+        size_t residentBytes = 0;   // 16-bit blocks in RAM (reserved ones included)
+        size_t realtimeBytes = 0;   // the part of them from the arena
+        size_t spilledBytes = 0;    // blocks only in the spill file
+        size_t silentBytes = 0;     // all-zero blocks, not stored at all
+        size_t decodedBytes = 0;    // float LRU
+        size_t budgetBytes = 0;     // 0 = unbounded
+        juce::uint64 hits = 0;      // reads served from the decoded LRU
+        juce::uint64 misses = 0;    // decoded from a resident block
+        juce::uint64 pageIns = 0;   // decoded from the spill file
+    };
+
+    explicit TakeStore(RealtimeArena& arenaToUse) : arena(arenaToUse) {}
+    ~TakeStore();
+
+    // Drops all samples and blocks, and deletes the spill file.
+    void reset();
+
+    // Message thread. Makes room for at least numSamples in total, or as much
+    // as could be allocated; existing samples are kept. The blocks are
+    // allocated without ownerLock and added under it.
+    void reserve(int numSamples, const juce::CriticalSection& ownerLock);
+
+    // The same with blocks from the arena, for the callback to record into.
+    void reserveForRecording(int numSamples, const juce::CriticalSection& ownerLock);
+
+    int getNumSamples() const noexcept { return numSamples.load(std::memory_order_acquire); }
+    int getCapacity() const noexcept { return (int)blocks.size() * blockSize; }
+
+    // Appends up to the reserved capacity; returns how many samples were stored.
+    // One appending thread at a time.
+    int append(const float* samples, int num) noexcept;
+    int appendSilence(int num) noexcept;
+
+    // Samples [start, start + num) into dest; zero outside what was recorded.
+    void read(int start, int num, float* dest);
+
+    // Resident 16-bit data above budgetBytes is spilled (0 turns spilling off).
+    void setMemoryBudget(size_t budgetBytes) noexcept { budget = budgetBytes; }
+    void setSpillDirectory(const juce::File& directory) { spillDirectory = directory; }
+
+    // Message thread, without holding ownerLock: spills cold full blocks
+    // until the budget is met. Returns the number of blocks spilled.
+    int spillColdBlocks(const juce::CriticalSection& ownerLock);
+
+    // Message thread, without holding ownerLock: frees full blocks that are
+    // all zeros. Each block is scanned once, when it is first found full.
+    // Returns the number freed.
+    int releaseSilentBlocks(const juce::CriticalSection& ownerLock);
+
+    Stats getStats() const noexcept;
+
+private:
+    struct Block
+    {
+        juce::int16* samples = nullptr;   // null once spilled or silent
+        juce::uint32 lastUse = 0;
+        bool realtime = false;            // samples from the arena, else the heap
+        bool scanned = false;             // checked by releaseSilentBlocks()
+        bool silent = false;              // all zeros, samples released
+    };
+
+    // A block's samples on their way out of the store
+    struct HeldBlock
+    {
+        int index;
+        juce::int16* samples;
+        bool realtime;
+    };
+
+    struct DecodedBlock
+    {
+        int blockIndex = -1;
+        int numDecoded = 0;              // blocks only grow, so a decoded prefix stays valid
+        juce::uint32 lastUse = 0;
+        juce::HeapBlock<float> samples;
+    };
+
+    const juce::int16* getEncoded(int blockIndex) const noexcept;
+    const float* getDecoded(int blockIndex, int numNeeded);
+    bool writeToSpillFile(int blockIndex, const juce::int16* samples);
+    void addBlocks(int numSamples, bool realtime, const juce::CriticalSection& ownerLock);
+    void freeSamples(juce::int16* samples, bool realtime);
+    void closeSpillFile();
+    void freeBlocks();
+
+    RealtimeArena& arena;
+    std::vector<Block> blocks;
+    std::atomic<int> numSamples{ 0 };
+
+    DecodedBlock decoded[numDecodedBlocks];
+    juce::uint32 useCounter = 0;
+
+    size_t budget = 0;
+    juce::File spillDirectory, spillFile;
+    std::unique_ptr<juce::FileOutputStream> spillStream;
+    std::unique_ptr<juce::MemoryMappedFile> spillMap;
+
+    juce::uint64 numHits = 0, numMisses = 0, numPageIns = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TakeStore)
+};
@@ -0,0 +1,337 @@
+// WaveformCache.cpp
+#include "WaveformCache.h"
+
+using int64 = juce::int64;
+
+//==============================================================================
+// WaveformPeakCache
+//==============================================================================
+
+WaveformPeakCache::WaveformPeakCache() = default;
+
+void WaveformPeakCache::clear()
+{
+    const juce::ScopedWriteLock sl(peaksLock);
+
+    for (auto& level : levels)
+    {
+        level.mins.clear();
+        level.maxs.clear();
+    }
+
+    numSamplesAdded = 0;
+}
+
+size_t WaveformPeakCache::getMemoryUsage() const
+{
+    const juce::ScopedReadLock sl(peaksLock);
+
+    size_t bytes = 0;
+    for (const auto& level : levels)
+        bytes += (level.mins.capacity() + level.maxs.capacity()) * sizeof(float);
+
+    return bytes;
+}
+
+int64 WaveformPeakCache::getSamplesPerPeak(int level) noexcept
+{
+    int64 size = samplesPerBasePeak;
+    for (int i = 0; i < level; ++i)
+        size *= peaksPerParent;
+    return size;
+}
+
+void WaveformPeakCache::setRawSampleReader(RawSampleReader reader)
+{
+    rawReader = std::move(reader);
+}
+
+void WaveformPeakCache::appendSamples(const float* samples, int numSamples)
+{
+    if (samples == nullptr || numSamples <= 0)
+        return;
+
+    const juce::ScopedWriteLock sl(peaksLock);
+
+    auto& base = levels[0];
+    const int firstDirtyPeak = (int)(numSamplesAdded / samplesPerBasePeak);
+
+    int done = 0;
+    while (done < numSamples)
+    {
+        // Fill the current level-0 peak up to its boundary, then start the next.
+        const int offsetInPeak = (int)(numSamplesAdded % samplesPerBasePeak);
+        const int chunk = juce::jmin(numSamples - done, samplesPerBasePeak - offsetInPeak);
+
+        const auto range = juce::FloatVectorOperations::findMinAndMax(samples + done, chunk);
+
+        if (offsetInPeak == 0)
+        {
+            base.mins.push_back(range.getStart());
+            base.maxs.push_back(range.getEnd());
+        }
+        else
+        {
+            base.mins.back() = juce::jmin(base.mins.back(), range.getStart());
+            base.maxs.back() = juce::jmax(base.maxs.back(), range.getEnd());
+        }
+
+        numSamplesAdded += chunk;
+        done += chunk;
+    }
+
+    updateParentLevels(firstDirtyPeak);
+}
+
+void WaveformPeakCache::appendSilence(int64 numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    const juce::ScopedWriteLock sl(peaksLock);
+
+    auto& base = levels[0];
+    const int firstDirtyPeak = (int)(numSamplesAdded / samplesPerBasePeak);
+
+    // A peak already started takes zero into its range
+    if (numSamplesAdded % samplesPerBasePeak != 0)
+    {
+        base.mins.back() = juce::jmin(base.mins.back(), 0.0f);
+        base.maxs.back() = juce::jmax(base.maxs.back(), 0.0f);
+    }
+
+    const int64 total = numSamplesAdded + numSamples;
+    const size_t numPeaks = (size_t)((total + samplesPerBasePeak - 1) / samplesPerBasePeak);
+
+    base.mins.resize(numPeaks, 0.0f);
+    base.maxs.resize(numPeaks, 0.0f);
+    numSamplesAdded = total;
+
+    updateParentLevels(firstDirtyPeak);
+}
+
+void WaveformPeakCache::updateParentLevels(int firstDirtyBasePeak)
+{
+    size_t firstDirty = (size_t)juce::jmax(0, firstDirtyBasePeak);
+
+    for (int level = 1; level < numLevels; ++level)
+    {
+        const auto& child = levels[level - 1];
+        auto& parent = levels[level];
+
+        const size_t numChildren = child.mins.size();
+        const size_t numParents = (numChildren + peaksPerParent - 1) / peaksPerParent;
+
+        firstDirty /= (size_t)peaksPerParent;
+
+        parent.mins.resize(numParents);
+        parent.maxs.resize(numParents);
+
+        // Only the parents whose children changed need recomputing.
+        for (size_t p = firstDirty; p < numParents; ++p)
+        {
+            const size_t c0 = p * (size_t)peaksPerParent;
+            const size_t c1 = juce::jmin(numChildren, c0 + (size_t)peaksPerParent);
+
+            float lo = child.mins[c0];
+            float hi = child.maxs[c0];
+
+            for (size_t c = c0 + 1; c < c1; ++c)
+            {
+                lo = juce::jmin(lo, child.mins[c]);
+                hi = juce::jmax(hi, child.maxs[c]);
+            }
+
+            parent.mins[p] = lo;
+            parent.maxs[p] = hi;
+        }
+    }
+}
+
+void WaveformPeakCache::drawRange(juce::Graphics& g,
+    juce::Rectangle<int> area,
+    double startSample,
+    double numSamples) const
+{
+    const int w = area.getWidth();
+    const int64 available = numSamplesAdded.load();
+    if (w <= 0 || area.getHeight() <= 0 || numSamples <= 0.0 || available <= 0)
+        return;
+
+    const double samplesPerPixel = numSamples / (double)w;
+    const float  midY = (float)area.getY() + (float)area.getHeight() * 0.5f;
+    const float  amp = (float)area.getHeight() * 0.5f;
+
+    juce::RectangleList<float> bars;
+    bars.ensureStorageAllocated(w);
+
+    auto addBar = [&](int x, float lo, float hi)
+        {
+            lo = juce::jlimit(-1.0f, 1.0f, lo);
+            hi = juce::jlimit(-1.0f, 1.0f, hi);
+
+            const float top = midY - hi * amp;
+            const float bottom = midY - lo * amp;
+
+            bars.addWithoutMerging({ (float)(area.getX() + x),
+                                     top,
+                                     1.0f,
+                                     juce::jmax(1.0f, bottom - top) });
+        };
+
+    if (samplesPerPixel < (double)samplesPerBasePeak && rawReader != nullptr)
+    {
+        // Zoomed in past level 0: read the (small) visible range directly.
+        // No peaks lock here: the reader may take locks of its own.
+        const int64 first = juce::jmax<int64>(0, (int64)std::floor(startSample));
+        const int64 last = juce::jmin<int64>(available,
+            (int64)std::ceil(startSample + numSamples) + 1);
+
+        if (last <= first)
+            return;
+
+        const int count = (int)(last - first);
+        std::vector<float> rawScratch((size_t)count);
+        rawReader(first, count, rawScratch.data());
+
+        for (int x = 0; x < w; ++x)
+        {
+            const int64 s0 = (int64)std::floor(startSample + x * samplesPerPixel);
+            const int64 s1 = juce::jmax(s0 + 1,
+                (int64)std::floor(startSample + (x + 1) * samplesPerPixel));
+
+            if (s0 >= last)
+                break;
+
+            // Include the previous sample so bars join up when samples are wider than pixels
+            const int64 i0 = juce::jmax<int64>(first, s0 - 1) - first;
+            const int64 i1 = juce::jmin<int64>(last, s1) - first;
+
+            if (i1 <= i0)
+                continue;
+
+            const auto r = juce::FloatVectorOperations::findMinAndMax(rawScratch.data() + i0,
+                (int)(i1 - i0));
+            addBar(x, r.getStart(), r.getEnd());
+        }
+    }
+    else
+    {
+        const juce::ScopedReadLock sl(peaksLock);
+
+        int level = 0;
+        while (level + 1 < numLevels && (double)getSamplesPerPeak(level + 1) <= samplesPerPixel)
+            ++level;
+
+        const auto&  peaks = levels[level];
+        const double peakSize = (double)getSamplesPerPeak(level);
+        const int64  numPeaks = (int64)peaks.mins.size();
+
+        for (int x = 0; x < w; ++x)
+        {
+            int64 p0 = (int64)std::floor((startSample + x * samplesPerPixel) / peakSize);
+            int64 p1 = (int64)std::ceil((startSample + (x + 1) * samplesPerPixel) / peakSize);
+
+            p0 = juce::jmax<int64>(0, p0);
+            p1 = juce::jmin(numPeaks, juce::jmax(p0 + 1, p1));
+
+            if (p0 >= numPeaks)
+                break;
+
+            if (p1 <= p0)
+                continue;
+
+            float lo = peaks.mins[(size_t)p0];
+            float hi = peaks.maxs[(size_t)p0];
+
+            for (int64 p = p0 + 1; p < p1; ++p)
+            {
+                lo = juce::jmin(lo, peaks.mins[(size_t)p]);
+                hi = juce::jmax(hi, peaks.maxs[(size_t)p]);
+            }
+
+            addBar(x, lo, hi);
+        }
+    }
+
+    g.fillRectList(bars);
+}
+
+std::unique_ptr<WaveformPeakCache> WaveformPeakCache::createFromReader(juce::AudioFormatReader& reader,
+    const std::function<bool()>& shouldExit)
+{
+    auto cache = std::make_unique<WaveformPeakCache>();
+    cache->setSampleRate(reader.sampleRate > 0.0 ? reader.sampleRate : 44100.0);
+
+    const int   numChannels = juce::jmax(1, (int)reader.numChannels);
+    const int   blockSize = 65536;
+    const int64 totalSamples = reader.lengthInSamples;
+
+    juce::AudioBuffer<float> block(numChannels, blockSize);
+
+    for (int64 pos = 0; pos < totalSamples; pos += blockSize)
+    {
+        if (shouldExit != nullptr && shouldExit())
+            return nullptr;
+
+        const int n = (int)juce::jmin<int64>(blockSize, totalSamples - pos);
+
+        reader.read(&block, 0, n, pos, true, true);
+
+        // Mix down to mono
+        if (numChannels > 1)
+        {
+            for (int ch = 1; ch < numChannels; ++ch)
+                block.addFrom(0, 0, block, ch, 0, n);
+
+            block.applyGain(0, 0, n, 1.0f / (float)numChannels);
+        }
+
+        cache->appendSamples(block.getReadPointer(0), n);
+    }
+
+    return cache;
+}
+
+//==============================================================================
+// WaveformImageRenderer
+//==============================================================================
+
+WaveformImageRenderer::WaveformImageRenderer(juce::ThreadPool& poolToUse)
+    : pool(poolToUse)
+{
+}
+
+void WaveformImageRenderer::renderAsync(Request request, std::function<void(juce::Image)> onDone)
+{
+    pool.addJob([request = std::move(request), onDone = std::move(onDone)]
+        {
+            auto image = render(request);
+
+            juce::MessageManager::callAsync([image, onDone]
+                {
+                    onDone(image);
+                });
+        });
+}
+
+juce::Image WaveformImageRenderer::render(const Request& request)
+{
+    if (request.peaks == nullptr || request.width <= 0 || request.height <= 0)
+        return {};
+
+    juce::Image image(juce::Image::ARGB,
+        request.width,
+        request.height,
+        true,
+        juce::SoftwareImageType());
+
+    juce::Graphics g(image);
+    g.setColour(request.colour);
+    request.peaks->drawRange(g,
+        image.getBounds(),
+        request.startSample,
+        request.numSamples);
+
+    return image;
+}
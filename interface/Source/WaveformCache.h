@@ -0,0 +1,114 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// WaveformPeakCache: multi-resolution min/max peaks for one mono signal.
+//
+// Level 0 stores one min/max pair per 64 samples; every further level merges
+// 4 peaks of the level below. Drawing picks the coarsest level that still has
+// at least one peak per pixel, so the cost depends on the number of visible
+// pixels and not on how many samples the visible range covers.
+//==============================================================================
+
+class WaveformPeakCache
+{
+public:
+    // Reads mono samples [startSample, startSample + numSamples) into dest.
+    // Only used when zoomed in below one level-0 peak per pixel.
+    using RawSampleReader = std::function<void(juce::int64 startSample, int numSamples, float* dest)>;
+
+    static constexpr int samplesPerBasePeak = 64;
+    static constexpr int peaksPerParent = 4;
+    static constexpr int numLevels = 8;
+
+    WaveformPeakCache();
+
+    // clear()/appendSamples() may run while another thread is inside
+    // drawRange(); the peak levels are guarded by a read/write lock.
+    void clear();
+
+    // Streaming build: append the next block of mono samples.
+    void appendSamples(const float* samples, int numSamples);
+
+    // Same as appending numSamples zeros, without reading or scanning any:
+    // for the inactive runs of a take.
+    void appendSilence(juce::int64 numSamples);
+
+    juce::int64 getNumSamples() const noexcept { return numSamplesAdded.load(); }
+
+    // Bytes held by the peak levels
+    size_t getMemoryUsage() const;
+
+    void   setSampleRate(double newSampleRate) noexcept { sampleRate = newSampleRate; }
+    double getSampleRate() const noexcept { return sampleRate; }
+
+    void setRawSampleReader(RawSampleReader reader);
+
+    // Draws [startSample, startSample + numSamples) into area as one
+    // min/max bar per pixel, using the current Graphics colour.
+    void drawRange(juce::Graphics& g,
+        juce::Rectangle<int> area,
+        double startSample,
+        double numSamples) const;
+
+    // Builds a cache from a whole file (mixed to mono). Meant for a worker
+    // thread; returns nullptr if shouldExit() turned true while reading.
+    static std::unique_ptr<WaveformPeakCache> createFromReader(juce::AudioFormatReader& reader,
+        const std::function<bool()>& shouldExit);
+
+private:
+    struct Level
+    {
+        std::vector<float> mins;
+        std::vector<float> maxs;
+    };
+
+    static juce::int64 getSamplesPerPeak(int level) noexcept;
+    void updateParentLevels(int firstDirtyBasePeak);
+
+    Level levels[numLevels];
+    std::atomic<juce::int64> numSamplesAdded{ 0 };
+    double sampleRate = 44100.0;
+
+    RawSampleReader rawReader;
+    juce::ReadWriteLock peaksLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformPeakCache)
+};
+
+//==============================================================================
+// WaveformImageRenderer: rasterises peak ranges into images on a thread pool,
+// so components only composite a finished image on the message thread.
+//==============================================================================
+
+class WaveformImageRenderer
+{
+public:
+    struct Request
+    {
+        std::shared_ptr<const WaveformPeakCache> peaks;
+        double startSample = 0.0;
+        double numSamples = 0.0;
+        int    width = 0;       // physical pixels
+        int    height = 0;
+        juce::Colour colour;
+    };
+
+    explicit WaveformImageRenderer(juce::ThreadPool& poolToUse);
+
+    // Renders on the pool, then calls onDone with the image on the message thread.
+    void renderAsync(Request request, std::function<void(juce::Image)> onDone);
+
+    // Synchronous version (any thread). Uses a software image so it is safe off the message thread.
+    static juce::Image render(const Request& request);
+
+private:
+    juce::ThreadPool& pool;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformImageRenderer)
+};
@@ -0,0 +1,226 @@
+// FeatureKernels.cpp
+#include "FeatureKernels.h"
+#include "FrameSpectrum.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr double pi = 3.14159265358979323846;
+
+    constexpr double onsetCompression = 100.0;   // log(1 + C |X|)
+    constexpr double onsetDelta = 0.07;          // over the local mean, of the peak strength
+
+    int secondsToFrames(double seconds, double sampleRate)
+    {
+        return std::max(1, (int)std::ceil(seconds * sampleRate / FeatureKernels::hopLength));
+    }
+}
+
+namespace FeatureKernels
+{
+    //==============================================================================
+    // Fft
+    //==============================================================================
+
+    Fft::Fft(int fftSize)
+        : size(fftSize),
+          twiddles((size_t)fftSize / 2),
+          bitReversed((size_t)fftSize)
+    {
+        for (int i = 0; i < size / 2; ++i)
+            twiddles[(size_t)i] = std::polar(1.0, -2.0 * pi * (double)i / (double)size);
+
+        int bits = 0;
+        while ((1 << bits) < size)
+            ++bits;
+
+        for (int i = 0; i < size; ++i)
+        {
+            int r = 0;
+            for (int b = 0; b < bits; ++b)
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+
+            bitReversed[(size_t)i] = r;
+        }
+    }
+
+    void Fft::perform(std::complex<double>* data) const
+    {
+        for (int i = 0; i < size; ++i)
+            if (i < bitReversed[(size_t)i])
+                std::swap(data[i], data[bitReversed[(size_t)i]]);
+
+        for (int length = 2; length <= size; length *= 2)
+        {
+            const int half = length / 2;
+            const int step = size / length;
+
+            for (int start = 0; start < size; start += length)
+            {
+                for (int j = 0; j < half; ++j)
+                {
+                    const auto t = twiddles[(size_t)(j * step)] * data[start + j + half];
+                    data[start + j + half] = data[start + j] - t;
+                    data[start + j] += t;
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    // FrameSpectrum
+    //==============================================================================
+
+    FrameSpectrum::FrameSpectrum()
+    {
+        for (int i = 0; i < frameLength; ++i)
+            window[(size_t)i] = 0.5 - 0.5 * std::cos(2.0 * pi * (double)i / (double)frameLength);   // periodic, like scipy's
+    }
+
+    const std::vector<double>& FrameSpectrum::computePower(const float* frame)
+    {
+        for (int i = 0; i < frameLength; ++i)
+            data[(size_t)i] = { (double)frame[i] * window[(size_t)i], 0.0 };
+
+        fft.perform(data.data());
+
+        for (int k = 0; k < numBins; ++k)
+            power[(size_t)k] = std::norm(data[(size_t)k]);
+
+        return power;
+    }
+
+    //==============================================================================
+    // OnsetDetector
+    //==============================================================================
+
+    OnsetDetector::OnsetDetector(double rate)
+        : sampleRate(rate > 0.0 ? rate : 48000.0),
+          preMax(secondsToFrames(0.03, sampleRate)),
+          preAvg(secondsToFrames(0.10, sampleRate)),
+          postAvg(secondsToFrames(0.10, sampleRate)),
+          wait(secondsToFrames(0.03, sampleRate)),
+          spectrum(std::make_unique<FrameSpectrum>())
+    {
+        reset();
+    }
+
+    OnsetDetector::~OnsetDetector() = default;
+
+    void OnsetDetector::reset()
+    {
+        previousLog.clear();
+        currentLog.assign((size_t)FrameSpectrum::numBins, 0.0);
+        strength.clear();
+        onsets.clear();
+        peakStrength = 0.0;
+        numDecided = 0;
+        lastOnsetFrame = -1;
+        finished = false;
+
+        carry.assign((size_t)frameLength / 2, 0.0f);
+    }
+
+    void OnsetDetector::process(const float* samples, int numSamples)
+    {
+        if (samples != nullptr && numSamples > 0 && !finished)
+            push(samples, numSamples);
+    }
+
+    void OnsetDetector::finish()
+    {
+        if (finished)
+            return;
+
+        const std::vector<float> padding((size_t)frameLength / 2, 0.0f);
+        push(padding.data(), (int)padding.size());
+        finished = true;
+
+        while (numDecided < (int)strength.size())
+            decide(numDecided++);
+    }
+
+    void OnsetDetector::push(const float* samples, int numSamples)
+    {
+        carry.insert(carry.end(), samples, samples + numSamples);
+
+        size_t pos = 0;
+        while (carry.size() - pos >= (size_t)frameLength)
+        {
+            analyseFrame(carry.data() + pos);
+            pos += (size_t)hopLength;
+        }
+
+        carry.erase(carry.begin(), carry.begin() + (std::ptrdiff_t)pos);
+    }
+
+    void OnsetDetector::analyseFrame(const float* frame)
+    {
+        const auto& power = spectrum->computePower(frame);
+
+        for (int k = 0; k < FrameSpectrum::numBins; ++k)
+            currentLog[(size_t)k] = std::log1p(onsetCompression * std::sqrt(power[(size_t)k]));
+
+        // Rise in level summed over bins; the first frame has nothing to rise from
+        double flux = 0.0;
+
+        if (!previousLog.empty())
+            for (int k = 0; k < FrameSpectrum::numBins; ++k)
+                flux += std::max(0.0, currentLog[(size_t)k] - previousLog[(size_t)k]);
+
+        flux /= (double)FrameSpectrum::numBins;
+
+        std::swap(previousLog, currentLog);
+        if (currentLog.empty())
+            currentLog.assign((size_t)FrameSpectrum::numBins, 0.0);
+
+        strength.push_back(flux);
+        peakStrength = std::max(peakStrength, flux);
+
+        // A frame is decided as soon as postAvg frames after it exist, frame
+        // by frame, so the peak it is measured against is the same for any
+        // block size
+        if (numDecided + postAvg < (int)strength.size())
+            decide(numDecided++);
+    }
+
+    void OnsetDetector::decide(int frame)
+    {
+        const int n = (int)strength.size();
+        const double value = strength[(size_t)frame];
+
+        if (value <= 0.0 || (lastOnsetFrame >= 0 && frame - lastOnsetFrame <= wait))
+            return;
+
+        // Largest in the preMax frames before it
+        for (int i = std::max(0, frame - preMax); i < frame; ++i)
+            if (strength[(size_t)i] > value)
+                return;
+
+        // ...and clearly above the mean around it
+        const int first = std::max(0, frame - preAvg);
+        const int last = std::min(n - 1, frame + postAvg);
+
+        double sum = 0.0;
+        for (int i = first; i <= last; ++i)
+            sum += strength[(size_t)i];
+
+        const double localMean = sum / (double)(last - first + 1);
+
+        if (value < localMean + onsetDelta * peakStrength)
+            return;
+
+        onsets.push_back((double)frame * hopLength / sampleRate);
+        lastOnsetFrame = frame;
+    }
+
+    std::vector<double> onsetTimes(const float* samples, int numSamples, double sampleRate)
+    {
+        OnsetDetector detector(sampleRate);
+        detector.process(samples, numSamples);
+        detector.finish();
+        return detector.getOnsetTimes();
+    }
+}
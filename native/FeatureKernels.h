@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// FeatureKernels: the audio features of src/features.py in C++.
+//
+// This file and FeatureKernels.cpp are shared by the app (compiled in through
+// the .jucer) and the Python pipeline (the _featurekernels module built from
+// this directory), so both find the same onsets. The take scoring kernels
+// are in ScoringKernels.h; only the Python module builds those. No JUCE
+// here: plain C++17, so the module builds without the framework.
+//
+// Every kernel reproduces its numpy/librosa counterpart: the same framing
+// (2048-sample frames, hop 512, centred with zero padding), the same
+// percentiles, rounding and smoothing. Sums are taken in double, so results
+// agree with the Python versions to float precision, not bit for bit.
+//
+// The frame-based features have streaming versions (push any block size,
+// then finish()), so the app can feed them from a recording as it happens.
+// Microtiming takes its onsets from OnsetDetector; the beat tracking it
+// scores them against stays in librosa.
+//==============================================================================
+
+namespace FeatureKernels
+{
+    constexpr int frameLength = 2048;
+    constexpr int hopLength = 512;
+
+    struct FrameSpectrum;   // windowed FFT of one frame (FrameSpectrum.h)
+
+    // Spectral-flux onsets: the half-wave rectified rise of log-compressed
+    // magnitude from one frame to the next, averaged over bins, then peak
+    // picked against a local mean (librosa.onset.onset_detect's defaults:
+    // 30 ms maximum window, 100 ms mean window either side, 30 ms between
+    // onsets). The envelope is normalised by its maximum so far instead of
+    // the whole take's, so a frame is decided as soon as 100 ms past it is
+    // known. Results do not depend on the block sizes fed in. onset_times()
+    // in src/features.py repeats it in numpy for when the module is not built.
+    class OnsetDetector
+    {
+    public:
+        explicit OnsetDetector(double sampleRate);
+        ~OnsetDetector();
+
+        void reset();
+        void process(const float* samples, int numSamples);
+
+        // Pads the end and decides the last frames.
+        void finish();
+
+        // Onset times in seconds from the first sample, ascending
+        const std::vector<double>& getOnsetTimes() const noexcept { return onsets; }
+
+        // Flux per frame; frame t is centred on sample t * hopLength
+        const std::vector<double>& getStrength() const noexcept { return strength; }
+        double getFramesPerSecond() const noexcept { return sampleRate / hopLength; }
+
+    private:
+        void push(const float* samples, int numSamples);
+        void analyseFrame(const float* frame);
+        void decide(int frame);
+
+        const double sampleRate;
+        const int preMax, preAvg, postAvg, wait;   // in frames
+
+        std::unique_ptr<FrameSpectrum> spectrum;
+        std::vector<float> carry;
+        std::vector<double> previousLog, currentLog;
+
+        std::vector<double> strength;
+        std::vector<double> onsets;
+        double peakStrength = 0.0;
+        int    numDecided = 0;
+        int    lastOnsetFrame = -1;
+        bool   finished = false;
+    };
+
+    // Whole buffer: onset times in seconds
+    std::vector<double> onsetTimes(const float* samples, int numSamples, double sampleRate);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "FeatureKernels.h"
+
+#include <complex>
+#include <vector>
+
+//==============================================================================
+// The FFT behind the kernels. Internal to native/: FeatureKernels.cpp and
+// ScoringKernels.cpp include it; the app and the bindings do not.
+//==============================================================================
+
+namespace FeatureKernels
+{
+    // Forward, unscaled radix-2 FFT of a power-of-two size, in place
+    class Fft
+    {
+    public:
+        explicit Fft(int size);
+
+        int getSize() const noexcept { return size; }
+        void perform(std::complex<double>* data) const;
+
+    private:
+        const int size;
+        std::vector<std::complex<double>> twiddles;
+        std::vector<int> bitReversed;
+    };
+
+    // Power spectrum of one Hann-windowed frame
+    struct FrameSpectrum
+    {
+        FrameSpectrum();
+
+        // |X[k]|^2 for k in [0, numBins)
+        const std::vector<double>& computePower(const float* frame);
+
+        static constexpr int numBins = frameLength / 2 + 1;
+
+        const Fft fft { frameLength };
+        std::vector<double> window = std::vector<double>((size_t)frameLength);
+        std::vector<std::complex<double>> data = std::vector<std::complex<double>>((size_t)frameLength);
+        std::vector<double> power = std::vector<double>((size_t)numBins);
+    };
+}
@@ -0,0 +1,124 @@
+// PythonBindings.cpp
+// The _featurekernels module: FeatureKernels and ScoringKernels for src/features.py.
+#include "ScoringKernels.h"
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace py = pybind11;
+
+namespace
+{
+    // Contiguous float32 copies only where the caller's array is not one already
+    using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+    int checkedLength(const FloatArray& a)
+    {
+        if (a.ndim() != 1)
+            throw py::value_error("expected a 1-D array");
+
+        if (a.size() > (py::ssize_t)std::numeric_limits<int>::max())
+            throw py::value_error("array too long");
+
+        return (int)a.size();
+    }
+
+    py::dict toDict(const FeatureKernels::VibratoAnalysis& v)
+    {
+        // The keys and types of features.vibrato_analysis()
+        py::dict d;
+        d["frames_voiced"] = v.framesVoiced;
+        d["fps"] = v.fps;
+        d["peak_hz"] = v.peakHz;
+        d["depth_cents"] = v.depthCents;
+        d["rate_score"] = v.rateScore;
+        d["depth_score"] = v.depthScore;
+        d["vib_score"] = v.vibScore;
+        d["sustain_frames"] = v.sustainFrames;
+        d["sustain_pct"] = v.sustainPct;
+        d["sustain_segments"] = v.sustainSegments;
+        d["sustain_score"] = v.sustainScore;
+        d["vib_score_weighted"] = v.vibScoreWeighted;
+        return d;
+    }
+}
+
+PYBIND11_MODULE(_featurekernels, m)
+{
+    m.doc() = "Native take scoring features, shared with the app (see native/FeatureKernels.h)";
+
+    m.def("snr_simple", [](const FloatArray& y)
+        {
+            const int n = checkedLength(y);
+            py::gil_scoped_release release;
+            return FeatureKernels::snrSimple(y.data(), n);
+        }, py::arg("y"));
+
+    m.def("deesser_ratio", [](const FloatArray& y, double sr)
+        {
+            const int n = checkedLength(y);
+            py::gil_scoped_release release;
+            return FeatureKernels::deesserRatio(y.data(), n, sr);
+        }, py::arg("y"), py::arg("sr"));
+
+    m.def("clip_count", [](const FloatArray& y, float threshold)
+        {
+            const int n = checkedLength(y);
+            py::gil_scoped_release release;
+            return FeatureKernels::clipCount(y.data(), n, threshold);
+        }, py::arg("y"), py::arg("threshold") = 0.999f);
+
+    m.def("dyn_shape", [](const FloatArray& y)
+        {
+            const int n = checkedLength(y);
+            py::gil_scoped_release release;
+            return FeatureKernels::dynShape(y.data(), n);
+        }, py::arg("y"));
+
+    m.def("vibrato_stability", [](const FloatArray& f0, const FloatArray& pd, double sr16, int hop, float pdThresh)
+        {
+            const int n = checkedLength(f0);
+            if (checkedLength(pd) != n)
+                throw py::value_error("f0 and pd differ in length");
+
+            py::gil_scoped_release release;
+            return FeatureKernels::vibratoStability(f0.data(), pd.data(), n, sr16, hop, pdThresh);
+        }, py::arg("f0"), py::arg("pd"), py::arg("sr16") = 16000.0, py::arg("hop") = 256,
+        py::arg("pd_thresh") = 0.6f);
+
+    m.def("vibrato_analysis", [](const FloatArray& f0, const FloatArray& pd, double sr16, int hop, float pdThresh,
+        double sustainMinMs, double sustainSlopeCents)
+        {
+            const int n = checkedLength(f0);
+            if (checkedLength(pd) != n)
+                throw py::value_error("f0 and pd differ in length");
+
+            FeatureKernels::VibratoAnalysis result;
+            {
+                py::gil_scoped_release release;
+                result = FeatureKernels::vibratoAnalysis(f0.data(), pd.data(), n, sr16, hop, pdThresh,
+                    sustainMinMs, sustainSlopeCents);
+            }
+
+            return toDict(result);
+        }, py::arg("f0"), py::arg("pd"), py::arg("sr16") = 16000.0, py::arg("hop") = 256,
+        py::arg("pd_thresh") = 0.6f, py::arg("sustain_min_ms") = 250.0, py::arg("sustain_slope_cents") = 5.0);
+
+    m.def("onset_times", [](const FloatArray& y, double sr)
+        {
+            const int n = checkedLength(y);
+
+            std::vector<double> times;
+            {
+                py::gil_scoped_release release;
+                times = FeatureKernels::onsetTimes(y.data(), n, sr);
+            }
+
+            py::array_t<double> result((py::ssize_t)times.size());
+            std::copy(times.begin(), times.end(), result.mutable_data());
+            return result;
+        }, py::arg("y"), py::arg("sr"));
+}
@@ -0,0 +1,539 @@
+// ScoringKernels.cpp
+#include "ScoringKernels.h"
+#include "FrameSpectrum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+using int64 = std::int64_t;
+
+namespace
+{
+    constexpr double eps = 1.0e-9;   // EPS in features.py
+    constexpr double pi = 3.14159265358979323846;
+
+    // Python's round(): halves go to the even neighbour
+    int pyRound(double x) { return (int)std::nearbyint(x); }
+
+    double bandScore(double x, double low, double mid, double high)
+    {
+        if (x <= low || x >= high)
+            return 0.0;
+
+        if (x < mid)
+            return (x - low) / (mid - low + eps);
+
+        return (high - x) / (high - mid + eps);
+    }
+
+    // band_score with a floor, as _tri in vibrato_stability
+    double triangleScore(double x, double low, double mid, double high, double minimum)
+    {
+        if (x <= low || x >= high)
+            return minimum;
+
+        const double s = x < mid ? (x - low) / (mid - low + eps) : (high - x) / (high - mid + eps);
+        return std::max(s, minimum);
+    }
+
+    // np.percentile, linear interpolation
+    double percentile(std::vector<double> values, double q)
+    {
+        if (values.empty())
+            return 0.0;
+
+        std::sort(values.begin(), values.end());
+
+        const double index = q / 100.0 * (double)(values.size() - 1);
+        const size_t lo = (size_t)std::floor(index);
+        const size_t hi = std::min(lo + 1, values.size() - 1);
+
+        return values[lo] + (index - (double)lo) * (values[hi] - values[lo]);
+    }
+
+    double median(std::vector<double> values)
+    {
+        return percentile(std::move(values), 50.0);
+    }
+
+    double mean(const std::vector<double>& values)
+    {
+        if (values.empty())
+            return 0.0;
+
+        double sum = 0.0;
+        for (double v : values)
+            sum += v;
+
+        return sum / (double)values.size();
+    }
+
+    // np.std (population)
+    double standardDeviation(const std::vector<double>& values)
+    {
+        const double m = mean(values);
+
+        double sum = 0.0;
+        for (double v : values)
+            sum += (v - m) * (v - m);
+
+        return values.empty() ? 0.0 : std::sqrt(sum / (double)values.size());
+    }
+
+    // np.convolve(x, ones(width) / width, mode="same"), for width <= x.size()
+    std::vector<double> movingAverageSame(const std::vector<double>& x, int width)
+    {
+        const int n = (int)x.size();
+
+        std::vector<double> prefix((size_t)n + 1, 0.0);
+        for (int i = 0; i < n; ++i)
+            prefix[(size_t)i + 1] = prefix[(size_t)i] + x[(size_t)i];
+
+        std::vector<double> out((size_t)n);
+
+        for (int i = 0; i < n; ++i)
+        {
+            const int first = std::max(0, i - width / 2);
+            const int last = std::min(n - 1, i + (width - 1) / 2);
+            out[(size_t)i] = (prefix[(size_t)last + 1] - prefix[(size_t)first]) / (double)width;
+        }
+
+        return out;
+    }
+
+    // Strongest bin of np.fft.rfft(x) between lowHz and highHz (first one on
+    // a tie, like np.argmax). x is seldom a power of two long, so the DFT is
+    // taken as a chirp convolution (Bluestein) on the radix-2 Fft
+    double peakModulationHz(const std::vector<double>& x, double fps, double lowHz, double highHz, bool& found)
+    {
+        const int n = (int)x.size();
+        found = false;
+
+        if (n == 0)
+            return 0.0;
+
+        int size = 1;
+        while (size < 2 * n - 1)
+            size *= 2;
+
+        // exp(-i pi t^2 / n), with t^2 reduced mod 2n so the angle stays exact
+        std::vector<std::complex<double>> chirp((size_t)n);
+        for (int t = 0; t < n; ++t)
+            chirp[(size_t)t] = std::polar(1.0, -pi * (double)(((int64)t * t) % (2 * (int64)n)) / (double)n);
+
+        std::vector<std::complex<double>> a((size_t)size), b((size_t)size);
+
+        for (int t = 0; t < n; ++t)
+            a[(size_t)t] = x[(size_t)t] * chirp[(size_t)t];
+
+        b[0] = std::conj(chirp[0]);
+        for (int t = 1; t < n; ++t)
+            b[(size_t)t] = b[(size_t)(size - t)] = std::conj(chirp[(size_t)t]);
+
+        const FeatureKernels::Fft fft(size);
+        fft.perform(a.data());
+        fft.perform(b.data());
+
+        // Inverse transform as conj(FFT(conj)); |X[k]| is then |a[k]| / size
+        for (int i = 0; i < size; ++i)
+            a[(size_t)i] = std::conj(a[(size_t)i] * b[(size_t)i]);
+
+        fft.perform(a.data());
+
+        double bestMagnitude = -1.0;
+        double bestHz = 0.0;
+
+        for (int k = 0; k <= n / 2; ++k)
+        {
+            const double hz = (double)k * fps / (double)n;
+            if (hz < lowHz || hz > highHz)
+                continue;
+
+            const double magnitude = std::abs(a[(size_t)k]) / (double)size;
+
+            if (magnitude > bestMagnitude)
+            {
+                bestMagnitude = magnitude;
+                bestHz = hz;
+                found = true;
+            }
+        }
+
+        return bestHz;
+    }
+
+    double rootMeanSquare(const std::vector<double>& x)
+    {
+        double sum = 0.0;
+        for (double v : x)
+            sum += v * v;
+
+        return x.empty() ? 0.0 : std::sqrt(sum / (double)x.size());
+    }
+
+    // Four partial sums so the loop vectorises without reassociation flags
+    double sumOfSquares(const float* data, int numSamples)
+    {
+        double acc[4] = {};
+        int i = 0;
+
+        for (; i + 4 <= numSamples; i += 4)
+            for (int j = 0; j < 4; ++j)
+                acc[j] += (double)data[i + j] * (double)data[i + j];
+
+        double sum = acc[0] + acc[1] + acc[2] + acc[3];
+
+        for (; i < numSamples; ++i)
+            sum += (double)data[i] * (double)data[i];
+
+        return sum;
+    }
+
+    std::vector<double> voicedCents(const float* f0, const float* periodicity, int numFrames,
+        float threshold, bool clampMedian)
+    {
+        std::vector<double> voiced;
+
+        for (int i = 0; i < numFrames; ++i)
+            if (f0[i] > 0.0f && periodicity[i] >= threshold)
+                voiced.push_back((double)f0[i]);
+
+        if (voiced.empty())
+            return voiced;
+
+        // vibrato_stability guards the median; cents() guards both sides
+        const double reference = std::max(median(voiced), clampMedian ? 1.0e-6 : eps);
+
+        for (auto& v : voiced)
+            v = 1200.0 * std::log2(std::max(v, eps) / reference);
+
+        return voiced;
+    }
+}
+
+namespace FeatureKernels
+{
+    //==============================================================================
+    // Whole-buffer kernels
+    //==============================================================================
+
+    double snrSimple(const float* samples, int numSamples)
+    {
+        RmsFrames rms;
+        rms.process(samples, numSamples);
+        rms.finish();
+        return rms.getSnrDb();
+    }
+
+    double deesserRatio(const float* samples, int numSamples, double sampleRate)
+    {
+        SibilanceMeter meter(sampleRate);
+        meter.process(samples, numSamples);
+        meter.finish();
+        return meter.getRatio();
+    }
+
+    int64 clipCount(const float* samples, int numSamples, float threshold)
+    {
+        ClipCounter counter(threshold);
+        counter.process(samples, numSamples);
+        return counter.getCount();
+    }
+
+    double dynShape(const float* samples, int numSamples)
+    {
+        RmsFrames rms;
+        rms.process(samples, numSamples);
+        rms.finish();
+        return rms.getDynShape();
+    }
+
+    double vibratoStability(const float* f0, const float* periodicity, int numFrames,
+        double f0SampleRate, int f0Hop, float periodicityThreshold)
+    {
+        const double fps = f0SampleRate / (double)f0Hop;
+        const auto cents = voicedCents(f0, periodicity, numFrames, periodicityThreshold, true);
+
+        // ~0.25 s of voiced content at least
+        if ((int)cents.size() < std::max(16, (int)(0.25 * fps)))
+            return 0.0;
+
+        // Detrended with a ~200 ms moving average to keep the modulation only
+        const int width = std::max(3, pyRound(0.20 * fps));
+        const auto trend = movingAverageSame(cents, width);
+
+        std::vector<double> vib(cents.size());
+        for (size_t i = 0; i < cents.size(); ++i)
+            vib[i] = cents[i] - trend[i];
+
+        bool found = false;
+        const double peakHz = peakModulationHz(vib, fps, 3.0, 9.0, found);
+        if (!found)
+            return 0.0;
+
+        const double depthCents = std::min(150.0, rootMeanSquare(vib));
+
+        const double rateScore = triangleScore(peakHz, 3.5, 5.5, 8.0, 0.1);
+        const double depthScore = triangleScore(depthCents, 10.0, 45.0, 80.0, 0.1);
+
+        return 0.5 * rateScore + 0.5 * depthScore;
+    }
+
+    VibratoAnalysis vibratoAnalysis(const float* f0, const float* periodicity, int numFrames,
+        double f0SampleRate, int f0Hop, float periodicityThreshold,
+        double sustainMinMs, double sustainSlopeCents)
+    {
+        VibratoAnalysis out;
+        out.fps = f0SampleRate / (double)f0Hop;
+
+        const auto cents = voicedCents(f0, periodicity, numFrames, periodicityThreshold, false);
+        out.framesVoiced = (int)cents.size();
+
+        if (out.framesVoiced < 16)
+            return out;
+
+        // 1) Sustained runs: frame-to-frame change under the slope, long enough
+        const int n = (int)cents.size();
+        const int minSustainFrames = std::max(3, pyRound(sustainMinMs / 1000.0 * out.fps));
+
+        std::vector<bool> stable((size_t)n, false);
+        for (int i = 1; i < n; ++i)
+            stable[(size_t)i] = std::abs(cents[(size_t)i] - cents[(size_t)i - 1]) < sustainSlopeCents;
+        stable[0] = stable[1];
+
+        int longestStart = 0, longestLength = 0;
+
+        for (int i = 0; i < n;)
+        {
+            if (!stable[(size_t)i])
+            {
+                ++i;
+                continue;
+            }
+
+            const int start = i;
+            while (i < n && stable[(size_t)i])
+                ++i;
+
+            const int length = i - start;
+            if (length >= minSustainFrames)
+            {
+                out.sustainFrames += length;
+                ++out.sustainSegments;
+
+                if (length > longestLength)
+                {
+                    longestStart = start;
+                    longestLength = length;
+                }
+            }
+        }
+
+        out.sustainPct = (double)out.sustainFrames / (double)n;
+        out.sustainScore = bandScore(out.sustainPct, 0.1, 0.4, 0.8);
+
+        // 2) Detrended modulation, on the longest sustained run if there is one
+        const int width = std::max(3, pyRound(0.20 * out.fps));
+        const auto trend = movingAverageSame(cents, width);
+
+        std::vector<double> vib;
+        const int first = longestLength > 0 ? longestStart : 0;
+        const int count = longestLength > 0 ? longestLength : n;
+
+        for (int i = first; i < first + count; ++i)
+            vib.push_back(cents[(size_t)i] - trend[(size_t)i]);
+
+        if ((int)vib.size() < 16)
+            return out;
+
+        bool found = false;
+        const double peakHz = peakModulationHz(vib, out.fps, 3.0, 9.0, found);
+        if (!found)
+            return out;
+
+        out.peakHz = peakHz;
+        out.depthCents = rootMeanSquare(vib);
+        out.rateScore = bandScore(out.peakHz, 4.0, 5.5, 7.5);
+        out.depthScore = bandScore(out.depthCents, 10.0, 45.0, 100.0);
+        out.vibScore = out.rateScore * out.depthScore;
+        out.vibScoreWeighted = out.vibScore * out.sustainScore;
+        return out;
+    }
+
+    //==============================================================================
+    // RmsFrames
+    //==============================================================================
+
+    RmsFrames::RmsFrames()
+    {
+        reset();
+    }
+
+    void RmsFrames::reset()
+    {
+        std::fill(std::begin(hopSums), std::end(hopSums), 0.0);
+        numHops = 0;
+        hopSum = 0.0;
+        hopFill = 0;
+        frames.clear();
+
+        // Centred frames: the first one starts half a frame before sample 0
+        const std::vector<float> padding((size_t)frameLength / 2, 0.0f);
+        push(padding.data(), (int)padding.size());
+    }
+
+    void RmsFrames::process(const float* samples, int numSamples)
+    {
+        if (samples != nullptr && numSamples > 0)
+            push(samples, numSamples);
+    }
+
+    void RmsFrames::finish()
+    {
+        const std::vector<float> padding((size_t)frameLength / 2, 0.0f);
+        push(padding.data(), (int)padding.size());
+    }
+
+    void RmsFrames::push(const float* samples, int numSamples)
+    {
+        static_assert(frameLength == 4 * hopLength, "a frame is four hops");
+
+        int pos = 0;
+        while (pos < numSamples)
+        {
+            const int n = std::min(hopLength - hopFill, numSamples - pos);
+
+            hopSum += sumOfSquares(samples + pos, n);
+            hopFill += n;
+            pos += n;
+
+            if (hopFill == hopLength)
+            {
+                hopSums[numHops % 4] = hopSum;
+                ++numHops;
+                hopSum = 0.0;
+                hopFill = 0;
+
+                if (numHops >= 4)
+                {
+                    const double power = (hopSums[0] + hopSums[1] + hopSums[2] + hopSums[3]) / frameLength;
+                    frames.push_back(std::sqrt(power));
+                }
+            }
+        }
+    }
+
+    double RmsFrames::getSnrDb() const
+    {
+        const double noise = percentile(frames, 10.0);
+        const double signal = percentile(frames, 90.0);
+        return 20.0 * std::log10((signal + eps) / (noise + eps));
+    }
+
+    double RmsFrames::getDynShape() const
+    {
+        auto smoothed = frames;
+
+        const int width = std::max(3, pyRound(0.10 * (double)frames.size()));
+        if (width > 3)
+            smoothed = movingAverageSame(frames, width);
+
+        for (auto& v : smoothed)
+            v = 20.0 * std::log10(v + eps);
+
+        // Around 4 dB of spread is preferred
+        return bandScore(standardDeviation(smoothed), 1.0, 4.0, 10.0);
+    }
+
+    //==============================================================================
+    // SibilanceMeter
+    //==============================================================================
+
+    SibilanceMeter::SibilanceMeter(double rate)
+        : sampleRate(rate > 0.0 ? rate : 48000.0),
+          spectrum(std::make_unique<FrameSpectrum>())
+    {
+        reset();
+    }
+
+    SibilanceMeter::~SibilanceMeter() = default;
+
+    void SibilanceMeter::reset()
+    {
+        highSum = midSum = 0.0;
+        highCount = midCount = 0;
+
+        // Centred frames, as in RmsFrames
+        carry.assign((size_t)frameLength / 2, 0.0f);
+    }
+
+    void SibilanceMeter::process(const float* samples, int numSamples)
+    {
+        if (samples != nullptr && numSamples > 0)
+            push(samples, numSamples);
+    }
+
+    void SibilanceMeter::finish()
+    {
+        const std::vector<float> padding((size_t)frameLength / 2, 0.0f);
+        push(padding.data(), (int)padding.size());
+    }
+
+    void SibilanceMeter::push(const float* samples, int numSamples)
+    {
+        carry.insert(carry.end(), samples, samples + numSamples);
+
+        size_t pos = 0;
+        while (carry.size() - pos >= (size_t)frameLength)
+        {
+            analyseFrame(carry.data() + pos);
+            pos += (size_t)hopLength;
+        }
+
+        carry.erase(carry.begin(), carry.begin() + (std::ptrdiff_t)pos);
+    }
+
+    void SibilanceMeter::analyseFrame(const float* frame)
+    {
+        const auto& power = spectrum->computePower(frame);
+
+        for (int k = 0; k < FrameSpectrum::numBins; ++k)
+        {
+            const double hz = (double)k * sampleRate / (double)frameLength;
+
+            if (hz >= 5000.0 && hz <= 10000.0)
+            {
+                highSum += power[(size_t)k];
+                ++highCount;
+            }
+
+            if (hz >= 1000.0 && hz <= 5000.0)
+            {
+                midSum += power[(size_t)k];
+                ++midCount;
+            }
+        }
+    }
+
+    double SibilanceMeter::getRatio() const
+    {
+        const double high = highCount > 0 ? highSum / (double)highCount : 0.0;
+        const double mid = midCount > 0 ? midSum / (double)midCount : 0.0;
+        return high / (mid + eps);
+    }
+
+    //==============================================================================
+    // ClipCounter
+    //==============================================================================
+
+    void ClipCounter::process(const float* samples, int numSamples) noexcept
+    {
+        // Branch-free so it vectorises
+        int64 n = 0;
+        for (int i = 0; i < numSamples; ++i)
+            n += std::abs(samples[i]) >= threshold ? 1 : 0;
+
+        count += n;
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "FeatureKernels.h"
+
+//==============================================================================
+// ScoringKernels: the take scoring features of src/features.py (snr_simple,
+// deesser_ratio, clip_count, dyn_shape, vibrato) in C++.
+//
+// Python-only: native/CMakeLists.txt builds them into the _featurekernels
+// module, and the .jucer does not compile ScoringKernels.cpp. The app
+// scores nothing itself; it runs the pipeline.
+//==============================================================================
+
+namespace FeatureKernels
+{
+    //==============================================================================
+    // Whole-buffer kernels, as in src/features.py
+
+    // snr_simple: 90th over 10th percentile of frame RMS, in dB
+    double snrSimple(const float* samples, int numSamples);
+
+    // deesser_ratio: mean STFT power 5-10 kHz over 1-5 kHz
+    double deesserRatio(const float* samples, int numSamples, double sampleRate);
+
+    // clip_count: samples with |x| >= threshold
+    std::int64_t clipCount(const float* samples, int numSamples, float threshold = 0.999f);
+
+    // dyn_shape: band score of the spread of smoothed frame RMS in dB
+    double dynShape(const float* samples, int numSamples);
+
+    // vibrato_stability: score in [0, 1] of the f0 modulation of voiced frames
+    double vibratoStability(const float* f0, const float* periodicity, int numFrames,
+        double f0SampleRate = 16000.0, int f0Hop = 256, float periodicityThreshold = 0.6f);
+
+    // vibrato_analysis: the same on the longest sustained run, with its details
+    struct VibratoAnalysis
+    {
+        int    framesVoiced = 0;
+        double fps = 0.0;
+        double peakHz = 0.0;
+        double depthCents = 0.0;
+        double rateScore = 0.0;
+        double depthScore = 0.0;
+        double vibScore = 0.0;
+        int    sustainFrames = 0;
+        double sustainPct = 0.0;
+        int    sustainSegments = 0;
+        double sustainScore = 0.0;
+        double vibScoreWeighted = 0.0;
+    };
+
+    VibratoAnalysis vibratoAnalysis(const float* f0, const float* periodicity, int numFrames,
+        double f0SampleRate = 16000.0, int f0Hop = 256, float periodicityThreshold = 0.6f,
+        double sustainMinMs = 250.0, double sustainSlopeCents = 5.0);
+
+    //==============================================================================
+    // Streaming versions
+
+    // librosa.feature.rms(frame_length=2048, hop_length=512), one block at a time
+    class RmsFrames
+    {
+    public:
+        RmsFrames();
+
+        void reset();
+        void process(const float* samples, int numSamples);
+
+        // Pads the end like librosa; no more samples after this.
+        void finish();
+
+        const std::vector<double>& getFrames() const noexcept { return frames; }
+
+        // snr_simple and dyn_shape of everything processed so far (call finish() first)
+        double getSnrDb() const;
+        double getDynShape() const;
+
+    private:
+        void push(const float* samples, int numSamples);
+
+        // A frame is 4 hops, so each hop's sum of squares is taken once and
+        // every frame adds up the last four
+        double hopSums[4] = {};
+        std::int64_t numHops = 0;
+        double hopSum = 0.0;
+        int    hopFill = 0;
+
+        std::vector<double> frames;
+    };
+
+    // The two band powers of deesserRatio, one block at a time
+    class SibilanceMeter
+    {
+    public:
+        explicit SibilanceMeter(double sampleRate);
+        ~SibilanceMeter();
+
+        void reset();
+        void process(const float* samples, int numSamples);
+        void finish();
+
+        double getRatio() const;
+
+    private:
+        void push(const float* samples, int numSamples);
+        void analyseFrame(const float* frame);
+
+        const double sampleRate;
+        std::unique_ptr<FrameSpectrum> spectrum;
+        std::vector<float> carry;   // samples not yet past the last frame
+
+        double highSum = 0.0, midSum = 0.0;
+        std::int64_t highCount = 0, midCount = 0;
+    };
+
+    // clip_count, one block at a time
+    class ClipCounter
+    {
+    public:
+        explicit ClipCounter(float clipThreshold = 0.999f) : threshold(clipThreshold) {}
+
+        void reset() noexcept { count = 0; }
+        void process(const float* samples, int numSamples) noexcept;
+
+        std::int64_t getCount() const noexcept { return count; }
+
+    private:
+        const float threshold;
+        std::int64_t count = 0;
+    };
+}
@@ -0,0 +1,192 @@
+# src/alignment.py
+# Cross-correlation alignment of takes against the reference take.
+#
+# Singers drift against the loop, so the same segment boundary can land on
+# slightly different material in every take. We estimate, per take and per
+# segment, how late (positive) or early (negative) the take is compared to
+# the reference, so scoring and stitching read the matching audio.
+#
+# Approach:
+#   - Reduce every take to a 1 kHz log-energy envelope (cheap, phase-free,
+#     robust to different vowels/timbre between performances).
+#   - Whole-take offset: one batched FFT cross-correlation of all takes
+#     against the reference, within +/- max_take_shift_s.
+#   - Per-segment offset: short windows around every reference segment,
+#     searched within +/- max_segment_shift_s around the take offset,
+#     all (take, segment) pairs in a single batched FFT.
+#   - Normalised correlation peak + parabolic interpolation; weak peaks
+#     (silence, very different phrasing) fall back to the take offset.
+
+import numpy as np
+
+ENV_RATE_HZ = 1000.0       # envelope frames per second (1 ms resolution)
+ENV_FLOOR = 1e-6           # energy floor (~ -60 dB) before log
+
+
+def _envelope(y, sr):
+    """Log-energy envelope at ENV_RATE_HZ. Returns (env, hop_samples)."""
+    hop = max(1, int(round(sr / ENV_RATE_HZ)))
+    n = len(y) // hop
+    if n <= 0:
+        return np.zeros(0, dtype=np.float32), hop
+
+    frames = np.asarray(y[: n * hop], dtype=np.float32).reshape(n, hop)
+    energy = np.mean(frames * frames, axis=1)
+    return np.log(energy + ENV_FLOOR).astype(np.float32), hop
+
+
+def _window(env, start, stop):
+    """env[start:stop], padded with the silence floor outside the take."""
+    out = np.full(stop - start, np.log(ENV_FLOOR), dtype=np.float32)
+    a = max(start, 0)
+    b = min(stop, len(env))
+    if b > a:
+        out[a - start: b - start] = env[a:b]
+    return out
+
+
+def _best_lags(ref_windows, target_windows, max_lag):
+    """
+    Batched normalised cross-correlation.
+
+    ref_windows[i] has length w_i; target_windows[i] has length w_i + 2*max_lag
+    and starts max_lag frames before the reference window.
+
+    Returns (lags, confidence): lag in frames (float, parabolic-refined) with
+    target[t + lag] ~ ref[t], and the normalised correlation at the peak.
+    """
+    num = len(ref_windows)
+    widths = np.array([len(r) for r in ref_windows], dtype=np.int64)
+    num_lags = 2 * max_lag + 1
+
+    w_max = int(widths.max())
+    n_fft = 1 << int(np.ceil(np.log2(w_max + 2 * max_lag + 1)))
+
+    refs = np.zeros((num, n_fft), dtype=np.float32)
+    targets = np.zeros((num, n_fft), dtype=np.float32)
+
+    for i, (r, x) in enumerate(zip(ref_windows, target_windows)):
+        # Zero-mean each window; taper the reference so its edges don't dominate
+        r = (r - r.mean()) * np.hanning(len(r)).astype(np.float32)
+        refs[i, : len(r)] = r
+        targets[i, : len(x)] = x - x.mean()
+
+    spec = np.conj(np.fft.rfft(refs, axis=1)) * np.fft.rfft(targets, axis=1)
+    corr = np.fft.irfft(spec, n=n_fft, axis=1)[:, :num_lags]
+
+    # Energy of the target under the reference at every lag
+    cum = np.concatenate(
+        [np.zeros((num, 1), dtype=np.float64), np.cumsum(targets.astype(np.float64) ** 2, axis=1)],
+        axis=1,
+    )
+    lag_idx = np.arange(num_lags)[None, :]
+    target_energy = (
+        np.take_along_axis(cum, lag_idx + widths[:, None], axis=1)
+        - cum[:, :num_lags]
+    )
+    ref_energy = np.sum(refs.astype(np.float64) ** 2, axis=1, keepdims=True)
+
+    ncc = corr / np.sqrt(ref_energy * target_energy + 1e-12)
+
+    peak = np.argmax(ncc, axis=1)
+    rows = np.arange(num)
+    confidence = ncc[rows, peak]
+
+    # Parabolic interpolation around interior peaks
+    inner = (peak > 0) & (peak < num_lags - 1)
+    left = ncc[rows, np.clip(peak - 1, 0, num_lags - 1)]
+    right = ncc[rows, np.clip(peak + 1, 0, num_lags - 1)]
+    denom = left - 2.0 * confidence + right
+    denom = np.where(inner & (np.abs(denom) > 1e-12), denom, np.inf)
+    delta = 0.5 * (left - right) / denom
+
+    lags = peak.astype(np.float64) - max_lag + np.clip(delta, -0.5, 0.5)
+    return lags, confidence.astype(np.float64)
+
+
+def align_takes(
+    ref_y,
+    takes_y,
+    sr,
+    segments,
+    max_take_shift_s=0.25,
+    max_segment_shift_s=0.06,
+    segment_pad_s=0.10,
+    min_confidence=0.4,
+):
+    """
+    Estimate time offsets of each take against the reference.
+
+    Args:
+      ref_y (np.ndarray): reference take (mono).
+      takes_y (list[np.ndarray]): all takes (mono, same sr); may include ref_y.
+      sr (int): sample rate.
+      segments (list[(start_s, end_s)]): reference segment grid.
+      max_take_shift_s (float): search range for the whole-take offset.
+      max_segment_shift_s (float): search range per segment, around the take offset.
+      segment_pad_s (float): context added on both sides of each segment window.
+      min_confidence (float): normalised correlation below which an estimate
+        is discarded (take -> 0, segment -> take offset).
+
+    Returns:
+      take_offsets (np.ndarray, shape [n_takes]) in seconds,
+      segment_offsets (np.ndarray, shape [n_takes, n_segments]) in seconds.
+      A positive offset means the take's material arrives later than the
+      reference: reference time t matches take time t + offset.
+    """
+    n_takes = len(takes_y)
+    n_segs = len(segments)
+
+    take_offsets = np.zeros(n_takes, dtype=np.float64)
+    segment_offsets = np.zeros((n_takes, n_segs), dtype=np.float64)
+
+    ref_env, hop = _envelope(ref_y, sr)
+    if n_takes == 0 or len(ref_env) < 2:
+        return take_offsets, segment_offsets
+
+    frame_s = hop / float(sr)
+    envs = [_envelope(y, sr)[0] for y in takes_y]
+
+    # Whole-take offsets
+    max_take_lag = max(1, int(round(max_take_shift_s / frame_s)))
+    n_ref = len(ref_env)
+
+    lags, conf = _best_lags(
+        [ref_env] * n_takes,
+        [_window(env, -max_take_lag, n_ref + max_take_lag) for env in envs],
+        max_take_lag,
+    )
+    take_lags = np.where(conf >= min_confidence, lags, 0.0)
+    take_offsets = take_lags * frame_s
+
+    if n_segs == 0:
+        return take_offsets, segment_offsets
+
+    # Per-segment offsets, searched around each take's offset
+    max_seg_lag = max(1, int(round(max_segment_shift_s / frame_s)))
+    pad = int(round(segment_pad_s / frame_s))
+
+    ref_windows = []
+    target_windows = []
+    base_lags = []
+
+    for t in range(n_takes):
+        base = int(round(take_lags[t]))
+        for s, e in segments:
+            a = max(0, int(np.floor(float(s) / frame_s)) - pad)
+            b = min(n_ref, int(np.ceil(float(e) / frame_s)) + pad)
+            if b - a < 2:
+                a, b = 0, n_ref
+
+            ref_windows.append(ref_env[a:b])
+            target_windows.append(_window(envs[t], a + base - max_seg_lag, b + base + max_seg_lag))
+            base_lags.append(base)
+
+    lags, conf = _best_lags(ref_windows, target_windows, max_seg_lag)
+    seg_lags = np.asarray(base_lags, dtype=np.float64) + lags
+
+    fallback = np.repeat(take_lags, n_segs)
+    seg_lags = np.where(conf >= min_confidence, seg_lags, fallback)
+    segment_offsets = (seg_lags * frame_s).reshape(n_takes, n_segs)
+
+    return take_offsets, segment_offsets
@@ -5,10 +5,14 @@
 #   1) For a selected phrase (e.g. "singer01/phrase02"), and given alpha% + BPM:
 #       - Load all takes.
 #       - Compute whole-phrase Accuracy/Emotion scores per take.
+#       - Apply each take's loudness gain (<take>.loudness.json, if present).
 #       - Pick the best overall take as reference.
 #   2) Segment the reference take into sub-phrase chunks.
-#   3) For each take and each segment:
-#       - Compute Accuracy/Emotion features on that segment.
+#      Estimate per-take / per-segment time offsets against the reference
+#      (src/alignment.py) so every take is cut where its own words are.
+#   3) For each take and each segment (spread over a process pool that shares
+#      the take audio/f0 read-only; rows come back in the sequential order):
+#       - Compute Accuracy/Emotion features on that (offset) segment.
 #       - Compute final blended score.
 #   4) Write:
 #       - features-<singer>-<phrase>-<alpha>.csv     (whole-take scores)
@@ -16,10 +20,13 @@
 #       - compmap-<singer>-<phrase>-<alpha>.json    (winner + candidates per segment)
 
 import argparse
+import contextlib
 import glob
 import json
+import multiprocessing as mp
 import os
 import re
+from multiprocessing import shared_memory
 from pathlib import Path
 
 import numpy as np
@@ -27,10 +34,12 @@ import pandas as pds
 import yaml
 
 
-from src.io import load_wav
+from src.io import load_wav, load_take_gain_db, load_take_clips, load_take_activity, load_take_onsets
 from src.segmentation import one_phrase, segment_phrase_reference
+from src.alignment import align_takes
 from src.features import (
     f0_crepe_16k,
+    f0_crepe_16k_active,
     pitch_rmse_vs_median,
     snr_simple,
     deesser_ratio,
@@ -40,6 +49,7 @@ from src.features import (
     vibrato_stability,
     dyn_shape,
     microtiming,
+    onset_times,
     vibrato_analysis,
     microtiming_analysis,
 )
@@ -142,6 +152,24 @@ def _load_cfg(cfg_path_str):
     return cfg
 
 
+def _clip_n(y_seg, gain, clips, s, e, sr):
+    """Clipped samples in [s, e). Uses the clip runs the app measured on the live
+    input when the take has them (exact, before the 16-bit file), else scans the
+    audio at its recorded level."""
+    if clips is None:
+        return clip_count(y_seg / gain)
+    return int(round(sum(max(0.0, min(ce, e) - max(cs, s)) for cs, ce in clips) * sr))
+
+
+def _onsets_in(onsets, s, e, sr):
+    """The take's onsets inside y[int(s * sr): int(e * sr)], in seconds from
+    the start of that slice (what microtiming() expects)."""
+    s0 = int(s * sr) / float(sr)
+    e0 = int(e * sr) / float(sr)
+    lo, hi = np.searchsorted(onsets, [s0, e0], side="left")
+    return onsets[lo:hi] - s0
+
+
 def _map_f0_to_times(f0, y_len, sr):
     """
     Approximate time stamp per F0 frame by evenly spreading frames
@@ -154,6 +182,201 @@ def _map_f0_to_times(f0, y_len, sr):
     # frames from [0, dur) with equal spacing
     return np.linspace(0.0, dur, num=n, endpoint=False, dtype=np.float32)
 
+
+# -------------------- pass 2 worker pool --------------------
+#
+# Pass 2 scores every (take, segment) unit on its own, so the units are spread
+# over a process pool. The take arrays (audio, f0, periodicity, f0 times,
+# onsets) are copied once into a shared-memory block that every worker maps
+# read-only; a unit only carries its two indices. Results come back in unit
+# order, which is the order of the old nested loop, so the rows (and the
+# debug output) are identical to a sequential run.
+
+_PASS2 = None  # per-process: the pass 2 context, with the take arrays attached
+_UNITS_PER_WORKER = 8  # "workers: 0" starts at most one worker per this many units
+
+
+def _share_arrays(arrays):
+    """Copy [(key, array), ...] into one shared-memory block.
+    Returns (shm, layout) with layout = [(key, offset, dtype, shape), ...]."""
+    layout = []
+    offset = 0
+    for key, a in arrays:
+        a = np.asarray(a)
+        offset = (offset + 63) // 64 * 64
+        layout.append((key, offset, a.dtype.str, a.shape))
+        offset += a.nbytes
+
+    shm = shared_memory.SharedMemory(create=True, size=max(offset, 1))
+    for (key, off, dtype, shape), (_, a) in zip(layout, arrays):
+        np.ndarray(shape, dtype=dtype, buffer=shm.buf, offset=off)[...] = a
+    return shm, layout
+
+
+def _attach_arrays(shm, layout):
+    """Read-only views of the arrays in a block made by _share_arrays()."""
+    views = {}
+    for key, off, dtype, shape in layout:
+        v = np.ndarray(shape, dtype=dtype, buffer=shm.buf, offset=off)
+        v.flags.writeable = False
+        views[key] = v
+    return views
+
+
+def _with_take_arrays(ctx, views):
+    """ctx with each take's arrays (keyed (take_i, name) in views) put in."""
+    return dict(ctx, takes=[
+        dict(t, **{name: views[(take_i, name)] for name in ("y", "f0", "pd", "f0_times", "onsets")})
+        for take_i, t in enumerate(ctx["takes"])
+    ])
+
+
+def _pass2_init(ctx, shm_name, layout):
+    """Pool initializer: map the shared take arrays into this worker."""
+    global _PASS2
+    shm = shared_memory.SharedMemory(name=shm_name)
+    _PASS2 = _with_take_arrays(ctx, _attach_arrays(shm, layout))
+    _PASS2["shm"] = shm  # keeps the mapping alive for the worker's lifetime
+
+
+@contextlib.contextmanager
+def _single_threaded_workers():
+    """Workers started inside this block run their numeric libraries on one
+    thread each; the pool supplies the parallelism."""
+    keys = ("OMP_NUM_THREADS", "OPENBLAS_NUM_THREADS", "MKL_NUM_THREADS", "NUMBA_NUM_THREADS")
+    saved = {k: os.environ.get(k) for k in keys}
+    os.environ.update({k: "1" for k in keys})
+    try:
+        yield
+    finally:
+        for k, v in saved.items():
+            if v is None:
+                os.environ.pop(k, None)
+            else:
+                os.environ[k] = v
+
+
+def _score_units(units, ctx, arrays, workers):
+    """Score units [(take_i, seg_idx), ...]; yields (row or None, debug text or
+    None) per unit, in order."""
+    global _PASS2
+    if workers <= 1:
+        # In this process, on the arrays as they are
+        _PASS2 = _with_take_arrays(ctx, dict(arrays))
+        try:
+            for unit in units:
+                yield _score_unit(unit)
+        finally:
+            _PASS2 = None
+        return
+
+    shm, layout = _share_arrays(arrays)
+    try:
+        # spawn: no torch/OpenMP state forked into the workers, same on every OS
+        with _single_threaded_workers():
+            pool = mp.get_context("spawn").Pool(
+                workers, initializer=_pass2_init, initargs=(ctx, shm.name, layout)
+            )
+        with pool:
+            chunksize = max(1, len(units) // (workers * 4))
+            yield from pool.imap(_score_unit, units, chunksize=chunksize)
+    finally:
+        shm.close()
+        shm.unlink()
+
+
+def _score_unit(unit):
+    """Accuracy/Emotion features and scores of one take on one segment."""
+    take_i, seg_idx = unit
+    ctx = _PASS2
+    take = ctx["takes"][take_i]
+    s, e = ctx["segments"][seg_idx]
+
+    take_id = take["take_id"]
+    y = take["y"]
+    sr = take["sr"]
+    f0 = take["f0"]
+    pd = take["pd"]
+    f0_times = take["f0_times"]
+
+    dur = len(y) / float(sr)
+
+    # Safety clamp to phrase duration (reference grid)
+    s_clamp = max(0.0, min(float(s), dur))
+    e_clamp = max(0.0, min(float(e), dur))
+    if e_clamp <= s_clamp:
+        return None, None
+
+    # Same words in this take: shift by its alignment offset
+    offset_s = float(ctx["segment_offsets"][take_i, seg_idx])
+    s_take = max(0.0, min(s_clamp + offset_s, dur))
+    e_take = max(0.0, min(e_clamp + offset_s, dur))
+    if e_take <= s_take:
+        return None, None
+
+    y_seg = y[int(s_take * sr): int(e_take * sr)]
+    if len(y_seg) <= 0:
+        return None, None
+    onsets_seg = _onsets_in(take["onsets"], s_take, e_take, sr)
+
+    # F0/Pd inside this segment
+    if len(f0_times) > 0:
+        mask = (f0_times >= s_take) & (f0_times <= e_take)
+        f0_seg = f0[mask]
+        pd_seg = pd[mask]
+    else:
+        f0_seg = np.asarray([], dtype=np.float32)
+        pd_seg = np.asarray([], dtype=np.float32)
+
+    # Accuracy features on segment
+    row = {
+        "phrase": ctx["phrase_name"],
+        "take": take_id,
+        "segment_idx": seg_idx,
+        "seg_start_s": s_clamp,
+        "seg_end_s": e_clamp,
+        "offset_s": offset_s,
+        "f0_rmse_c": pitch_rmse_vs_median(f0_seg, pd_seg),
+        "voiced_ratio": voiced_ratio(pd_seg),
+        "mean_periodicity": mean_periodicity(pd_seg),
+        "snr_db": snr_simple(y_seg),
+        "deess_ratio": deesser_ratio(y_seg, sr),
+        "clip_n": _clip_n(y_seg, take["gain"], take["clips"], s_take, e_take, sr),
+    }
+
+    n = norm_block(row)
+    row["acc_score"] = accuracy_score(n, weights=ctx["weights_acc"])
+
+    # Emotion features on segment
+    row["vibrato_stability"] = vibrato_stability(
+        f0_seg, pd_seg, sr16=take["sr_f0"], hop=256, pd_thresh=0.6
+    )
+    row["dyn_shape"] = dyn_shape(y_seg, sr)
+    row["microtiming"] = microtiming(y_seg, sr, onsets=onsets_seg)
+    row["emo_score"] = emotion_score(row, weights=ctx["weights_emo"])
+
+    row["alpha"] = ctx["alpha"]
+    row["final_score"] = final_blend(row["acc_score"], row["emo_score"], ctx["alpha"])
+
+    debug_text = None
+    if ctx["debug_emotion"]:
+        vib_dbg = vibrato_analysis(
+            f0_seg, pd_seg, sr16=take["sr_f0"], hop=256, pd_thresh=0.6
+        )
+        mt_dbg = microtiming_analysis(y_seg, sr, onsets=onsets_seg)
+        debug_text = "\n".join([
+            f"[DEBUG] take={take_id}, seg_idx={seg_idx}",
+            f"  Vibrato: frames_voiced={vib_dbg['frames_voiced']}, "
+            f"peak_hz={vib_dbg['peak_hz']:.2f}, depth_cents={vib_dbg['depth_cents']:.1f}, "
+            f"rate_score={vib_dbg['rate_score']:.2f}, depth_score={vib_dbg['depth_score']:.2f}, "
+            f"vib_score={vib_dbg['vib_score']:.2f}",
+            f"  Microtiming: tempo={mt_dbg['tempo']:.1f}, n_onsets={mt_dbg['n_onsets']}, "
+            f"n_beats={mt_dbg['n_beats']}, jitter_ms={mt_dbg['jitter_ms']}, "
+            f"jt_score={mt_dbg['jt_score']:.2f}, note={mt_dbg['note']}",
+        ])
+
+    return row, debug_text
+
 def run_feature_extraction(
     base,
     select,
@@ -163,6 +386,7 @@ def run_feature_extraction(
     out_dir="outputs",
     debug_emotion=False,
     explicit_compmap_path=None,
+    workers=None,
 ):
 
     """
@@ -193,6 +417,12 @@ def run_feature_extraction(
     explicit_compmap_path (str or Path, optional):
         If given, compmap JSON will be written exactly to this path
         instead of the default scoring-*/compmap-*.json.
+
+    workers (int, optional):
+        Processes scoring pass 2's take/segment units; 1 = sequential in this
+        process, 0 = one per core but at most one per 8 units. Defaults to the
+        config's "workers" (sequential if unset). The output is the same for
+        any number.
     """
     base_str = str(base)
     out_dir_str = str(out_dir)
@@ -212,6 +442,9 @@ def run_feature_extraction(
     diversity_delta = float(cfg.get("diversity_delta", 0.07))
     top_k = int(cfg.get("top_k", 3))
 
+    # Take alignment search ranges (seconds)
+    align_cfg = cfg.get("alignment", {}) or {}
+
     # Selection (phrase directory)
     select_str = str(select)
     rel, singer_id, phrase_num = parse_selection(select_str)
@@ -260,12 +493,32 @@ def run_feature_extraction(
         # Load audio: y @ sr_proc (48k), y_f0 @ sr_f0 (16k)
         y, sr, y_f016, sr_f0_actual = load_wav(wav, target_sr=sr_proc, f0_sr=sr_f0)
 
+        # Note onsets, found once per take (by the app when it wrote the take, else
+        # here) and sliced for every segment; taken at the recorded level
+        onsets = load_take_onsets(wav)
+        if onsets is None:
+            onsets = np.asarray(onset_times(y, sr), dtype=np.float64)
+
+        # Loudness-match takes (gain measured by the app when the take was written);
+        # clipping is still judged at the recorded level
+        gain_db = load_take_gain_db(wav)
+        clips = load_take_clips(wav)
+        gain = 10.0 ** (gain_db / 20.0) if gain_db is not None else 1.0
+        if gain != 1.0:
+            y = (y * gain).astype(np.float32)
+            y_f016 = (y_f016 * gain).astype(np.float32)
+
         # Single phrase per file
         (s0, e0) = one_phrase(y, sr)[0]
         yph = y[int(s0 * sr): int(e0 * sr)]
 
-        # F0 + periodicity on the 16k signal (whole phrase)
-        f0, periodicity = f0_crepe_16k(y_f016, sr16=sr_f0_actual, mask_thresh=0.5)
+        # F0 + periodicity on the 16k signal (whole phrase); where the app has mapped
+        # the take's activity, only the sung runs go through the pitch model
+        activity = load_take_activity(wav)
+        if activity is not None:
+            f0, periodicity = f0_crepe_16k_active(y_f016, activity, sr16=sr_f0_actual, mask_thresh=0.5)
+        else:
+            f0, periodicity = f0_crepe_16k(y_f016, sr16=sr_f0_actual, mask_thresh=0.5)
 
         # Accuracy-side features
         row = {
@@ -278,7 +531,7 @@ def run_feature_extraction(
             "mean_periodicity": mean_periodicity(periodicity),
             "snr_db": snr_simple(yph),
             "deess_ratio": deesser_ratio(yph, sr),
-            "clip_n": clip_count(yph),
+            "clip_n": _clip_n(yph, gain, clips, s0, e0, sr),
         }
 
         n = norm_block(row)
@@ -289,7 +542,7 @@ def run_feature_extraction(
             f0, periodicity, sr16=sr_f0_actual, hop=256, pd_thresh=0.6
         )
         row["dyn_shape"] = dyn_shape(yph, sr)
-        row["microtiming"] = microtiming(yph, sr)
+        row["microtiming"] = microtiming(yph, sr, onsets=_onsets_in(onsets, s0, e0, sr))
         row["emo_score"] = emotion_score(row, weights=weights_emo)
 
         row["alpha"] = alpha
@@ -306,8 +559,11 @@ def run_feature_extraction(
                 "sr": sr,
                 "y_f0": y_f016,
                 "sr_f0": sr_f0_actual,
+                "gain": gain,
+                "clips": clips,
                 "f0": f0,
                 "pd": periodicity,
+                "onsets": onsets,
             }
         )
 
@@ -336,91 +592,76 @@ def run_feature_extraction(
     ref_y = ref_take["y"]
     ref_sr = ref_take["sr"]
 
-    # Segment the reference take
-    segments = segment_phrase_reference(ref_y, ref_sr, bpm=bpm)
+    # Segment the reference take; cuts keep clear of its note onsets
+    segments = segment_phrase_reference(ref_y, ref_sr, bpm=bpm, onsets=ref_take["onsets"])
     print(f"[PASS 2] Detected {len(segments)} segments in reference take.")
 
-    # Segment-level rows
-    seg_rows = []
+    # Align every take to the reference: reference time t -> take time t + offset
+    take_offsets, segment_offsets = align_takes(
+        ref_y,
+        [t["y"] for t in takes],
+        ref_sr,
+        segments,
+        max_take_shift_s=float(align_cfg.get("max_take_shift_s", 0.25)),
+        max_segment_shift_s=float(align_cfg.get("max_segment_shift_s", 0.06)),
+        min_confidence=float(align_cfg.get("min_confidence", 0.4)),
+    )
+    print(
+        "[PASS 2] Take offsets vs reference (ms): "
+        + ", ".join(
+            f"{t['take_id']}={off * 1000.0:+.1f}" for t, off in zip(takes, take_offsets)
+        )
+    )
 
-    for take, glob_row in zip(takes, global_rows):
-        take_id = take["take_id"]
-        y = take["y"]
-        sr = take["sr"]
-        f0 = take["f0"]
-        pd = take["pd"]
-
-        dur = len(y) / float(sr)
-        f0_times = _map_f0_to_times(f0, len(y), sr)
-
-        for seg_idx, (s, e) in enumerate(segments):
-            # Safety clamp to phrase duration
-            s_clamp = max(0.0, min(float(s), dur))
-            e_clamp = max(0.0, min(float(e), dur))
-            if e_clamp <= s_clamp:
-                continue
-
-            y_seg = y[int(s_clamp * sr): int(e_clamp * sr)]
-            if len(y_seg) <= 0:
-                continue
-
-            # F0/Pd inside this segment
-            if len(f0_times) > 0:
-                mask = (f0_times >= s_clamp) & (f0_times <= e_clamp)
-                f0_seg = f0[mask]
-                pd_seg = pd[mask]
-            else:
-                f0_seg = np.asarray([], dtype=np.float32)
-                pd_seg = np.asarray([], dtype=np.float32)
-
-            # Accuracy features on segment
-            row = {
-                "phrase": phrase_name,
-                "take": take_id,
-                "segment_idx": seg_idx,
-                "seg_start_s": s_clamp,
-                "seg_end_s": e_clamp,
-                "f0_rmse_c": pitch_rmse_vs_median(f0_seg, pd_seg),
-                "voiced_ratio": voiced_ratio(pd_seg),
-                "mean_periodicity": mean_periodicity(pd_seg),
-                "snr_db": snr_simple(y_seg),
-                "deess_ratio": deesser_ratio(y_seg, sr),
-                "clip_n": clip_count(y_seg),
+    # Segment-level rows: one unit per (take, segment), in the sequential order,
+    # scored on a worker pool that maps the take audio and f0 from shared memory
+    ctx = {
+        "takes": [
+            {
+                "take_id": t["take_id"],
+                "sr": t["sr"],
+                "sr_f0": t["sr_f0"],
+                "gain": t["gain"],
+                "clips": t["clips"],
             }
+            for t in takes
+        ],
+        "segments": [(float(s), float(e)) for s, e in segments],
+        "segment_offsets": np.asarray(segment_offsets),
+        "phrase_name": phrase_name,
+        "weights_acc": weights_acc,
+        "weights_emo": weights_emo,
+        "alpha": alpha,
+        "debug_emotion": debug_emotion,
+    }
+    arrays = []
+    for take_i, t in enumerate(takes):
+        arrays += [
+            ((take_i, "y"), t["y"]),
+            ((take_i, "f0"), t["f0"]),
+            ((take_i, "pd"), t["pd"]),
+            ((take_i, "f0_times"), _map_f0_to_times(t["f0"], len(t["y"]), t["sr"])),
+            ((take_i, "onsets"), t["onsets"]),
+        ]
+    units = [(take_i, seg_idx) for take_i in range(len(takes)) for seg_idx in range(len(segments))]
 
-            n = norm_block(row)
-            row["acc_score"] = accuracy_score(n, weights=weights_acc)
-
-            # Emotion features on segment
-            row["vibrato_stability"] = vibrato_stability(
-                f0_seg, pd_seg, sr16=take["sr_f0"], hop=256, pd_thresh=0.6
-            )
-            row["dyn_shape"] = dyn_shape(y_seg, sr)
-            row["microtiming"] = microtiming(y_seg, sr)
-            row["emo_score"] = emotion_score(row, weights=weights_emo)
-
-            row["alpha"] = alpha
-            row["final_score"] = final_blend(row["acc_score"], row["emo_score"], alpha)
+    if workers is None:
+        workers = int(cfg.get("workers", 1) or 0)
+    if workers <= 0:
+        # Each worker is a spawned interpreter that imports librosa and the
+        # scoring modules before its first unit, so a pool only pays off with
+        # several units per worker
+        workers = min(os.cpu_count() or 1, len(units) // _UNITS_PER_WORKER)
+    workers = max(1, min(workers, len(units)))
 
+    seg_rows = []
+    for row, debug_text in _score_units(units, ctx, arrays, workers):
+        if row is not None:
             seg_rows.append(row)
+        if debug_text:
+            print(debug_text)
 
-            if debug_emotion:
-                vib_dbg = vibrato_analysis(
-                    f0_seg, pd_seg, sr16=take["sr_f0"], hop=256, pd_thresh=0.6
-                )
-                mt_dbg = microtiming_analysis(y_seg, sr)
-                print(f"[DEBUG] take={take_id}, seg_idx={seg_idx}")
-                print(
-                    f"  Vibrato: frames_voiced={vib_dbg['frames_voiced']}, "
-                    f"peak_hz={vib_dbg['peak_hz']:.2f}, depth_cents={vib_dbg['depth_cents']:.1f}, "
-                    f"rate_score={vib_dbg['rate_score']:.2f}, depth_score={vib_dbg['depth_score']:.2f}, "
-                    f"vib_score={vib_dbg['vib_score']:.2f}"
-                )
-                print(
-                    f"  Microtiming: tempo={mt_dbg['tempo']:.1f}, n_onsets={mt_dbg['n_onsets']}, "
-                    f"n_beats={mt_dbg['n_beats']}, jitter_ms={mt_dbg['jitter_ms']}, "
-                    f"jt_score={mt_dbg['jt_score']:.2f}, note={mt_dbg['note']}"
-                )
+    print(f"[PASS 2] Scored {len(units)} take/segment units on {max(workers, 1)} worker(s).")
 
     if not seg_rows:
         raise RuntimeError("No segment rows produced—check segmentation or audio files.")
@@ -463,6 +704,7 @@ def run_feature_extraction(
             "emo_score": float(best["emo_score"]),
             "snr_db": float(best["snr_db"]),
             "f0_rmse_c": float(best["f0_rmse_c"]),
+            "offset_s": float(best["offset_s"]),
         }
 
         # Alternative candidates close in quality
@@ -479,6 +721,7 @@ def run_feature_extraction(
                         "emo_score": float(row["emo_score"]),
                         "snr_db": float(row["snr_db"]),
                         "f0_rmse_c": float(row["f0_rmse_c"]),
+                        "offset_s": float(row["offset_s"]),
                     }
                 )
 
@@ -501,6 +744,9 @@ def run_feature_extraction(
         "base_dir": base_str,
         "relative_path": rel,
         "reference_take": ref_id,
+        "take_offsets_s": {
+            t["take_id"]: float(off) for t, off in zip(takes, take_offsets)
+        },
         "segments": segments_summary,
     }
 
@@ -567,6 +813,12 @@ def main():
         action="store_true",
         help="Print vibrato/microtiming debug stats per segment",
     )
+    ap.add_argument(
+        "--workers",
+        type=int,
+        default=None,
+        help="Processes for pass 2 (1 = sequential, 0 = one per core, at most one per 8 units); default from the config",
+    )
     args = ap.parse_args()
 
     # Interactive fallback (same behaviour as before)
@@ -581,6 +833,7 @@ def main():
         cfg_path=args.cfg,
         out_dir=args.out_dir,
         debug_emotion=args.debug_emotion,
+        workers=args.workers,
     )
 
 
@@ -1,10 +1,20 @@
+import os
 import numpy as np
 import librosa
-import torch
-import torchcrepe
 
 EPS = 1e-9
 
+# Native versions of the scoring kernels (native/ScoringKernels) and of the onset
+# detector (native/FeatureKernels, the same code the app runs), built into src/ with:
+# cmake -S native -B native/build && cmake --build native/build
+# Without the module, or with AICOMP_NATIVE_FEATURES=0, the numpy versions below are used.
+_native = None
+if os.environ.get("AICOMP_NATIVE_FEATURES", "1") != "0":
+    try:
+        from src import _featurekernels as _native
+    except ImportError:
+        _native = None
+
 # -------------------- generic utils --------------------
 
 def cents(f2, f1):
@@ -31,6 +41,10 @@ def f0_crepe_16k(y16k, sr16=16000, hop=320, device="cpu", model="tiny", mask_thr
     """
     Pitch track with torchcrepe at 16 kHz. Returns (f0_hz, periodicity) as numpy arrays.
     """
+    # Imported here: only pass 1 tracks pitch, so pass 2 workers never load torch
+    import torch
+    import torchcrepe
+
     # Expect shape [1, T]
     x = torch.tensor(y16k, dtype=torch.float32, device=device)[None, :]
 
@@ -58,6 +72,31 @@ def f0_crepe_16k(y16k, sr16=16000, hop=320, device="cpu", model="tiny", mask_thr
 
     return f0, pd
 
+def f0_crepe_16k_active(y16k, runs_s, sr16=16000, hop=320, mask_thresh=None, **kwargs):
+    """
+    f0_crepe_16k over the active runs of a take only (from the app's activity map);
+    frames outside them are unvoiced (f0 = 0, periodicity = 0). Same frame grid as
+    running f0_crepe_16k on the whole signal.
+    """
+    n_frames = 1 + len(y16k) // hop
+    f0 = np.zeros(n_frames, dtype=np.float32)
+    pd = np.zeros(n_frames, dtype=np.float32)
+
+    for s, e in runs_s:
+        # start on a frame centre so the run's frames land on the whole-take grid
+        a = (int(s * sr16) // hop) * hop
+        b = min(len(y16k), int(np.ceil(e * sr16)))
+        if b - a < hop:
+            continue
+        f0_run, pd_run = f0_crepe_16k(y16k[a:b], sr16=sr16, hop=hop, mask_thresh=mask_thresh, **kwargs)
+        f0_run, pd_run = np.atleast_1d(f0_run), np.atleast_1d(pd_run)
+        k0 = a // hop
+        k1 = min(n_frames, k0 + len(f0_run))
+        f0[k0:k1] = f0_run[: k1 - k0]
+        pd[k0:k1] = pd_run[: k1 - k0]
+
+    return f0, pd
+
 def pitch_rmse_vs_median(f0, pd=None, pd_thresh=0.6):
     """
     RMSE of pitch error (in cents) vs phrase median, using voiced frames only.
@@ -103,6 +142,8 @@ def snr_simple(y):
       - 'signal' ~ 90th percentile
     Returns dB (higher ~ cleaner).
     """
+    if _native is not None:
+        return _native.snr_simple(y)
     rms = librosa.feature.rms(y=y, frame_length=2048, hop_length=512).squeeze()
     noise = np.percentile(rms, 10)
     signal = np.percentile(rms, 90)
@@ -110,6 +151,8 @@ def snr_simple(y):
 
 def deesser_ratio(y, sr):
     """Sibilance proxy: power(5–10 kHz) / power(1–5 kHz). Higher → more sibilant/harsh."""
+    if _native is not None:
+        return _native.deesser_ratio(y, sr)
     S = np.abs(librosa.stft(y, n_fft=2048, hop_length=512)) ** 2
     freqs = librosa.fft_frequencies(sr=sr, n_fft=2048)
     hi = S[(freqs >= 5000) & (freqs <= 10000)].mean()
@@ -118,6 +161,8 @@ def deesser_ratio(y, sr):
 
 def clip_count(y):
     """Count samples at/near full scale (|y| >= 0.999). Non-zero suggests clipping/distortion."""
+    if _native is not None:
+        return int(_native.clip_count(y))
     return int(np.sum(np.abs(y) >= 0.999))
 
 # -------------------- MVP emotion features --------------------
@@ -148,6 +193,9 @@ def vibrato_stability(f0, pd, sr16=16000, hop=256, pd_thresh=0.6, return_details
     Returns:
       float or (float, dict)
     """
+    if _native is not None and not return_details:
+        return _native.vibrato_stability(f0, pd, sr16=sr16, hop=hop, pd_thresh=pd_thresh)
+
     import numpy as np
 
     def _frame_rate(sr, hop):  # frames per second for f0 stream
@@ -234,6 +282,8 @@ def dyn_shape(y, sr):
     Prefers moderate dynamics: not flat (boring), not pumping/clipping.
     Heuristic: std of smoothed RMS in dB → triangle score.
     """
+    if _native is not None:
+        return _native.dyn_shape(y)
     rms = librosa.feature.rms(y=y, frame_length=2048, hop_length=512).squeeze()
     # smooth a bit
     win = max(3, int(round(0.10 * len(rms))))
@@ -245,21 +295,93 @@ def dyn_shape(y, sr):
     # prefer around ~4 dB std (2..8 acceptable)
     return float(band_score(std_db, low=1.0, mid=4.0, high=10.0))
 
-def microtiming(y, sr):
+def _onset_strength(y, n_fft=2048, hop=512, compression=100.0, block=1024):
+    """
+    Spectral flux per frame, as FeatureKernels::OnsetDetector computes it:
+    frames centred on t * hop (n_fft // 2 zeros either side), periodic Hann,
+    mean over bins of the rectified rise in log1p(compression * |X|).
+    """
+    y = np.asarray(y, dtype=np.float32).astype(np.float64)
+    padded = np.concatenate([np.zeros(n_fft // 2), y, np.zeros(n_fft // 2)])
+    n_frames = (len(padded) - n_fft) // hop + 1
+    window = 0.5 - 0.5 * np.cos(2.0 * np.pi * np.arange(n_fft) / n_fft)
+    frames = np.lib.stride_tricks.sliding_window_view(padded, n_fft)[::hop]
+
+    strength = np.zeros(n_frames)
+    previous = None
+    # A block of frames at a time, so a long take never needs all its spectra at once
+    for b0 in range(0, n_frames, block):
+        logmag = np.log1p(compression * np.abs(np.fft.rfft(frames[b0:b0 + block] * window, axis=1)))
+        stacked = logmag if previous is None else np.vstack([previous, logmag])
+        rise = np.maximum(np.diff(stacked, axis=0), 0.0).mean(axis=1)
+        # The very first frame has nothing to rise from and stays 0
+        b1 = b0 + len(logmag)
+        strength[b1 - len(rise):b1] = rise
+        previous = logmag[-1:]
+    return strength
+
+def onset_times(y, sr):
+    """
+    Note onset times in seconds from the start of y (ascending float64 array).
+    The native spectral-flux detector the app uses (take_N.onsets.json holds its
+    result for a whole take), or the same detector in numpy without the module,
+    so microtiming and boundary snapping do not depend on which one ran.
+    """
+    if _native is not None:
+        return _native.onset_times(y, sr)
+
+    hop = 512
+    sr = float(sr) if sr > 0 else 48000.0
+    strength = _onset_strength(y, hop=hop)
+    n = len(strength)
+
+    def frames(seconds):
+        return max(1, int(np.ceil(seconds * sr / hop)))
+
+    pre_max, pre_avg, post_avg, wait = frames(0.03), frames(0.10), frames(0.10), frames(0.03)
+
+    # Frame t is measured against the peak strength up to t + post_avg, the
+    # running maximum the streaming detector has seen when it decides t
+    idx = np.arange(n)
+    peak = np.maximum.accumulate(strength)[np.minimum(idx + post_avg, n - 1)]
+
+    # Largest of the pre_max frames before it (earlier frames only)
+    padded = np.concatenate([np.full(pre_max, -np.inf), strength])
+    before = np.lib.stride_tricks.sliding_window_view(padded, pre_max)[:n].max(axis=1)
+
+    # Mean over [t - pre_avg, t + post_avg], clipped to the envelope
+    csum = np.concatenate([[0.0], np.cumsum(strength)])
+    first = np.maximum(idx - pre_avg, 0)
+    last = np.minimum(idx + post_avg, n - 1)
+    local_mean = (csum[last + 1] - csum[first]) / (last - first + 1)
+
+    candidates = np.flatnonzero((strength > 0.0) & (before <= strength)
+                                & (strength >= local_mean + 0.07 * peak))
+    onsets = []
+    last_onset = -1
+    for t in candidates:
+        if last_onset >= 0 and t - last_onset <= wait:
+            continue
+        onsets.append(t * hop / sr)
+        last_onset = t
+    return np.asarray(onsets, dtype=np.float64)
+
+def microtiming(y, sr, onsets=None):
     """
     Microtiming score (0..1): how consistently onsets sit relative to a beat grid.
     Improvements:
       - Neutral fallback (0.5) if the beat tracker is unreliable
       - Looser jitter mapping (20..100 ms -> 1..0) to avoid collapsing to 0
+    onsets: onset times in seconds from the start of y, if already known
+    (e.g. sliced from the take's); found with onset_times() otherwise.
     """
     hop = 512
 
     # Onset detection
-    oenv = librosa.onset.onset_strength(y=y, sr=sr, hop_length=hop)
-    onset_frames = librosa.onset.onset_detect(onset_envelope=oenv, sr=sr, hop_length=hop)
+    times_onsets = np.asarray(onset_times(y, sr) if onsets is None else onsets, dtype=np.float64)
 
     # If we hardly have onsets, we can't judge microtiming → neutral
-    if len(onset_frames) < 3:
+    if len(times_onsets) < 3:
         return 0.5
 
     # Beat tracking (may be unreliable on a cappella)
@@ -270,7 +392,6 @@ def microtiming(y, sr):
         return 0.5
 
     # Convert to seconds
-    times_onsets = librosa.frames_to_time(onset_frames, sr=sr, hop_length=hop)
     times_beats  = librosa.frames_to_time(beat_frames, sr=sr, hop_length=hop)
 
     # Another guard: if beat spacing looks degenerate
@@ -326,6 +447,12 @@ def vibrato_analysis(
       - sustain_score          (0..1, how "sustained" the note is)
       - vib_score_weighted     (vib_score * sustain_score)
     """
+    if _native is not None:
+        return _native.vibrato_analysis(
+            f0, pd, sr16=sr16, hop=hop, pd_thresh=pd_thresh,
+            sustain_min_ms=sustain_min_ms, sustain_slope_cents=sustain_slope_cents,
+        )
+
     fps = float(sr16) / float(hop)
     voiced = (f0 > 0) & (pd >= pd_thresh)
 
@@ -436,19 +563,18 @@ def vibrato_analysis(
 
 
 
-def microtiming_analysis(y, sr):
+def microtiming_analysis(y, sr, onsets=None):
     """
     Return intermediate microtiming stats:
       - tempo, n_onsets, n_beats, jitter_ms, jt_score
-    Mirrors microtiming() logic (with the improved mapping).
+    Mirrors microtiming() logic (with the improved mapping), onsets included.
     """
     hop = 512
-    oenv = librosa.onset.onset_strength(y=y, sr=sr, hop_length=hop)
-    onset_frames = librosa.onset.onset_detect(onset_envelope=oenv, sr=sr, hop_length=hop)
+    times_onsets = np.asarray(onset_times(y, sr) if onsets is None else onsets, dtype=np.float64)
 
-    if len(onset_frames) < 3:
+    if len(times_onsets) < 3:
         return {
-            "tempo": 0.0, "n_onsets": int(len(onset_frames)), "n_beats": 0,
+            "tempo": 0.0, "n_onsets": int(len(times_onsets)), "n_beats": 0,
             "jitter_ms": None, "jt_score": 0.5, "note": "too_few_onsets"
         }
 
@@ -456,15 +582,14 @@ def microtiming_analysis(y, sr):
 
     if tempo <= 0 or len(beat_frames) < 4 or tempo < 50 or tempo > 180:
         return {
-            "tempo": float(tempo), "n_onsets": int(len(onset_frames)), "n_beats": int(len(beat_frames)),
+            "tempo": float(tempo), "n_onsets": int(len(times_onsets)), "n_beats": int(len(beat_frames)),
             "jitter_ms": None, "jt_score": 0.5, "note": "unreliable_beat"
         }
 
-    times_onsets = librosa.frames_to_time(onset_frames, sr=sr, hop_length=hop)
     times_beats  = librosa.frames_to_time(beat_frames, sr=sr, hop_length=hop)
     if len(times_beats) < 2 or np.median(np.diff(times_beats)) <= 0:
         return {
-            "tempo": float(tempo), "n_onsets": int(len(onset_frames)), "n_beats": int(len(beat_frames)),
+            "tempo": float(tempo), "n_onsets": int(len(times_onsets)), "n_beats": int(len(beat_frames)),
             "jitter_ms": None, "jt_score": 0.5, "note": "degenerate_beats"
         }
 
@@ -486,7 +611,7 @@ def microtiming_analysis(y, sr):
 
     return {
         "tempo": float(tempo),
-        "n_onsets": int(len(onset_frames)),
+        "n_onsets": int(len(times_onsets)),
         "n_beats": int(len(beat_frames)),
         "jitter_ms": float(jitter_ms),
         "jt_score": float(np.clip(jt_score, 0.0, 1.0)),
@@ -1,3 +1,4 @@
+import json, os
 import soundfile as sf, numpy as np, librosa
 
 #sf = soundfile
@@ -13,3 +14,55 @@ def load_wav(path, target_sr=48000, f0_sr=16000):
     y = np.clip(y, -1.0, 1.0)
     y_f0 = librosa.resample(y, orig_sr=sr, target_sr=f0_sr) if f0_sr != sr else y #resampling for F0 (pitch)
     return y, sr, y_f0, f0_sr
+
+def _read_sidecar(path, suffix):
+    #parsed JSON dict of the app's <take><suffix> sidecar next to the wav at path,
+    #None if missing, older than the take (stale) or unreadable
+    wav = os.path.abspath(path)
+    sidecar = os.path.splitext(wav)[0] + suffix
+    if not os.path.isfile(sidecar) or os.path.getmtime(sidecar) < os.path.getmtime(wav):
+        return None
+    try:
+        with open(sidecar, "r", encoding="utf-8") as f:
+            data = json.load(f)
+    except (OSError, ValueError):
+        return None
+    return data if isinstance(data, dict) else None
+
+def load_take_gain_db(path):
+    #gain_db from the app's <take>.loudness.json sidecar (LoudnessAnalyser), None if missing/stale
+    data = _read_sidecar(path, ".loudness.json")
+    try:
+        return None if data is None else float(data["gain_db"])
+    except (ValueError, KeyError, TypeError):
+        return None
+
+def load_take_clips(path):
+    #clipped input runs [(start_s, end_s), ...] the app saw while recording the take,
+    #from the same sidecar; None if missing/stale or the take was not recorded live
+    data = _read_sidecar(path, ".loudness.json")
+    clips = None if data is None else data.get("clips_s")
+    try:
+        return None if clips is None else [(float(s), float(e)) for s, e in clips]
+    except (ValueError, TypeError):
+        return None
+
+def load_take_activity(path):
+    #active runs [(start_s, end_s), ...] from the app's <take>.activity.json sidecar
+    #(ActivityAnalyser); everything outside them is below its silence threshold.
+    #None if missing/stale
+    data = _read_sidecar(path, ".activity.json")
+    try:
+        return None if data is None else [(float(s), float(e)) for s, e in data["active_s"]]
+    except (ValueError, KeyError, TypeError):
+        return None
+
+def load_take_onsets(path):
+    #onset times in seconds (ascending float64 array) from the app's
+    #<take>.onsets.json sidecar (OnsetAnalyser, the same detector as
+    #features.onset_times). None if missing/stale
+    data = _read_sidecar(path, ".onsets.json")
+    try:
+        return None if data is None else np.sort(np.asarray(data["onset_s"], dtype=np.float64))
+    except (ValueError, KeyError, TypeError):
+        return None
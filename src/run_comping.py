@@ -2,7 +2,9 @@
 #
 # High-level wrapper to:
 #   1) Run feature extraction + compmap generation (non-interactive).
-#   2) Stitch the comped audio from the generated compmap.
+#   2) Stitch the comped audio from the generated compmap
+#      (skipped with --skip_stitch when the caller stitches natively,
+#      e.g. the JUCE app's CompStitcher).
 #
 # Programmatic entry:
 #   run_comping(base_dir, select, alpha_pct, bpm, fade_fraction,
@@ -39,6 +41,7 @@ def run_comping(
     cfg="configs/weights.yaml",
     out_comped_path=None,
     out_compmap_path=None,
+    skip_stitch=False,
 ):
     """
     Run the full comping pipeline:
@@ -65,8 +68,11 @@ def run_comping(
             If given, the final comped WAV will be written exactly here.
         out_compmap_path (str or Path, optional):
             If given, the compmap JSON will be written exactly here.
+        skip_stitch (bool):
+            If True, stop after writing the compmap; no WAV is written.
     Returns:
-        pathlib.Path: Path to the final comped WAV file.
+        pathlib.Path: Path to the final comped WAV file, or to the compmap
+        JSON when skip_stitch is set.
     """
     base_str = str(base_dir)
     out_dir_str = str(out_dir)
@@ -87,6 +93,8 @@ def run_comping(
     )
     compmap_path = Path(compmap_path)
 
+    if skip_stitch:
+        return compmap_path
 
     # ------------------------------------------------------------------
     # 2) Decide output WAV name using singer/phrase/alpha from compmap
@@ -195,6 +203,11 @@ def _parse_args():
         default=None,
         help="Optional explicit path for the compmap JSON.",
     )
+    p.add_argument(
+        "--skip_stitch",
+        action="store_true",
+        help="Only write the compmap; the caller stitches the audio itself.",
+    )
     return p.parse_args()
 
 
@@ -210,6 +223,10 @@ if __name__ == "__main__":
         cfg=args.cfg,
         out_comped_path=args.out_comped_path,
         out_compmap_path=args.out_compmap_path,
+        skip_stitch=args.skip_stitch,
     )
-    print(f"\n[RUN COMPING] Wrote final comped file to: {out_path}\n")
+    if args.skip_stitch:
+        print(f"\n[RUN COMPING] Wrote compmap to: {out_path} (stitching skipped)\n")
+    else:
+        print(f"\n[RUN COMPING] Wrote final comped file to: {out_path}\n")
 
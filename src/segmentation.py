@@ -7,6 +7,8 @@
 #   - Aim for ~2-beat segments (via BPM), but:
 #       * enforce a minimum duration (so we don't get tiny segments),
 #       * use a soft max (~5 s), but allow longer if there are no good valleys.
+#   - Given the take's note onsets, pull a cut that lands just after an onset
+#     back in front of it, so the attack starts the next segment.
 #
 # The best overall take (chosen in extract_features.py) defines the
 # "master" segment grid; all other takes are cut at the same times.
@@ -95,12 +97,26 @@ def _find_rms_valleys(rms, times, min_spacing=0.18):
     return np.asarray(keep_times, dtype=np.float32)
 
 
+def _snap_before_onset(btime, onsets, lookback=0.08, lead=0.02):
+    """
+    If a note onset lies within `lookback` seconds before the cut at btime,
+    move the cut to `lead` seconds before that onset (else return btime).
+    """
+    if onsets is None or len(onsets) == 0:
+        return btime
+    i = int(np.searchsorted(onsets, btime, side="right")) - 1
+    if i >= 0 and btime - onsets[i] <= lookback:
+        return max(0.0, float(onsets[i]) - lead)
+    return btime
+
+
 def segment_phrase_reference(
     y,
     sr,
     bpm,
     min_seg_dur=0.45,
     max_seg_dur=5.0,
+    onsets=None,
 ):
     """
     Segment a reference take into sub-phrase chunks.
@@ -119,6 +135,8 @@ def segment_phrase_reference(
       bpm (float): user-provided tempo in BPM.
       min_seg_dur (float): minimum segment length in seconds.
       max_seg_dur (float): "soft" maximum segment length in seconds.
+      onsets (array-like, optional): note onset times in seconds (e.g. the
+        take's take_N.onsets.json); cuts just after an onset snap in front of it.
 
     Returns:
       list[(start_s, end_s)] in seconds.
@@ -133,6 +151,8 @@ def segment_phrase_reference(
 
     # Detect RMS valleys once; we will pick among these.
     valley_times = _find_rms_valleys(rms, rms_times, min_spacing=0.18)
+    if onsets is not None:
+        onsets = np.sort(np.asarray(onsets, dtype=np.float64))
 
     # Target duration: about 2 beats, but clamped to reasonable bounds.
     if bpm is not None and bpm > 0:
@@ -178,6 +198,11 @@ def segment_phrase_reference(
         idx = int(np.argmin(np.abs(cand - desired)))
         btime = float(cand[idx])
 
+        # Keep the attack of a note that starts right before the valley together
+        snapped = _snap_before_onset(btime, onsets)
+        if snapped - last >= min_seg_dur:
+            btime = snapped
+
         # Safety: ensure progress and minimum duration
         if btime - last < min_seg_dur:
             # If we somehow got an invalid boundary, stop to avoid infinite loop.
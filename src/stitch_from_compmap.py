@@ -4,7 +4,10 @@
 # a single comped WAV (48 kHz), with simple crossfades at boundaries.
 #
 # Assumptions:
-#   - All takes for the phrase are time-aligned and same length (your pipeline).
+#   - All takes for the phrase are the same length (your pipeline). Segment
+#     times are on the reference take's timeline; a winner's "offset_s"
+#     (from src/alignment.py, 0 if missing) says where the same words sit in
+#     its own take, so we read take audio at t + offset_s.
 #   - Audio is mono, or can be treated as mono.
 #   - Take IDs in JSON (e.g. "take_1") correspond to "<take_id>.wav" files
 #     in: base_dir / relative_path / "<take_id>.wav".
@@ -22,7 +25,7 @@ from pathlib import Path
 import numpy as np
 import soundfile as sf
 
-from src.io import load_wav
+from src.io import load_wav, load_take_gain_db
 
 PROJECT_ROOT = Path(__file__).resolve().parent.parent
 
@@ -78,7 +81,11 @@ def _load_winner_audio(compmap, base_override=None):
 
         audio[take_id] = y.astype(np.float32)
 
-        if PER_TAKE_NORMALIZE_DBFS is not None:
+        # Loudness-matched gain from the app's sidecar, else peak normalise
+        gain_db = load_take_gain_db(wav_path)
+        if gain_db is not None:
+            y = (y * 10.0 ** (gain_db / 20.0)).astype(np.float32)
+        elif PER_TAKE_NORMALIZE_DBFS is not None:
             y = _peak_normalize(y, target_dbfs=PER_TAKE_NORMALIZE_DBFS)
 
         audio[take_id] = y
@@ -89,6 +96,16 @@ def _load_winner_audio(compmap, base_override=None):
     return sr_ref, audio
 
 
+def _take_slice(y, start_sample, length):
+    """y[start:start+length] as float32, zero-padded where it leaves the take."""
+    out = np.zeros(max(0, length), dtype=np.float32)
+    a = max(start_sample, 0)
+    b = min(start_sample + length, y.size)
+    if b > a:
+        out[a - start_sample: b - start_sample] = y[a:b]
+    return out
+
+
 def _crossfade_concat(a, b, sr, crossfade_ms):
     """
     Concatenate arrays a and b with a linear crossfade of length crossfade_ms.
@@ -180,6 +197,9 @@ def stitch_from_compmap(
     start_s = np.array([float(s["start_s"]) for s in segments_sorted], dtype=float)
     end_s = np.array([float(s["end_s"]) for s in segments_sorted], dtype=float)
     take_ids = [s["winner"]["take"] for s in segments_sorted]
+    offsets = [
+        int(round(float(s["winner"].get("offset_s", 0.0)) * sr)) for s in segments_sorted
+    ]
     dur_s = end_s - start_s
 
     phrase_end_s = float(end_s.max())
@@ -206,9 +226,9 @@ def stitch_from_compmap(
         start_sample = int(round(start_s[idx] * sr))
         end_sample = int(round(end_s[idx] * sr))
 
-        # Clamp to valid range
+        # Clamp to valid range (output timeline)
         start_sample = max(0, min(start_sample, target_samples))
-        end_sample = max(start_sample, min(end_sample, target_samples, y.size))
+        end_sample = max(start_sample, min(end_sample, target_samples))
 
         if end_sample <= start_sample:
             if verbose:
@@ -218,16 +238,17 @@ def stitch_from_compmap(
                 )
             continue
 
-        seg_wave = y[start_sample:end_sample]
+        seg_wave = _take_slice(y, start_sample + offsets[idx], end_sample - start_sample)
 
         if verbose:
             dur_seg = (end_sample - start_sample) / float(sr)
             print(
                 f"Segment {seg['index']:02d}: {start_s[idx]:7.3f}s -> {end_s[idx]:7.3f}s "
-                f"({dur_seg:5.3f}s) from {take_id}"
+                f"({dur_seg:5.3f}s) from {take_id} "
+                f"(offset {offsets[idx] * 1000.0 / sr:+.1f} ms)"
             )
 
-        out_wave[start_sample:end_sample] = seg_wave.astype(np.float32)
+        out_wave[start_sample:end_sample] = seg_wave
 
     # Step 2: apply time-aligned crossfades around boundaries
     # We work per-boundary, mixing the two relevant takes in a window
@@ -278,22 +299,9 @@ def stitch_from_compmap(
         y_prev = audio[prev_take_id]
         y_next = audio[next_take_id]
 
-        # Clamp to available samples in each take
-        end_sample_cf_prev = min(end_sample_cf, y_prev.size)
-        end_sample_cf_next = min(end_sample_cf, y_next.size)
-        # Adjust length if needed (should be the same for both)
-        length_cf = min(
-            length_cf,
-            end_sample_cf_prev - start_sample_cf,
-            end_sample_cf_next - start_sample_cf,
-        )
-        if length_cf <= 1:
-            continue
-
-        end_sample_cf = start_sample_cf + length_cf
-
-        prev_slice = y_prev[start_sample_cf:end_sample_cf].astype(np.float32)
-        next_slice = y_next[start_sample_cf:end_sample_cf].astype(np.float32)
+        # Each side is read at its own alignment offset
+        prev_slice = _take_slice(y_prev, start_sample_cf + offsets[b], length_cf)
+        next_slice = _take_slice(y_next, start_sample_cf + offsets[b + 1], length_cf)
 
         # Linear crossfade weights across the region
         t = np.linspace(0.0, 1.0, length_cf, dtype=np.float32)